@@ -24,6 +24,7 @@
 #include "audioport.h"
 #include "audioengine.h"
 #include "beattracker.h"
+#include "analyzer.h"
 #include <stdexcept>
 #include <cstring>
 
@@ -42,6 +43,8 @@ HSQOBJECT AudioSystemInObject;
 HSQOBJECT AudioStereoInObject;
 HSQOBJECT AudioStereoOutObject;
 HSQOBJECT AudioBeatTrackerObject;
+HSQOBJECT AudioAnalyzerObject;
+HSQOBJECT AudioFeaturesObject;
 
 //
 // Audio.Mixer class
@@ -513,6 +516,60 @@ SQInteger AudioOnsetDetectorconnect(HSQUIRRELVM vm)
     }
 }
 
+//
+// Audio.OnsetDetector minInterval
+//
+SQInteger AudioOnsetDetectorminInterval(HSQUIRRELVM vm)
+{
+    SQInteger numargs = sq_gettop(vm);
+    // check parameter count
+    if(numargs > 2) {
+        return sq_throwerror(vm, "too many parameters, expected at most 1");
+    }
+    // get "this" pointer
+    SQUserPointer userPtr = 0;
+    if (SQ_FAILED(sq_getinstanceup(vm, 1, &userPtr, 0))) {
+        return sq_throwerror(vm, "minInterval method needs an instance of OnsetDetector");
+    }
+    OnsetDetector *obj = static_cast<OnsetDetector*>(userPtr);
+    if(!obj) {
+        return sq_throwerror(vm, "minInterval method called before Audio.OnsetDetector constructor");
+    }
+    // return value
+    SQFloat ret;
+    // 1 parameters passed in
+    if(numargs == 2) {
+
+        // get parameter 1 "milliseconds" as float
+        SQFloat milliseconds;
+        if (SQ_FAILED(sq_getfloat(vm, 2, &milliseconds))){
+            return sq_throwerror(vm, "argument 1 \"milliseconds\" is not of type float");
+        }
+
+        // call the implementation
+        try {
+            ret = obj->minInterval(milliseconds);
+        }
+        catch(std::exception const& e) {
+            return sq_throwerror(vm, e.what());
+        }
+    }
+
+    else {
+        // call the implementation
+        try {
+            ret = obj->minInterval();
+        }
+        catch(std::exception const& e) {
+            return sq_throwerror(vm, e.what());
+        }
+    }
+
+    // push return value
+    sq_pushfloat(vm, ret);
+    return 1;
+}
+
 //
 // Audio.OnsetDetector onOnset
 //
@@ -614,6 +671,60 @@ SQInteger AudioOnsetDetectorthreshold(HSQUIRRELVM vm)
     return 1;
 }
 
+//
+// Audio.OnsetDetector window
+//
+SQInteger AudioOnsetDetectorwindow(HSQUIRRELVM vm)
+{
+    SQInteger numargs = sq_gettop(vm);
+    // check parameter count
+    if(numargs > 2) {
+        return sq_throwerror(vm, "too many parameters, expected at most 1");
+    }
+    // get "this" pointer
+    SQUserPointer userPtr = 0;
+    if (SQ_FAILED(sq_getinstanceup(vm, 1, &userPtr, 0))) {
+        return sq_throwerror(vm, "window method needs an instance of OnsetDetector");
+    }
+    OnsetDetector *obj = static_cast<OnsetDetector*>(userPtr);
+    if(!obj) {
+        return sq_throwerror(vm, "window method called before Audio.OnsetDetector constructor");
+    }
+    // return value
+    SQInteger ret;
+    // 1 parameters passed in
+    if(numargs == 2) {
+
+        // get parameter 1 "hops" as integer
+        SQInteger hops;
+        if (SQ_FAILED(sq_getinteger(vm, 2, &hops))){
+            return sq_throwerror(vm, "argument 1 \"hops\" is not of type integer");
+        }
+
+        // call the implementation
+        try {
+            ret = obj->window(hops);
+        }
+        catch(std::exception const& e) {
+            return sq_throwerror(vm, e.what());
+        }
+    }
+
+    else {
+        // call the implementation
+        try {
+            ret = obj->window();
+        }
+        catch(std::exception const& e) {
+            return sq_throwerror(vm, e.what());
+        }
+    }
+
+    // push return value
+    sq_pushinteger(vm, ret);
+    return 1;
+}
+
 //
 // Audio.Output class
 //
@@ -1178,6 +1289,422 @@ SQInteger AudioBeatTrackerconnect(HSQUIRRELVM vm)
     }
 }
 
+//
+// Audio.Analyzer class
+//
+SQInteger AudioAnalyzerCtor(HSQUIRRELVM vm)
+{
+    SQInteger numargs = sq_gettop(vm);
+    // check parameter count
+    if(numargs > 1) {
+        return sq_throwerror(vm, "too many parameters, expected at most 0");
+    }
+    Analyzer *obj;
+    // call the implementation
+    try {
+        obj = AnalyzerCache::instance().getAnalyzer();
+    }
+    catch(std::exception const& e) {
+        return sq_throwerror(vm, e.what());
+    }
+
+    // return pointer to new object
+    sq_setinstanceup(vm, 1, (SQUserPointer*)obj);
+    return 1;
+}
+
+//
+// Audio.Analyzer connect
+//
+SQInteger AudioAnalyzerconnect(HSQUIRRELVM vm)
+{
+    SQObjectType overrideType = sq_gettype(vm, 2);
+    if(audio::Source *source = getAudioSource(vm, 2)) {
+        SQInteger numargs = sq_gettop(vm);
+        // check parameter count
+        if(numargs > 2) {
+            return sq_throwerror(vm, "too many parameters, expected at most 1");
+        }
+        if(numargs < 2) {
+            return sq_throwerror(vm, "insufficient parameters, expected at least 1");
+        }
+        // get "this" pointer
+        SQUserPointer userPtr = 0;
+        if (SQ_FAILED(sq_getinstanceup(vm, 1, &userPtr, 0))) {
+            return sq_throwerror(vm, "connect method needs an instance of Analyzer");
+        }
+        Analyzer *obj = static_cast<Analyzer*>(userPtr);
+        if(!obj) {
+            return sq_throwerror(vm, "connect method called before Audio.Analyzer constructor");
+        }
+        // call the implementation
+        try {
+            obj->connect(*source);
+        }
+        catch(std::exception const& e) {
+            return sq_throwerror(vm, e.what());
+        }
+
+        // void method, returns no value
+        return 0;
+    }
+    else if(audio::AudioConnection *output = getAudioOutput(vm, 2)) {
+        SQInteger numargs = sq_gettop(vm);
+        // check parameter count
+        if(numargs > 2) {
+            return sq_throwerror(vm, "too many parameters, expected at most 1");
+        }
+        if(numargs < 2) {
+            return sq_throwerror(vm, "insufficient parameters, expected at least 1");
+        }
+        // get "this" pointer
+        SQUserPointer userPtr = 0;
+        if (SQ_FAILED(sq_getinstanceup(vm, 1, &userPtr, 0))) {
+            return sq_throwerror(vm, "connect method needs an instance of Analyzer");
+        }
+        Analyzer *obj = static_cast<Analyzer*>(userPtr);
+        if(!obj) {
+            return sq_throwerror(vm, "connect method called before Audio.Analyzer constructor");
+        }
+        // call the implementation
+        try {
+            obj->connect(*output);
+        }
+        catch(std::exception const& e) {
+            return sq_throwerror(vm, e.what());
+        }
+
+        // void method, returns no value
+        return 0;
+    }
+    else {
+        return sq_throwerror(vm, "argument 1 is not of type {Audio.Source, Audio.Output}");
+    }
+}
+
+//
+// Audio.Analyzer features
+//
+SQInteger AudioAnalyzerfeatures(HSQUIRRELVM vm)
+{
+    SQInteger numargs = sq_gettop(vm);
+    // check parameter count
+    if(numargs > 1) {
+        return sq_throwerror(vm, "too many parameters, expected at most 0");
+    }
+    // get "this" pointer
+    SQUserPointer userPtr = 0;
+    if (SQ_FAILED(sq_getinstanceup(vm, 1, &userPtr, 0))) {
+        return sq_throwerror(vm, "features method needs an instance of Analyzer");
+    }
+    Analyzer *obj = static_cast<Analyzer*>(userPtr);
+    if(!obj) {
+        return sq_throwerror(vm, "features method called before Audio.Analyzer constructor");
+    }
+    // return value
+    Features* ret;
+    // call the implementation
+    try {
+        ret = obj->features();
+    }
+    catch(std::exception const& e) {
+        return sq_throwerror(vm, e.what());
+    }
+
+    // push return value
+    sq_pushobject(vm, AudioFeaturesObject);
+    sq_createinstance(vm, -1);
+    sq_remove(vm, -2);
+    sq_setinstanceup(vm, -1, ret);
+    sq_setreleasehook(vm, -1, &AudioFeaturesRelease);
+
+    return 1;
+}
+
+//
+// Audio.Analyzer onFeatures
+//
+SQInteger AudioAnalyzeronFeatures(HSQUIRRELVM vm)
+{
+    SQInteger numargs = sq_gettop(vm);
+    // check parameter count
+    if(numargs > 2) {
+        return sq_throwerror(vm, "too many parameters, expected at most 1");
+    }
+    if(numargs < 2) {
+        return sq_throwerror(vm, "insufficient parameters, expected at least 1");
+    }
+    // get "this" pointer
+    SQUserPointer userPtr = 0;
+    if (SQ_FAILED(sq_getinstanceup(vm, 1, &userPtr, 0))) {
+        return sq_throwerror(vm, "onFeatures method needs an instance of Analyzer");
+    }
+    Analyzer *obj = static_cast<Analyzer*>(userPtr);
+    if(!obj) {
+        return sq_throwerror(vm, "onFeatures method called before Audio.Analyzer constructor");
+    }
+    // get parameter 1 "handler" as function
+    HSQOBJECT handlerObj;
+    if (SQ_FAILED(sq_getstackobj(vm, 2, &handlerObj))) {
+        return sq_throwerror(vm, "argument 1 \"handler\" is not of type function");
+    }
+    if (sq_gettype(vm, 2) != OT_CLOSURE) {
+        return sq_throwerror(vm, "argument 1 \"handler\" is not of type function");
+    }
+    SQUnsignedInteger nparams, nfreevars;
+    sq_getclosureinfo(vm, 2, &nparams, &nfreevars);
+    sq_addref(vm, &handlerObj);
+    ScriptFunction handler(vm, handlerObj, nparams);
+
+    // call the implementation
+    try {
+        obj->onFeatures(handler);
+    }
+    catch(std::exception const& e) {
+        return sq_throwerror(vm, e.what());
+    }
+
+    // void method, returns no value
+    return 0;
+}
+
+//
+// Audio.Analyzer updateInterval
+//
+SQInteger AudioAnalyzerupdateInterval(HSQUIRRELVM vm)
+{
+    SQInteger numargs = sq_gettop(vm);
+    // check parameter count
+    if(numargs > 2) {
+        return sq_throwerror(vm, "too many parameters, expected at most 1");
+    }
+    // get "this" pointer
+    SQUserPointer userPtr = 0;
+    if (SQ_FAILED(sq_getinstanceup(vm, 1, &userPtr, 0))) {
+        return sq_throwerror(vm, "updateInterval method needs an instance of Analyzer");
+    }
+    Analyzer *obj = static_cast<Analyzer*>(userPtr);
+    if(!obj) {
+        return sq_throwerror(vm, "updateInterval method called before Audio.Analyzer constructor");
+    }
+    // return value
+    SQFloat ret;
+    // 1 parameters passed in
+    if(numargs == 2) {
+
+        // get parameter 1 "milliseconds" as float
+        SQFloat milliseconds;
+        if (SQ_FAILED(sq_getfloat(vm, 2, &milliseconds))){
+            return sq_throwerror(vm, "argument 1 \"milliseconds\" is not of type float");
+        }
+
+        // call the implementation
+        try {
+            ret = obj->updateInterval(milliseconds);
+        }
+        catch(std::exception const& e) {
+            return sq_throwerror(vm, e.what());
+        }
+    }
+
+    else {
+        // call the implementation
+        try {
+            ret = obj->updateInterval();
+        }
+        catch(std::exception const& e) {
+            return sq_throwerror(vm, e.what());
+        }
+    }
+
+    // push return value
+    sq_pushfloat(vm, ret);
+    return 1;
+}
+
+//
+// Audio.Features class
+//
+SQInteger AudioFeaturesRelease(SQUserPointer p, SQInteger size)
+{
+    delete static_cast<Features*>(p);
+}
+
+SQInteger AudioFeaturesCtor(HSQUIRRELVM vm)
+{
+    return sq_throwerror(vm, "cannot directly instantiate Audio.Features");
+}
+
+//
+// Audio.Features centroid
+//
+SQInteger AudioFeaturescentroid(HSQUIRRELVM vm)
+{
+    SQInteger numargs = sq_gettop(vm);
+    // check parameter count
+    if(numargs > 1) {
+        return sq_throwerror(vm, "too many parameters, expected at most 0");
+    }
+    // get "this" pointer
+    SQUserPointer userPtr = 0;
+    if (SQ_FAILED(sq_getinstanceup(vm, 1, &userPtr, 0))) {
+        return sq_throwerror(vm, "centroid method needs an instance of Features");
+    }
+    Features *obj = static_cast<Features*>(userPtr);
+    if(!obj) {
+        return sq_throwerror(vm, "centroid method called before Audio.Features constructor");
+    }
+    // return value
+    SQFloat ret;
+    // call the implementation
+    try {
+        ret = obj->centroid();
+    }
+    catch(std::exception const& e) {
+        return sq_throwerror(vm, e.what());
+    }
+
+    // push return value
+    sq_pushfloat(vm, ret);
+    return 1;
+}
+
+//
+// Audio.Features flux
+//
+SQInteger AudioFeaturesflux(HSQUIRRELVM vm)
+{
+    SQInteger numargs = sq_gettop(vm);
+    // check parameter count
+    if(numargs > 1) {
+        return sq_throwerror(vm, "too many parameters, expected at most 0");
+    }
+    // get "this" pointer
+    SQUserPointer userPtr = 0;
+    if (SQ_FAILED(sq_getinstanceup(vm, 1, &userPtr, 0))) {
+        return sq_throwerror(vm, "flux method needs an instance of Features");
+    }
+    Features *obj = static_cast<Features*>(userPtr);
+    if(!obj) {
+        return sq_throwerror(vm, "flux method called before Audio.Features constructor");
+    }
+    // return value
+    SQFloat ret;
+    // call the implementation
+    try {
+        ret = obj->flux();
+    }
+    catch(std::exception const& e) {
+        return sq_throwerror(vm, e.what());
+    }
+
+    // push return value
+    sq_pushfloat(vm, ret);
+    return 1;
+}
+
+//
+// Audio.Features peak
+//
+SQInteger AudioFeaturespeak(HSQUIRRELVM vm)
+{
+    SQInteger numargs = sq_gettop(vm);
+    // check parameter count
+    if(numargs > 1) {
+        return sq_throwerror(vm, "too many parameters, expected at most 0");
+    }
+    // get "this" pointer
+    SQUserPointer userPtr = 0;
+    if (SQ_FAILED(sq_getinstanceup(vm, 1, &userPtr, 0))) {
+        return sq_throwerror(vm, "peak method needs an instance of Features");
+    }
+    Features *obj = static_cast<Features*>(userPtr);
+    if(!obj) {
+        return sq_throwerror(vm, "peak method called before Audio.Features constructor");
+    }
+    // return value
+    SQFloat ret;
+    // call the implementation
+    try {
+        ret = obj->peak();
+    }
+    catch(std::exception const& e) {
+        return sq_throwerror(vm, e.what());
+    }
+
+    // push return value
+    sq_pushfloat(vm, ret);
+    return 1;
+}
+
+//
+// Audio.Features pitch
+//
+SQInteger AudioFeaturespitch(HSQUIRRELVM vm)
+{
+    SQInteger numargs = sq_gettop(vm);
+    // check parameter count
+    if(numargs > 1) {
+        return sq_throwerror(vm, "too many parameters, expected at most 0");
+    }
+    // get "this" pointer
+    SQUserPointer userPtr = 0;
+    if (SQ_FAILED(sq_getinstanceup(vm, 1, &userPtr, 0))) {
+        return sq_throwerror(vm, "pitch method needs an instance of Features");
+    }
+    Features *obj = static_cast<Features*>(userPtr);
+    if(!obj) {
+        return sq_throwerror(vm, "pitch method called before Audio.Features constructor");
+    }
+    // return value
+    SQFloat ret;
+    // call the implementation
+    try {
+        ret = obj->pitch();
+    }
+    catch(std::exception const& e) {
+        return sq_throwerror(vm, e.what());
+    }
+
+    // push return value
+    sq_pushfloat(vm, ret);
+    return 1;
+}
+
+//
+// Audio.Features rms
+//
+SQInteger AudioFeaturesrms(HSQUIRRELVM vm)
+{
+    SQInteger numargs = sq_gettop(vm);
+    // check parameter count
+    if(numargs > 1) {
+        return sq_throwerror(vm, "too many parameters, expected at most 0");
+    }
+    // get "this" pointer
+    SQUserPointer userPtr = 0;
+    if (SQ_FAILED(sq_getinstanceup(vm, 1, &userPtr, 0))) {
+        return sq_throwerror(vm, "rms method needs an instance of Features");
+    }
+    Features *obj = static_cast<Features*>(userPtr);
+    if(!obj) {
+        return sq_throwerror(vm, "rms method called before Audio.Features constructor");
+    }
+    // return value
+    SQFloat ret;
+    // call the implementation
+    try {
+        ret = obj->rms();
+    }
+    catch(std::exception const& e) {
+        return sq_throwerror(vm, e.what());
+    }
+
+    // push return value
+    sq_pushfloat(vm, ret);
+    return 1;
+}
+
 
 void bindAudio(HSQUIRRELVM vm)
 {
@@ -1242,6 +1769,10 @@ void bindAudio(HSQUIRRELVM vm)
     sq_newclosure(vm, &AudioOnsetDetectorconnect, 0);
     sq_newslot(vm, -3, false);
 
+    sq_pushstring(vm, _SC("minInterval"), -1);
+    sq_newclosure(vm, &AudioOnsetDetectorminInterval, 0);
+    sq_newslot(vm, -3, false);
+
     sq_pushstring(vm, _SC("onOnset"), -1);
     sq_newclosure(vm, &AudioOnsetDetectoronOnset, 0);
     sq_newslot(vm, -3, false);
@@ -1250,6 +1781,10 @@ void bindAudio(HSQUIRRELVM vm)
     sq_newclosure(vm, &AudioOnsetDetectorthreshold, 0);
     sq_newslot(vm, -3, false);
 
+    sq_pushstring(vm, _SC("window"), -1);
+    sq_newclosure(vm, &AudioOnsetDetectorwindow, 0);
+    sq_newslot(vm, -3, false);
+
     // push OnsetDetector to Audio package table
     sq_newslot(vm, -3, false);
 
@@ -1393,6 +1928,82 @@ void bindAudio(HSQUIRRELVM vm)
     // push BeatTracker to Audio package table
     sq_newslot(vm, -3, false);
 
+    // create class Audio.Analyzer
+    sq_pushstring(vm, "Analyzer", -1);
+    sq_newclass(vm, false);
+    sq_getstackobj(vm, -1, &AudioAnalyzerObject);
+    sq_settypetag(vm, -1, &AudioAnalyzerObject);
+
+    // ctor for class Analyzer
+    sq_pushstring(vm, _SC("constructor"), -1);
+    sq_newclosure(vm, &AudioAnalyzerCtor, 0);
+    sq_newslot(vm, -3, false);
+
+    // clone for class Analyzer
+    sq_pushstring(vm, _SC("_cloned"), -1);
+    sq_newclosure(vm, &unclonable, 0);
+    sq_newslot(vm, -3, false);
+
+    // methods for class Analyzer
+    sq_pushstring(vm, _SC("connect"), -1);
+    sq_newclosure(vm, &AudioAnalyzerconnect, 0);
+    sq_newslot(vm, -3, false);
+
+    sq_pushstring(vm, _SC("features"), -1);
+    sq_newclosure(vm, &AudioAnalyzerfeatures, 0);
+    sq_newslot(vm, -3, false);
+
+    sq_pushstring(vm, _SC("onFeatures"), -1);
+    sq_newclosure(vm, &AudioAnalyzeronFeatures, 0);
+    sq_newslot(vm, -3, false);
+
+    sq_pushstring(vm, _SC("updateInterval"), -1);
+    sq_newclosure(vm, &AudioAnalyzerupdateInterval, 0);
+    sq_newslot(vm, -3, false);
+
+    // push Analyzer to Audio package table
+    sq_newslot(vm, -3, false);
+
+    // create class Audio.Features
+    sq_pushstring(vm, "Features", -1);
+    sq_newclass(vm, false);
+    sq_getstackobj(vm, -1, &AudioFeaturesObject);
+    sq_settypetag(vm, -1, &AudioFeaturesObject);
+
+    // ctor for class Features
+    sq_pushstring(vm, _SC("constructor"), -1);
+    sq_newclosure(vm, &AudioFeaturesCtor, 0);
+    sq_newslot(vm, -3, false);
+
+    // clone for class Features
+    sq_pushstring(vm, _SC("_cloned"), -1);
+    sq_newclosure(vm, &unclonable, 0);
+    sq_newslot(vm, -3, false);
+
+    // methods for class Features
+    sq_pushstring(vm, _SC("centroid"), -1);
+    sq_newclosure(vm, &AudioFeaturescentroid, 0);
+    sq_newslot(vm, -3, false);
+
+    sq_pushstring(vm, _SC("flux"), -1);
+    sq_newclosure(vm, &AudioFeaturesflux, 0);
+    sq_newslot(vm, -3, false);
+
+    sq_pushstring(vm, _SC("peak"), -1);
+    sq_newclosure(vm, &AudioFeaturespeak, 0);
+    sq_newslot(vm, -3, false);
+
+    sq_pushstring(vm, _SC("pitch"), -1);
+    sq_newclosure(vm, &AudioFeaturespitch, 0);
+    sq_newslot(vm, -3, false);
+
+    sq_pushstring(vm, _SC("rms"), -1);
+    sq_newclosure(vm, &AudioFeaturesrms, 0);
+    sq_newslot(vm, -3, false);
+
+    // push Features to Audio package table
+    sq_newslot(vm, -3, false);
+
     // push package "Audio" to root table
     sq_newslot(vm, -3, false);
 }
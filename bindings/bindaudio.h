@@ -23,6 +23,7 @@ namespace bipscript {
 
 namespace audio {
 class AudioConnection;
+class Features;
 }
 
 namespace binding
@@ -36,9 +37,12 @@ namespace binding
     extern HSQOBJECT AudioStereoInObject;
     extern HSQOBJECT AudioStereoOutObject;
     extern HSQOBJECT AudioBeatTrackerObject;
+    extern HSQOBJECT AudioAnalyzerObject;
+    extern HSQOBJECT AudioFeaturesObject;
     audio::AudioConnection *getAudioOutput(HSQUIRRELVM &vm, int index);
     // release hooks for types in this package
     SQInteger AudioStereoOutRelease(SQUserPointer p, SQInteger size);
+    SQInteger AudioFeaturesRelease(SQUserPointer p, SQInteger size);
     // method to bind this package
     void bindAudio(HSQUIRRELVM vm);
 }}
@@ -348,6 +348,89 @@ SQInteger Lv2PluginconnectMidi(HSQUIRRELVM vm)
     return 0;
 }
 
+//
+// Lv2.Plugin getOutput
+//
+SQInteger Lv2PlugingetOutput(HSQUIRRELVM vm)
+{
+    SQInteger numargs = sq_gettop(vm);
+    // check parameter count
+    if(numargs > 2) {
+        return sq_throwerror(vm, "too many parameters, expected at most 1");
+    }
+    if(numargs < 2) {
+        return sq_throwerror(vm, "insufficient parameters, expected at least 1");
+    }
+    // get "this" pointer
+    SQUserPointer userPtr = 0;
+    if (SQ_FAILED(sq_getinstanceup(vm, 1, &userPtr, 0))) {
+        return sq_throwerror(vm, "getOutput method needs an instance of Plugin");
+    }
+    Plugin *obj = static_cast<Plugin*>(userPtr);
+    if(!obj) {
+        return sq_throwerror(vm, "getOutput method called before Lv2.Plugin constructor");
+    }
+    // get parameter 1 "name" as string
+    const SQChar* name;
+    if (SQ_FAILED(sq_getstring(vm, 2, &name))){
+        return sq_throwerror(vm, "argument 1 \"name\" is not of type string");
+    }
+
+    // return value
+    SQFloat ret;
+    // call the implementation
+    try {
+        ret = obj->getOutput(name);
+    }
+    catch(std::exception const& e) {
+        return sq_throwerror(vm, e.what());
+    }
+
+    // push return value
+    sq_pushfloat(vm, ret);
+    return 1;
+}
+
+//
+// Lv2.Plugin humanize
+//
+SQInteger Lv2Pluginhumanize(HSQUIRRELVM vm)
+{
+    SQInteger numargs = sq_gettop(vm);
+    // check parameter count
+    if(numargs > 2) {
+        return sq_throwerror(vm, "too many parameters, expected at most 1");
+    }
+    if(numargs < 2) {
+        return sq_throwerror(vm, "insufficient parameters, expected at least 1");
+    }
+    // get "this" pointer
+    SQUserPointer userPtr = 0;
+    if (SQ_FAILED(sq_getinstanceup(vm, 1, &userPtr, 0))) {
+        return sq_throwerror(vm, "humanize method needs an instance of Plugin");
+    }
+    Plugin *obj = static_cast<Plugin*>(userPtr);
+    if(!obj) {
+        return sq_throwerror(vm, "humanize method called before Lv2.Plugin constructor");
+    }
+    // get parameter 1 "milliseconds" as float
+    SQFloat milliseconds;
+    if (SQ_FAILED(sq_getfloat(vm, 2, &milliseconds))){
+        return sq_throwerror(vm, "argument 1 \"milliseconds\" is not of type float");
+    }
+
+    // call the implementation
+    try {
+        obj->humanize(milliseconds);
+    }
+    catch(std::exception const& e) {
+        return sq_throwerror(vm, e.what());
+    }
+
+    // void method, returns no value
+    return 0;
+}
+
 //
 // Lv2.Plugin midiChannel
 //
@@ -591,6 +674,59 @@ SQInteger Lv2PluginonNoteOn(HSQUIRRELVM vm)
     return 0;
 }
 
+//
+// Lv2.Plugin onOutput
+//
+SQInteger Lv2PluginonOutput(HSQUIRRELVM vm)
+{
+    SQInteger numargs = sq_gettop(vm);
+    // check parameter count
+    if(numargs > 3) {
+        return sq_throwerror(vm, "too many parameters, expected at most 2");
+    }
+    if(numargs < 3) {
+        return sq_throwerror(vm, "insufficient parameters, expected at least 2");
+    }
+    // get "this" pointer
+    SQUserPointer userPtr = 0;
+    if (SQ_FAILED(sq_getinstanceup(vm, 1, &userPtr, 0))) {
+        return sq_throwerror(vm, "onOutput method needs an instance of Plugin");
+    }
+    Plugin *obj = static_cast<Plugin*>(userPtr);
+    if(!obj) {
+        return sq_throwerror(vm, "onOutput method called before Lv2.Plugin constructor");
+    }
+    // get parameter 1 "name" as string
+    const SQChar* name;
+    if (SQ_FAILED(sq_getstring(vm, 2, &name))){
+        return sq_throwerror(vm, "argument 1 \"name\" is not of type string");
+    }
+
+    // get parameter 2 "handler" as function
+    HSQOBJECT handlerObj;
+    if (SQ_FAILED(sq_getstackobj(vm, 3, &handlerObj))) {
+        return sq_throwerror(vm, "argument 2 \"handler\" is not of type function");
+    }
+    if (sq_gettype(vm, 3) != OT_CLOSURE) {
+        return sq_throwerror(vm, "argument 2 \"handler\" is not of type function");
+    }
+    SQUnsignedInteger nparams, nfreevars;
+    sq_getclosureinfo(vm, 3, &nparams, &nfreevars);
+    sq_addref(vm, &handlerObj);
+    ScriptFunction handler(vm, handlerObj, nparams);
+
+    // call the implementation
+    try {
+        obj->onOutput(name, handler);
+    }
+    catch(std::exception const& e) {
+        return sq_throwerror(vm, e.what());
+    }
+
+    // void method, returns no value
+    return 0;
+}
+
 //
 // Lv2.Plugin output
 //
@@ -639,6 +775,66 @@ SQInteger Lv2Pluginoutput(HSQUIRRELVM vm)
     return 1;
 }
 
+//
+// Lv2.Plugin quantize
+//
+SQInteger Lv2Pluginquantize(HSQUIRRELVM vm)
+{
+    SQInteger numargs = sq_gettop(vm);
+    // check parameter count
+    if(numargs > 3) {
+        return sq_throwerror(vm, "too many parameters, expected at most 2");
+    }
+    if(numargs < 2) {
+        return sq_throwerror(vm, "insufficient parameters, expected at least 1");
+    }
+    // get "this" pointer
+    SQUserPointer userPtr = 0;
+    if (SQ_FAILED(sq_getinstanceup(vm, 1, &userPtr, 0))) {
+        return sq_throwerror(vm, "quantize method needs an instance of Plugin");
+    }
+    Plugin *obj = static_cast<Plugin*>(userPtr);
+    if(!obj) {
+        return sq_throwerror(vm, "quantize method called before Lv2.Plugin constructor");
+    }
+    // get parameter 1 "division" as integer
+    SQInteger division;
+    if (SQ_FAILED(sq_getinteger(vm, 2, &division))){
+        return sq_throwerror(vm, "argument 1 \"division\" is not of type integer");
+    }
+
+    // 2 parameters passed in
+    if(numargs == 3) {
+
+        // get parameter 2 "strength" as float
+        SQFloat strength;
+        if (SQ_FAILED(sq_getfloat(vm, 3, &strength))){
+            return sq_throwerror(vm, "argument 2 \"strength\" is not of type float");
+        }
+
+        // call the implementation
+        try {
+            obj->quantize(division, strength);
+        }
+        catch(std::exception const& e) {
+            return sq_throwerror(vm, e.what());
+        }
+    }
+
+    else {
+        // call the implementation
+        try {
+            obj->quantize(division);
+        }
+        catch(std::exception const& e) {
+            return sq_throwerror(vm, e.what());
+        }
+    }
+
+    // void method, returns no value
+    return 0;
+}
+
 //
 // Lv2.Plugin schedule
 //
@@ -1087,6 +1283,91 @@ SQInteger Lv2PluginsetControl(HSQUIRRELVM vm)
     return 0;
 }
 
+//
+// Lv2.Plugin splitBlocks
+//
+SQInteger Lv2PluginsplitBlocks(HSQUIRRELVM vm)
+{
+    SQInteger numargs = sq_gettop(vm);
+    // check parameter count
+    if(numargs > 2) {
+        return sq_throwerror(vm, "too many parameters, expected at most 1");
+    }
+    if(numargs < 2) {
+        return sq_throwerror(vm, "insufficient parameters, expected at least 1");
+    }
+    // get "this" pointer
+    SQUserPointer userPtr = 0;
+    if (SQ_FAILED(sq_getinstanceup(vm, 1, &userPtr, 0))) {
+        return sq_throwerror(vm, "splitBlocks method needs an instance of Plugin");
+    }
+    Plugin *obj = static_cast<Plugin*>(userPtr);
+    if(!obj) {
+        return sq_throwerror(vm, "splitBlocks method called before Lv2.Plugin constructor");
+    }
+    // get parameter 1 "minimum" as integer
+    SQInteger minimum;
+    if (SQ_FAILED(sq_getinteger(vm, 2, &minimum))){
+        return sq_throwerror(vm, "argument 1 \"minimum\" is not of type integer");
+    }
+
+    // call the implementation
+    try {
+        obj->setSplitBlocks(minimum);
+    }
+    catch(std::exception const& e) {
+        return sq_throwerror(vm, e.what());
+    }
+
+    // void method, returns no value
+    return 0;
+}
+
+//
+// Lv2.Plugin swing
+//
+SQInteger Lv2Pluginswing(HSQUIRRELVM vm)
+{
+    SQInteger numargs = sq_gettop(vm);
+    // check parameter count
+    if(numargs > 3) {
+        return sq_throwerror(vm, "too many parameters, expected at most 2");
+    }
+    if(numargs < 3) {
+        return sq_throwerror(vm, "insufficient parameters, expected at least 2");
+    }
+    // get "this" pointer
+    SQUserPointer userPtr = 0;
+    if (SQ_FAILED(sq_getinstanceup(vm, 1, &userPtr, 0))) {
+        return sq_throwerror(vm, "swing method needs an instance of Plugin");
+    }
+    Plugin *obj = static_cast<Plugin*>(userPtr);
+    if(!obj) {
+        return sq_throwerror(vm, "swing method called before Lv2.Plugin constructor");
+    }
+    // get parameter 1 "division" as integer
+    SQInteger division;
+    if (SQ_FAILED(sq_getinteger(vm, 2, &division))){
+        return sq_throwerror(vm, "argument 1 \"division\" is not of type integer");
+    }
+    // get parameter 2 "amount" as float
+    SQFloat amount;
+    if (SQ_FAILED(sq_getfloat(vm, 3, &amount))){
+        return sq_throwerror(vm, "argument 2 \"amount\" is not of type float");
+    }
+
+    // call the implementation
+    try {
+        obj->swing(division, amount);
+    }
+    catch(std::exception const& e) {
+        return sq_throwerror(vm, e.what());
+    }
+
+    // void method, returns no value
+    return 0;
+}
+
 //
 // Lv2.State class
 //
@@ -1219,6 +1500,14 @@ void bindLv2(HSQUIRRELVM vm)
     sq_newclosure(vm, &Lv2PluginconnectMidi, 0);
     sq_newslot(vm, -3, false);
 
+    sq_pushstring(vm, _SC("getOutput"), -1);
+    sq_newclosure(vm, &Lv2PlugingetOutput, 0);
+    sq_newslot(vm, -3, false);
+
+    sq_pushstring(vm, _SC("humanize"), -1);
+    sq_newclosure(vm, &Lv2Pluginhumanize, 0);
+    sq_newslot(vm, -3, false);
+
     sq_pushstring(vm, _SC("midiChannel"), -1);
     sq_newclosure(vm, &Lv2PluginmidiChannel, 0);
     sq_newslot(vm, -3, false);
@@ -1239,10 +1528,18 @@ void bindLv2(HSQUIRRELVM vm)
     sq_newclosure(vm, &Lv2PluginonNoteOn, 0);
     sq_newslot(vm, -3, false);
 
+    sq_pushstring(vm, _SC("onOutput"), -1);
+    sq_newclosure(vm, &Lv2PluginonOutput, 0);
+    sq_newslot(vm, -3, false);
+
     sq_pushstring(vm, _SC("output"), -1);
     sq_newclosure(vm, &Lv2Pluginoutput, 0);
     sq_newslot(vm, -3, false);
 
+    sq_pushstring(vm, _SC("quantize"), -1);
+    sq_newclosure(vm, &Lv2Pluginquantize, 0);
+    sq_newslot(vm, -3, false);
+
     sq_pushstring(vm, _SC("schedule"), -1);
     sq_newclosure(vm, &Lv2Pluginschedule, 0);
     sq_newslot(vm, -3, false);
@@ -1255,6 +1552,14 @@ void bindLv2(HSQUIRRELVM vm)
     sq_newclosure(vm, &Lv2PluginsetControl, 0);
     sq_newslot(vm, -3, false);
 
+    sq_pushstring(vm, _SC("splitBlocks"), -1);
+    sq_newclosure(vm, &Lv2PluginsplitBlocks, 0);
+    sq_newslot(vm, -3, false);
+
+    sq_pushstring(vm, _SC("swing"), -1);
+    sq_newclosure(vm, &Lv2Pluginswing, 0);
+    sq_newslot(vm, -3, false);
+
     // push Plugin to Lv2 package table
     sq_newslot(vm, -3, false);
 
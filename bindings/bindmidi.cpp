@@ -28,6 +28,11 @@
 #include "mmlreader.h"
 #include "miditune.h"
 #include "beattracker.h"
+#include "midiloop.h"
+#include "smfreader.h"
+#include "smfwriter.h"
+#include "midirouter.h"
+#include "midiclock.h"
 #include <stdexcept>
 #include <cstring>
 
@@ -52,7 +57,14 @@ HSQOBJECT MidiTuneObject;
 HSQOBJECT MidiSystemOutObject;
 HSQOBJECT MidiPitchBendObject;
 HSQOBJECT MidiProgramChangeObject;
+HSQOBJECT MidiSysExObject;
 HSQOBJECT MidiBeatTrackerObject;
+HSQOBJECT MidiLoopObject;
+HSQOBJECT MidiSMFReaderObject;
+HSQOBJECT MidiSMFWriterObject;
+HSQOBJECT MidiRouterObject;
+HSQOBJECT MidiClockOutObject;
+HSQOBJECT MidiClockInObject;
 
 //
 // Midi abc
@@ -1789,6 +1801,46 @@ SQInteger MidiPatternadd(HSQUIRRELVM vm)
     return 0;
 }
 
+//
+// Midi.Pattern merge
+//
+SQInteger MidiPatternmerge(HSQUIRRELVM vm)
+{
+    SQInteger numargs = sq_gettop(vm);
+    // check parameter count
+    if(numargs > 2) {
+        return sq_throwerror(vm, "too many parameters, expected at most 1");
+    }
+    if(numargs < 2) {
+        return sq_throwerror(vm, "insufficient parameters, expected at least 1");
+    }
+    // get "this" pointer
+    SQUserPointer userPtr = 0;
+    if (SQ_FAILED(sq_getinstanceup(vm, 1, &userPtr, 0))) {
+        return sq_throwerror(vm, "merge method needs an instance of Pattern");
+    }
+    Pattern *obj = static_cast<Pattern*>(userPtr);
+    if(!obj) {
+        return sq_throwerror(vm, "merge method called before Midi.Pattern constructor");
+    }
+    // get parameter 1 "pattern" as Midi.Pattern
+    Pattern *pattern = getMidiPattern(vm, 2);
+    if(pattern == 0) {
+        return sq_throwerror(vm, "argument 1 \"pattern\" is not of type Midi.Pattern");
+    }
+
+    // call the implementation
+    try {
+        obj->merge(*pattern);
+    }
+    catch(std::exception const& e) {
+        return sq_throwerror(vm, e.what());
+    }
+
+    // void method, returns no value
+    return 0;
+}
+
 //
 // Midi.Pattern note
 //
@@ -1832,7 +1884,7 @@ SQInteger MidiPatternnote(HSQUIRRELVM vm)
     sq_createinstance(vm, -1);
     sq_remove(vm, -2);
     sq_setinstanceup(vm, -1, ret);
-    // no release hook, release ignored per binding
+    sq_setreleasehook(vm, -1, &MidiNoteRelease);
 
     return 1;
 }
@@ -1868,6 +1920,146 @@ SQInteger MidiPatternprint(HSQUIRRELVM vm)
     return 0;
 }
 
+//
+// Midi.Pattern quantize
+//
+SQInteger MidiPatternquantize(HSQUIRRELVM vm)
+{
+    SQInteger numargs = sq_gettop(vm);
+    // check parameter count
+    if(numargs > 2) {
+        return sq_throwerror(vm, "too many parameters, expected at most 1");
+    }
+    if(numargs < 2) {
+        return sq_throwerror(vm, "insufficient parameters, expected at least 1");
+    }
+    // get "this" pointer
+    SQUserPointer userPtr = 0;
+    if (SQ_FAILED(sq_getinstanceup(vm, 1, &userPtr, 0))) {
+        return sq_throwerror(vm, "quantize method needs an instance of Pattern");
+    }
+    Pattern *obj = static_cast<Pattern*>(userPtr);
+    if(!obj) {
+        return sq_throwerror(vm, "quantize method called before Midi.Pattern constructor");
+    }
+    // get parameter 1 "division" as integer
+    SQInteger division;
+    if (SQ_FAILED(sq_getinteger(vm, 2, &division))){
+        return sq_throwerror(vm, "argument 1 \"division\" is not of type integer");
+    }
+
+    // call the implementation
+    try {
+        obj->quantize(division);
+    }
+    catch(std::exception const& e) {
+        return sq_throwerror(vm, e.what());
+    }
+
+    // void method, returns no value
+    return 0;
+}
+
+//
+// Midi.Pattern scaleVelocity
+//
+SQInteger MidiPatternscaleVelocity(HSQUIRRELVM vm)
+{
+    SQInteger numargs = sq_gettop(vm);
+    // check parameter count
+    if(numargs > 2) {
+        return sq_throwerror(vm, "too many parameters, expected at most 1");
+    }
+    if(numargs < 2) {
+        return sq_throwerror(vm, "insufficient parameters, expected at least 1");
+    }
+    // get "this" pointer
+    SQUserPointer userPtr = 0;
+    if (SQ_FAILED(sq_getinstanceup(vm, 1, &userPtr, 0))) {
+        return sq_throwerror(vm, "scaleVelocity method needs an instance of Pattern");
+    }
+    Pattern *obj = static_cast<Pattern*>(userPtr);
+    if(!obj) {
+        return sq_throwerror(vm, "scaleVelocity method called before Midi.Pattern constructor");
+    }
+    // get parameter 1 "factor" as float
+    SQFloat factor;
+    if (SQ_FAILED(sq_getfloat(vm, 2, &factor))){
+        return sq_throwerror(vm, "argument 1 \"factor\" is not of type float");
+    }
+
+    // call the implementation
+    try {
+        obj->scaleVelocity(factor);
+    }
+    catch(std::exception const& e) {
+        return sq_throwerror(vm, e.what());
+    }
+
+    // void method, returns no value
+    return 0;
+}
+
+//
+// Midi.Pattern shift
+//
+SQInteger MidiPatternshift(HSQUIRRELVM vm)
+{
+    SQInteger numargs = sq_gettop(vm);
+    // check parameter count
+    if(numargs > 3) {
+        return sq_throwerror(vm, "too many parameters, expected at most 2");
+    }
+    if(numargs < 2) {
+        return sq_throwerror(vm, "insufficient parameters, expected at least 1");
+    }
+    // get "this" pointer
+    SQUserPointer userPtr = 0;
+    if (SQ_FAILED(sq_getinstanceup(vm, 1, &userPtr, 0))) {
+        return sq_throwerror(vm, "shift method needs an instance of Pattern");
+    }
+    Pattern *obj = static_cast<Pattern*>(userPtr);
+    if(!obj) {
+        return sq_throwerror(vm, "shift method called before Midi.Pattern constructor");
+    }
+    // get parameter 1 "position" as integer
+    SQInteger position;
+    if (SQ_FAILED(sq_getinteger(vm, 2, &position))){
+        return sq_throwerror(vm, "argument 1 \"position\" is not of type integer");
+    }
+
+    // 2 parameters passed in
+    if(numargs == 3) {
+
+        // get parameter 2 "division" as integer
+        SQInteger division;
+        if (SQ_FAILED(sq_getinteger(vm, 3, &division))){
+            return sq_throwerror(vm, "argument 2 \"division\" is not of type integer");
+        }
+
+        // call the implementation
+        try {
+            obj->shift(position, division);
+        }
+        catch(std::exception const& e) {
+            return sq_throwerror(vm, e.what());
+        }
+    }
+
+    else {
+        // call the implementation
+        try {
+            obj->shift(position);
+        }
+        catch(std::exception const& e) {
+            return sq_throwerror(vm, e.what());
+        }
+    }
+
+    // void method, returns no value
+    return 0;
+}
+
 //
 // Midi.Pattern size
 //
@@ -2200,6 +2392,86 @@ SQInteger MidiSystemOutCtor(HSQUIRRELVM vm)
     return 1;
 }
 
+//
+// Midi.SystemOut connectMidi
+//
+SQInteger MidiSystemOutconnectMidi(HSQUIRRELVM vm)
+{
+    SQInteger numargs = sq_gettop(vm);
+    // check parameter count
+    if(numargs > 2) {
+        return sq_throwerror(vm, "too many parameters, expected at most 1");
+    }
+    if(numargs < 2) {
+        return sq_throwerror(vm, "insufficient parameters, expected at least 1");
+    }
+    // get "this" pointer
+    SQUserPointer userPtr = 0;
+    if (SQ_FAILED(sq_getinstanceup(vm, 1, &userPtr, 0))) {
+        return sq_throwerror(vm, "connectMidi method needs an instance of SystemOut");
+    }
+    MidiOutputPort *obj = static_cast<MidiOutputPort*>(userPtr);
+    if(!obj) {
+        return sq_throwerror(vm, "connectMidi method called before Midi.SystemOut constructor");
+    }
+    // get parameter 1 "source" as Midi.Source
+    midi::Source *source = getMidiSource(vm, 2);
+    if(source == 0) {
+        return sq_throwerror(vm, "argument 1 \"source\" is not of type Midi.Source");
+    }
+
+    // call the implementation
+    try {
+        obj->connectMidi(*source);
+    }
+    catch(std::exception const& e) {
+        return sq_throwerror(vm, e.what());
+    }
+
+    // void method, returns no value
+    return 0;
+}
+
+//
+// Midi.SystemOut humanize
+//
+SQInteger MidiSystemOuthumanize(HSQUIRRELVM vm)
+{
+    SQInteger numargs = sq_gettop(vm);
+    // check parameter count
+    if(numargs > 2) {
+        return sq_throwerror(vm, "too many parameters, expected at most 1");
+    }
+    if(numargs < 2) {
+        return sq_throwerror(vm, "insufficient parameters, expected at least 1");
+    }
+    // get "this" pointer
+    SQUserPointer userPtr = 0;
+    if (SQ_FAILED(sq_getinstanceup(vm, 1, &userPtr, 0))) {
+        return sq_throwerror(vm, "humanize method needs an instance of SystemOut");
+    }
+    MidiOutputPort *obj = static_cast<MidiOutputPort*>(userPtr);
+    if(!obj) {
+        return sq_throwerror(vm, "humanize method called before Midi.SystemOut constructor");
+    }
+    // get parameter 1 "milliseconds" as float
+    SQFloat milliseconds;
+    if (SQ_FAILED(sq_getfloat(vm, 2, &milliseconds))){
+        return sq_throwerror(vm, "argument 1 \"milliseconds\" is not of type float");
+    }
+
+    // call the implementation
+    try {
+        obj->humanize(milliseconds);
+    }
+    catch(std::exception const& e) {
+        return sq_throwerror(vm, e.what());
+    }
+
+    // void method, returns no value
+    return 0;
+}
+
 //
 // Midi.SystemOut midiChannel
 //
@@ -2254,6 +2526,66 @@ SQInteger MidiSystemOutmidiChannel(HSQUIRRELVM vm)
     return 1;
 }
 
+//
+// Midi.SystemOut quantize
+//
+SQInteger MidiSystemOutquantize(HSQUIRRELVM vm)
+{
+    SQInteger numargs = sq_gettop(vm);
+    // check parameter count
+    if(numargs > 3) {
+        return sq_throwerror(vm, "too many parameters, expected at most 2");
+    }
+    if(numargs < 2) {
+        return sq_throwerror(vm, "insufficient parameters, expected at least 1");
+    }
+    // get "this" pointer
+    SQUserPointer userPtr = 0;
+    if (SQ_FAILED(sq_getinstanceup(vm, 1, &userPtr, 0))) {
+        return sq_throwerror(vm, "quantize method needs an instance of SystemOut");
+    }
+    MidiOutputPort *obj = static_cast<MidiOutputPort*>(userPtr);
+    if(!obj) {
+        return sq_throwerror(vm, "quantize method called before Midi.SystemOut constructor");
+    }
+    // get parameter 1 "division" as integer
+    SQInteger division;
+    if (SQ_FAILED(sq_getinteger(vm, 2, &division))){
+        return sq_throwerror(vm, "argument 1 \"division\" is not of type integer");
+    }
+
+    // 2 parameters passed in
+    if(numargs == 3) {
+
+        // get parameter 2 "strength" as float
+        SQFloat strength;
+        if (SQ_FAILED(sq_getfloat(vm, 3, &strength))){
+            return sq_throwerror(vm, "argument 2 \"strength\" is not of type float");
+        }
+
+        // call the implementation
+        try {
+            obj->quantize(division, strength);
+        }
+        catch(std::exception const& e) {
+            return sq_throwerror(vm, e.what());
+        }
+    }
+
+    else {
+        // call the implementation
+        try {
+            obj->quantize(division);
+        }
+        catch(std::exception const& e) {
+            return sq_throwerror(vm, e.what());
+        }
+    }
+
+    // void method, returns no value
+    return 0;
+}
+
 //
 // Midi.SystemOut schedule
 //
@@ -2592,6 +2924,51 @@ SQInteger MidiSystemOutschedule(HSQUIRRELVM vm)
     }
 }
 
+//
+// Midi.SystemOut swing
+//
+SQInteger MidiSystemOutswing(HSQUIRRELVM vm)
+{
+    SQInteger numargs = sq_gettop(vm);
+    // check parameter count
+    if(numargs > 3) {
+        return sq_throwerror(vm, "too many parameters, expected at most 2");
+    }
+    if(numargs < 3) {
+        return sq_throwerror(vm, "insufficient parameters, expected at least 2");
+    }
+    // get "this" pointer
+    SQUserPointer userPtr = 0;
+    if (SQ_FAILED(sq_getinstanceup(vm, 1, &userPtr, 0))) {
+        return sq_throwerror(vm, "swing method needs an instance of SystemOut");
+    }
+    MidiOutputPort *obj = static_cast<MidiOutputPort*>(userPtr);
+    if(!obj) {
+        return sq_throwerror(vm, "swing method called before Midi.SystemOut constructor");
+    }
+    // get parameter 1 "division" as integer
+    SQInteger division;
+    if (SQ_FAILED(sq_getinteger(vm, 2, &division))){
+        return sq_throwerror(vm, "argument 1 \"division\" is not of type integer");
+    }
+    // get parameter 2 "amount" as float
+    SQFloat amount;
+    if (SQ_FAILED(sq_getfloat(vm, 3, &amount))){
+        return sq_throwerror(vm, "argument 2 \"amount\" is not of type float");
+    }
+
+    // call the implementation
+    try {
+        obj->swing(division, amount);
+    }
+    catch(std::exception const& e) {
+        return sq_throwerror(vm, e.what());
+    }
+
+    // void method, returns no value
+    return 0;
+}
+
 //
 // Midi.PitchBend class
 //
@@ -2692,6 +3069,60 @@ SQInteger MidiProgramChangeClone(HSQUIRRELVM vm)
     return 0;
 }
 
+//
+// Midi.SysEx class
+//
+SQInteger MidiSysExRelease(SQUserPointer p, SQInteger size)
+{
+    delete static_cast<SysEx*>(p);
+}
+
+SQInteger MidiSysExCtor(HSQUIRRELVM vm)
+{
+    SQInteger numargs = sq_gettop(vm);
+    // check parameter count
+    if(numargs > 2) {
+        return sq_throwerror(vm, "too many parameters, expected at most 1");
+    }
+    if(numargs < 2) {
+        return sq_throwerror(vm, "insufficient parameters, expected at least 1");
+    }
+    // get parameter 1 "data" as array
+    HSQOBJECT dataObj;
+    if (SQ_FAILED(sq_getstackobj(vm, 2, &dataObj))) {
+        return sq_throwerror(vm, "argument 1 \"data\" is not of type array");
+    }
+    if (sq_gettype(vm, 2) != OT_ARRAY) {
+        return sq_throwerror(vm, "argument 1 \"data\" is not of type array");
+    }
+    ScriptArray data(vm, dataObj);
+
+    SysEx *obj;
+    // call the implementation
+    try {
+        obj = new SysEx(data);
+    }
+    catch(std::exception const& e) {
+        return sq_throwerror(vm, e.what());
+    }
+
+    // return pointer to new object
+    sq_setinstanceup(vm, 1, (SQUserPointer*)obj);
+    sq_setreleasehook(vm, 1, MidiSysExRelease);
+    return 1;
+}
+
+SQInteger MidiSysExClone(HSQUIRRELVM vm)
+{
+    // get instance ptr of original
+    SQUserPointer userPtr;
+    sq_getinstanceup(vm, 2, &userPtr, 0);
+    // set instance ptr to a copy
+    sq_setinstanceup(vm, 1, new SysEx(*(SysEx*)userPtr));
+    sq_setreleasehook(vm, 1, &MidiSysExRelease);
+    return 0;
+}
+
 //
 // Midi.BeatTracker class
 //
@@ -2849,6 +3280,132 @@ SQInteger MidiBeatTrackercountIn(HSQUIRRELVM vm)
     return 0;
 }
 
+//
+// Midi.BeatTracker countInVelocity
+//
+SQInteger MidiBeatTrackercountInVelocity(HSQUIRRELVM vm)
+{
+    SQInteger numargs = sq_gettop(vm);
+    // check parameter count
+    if(numargs > 3) {
+        return sq_throwerror(vm, "too many parameters, expected at most 2");
+    }
+    if(numargs < 3) {
+        return sq_throwerror(vm, "insufficient parameters, expected at least 2");
+    }
+    // get "this" pointer
+    SQUserPointer userPtr = 0;
+    if (SQ_FAILED(sq_getinstanceup(vm, 1, &userPtr, 0))) {
+        return sq_throwerror(vm, "countInVelocity method needs an instance of BeatTracker");
+    }
+    BeatTracker *obj = static_cast<BeatTracker*>(userPtr);
+    if(!obj) {
+        return sq_throwerror(vm, "countInVelocity method called before Midi.BeatTracker constructor");
+    }
+    // get parameter 1 "minimum" as integer
+    SQInteger minimum;
+    if (SQ_FAILED(sq_getinteger(vm, 2, &minimum))){
+        return sq_throwerror(vm, "argument 1 \"minimum\" is not of type integer");
+    }
+
+    // get parameter 2 "maximum" as integer
+    SQInteger maximum;
+    if (SQ_FAILED(sq_getinteger(vm, 3, &maximum))){
+        return sq_throwerror(vm, "argument 2 \"maximum\" is not of type integer");
+    }
+
+    // call the implementation
+    try {
+        obj->countInVelocity(minimum, maximum);
+    }
+    catch(std::exception const& e) {
+        return sq_throwerror(vm, e.what());
+    }
+
+    // void method, returns no value
+    return 0;
+}
+
+//
+// Midi.BeatTracker countInWindow
+//
+SQInteger MidiBeatTrackercountInWindow(HSQUIRRELVM vm)
+{
+    SQInteger numargs = sq_gettop(vm);
+    // check parameter count
+    if(numargs > 2) {
+        return sq_throwerror(vm, "too many parameters, expected at most 1");
+    }
+    if(numargs < 2) {
+        return sq_throwerror(vm, "insufficient parameters, expected at least 1");
+    }
+    // get "this" pointer
+    SQUserPointer userPtr = 0;
+    if (SQ_FAILED(sq_getinstanceup(vm, 1, &userPtr, 0))) {
+        return sq_throwerror(vm, "countInWindow method needs an instance of BeatTracker");
+    }
+    BeatTracker *obj = static_cast<BeatTracker*>(userPtr);
+    if(!obj) {
+        return sq_throwerror(vm, "countInWindow method called before Midi.BeatTracker constructor");
+    }
+    // get parameter 1 "percent" as integer
+    SQInteger percent;
+    if (SQ_FAILED(sq_getinteger(vm, 2, &percent))){
+        return sq_throwerror(vm, "argument 1 \"percent\" is not of type integer");
+    }
+
+    // call the implementation
+    try {
+        obj->countInWindow(percent);
+    }
+    catch(std::exception const& e) {
+        return sq_throwerror(vm, e.what());
+    }
+
+    // void method, returns no value
+    return 0;
+}
+
+//
+// Midi.BeatTracker hopSize
+//
+SQInteger MidiBeatTrackerhopSize(HSQUIRRELVM vm)
+{
+    SQInteger numargs = sq_gettop(vm);
+    // check parameter count
+    if(numargs > 2) {
+        return sq_throwerror(vm, "too many parameters, expected at most 1");
+    }
+    if(numargs < 2) {
+        return sq_throwerror(vm, "insufficient parameters, expected at least 1");
+    }
+    // get "this" pointer
+    SQUserPointer userPtr = 0;
+    if (SQ_FAILED(sq_getinstanceup(vm, 1, &userPtr, 0))) {
+        return sq_throwerror(vm, "hopSize method needs an instance of BeatTracker");
+    }
+    BeatTracker *obj = static_cast<BeatTracker*>(userPtr);
+    if(!obj) {
+        return sq_throwerror(vm, "hopSize method called before Midi.BeatTracker constructor");
+    }
+    // get parameter 1 "frames" as integer
+    SQInteger frames;
+    if (SQ_FAILED(sq_getinteger(vm, 2, &frames))){
+        return sq_throwerror(vm, "argument 1 \"frames\" is not of type integer");
+    }
+
+    // call the implementation
+    try {
+        obj->setHopSize(frames);
+    }
+    catch(std::exception const& e) {
+        return sq_throwerror(vm, e.what());
+    }
+
+    // void method, returns no value
+    return 0;
+}
+
 //
 // Midi.BeatTracker noteWeight
 //
@@ -2969,30 +3526,1918 @@ SQInteger MidiBeatTrackeronCount(HSQUIRRELVM vm)
     if (SQ_FAILED(sq_getstackobj(vm, 2, &handlerObj))) {
         return sq_throwerror(vm, "argument 1 \"handler\" is not of type function");
     }
-    if (sq_gettype(vm, 2) != OT_CLOSURE) {
-        return sq_throwerror(vm, "argument 1 \"handler\" is not of type function");
+    if (sq_gettype(vm, 2) != OT_CLOSURE) {
+        return sq_throwerror(vm, "argument 1 \"handler\" is not of type function");
+    }
+    SQUnsignedInteger nparams, nfreevars;
+    sq_getclosureinfo(vm, 2, &nparams, &nfreevars);
+    sq_addref(vm, &handlerObj);
+    ScriptFunction handler(vm, handlerObj, nparams);
+
+    // call the implementation
+    try {
+        obj->onCount(handler);
+    }
+    catch(std::exception const& e) {
+        return sq_throwerror(vm, e.what());
+    }
+
+    // void method, returns no value
+    return 0;
+}
+
+//
+// Midi.BeatTracker stopOnSilence
+//
+SQInteger MidiBeatTrackerstopOnSilence(HSQUIRRELVM vm)
+{
+    SQInteger numargs = sq_gettop(vm);
+    // check parameter count
+    if(numargs > 2) {
+        return sq_throwerror(vm, "too many parameters, expected at most 1");
+    }
+    if(numargs < 2) {
+        return sq_throwerror(vm, "insufficient parameters, expected at least 1");
+    }
+    // get "this" pointer
+    SQUserPointer userPtr = 0;
+    if (SQ_FAILED(sq_getinstanceup(vm, 1, &userPtr, 0))) {
+        return sq_throwerror(vm, "stopOnSilence method needs an instance of BeatTracker");
+    }
+    BeatTracker *obj = static_cast<BeatTracker*>(userPtr);
+    if(!obj) {
+        return sq_throwerror(vm, "stopOnSilence method called before Midi.BeatTracker constructor");
+    }
+    // get parameter 1 "seconds" as integer
+    SQInteger seconds;
+    if (SQ_FAILED(sq_getinteger(vm, 2, &seconds))){
+        return sq_throwerror(vm, "argument 1 \"seconds\" is not of type integer");
+    }
+
+    // call the implementation
+    try {
+        obj->stopOnSilence(seconds);
+    }
+    catch(std::exception const& e) {
+        return sq_throwerror(vm, e.what());
+    }
+
+    // void method, returns no value
+    return 0;
+}
+
+//
+// Midi.Loop class
+//
+SQInteger MidiLoopCtor(HSQUIRRELVM vm)
+{
+    SQInteger numargs = sq_gettop(vm);
+    // check parameter count
+    if(numargs > 2) {
+        return sq_throwerror(vm, "too many parameters, expected at most 1");
+    }
+    if(numargs < 2) {
+        return sq_throwerror(vm, "insufficient parameters, expected at least 1");
+    }
+    // get parameter 1 "bars" as integer
+    SQInteger bars;
+    if (SQ_FAILED(sq_getinteger(vm, 2, &bars))){
+        return sq_throwerror(vm, "argument 1 \"bars\" is not of type integer");
+    }
+
+    Loop *obj;
+    // call the implementation
+    try {
+        obj = midi::LoopCache::instance().getLoop(bars);
+    }
+    catch(std::exception const& e) {
+        return sq_throwerror(vm, e.what());
+    }
+
+    // return pointer to new object
+    sq_setinstanceup(vm, 1, (SQUserPointer*)obj);
+    return 1;
+}
+
+//
+// Midi.Loop midiOutput
+//
+SQInteger MidiLoopmidiOutput(HSQUIRRELVM vm)
+{
+    SQInteger numargs = sq_gettop(vm);
+    // check parameter count
+    if(numargs > 2) {
+        return sq_throwerror(vm, "too many parameters, expected at most 1");
+    }
+    if(numargs < 2) {
+        return sq_throwerror(vm, "insufficient parameters, expected at least 1");
+    }
+    // get "this" pointer
+    SQUserPointer userPtr = 0;
+    if (SQ_FAILED(sq_getinstanceup(vm, 1, &userPtr, 0))) {
+        return sq_throwerror(vm, "midiOutput method needs an instance of Loop");
+    }
+    Loop *obj = static_cast<Loop*>(userPtr);
+    if(!obj) {
+        return sq_throwerror(vm, "midiOutput method called before Midi.Loop constructor");
+    }
+    // get parameter 1 "index" as integer
+    SQInteger index;
+    if (SQ_FAILED(sq_getinteger(vm, 2, &index))){
+        return sq_throwerror(vm, "argument 1 \"index\" is not of type integer");
+    }
+
+    // return value
+    midi::MidiConnection* ret;
+    // call the implementation
+    try {
+        ret = obj->getMidiConnection(index);
+    }
+    catch(std::exception const& e) {
+        return sq_throwerror(vm, e.what());
+    }
+
+    // push return value
+    sq_pushobject(vm, MidiOutputObject);
+    sq_createinstance(vm, -1);
+    sq_remove(vm, -2);
+    sq_setinstanceup(vm, -1, ret);
+    // no release hook, release ignored per binding
+
+    return 1;
+}
+
+//
+// Midi.Loop onControl
+//
+SQInteger MidiLooponControl(HSQUIRRELVM vm)
+{
+    SQInteger numargs = sq_gettop(vm);
+    // check parameter count
+    if(numargs > 2) {
+        return sq_throwerror(vm, "too many parameters, expected at most 1");
+    }
+    if(numargs < 2) {
+        return sq_throwerror(vm, "insufficient parameters, expected at least 1");
+    }
+    // get "this" pointer
+    SQUserPointer userPtr = 0;
+    if (SQ_FAILED(sq_getinstanceup(vm, 1, &userPtr, 0))) {
+        return sq_throwerror(vm, "onControl method needs an instance of Loop");
+    }
+    Loop *obj = static_cast<Loop*>(userPtr);
+    if(!obj) {
+        return sq_throwerror(vm, "onControl method called before Midi.Loop constructor");
+    }
+    // get parameter 1 "handler" as function
+    HSQOBJECT handlerObj;
+    if (SQ_FAILED(sq_getstackobj(vm, 2, &handlerObj))) {
+        return sq_throwerror(vm, "argument 1 \"handler\" is not of type function");
+    }
+    if (sq_gettype(vm, 2) != OT_CLOSURE) {
+        return sq_throwerror(vm, "argument 1 \"handler\" is not of type function");
+    }
+    SQUnsignedInteger nparams, nfreevars;
+    sq_getclosureinfo(vm, 2, &nparams, &nfreevars);
+    sq_addref(vm, &handlerObj);
+    ScriptFunction handler(vm, handlerObj, nparams);
+
+    // call the implementation
+    try {
+        obj->onControl(handler);
+    }
+    catch(std::exception const& e) {
+        return sq_throwerror(vm, e.what());
+    }
+
+    // void method, returns no value
+    return 0;
+}
+
+//
+// Midi.Loop onNoteOff
+//
+SQInteger MidiLooponNoteOff(HSQUIRRELVM vm)
+{
+    SQInteger numargs = sq_gettop(vm);
+    // check parameter count
+    if(numargs > 2) {
+        return sq_throwerror(vm, "too many parameters, expected at most 1");
+    }
+    if(numargs < 2) {
+        return sq_throwerror(vm, "insufficient parameters, expected at least 1");
+    }
+    // get "this" pointer
+    SQUserPointer userPtr = 0;
+    if (SQ_FAILED(sq_getinstanceup(vm, 1, &userPtr, 0))) {
+        return sq_throwerror(vm, "onNoteOff method needs an instance of Loop");
+    }
+    Loop *obj = static_cast<Loop*>(userPtr);
+    if(!obj) {
+        return sq_throwerror(vm, "onNoteOff method called before Midi.Loop constructor");
+    }
+    // get parameter 1 "handler" as function
+    HSQOBJECT handlerObj;
+    if (SQ_FAILED(sq_getstackobj(vm, 2, &handlerObj))) {
+        return sq_throwerror(vm, "argument 1 \"handler\" is not of type function");
+    }
+    if (sq_gettype(vm, 2) != OT_CLOSURE) {
+        return sq_throwerror(vm, "argument 1 \"handler\" is not of type function");
+    }
+    SQUnsignedInteger nparams, nfreevars;
+    sq_getclosureinfo(vm, 2, &nparams, &nfreevars);
+    sq_addref(vm, &handlerObj);
+    ScriptFunction handler(vm, handlerObj, nparams);
+
+    // call the implementation
+    try {
+        obj->onNoteOff(handler);
+    }
+    catch(std::exception const& e) {
+        return sq_throwerror(vm, e.what());
+    }
+
+    // void method, returns no value
+    return 0;
+}
+
+//
+// Midi.Loop onNoteOn
+//
+SQInteger MidiLooponNoteOn(HSQUIRRELVM vm)
+{
+    SQInteger numargs = sq_gettop(vm);
+    // check parameter count
+    if(numargs > 2) {
+        return sq_throwerror(vm, "too many parameters, expected at most 1");
+    }
+    if(numargs < 2) {
+        return sq_throwerror(vm, "insufficient parameters, expected at least 1");
+    }
+    // get "this" pointer
+    SQUserPointer userPtr = 0;
+    if (SQ_FAILED(sq_getinstanceup(vm, 1, &userPtr, 0))) {
+        return sq_throwerror(vm, "onNoteOn method needs an instance of Loop");
+    }
+    Loop *obj = static_cast<Loop*>(userPtr);
+    if(!obj) {
+        return sq_throwerror(vm, "onNoteOn method called before Midi.Loop constructor");
+    }
+    // get parameter 1 "handler" as function
+    HSQOBJECT handlerObj;
+    if (SQ_FAILED(sq_getstackobj(vm, 2, &handlerObj))) {
+        return sq_throwerror(vm, "argument 1 \"handler\" is not of type function");
+    }
+    if (sq_gettype(vm, 2) != OT_CLOSURE) {
+        return sq_throwerror(vm, "argument 1 \"handler\" is not of type function");
+    }
+    SQUnsignedInteger nparams, nfreevars;
+    sq_getclosureinfo(vm, 2, &nparams, &nfreevars);
+    sq_addref(vm, &handlerObj);
+    ScriptFunction handler(vm, handlerObj, nparams);
+
+    // call the implementation
+    try {
+        obj->onNoteOn(handler);
+    }
+    catch(std::exception const& e) {
+        return sq_throwerror(vm, e.what());
+    }
+
+    // void method, returns no value
+    return 0;
+}
+
+//
+// Midi.Loop play
+//
+SQInteger MidiLoopplay(HSQUIRRELVM vm)
+{
+    SQInteger numargs = sq_gettop(vm);
+    // check parameter count
+    if(numargs > 3) {
+        return sq_throwerror(vm, "too many parameters, expected at most 2");
+    }
+    if(numargs < 2) {
+        return sq_throwerror(vm, "insufficient parameters, expected at least 1");
+    }
+    // get "this" pointer
+    SQUserPointer userPtr = 0;
+    if (SQ_FAILED(sq_getinstanceup(vm, 1, &userPtr, 0))) {
+        return sq_throwerror(vm, "play method needs an instance of Loop");
+    }
+    Loop *obj = static_cast<Loop*>(userPtr);
+    if(!obj) {
+        return sq_throwerror(vm, "play method called before Midi.Loop constructor");
+    }
+    // get parameter 1 "pattern" as Midi.Pattern
+    midi::Pattern *pattern = getMidiPattern(vm, 2);
+    if(pattern == 0) {
+        return sq_throwerror(vm, "argument 1 \"pattern\" is not of type Midi.Pattern");
+    }
+
+    // 2 parameters passed in
+    if(numargs == 3) {
+
+        // get parameter 2 "channel" as integer
+        SQInteger channel;
+        if (SQ_FAILED(sq_getinteger(vm, 3, &channel))){
+            return sq_throwerror(vm, "argument 2 \"channel\" is not of type integer");
+        }
+
+        // call the implementation
+        try {
+            obj->play(*pattern, channel);
+        }
+        catch(std::exception const& e) {
+            return sq_throwerror(vm, e.what());
+        }
+    }
+
+    else {
+        // call the implementation
+        try {
+            obj->play(*pattern);
+        }
+        catch(std::exception const& e) {
+            return sq_throwerror(vm, e.what());
+        }
+    }
+
+    // void method, returns no value
+    return 0;
+}
+
+//
+// Midi.SMFReader class
+//
+SQInteger MidiSMFReaderRelease(SQUserPointer p, SQInteger size)
+{
+    delete static_cast<SMFReader*>(p);
+}
+
+SQInteger MidiSMFReaderCtor(HSQUIRRELVM vm)
+{
+    SQInteger numargs = sq_gettop(vm);
+    // check parameter count
+    if(numargs > 1) {
+        return sq_throwerror(vm, "too many parameters, expected at most 0");
+    }
+    SMFReader *obj;
+    // call the implementation
+    try {
+        obj = new SMFReader();
+    }
+    catch(std::exception const& e) {
+        return sq_throwerror(vm, e.what());
+    }
+
+    // return pointer to new object
+    sq_setinstanceup(vm, 1, (SQUserPointer*)obj);
+    sq_setreleasehook(vm, 1, MidiSMFReaderRelease);
+    return 1;
+}
+
+SQInteger MidiSMFReaderClone(HSQUIRRELVM vm)
+{
+    // get instance ptr of original
+    SQUserPointer userPtr;
+    sq_getinstanceup(vm, 2, &userPtr, 0);
+    // set instance ptr to a copy
+    sq_setinstanceup(vm, 1, new SMFReader(*(SMFReader*)userPtr));
+    sq_setreleasehook(vm, 1, &MidiSMFReaderRelease);
+    return 0;
+}
+
+//
+// Midi.SMFReader read
+//
+SQInteger MidiSMFReaderread(HSQUIRRELVM vm)
+{
+    SQInteger numargs = sq_gettop(vm);
+    // check parameter count
+    if(numargs > 3) {
+        return sq_throwerror(vm, "too many parameters, expected at most 2");
+    }
+    if(numargs < 2) {
+        return sq_throwerror(vm, "insufficient parameters, expected at least 1");
+    }
+    // get "this" pointer
+    SQUserPointer userPtr = 0;
+    if (SQ_FAILED(sq_getinstanceup(vm, 1, &userPtr, 0))) {
+        return sq_throwerror(vm, "read method needs an instance of SMFReader");
+    }
+    SMFReader *obj = static_cast<SMFReader*>(userPtr);
+    if(!obj) {
+        return sq_throwerror(vm, "read method called before Midi.SMFReader constructor");
+    }
+    // get parameter 1 "file" as string
+    const SQChar* file;
+    if (SQ_FAILED(sq_getstring(vm, 2, &file))){
+        return sq_throwerror(vm, "argument 1 \"file\" is not of type string");
+    }
+
+    // return value
+    midi::Pattern* ret;
+    // 2 parameters passed in
+    if(numargs == 3) {
+
+        // get parameter 2 "track" as integer
+        SQInteger track;
+        if (SQ_FAILED(sq_getinteger(vm, 3, &track))){
+            return sq_throwerror(vm, "argument 2 \"track\" is not of type integer");
+        }
+
+        // call the implementation
+        try {
+            ret = obj->read(file, track);
+        }
+        catch(std::exception const& e) {
+            return sq_throwerror(vm, e.what());
+        }
+    }
+
+    else {
+        // call the implementation
+        try {
+            ret = obj->read(file);
+        }
+        catch(std::exception const& e) {
+            return sq_throwerror(vm, e.what());
+        }
+    }
+
+    // push return value
+    sq_pushobject(vm, MidiPatternObject);
+    sq_createinstance(vm, -1);
+    sq_remove(vm, -2);
+    sq_setinstanceup(vm, -1, ret);
+    sq_setreleasehook(vm, -1, &MidiPatternRelease);
+
+    return 1;
+}
+
+//
+// Midi.SMFReader readTune
+//
+SQInteger MidiSMFReaderreadTune(HSQUIRRELVM vm)
+{
+    SQInteger numargs = sq_gettop(vm);
+    // check parameter count
+    if(numargs > 2) {
+        return sq_throwerror(vm, "too many parameters, expected at most 1");
+    }
+    if(numargs < 2) {
+        return sq_throwerror(vm, "insufficient parameters, expected at least 1");
+    }
+    // get "this" pointer
+    SQUserPointer userPtr = 0;
+    if (SQ_FAILED(sq_getinstanceup(vm, 1, &userPtr, 0))) {
+        return sq_throwerror(vm, "readTune method needs an instance of SMFReader");
+    }
+    SMFReader *obj = static_cast<SMFReader*>(userPtr);
+    if(!obj) {
+        return sq_throwerror(vm, "readTune method called before Midi.SMFReader constructor");
+    }
+    // get parameter 1 "file" as string
+    const SQChar* file;
+    if (SQ_FAILED(sq_getstring(vm, 2, &file))){
+        return sq_throwerror(vm, "argument 1 \"file\" is not of type string");
+    }
+
+    // return value
+    midi::Tune* ret;
+    // call the implementation
+    try {
+        ret = obj->readTune(file);
+    }
+    catch(std::exception const& e) {
+        return sq_throwerror(vm, e.what());
+    }
+
+    // push return value
+    sq_pushobject(vm, MidiTuneObject);
+    sq_createinstance(vm, -1);
+    sq_remove(vm, -2);
+    sq_setinstanceup(vm, -1, ret);
+    sq_setreleasehook(vm, -1, &MidiTuneRelease);
+
+    return 1;
+}
+
+//
+// Midi.SMFWriter class
+//
+SQInteger MidiSMFWriterCtor(HSQUIRRELVM vm)
+{
+    SQInteger numargs = sq_gettop(vm);
+    // check parameter count
+    if(numargs > 2) {
+        return sq_throwerror(vm, "too many parameters, expected at most 1");
+    }
+    if(numargs < 2) {
+        return sq_throwerror(vm, "insufficient parameters, expected at least 1");
+    }
+    // get parameter 1 "file" as string
+    const SQChar* file;
+    if (SQ_FAILED(sq_getstring(vm, 2, &file))){
+        return sq_throwerror(vm, "argument 1 \"file\" is not of type string");
+    }
+
+    SMFWriter *obj;
+    // call the implementation
+    try {
+        obj = midi::SMFWriterCache::instance().getSMFWriter(file);
+    }
+    catch(std::exception const& e) {
+        return sq_throwerror(vm, e.what());
+    }
+
+    // return pointer to new object
+    sq_setinstanceup(vm, 1, (SQUserPointer*)obj);
+    return 1;
+}
+
+//
+// Midi.SMFWriter connectMidi
+//
+SQInteger MidiSMFWriterconnectMidi(HSQUIRRELVM vm)
+{
+    SQInteger numargs = sq_gettop(vm);
+    // check parameter count
+    if(numargs > 2) {
+        return sq_throwerror(vm, "too many parameters, expected at most 1");
+    }
+    if(numargs < 2) {
+        return sq_throwerror(vm, "insufficient parameters, expected at least 1");
+    }
+    // get "this" pointer
+    SQUserPointer userPtr = 0;
+    if (SQ_FAILED(sq_getinstanceup(vm, 1, &userPtr, 0))) {
+        return sq_throwerror(vm, "connectMidi method needs an instance of SMFWriter");
+    }
+    SMFWriter *obj = static_cast<SMFWriter*>(userPtr);
+    if(!obj) {
+        return sq_throwerror(vm, "connectMidi method called before Midi.SMFWriter constructor");
+    }
+    // get parameter 1 "source" as Midi.Source
+    midi::Source *source = getMidiSource(vm, 2);
+    if(source == 0) {
+        return sq_throwerror(vm, "argument 1 \"source\" is not of type Midi.Source");
+    }
+
+    // call the implementation
+    try {
+        obj->connectMidi(*source);
+    }
+    catch(std::exception const& e) {
+        return sq_throwerror(vm, e.what());
+    }
+
+    // void method, returns no value
+    return 0;
+}
+
+//
+// Midi.Router class
+//
+SQInteger MidiRouterCtor(HSQUIRRELVM vm)
+{
+    SQInteger numargs = sq_gettop(vm);
+    // check parameter count
+    if(numargs > 1) {
+        return sq_throwerror(vm, "too many parameters, expected at most 0");
+    }
+    Router *obj;
+    // call the implementation
+    try {
+        obj = midi::RouterCache::instance().getRouter();
+    }
+    catch(std::exception const& e) {
+        return sq_throwerror(vm, e.what());
+    }
+
+    // return pointer to new object
+    sq_setinstanceup(vm, 1, (SQUserPointer*)obj);
+    return 1;
+}
+
+//
+// Midi.Router connectMidi
+//
+SQInteger MidiRouterconnectMidi(HSQUIRRELVM vm)
+{
+    SQInteger numargs = sq_gettop(vm);
+    // check parameter count
+    if(numargs > 2) {
+        return sq_throwerror(vm, "too many parameters, expected at most 1");
+    }
+    if(numargs < 2) {
+        return sq_throwerror(vm, "insufficient parameters, expected at least 1");
+    }
+    // get "this" pointer
+    SQUserPointer userPtr = 0;
+    if (SQ_FAILED(sq_getinstanceup(vm, 1, &userPtr, 0))) {
+        return sq_throwerror(vm, "connectMidi method needs an instance of Router");
+    }
+    Router *obj = static_cast<Router*>(userPtr);
+    if(!obj) {
+        return sq_throwerror(vm, "connectMidi method called before Midi.Router constructor");
+    }
+    // get parameter 1 "source" as Midi.Source
+    midi::Source *source = getMidiSource(vm, 2);
+    if(source == 0) {
+        return sq_throwerror(vm, "argument 1 \"source\" is not of type Midi.Source");
+    }
+
+    // call the implementation
+    try {
+        obj->connectMidi(*source);
+    }
+    catch(std::exception const& e) {
+        return sq_throwerror(vm, e.what());
+    }
+
+    // void method, returns no value
+    return 0;
+}
+
+//
+// Midi.Router humanize
+//
+SQInteger MidiRouterhumanize(HSQUIRRELVM vm)
+{
+    SQInteger numargs = sq_gettop(vm);
+    // check parameter count
+    if(numargs > 2) {
+        return sq_throwerror(vm, "too many parameters, expected at most 1");
+    }
+    if(numargs < 2) {
+        return sq_throwerror(vm, "insufficient parameters, expected at least 1");
+    }
+    // get "this" pointer
+    SQUserPointer userPtr = 0;
+    if (SQ_FAILED(sq_getinstanceup(vm, 1, &userPtr, 0))) {
+        return sq_throwerror(vm, "humanize method needs an instance of Router");
+    }
+    Router *obj = static_cast<Router*>(userPtr);
+    if(!obj) {
+        return sq_throwerror(vm, "humanize method called before Midi.Router constructor");
+    }
+    // get parameter 1 "milliseconds" as float
+    SQFloat milliseconds;
+    if (SQ_FAILED(sq_getfloat(vm, 2, &milliseconds))){
+        return sq_throwerror(vm, "argument 1 \"milliseconds\" is not of type float");
+    }
+
+    // call the implementation
+    try {
+        obj->humanize(milliseconds);
+    }
+    catch(std::exception const& e) {
+        return sq_throwerror(vm, e.what());
+    }
+
+    // void method, returns no value
+    return 0;
+}
+
+//
+// Midi.Router mapChannel
+//
+SQInteger MidiRoutermapChannel(HSQUIRRELVM vm)
+{
+    SQInteger numargs = sq_gettop(vm);
+    // check parameter count
+    if(numargs > 3) {
+        return sq_throwerror(vm, "too many parameters, expected at most 2");
+    }
+    if(numargs < 3) {
+        return sq_throwerror(vm, "insufficient parameters, expected at least 2");
+    }
+    // get "this" pointer
+    SQUserPointer userPtr = 0;
+    if (SQ_FAILED(sq_getinstanceup(vm, 1, &userPtr, 0))) {
+        return sq_throwerror(vm, "mapChannel method needs an instance of Router");
+    }
+    Router *obj = static_cast<Router*>(userPtr);
+    if(!obj) {
+        return sq_throwerror(vm, "mapChannel method called before Midi.Router constructor");
+    }
+    // get parameter 1 "from" as integer
+    SQInteger from;
+    if (SQ_FAILED(sq_getinteger(vm, 2, &from))){
+        return sq_throwerror(vm, "argument 1 \"from\" is not of type integer");
+    }
+    // get parameter 2 "to" as integer
+    SQInteger to;
+    if (SQ_FAILED(sq_getinteger(vm, 3, &to))){
+        return sq_throwerror(vm, "argument 2 \"to\" is not of type integer");
+    }
+
+    // call the implementation
+    try {
+        obj->mapChannel(from, to);
+    }
+    catch(std::exception const& e) {
+        return sq_throwerror(vm, e.what());
+    }
+
+    // void method, returns no value
+    return 0;
+}
+
+//
+// Midi.Router mapControl
+//
+SQInteger MidiRoutermapControl(HSQUIRRELVM vm)
+{
+    SQInteger numargs = sq_gettop(vm);
+    // check parameter count
+    if(numargs > 3) {
+        return sq_throwerror(vm, "too many parameters, expected at most 2");
+    }
+    if(numargs < 3) {
+        return sq_throwerror(vm, "insufficient parameters, expected at least 2");
+    }
+    // get "this" pointer
+    SQUserPointer userPtr = 0;
+    if (SQ_FAILED(sq_getinstanceup(vm, 1, &userPtr, 0))) {
+        return sq_throwerror(vm, "mapControl method needs an instance of Router");
+    }
+    Router *obj = static_cast<Router*>(userPtr);
+    if(!obj) {
+        return sq_throwerror(vm, "mapControl method called before Midi.Router constructor");
+    }
+    // get parameter 1 "from" as integer
+    SQInteger from;
+    if (SQ_FAILED(sq_getinteger(vm, 2, &from))){
+        return sq_throwerror(vm, "argument 1 \"from\" is not of type integer");
+    }
+    // get parameter 2 "to" as integer
+    SQInteger to;
+    if (SQ_FAILED(sq_getinteger(vm, 3, &to))){
+        return sq_throwerror(vm, "argument 2 \"to\" is not of type integer");
+    }
+
+    // call the implementation
+    try {
+        obj->mapControl(from, to);
+    }
+    catch(std::exception const& e) {
+        return sq_throwerror(vm, e.what());
+    }
+
+    // void method, returns no value
+    return 0;
+}
+
+//
+// Midi.Router midiChannel
+//
+SQInteger MidiRoutermidiChannel(HSQUIRRELVM vm)
+{
+    SQInteger numargs = sq_gettop(vm);
+    // check parameter count
+    if(numargs > 2) {
+        return sq_throwerror(vm, "too many parameters, expected at most 1");
+    }
+    // get "this" pointer
+    SQUserPointer userPtr = 0;
+    if (SQ_FAILED(sq_getinstanceup(vm, 1, &userPtr, 0))) {
+        return sq_throwerror(vm, "midiChannel method needs an instance of Router");
+    }
+    Router *obj = static_cast<Router*>(userPtr);
+    if(!obj) {
+        return sq_throwerror(vm, "midiChannel method called before Midi.Router constructor");
+    }
+    // return value
+    SQInteger ret;
+    // 1 parameters passed in
+    if(numargs == 2) {
+
+        // get parameter 1 "channel" as integer
+        SQInteger channel;
+        if (SQ_FAILED(sq_getinteger(vm, 2, &channel))){
+            return sq_throwerror(vm, "argument 1 \"channel\" is not of type integer");
+        }
+
+        // call the implementation
+        try {
+            ret = obj->midiChannel(channel);
+        }
+        catch(std::exception const& e) {
+            return sq_throwerror(vm, e.what());
+        }
+    }
+
+    else {
+        // call the implementation
+        try {
+            ret = obj->midiChannel();
+        }
+        catch(std::exception const& e) {
+            return sq_throwerror(vm, e.what());
+        }
+    }
+
+    // push return value
+    sq_pushinteger(vm, ret);
+    return 1;
+}
+
+//
+// Midi.Router midiOutput
+//
+SQInteger MidiRoutermidiOutput(HSQUIRRELVM vm)
+{
+    SQInteger numargs = sq_gettop(vm);
+    // check parameter count
+    if(numargs > 2) {
+        return sq_throwerror(vm, "too many parameters, expected at most 1");
+    }
+    if(numargs < 2) {
+        return sq_throwerror(vm, "insufficient parameters, expected at least 1");
+    }
+    // get "this" pointer
+    SQUserPointer userPtr = 0;
+    if (SQ_FAILED(sq_getinstanceup(vm, 1, &userPtr, 0))) {
+        return sq_throwerror(vm, "midiOutput method needs an instance of Router");
+    }
+    Router *obj = static_cast<Router*>(userPtr);
+    if(!obj) {
+        return sq_throwerror(vm, "midiOutput method called before Midi.Router constructor");
+    }
+    // get parameter 1 "index" as integer
+    SQInteger index;
+    if (SQ_FAILED(sq_getinteger(vm, 2, &index))){
+        return sq_throwerror(vm, "argument 1 \"index\" is not of type integer");
+    }
+
+    // return value
+    midi::MidiConnection* ret;
+    // call the implementation
+    try {
+        ret = obj->getMidiConnection(index);
+    }
+    catch(std::exception const& e) {
+        return sq_throwerror(vm, e.what());
+    }
+
+    // push return value
+    sq_pushobject(vm, MidiOutputObject);
+    sq_createinstance(vm, -1);
+    sq_remove(vm, -2);
+    sq_setinstanceup(vm, -1, ret);
+    // no release hook, release ignored per binding
+
+    return 1;
+}
+
+//
+// Midi.Router noteRange
+//
+SQInteger MidiRouternoteRange(HSQUIRRELVM vm)
+{
+    SQInteger numargs = sq_gettop(vm);
+    // check parameter count
+    if(numargs > 3) {
+        return sq_throwerror(vm, "too many parameters, expected at most 2");
+    }
+    if(numargs < 3) {
+        return sq_throwerror(vm, "insufficient parameters, expected at least 2");
+    }
+    // get "this" pointer
+    SQUserPointer userPtr = 0;
+    if (SQ_FAILED(sq_getinstanceup(vm, 1, &userPtr, 0))) {
+        return sq_throwerror(vm, "noteRange method needs an instance of Router");
+    }
+    Router *obj = static_cast<Router*>(userPtr);
+    if(!obj) {
+        return sq_throwerror(vm, "noteRange method called before Midi.Router constructor");
+    }
+    // get parameter 1 "low" as integer
+    SQInteger low;
+    if (SQ_FAILED(sq_getinteger(vm, 2, &low))){
+        return sq_throwerror(vm, "argument 1 \"low\" is not of type integer");
+    }
+    // get parameter 2 "high" as integer
+    SQInteger high;
+    if (SQ_FAILED(sq_getinteger(vm, 3, &high))){
+        return sq_throwerror(vm, "argument 2 \"high\" is not of type integer");
+    }
+
+    // call the implementation
+    try {
+        obj->noteRange(low, high);
+    }
+    catch(std::exception const& e) {
+        return sq_throwerror(vm, e.what());
+    }
+
+    // void method, returns no value
+    return 0;
+}
+
+//
+// Midi.Router onControl
+//
+SQInteger MidiRouteronControl(HSQUIRRELVM vm)
+{
+    SQInteger numargs = sq_gettop(vm);
+    // check parameter count
+    if(numargs > 2) {
+        return sq_throwerror(vm, "too many parameters, expected at most 1");
+    }
+    if(numargs < 2) {
+        return sq_throwerror(vm, "insufficient parameters, expected at least 1");
+    }
+    // get "this" pointer
+    SQUserPointer userPtr = 0;
+    if (SQ_FAILED(sq_getinstanceup(vm, 1, &userPtr, 0))) {
+        return sq_throwerror(vm, "onControl method needs an instance of Router");
+    }
+    Router *obj = static_cast<Router*>(userPtr);
+    if(!obj) {
+        return sq_throwerror(vm, "onControl method called before Midi.Router constructor");
+    }
+    // get parameter 1 "handler" as function
+    HSQOBJECT handlerObj;
+    if (SQ_FAILED(sq_getstackobj(vm, 2, &handlerObj))) {
+        return sq_throwerror(vm, "argument 1 \"handler\" is not of type function");
+    }
+    if (sq_gettype(vm, 2) != OT_CLOSURE) {
+        return sq_throwerror(vm, "argument 1 \"handler\" is not of type function");
+    }
+    SQUnsignedInteger nparams, nfreevars;
+    sq_getclosureinfo(vm, 2, &nparams, &nfreevars);
+    sq_addref(vm, &handlerObj);
+    ScriptFunction handler(vm, handlerObj, nparams);
+
+    // call the implementation
+    try {
+        obj->onControl(handler);
+    }
+    catch(std::exception const& e) {
+        return sq_throwerror(vm, e.what());
+    }
+
+    // void method, returns no value
+    return 0;
+}
+
+//
+// Midi.Router onNoteOff
+//
+SQInteger MidiRouteronNoteOff(HSQUIRRELVM vm)
+{
+    SQInteger numargs = sq_gettop(vm);
+    // check parameter count
+    if(numargs > 2) {
+        return sq_throwerror(vm, "too many parameters, expected at most 1");
+    }
+    if(numargs < 2) {
+        return sq_throwerror(vm, "insufficient parameters, expected at least 1");
+    }
+    // get "this" pointer
+    SQUserPointer userPtr = 0;
+    if (SQ_FAILED(sq_getinstanceup(vm, 1, &userPtr, 0))) {
+        return sq_throwerror(vm, "onNoteOff method needs an instance of Router");
+    }
+    Router *obj = static_cast<Router*>(userPtr);
+    if(!obj) {
+        return sq_throwerror(vm, "onNoteOff method called before Midi.Router constructor");
+    }
+    // get parameter 1 "handler" as function
+    HSQOBJECT handlerObj;
+    if (SQ_FAILED(sq_getstackobj(vm, 2, &handlerObj))) {
+        return sq_throwerror(vm, "argument 1 \"handler\" is not of type function");
+    }
+    if (sq_gettype(vm, 2) != OT_CLOSURE) {
+        return sq_throwerror(vm, "argument 1 \"handler\" is not of type function");
+    }
+    SQUnsignedInteger nparams, nfreevars;
+    sq_getclosureinfo(vm, 2, &nparams, &nfreevars);
+    sq_addref(vm, &handlerObj);
+    ScriptFunction handler(vm, handlerObj, nparams);
+
+    // call the implementation
+    try {
+        obj->onNoteOff(handler);
+    }
+    catch(std::exception const& e) {
+        return sq_throwerror(vm, e.what());
+    }
+
+    // void method, returns no value
+    return 0;
+}
+
+//
+// Midi.Router onNoteOn
+//
+SQInteger MidiRouteronNoteOn(HSQUIRRELVM vm)
+{
+    SQInteger numargs = sq_gettop(vm);
+    // check parameter count
+    if(numargs > 2) {
+        return sq_throwerror(vm, "too many parameters, expected at most 1");
+    }
+    if(numargs < 2) {
+        return sq_throwerror(vm, "insufficient parameters, expected at least 1");
+    }
+    // get "this" pointer
+    SQUserPointer userPtr = 0;
+    if (SQ_FAILED(sq_getinstanceup(vm, 1, &userPtr, 0))) {
+        return sq_throwerror(vm, "onNoteOn method needs an instance of Router");
+    }
+    Router *obj = static_cast<Router*>(userPtr);
+    if(!obj) {
+        return sq_throwerror(vm, "onNoteOn method called before Midi.Router constructor");
+    }
+    // get parameter 1 "handler" as function
+    HSQOBJECT handlerObj;
+    if (SQ_FAILED(sq_getstackobj(vm, 2, &handlerObj))) {
+        return sq_throwerror(vm, "argument 1 \"handler\" is not of type function");
+    }
+    if (sq_gettype(vm, 2) != OT_CLOSURE) {
+        return sq_throwerror(vm, "argument 1 \"handler\" is not of type function");
+    }
+    SQUnsignedInteger nparams, nfreevars;
+    sq_getclosureinfo(vm, 2, &nparams, &nfreevars);
+    sq_addref(vm, &handlerObj);
+    ScriptFunction handler(vm, handlerObj, nparams);
+
+    // call the implementation
+    try {
+        obj->onNoteOn(handler);
+    }
+    catch(std::exception const& e) {
+        return sq_throwerror(vm, e.what());
+    }
+
+    // void method, returns no value
+    return 0;
+}
+
+//
+// Midi.Router quantize
+//
+SQInteger MidiRouterquantize(HSQUIRRELVM vm)
+{
+    SQInteger numargs = sq_gettop(vm);
+    // check parameter count
+    if(numargs > 3) {
+        return sq_throwerror(vm, "too many parameters, expected at most 2");
+    }
+    if(numargs < 2) {
+        return sq_throwerror(vm, "insufficient parameters, expected at least 1");
+    }
+    // get "this" pointer
+    SQUserPointer userPtr = 0;
+    if (SQ_FAILED(sq_getinstanceup(vm, 1, &userPtr, 0))) {
+        return sq_throwerror(vm, "quantize method needs an instance of Router");
+    }
+    Router *obj = static_cast<Router*>(userPtr);
+    if(!obj) {
+        return sq_throwerror(vm, "quantize method called before Midi.Router constructor");
+    }
+    // get parameter 1 "division" as integer
+    SQInteger division;
+    if (SQ_FAILED(sq_getinteger(vm, 2, &division))){
+        return sq_throwerror(vm, "argument 1 \"division\" is not of type integer");
+    }
+
+    // 2 parameters passed in
+    if(numargs == 3) {
+
+        // get parameter 2 "strength" as float
+        SQFloat strength;
+        if (SQ_FAILED(sq_getfloat(vm, 3, &strength))){
+            return sq_throwerror(vm, "argument 2 \"strength\" is not of type float");
+        }
+
+        // call the implementation
+        try {
+            obj->quantize(division, strength);
+        }
+        catch(std::exception const& e) {
+            return sq_throwerror(vm, e.what());
+        }
+    }
+
+    else {
+        // call the implementation
+        try {
+            obj->quantize(division);
+        }
+        catch(std::exception const& e) {
+            return sq_throwerror(vm, e.what());
+        }
+    }
+
+    // void method, returns no value
+    return 0;
+}
+
+//
+// Midi.Router schedule
+//
+SQInteger MidiRouterschedule(HSQUIRRELVM vm)
+{
+    SQObjectType overrideType = sq_gettype(vm, 2);
+    if(midi::Note *note = getMidiNote(vm, 2)) {
+        SQInteger numargs = sq_gettop(vm);
+        // check parameter count
+        if(numargs > 6) {
+            return sq_throwerror(vm, "too many parameters, expected at most 5");
+        }
+        if(numargs < 3) {
+            return sq_throwerror(vm, "insufficient parameters, expected at least 2");
+        }
+        // get "this" pointer
+        SQUserPointer userPtr = 0;
+        if (SQ_FAILED(sq_getinstanceup(vm, 1, &userPtr, 0))) {
+            return sq_throwerror(vm, "schedule method needs an instance of Router");
+        }
+        Router *obj = static_cast<Router*>(userPtr);
+        if(!obj) {
+            return sq_throwerror(vm, "schedule method called before Midi.Router constructor");
+        }
+        // get parameter 2 "bar" as integer
+        SQInteger bar;
+        if (SQ_FAILED(sq_getinteger(vm, 3, &bar))){
+            return sq_throwerror(vm, "argument 2 \"bar\" is not of type integer");
+        }
+
+        // 3 parameters passed in
+        if(numargs == 4) {
+
+            // get parameter 3 "position" as integer
+            SQInteger position;
+            if (SQ_FAILED(sq_getinteger(vm, 4, &position))){
+                return sq_throwerror(vm, "argument 3 \"position\" is not of type integer");
+            }
+
+            // call the implementation
+            try {
+                obj->schedule(*note, bar, position);
+            }
+            catch(std::exception const& e) {
+                return sq_throwerror(vm, e.what());
+            }
+        }
+
+        // 4 parameters passed in
+        else if(numargs == 5) {
+
+            // get parameter 3 "position" as integer
+            SQInteger position;
+            if (SQ_FAILED(sq_getinteger(vm, 4, &position))){
+                return sq_throwerror(vm, "argument 3 \"position\" is not of type integer");
+            }
+
+            // get parameter 4 "division" as integer
+            SQInteger division;
+            if (SQ_FAILED(sq_getinteger(vm, 5, &division))){
+                return sq_throwerror(vm, "argument 4 \"division\" is not of type integer");
+            }
+
+            // call the implementation
+            try {
+                obj->schedule(*note, bar, position, division);
+            }
+            catch(std::exception const& e) {
+                return sq_throwerror(vm, e.what());
+            }
+        }
+
+        // 5 parameters passed in
+        else if(numargs == 6) {
+
+            // get parameter 3 "position" as integer
+            SQInteger position;
+            if (SQ_FAILED(sq_getinteger(vm, 4, &position))){
+                return sq_throwerror(vm, "argument 3 \"position\" is not of type integer");
+            }
+
+            // get parameter 4 "division" as integer
+            SQInteger division;
+            if (SQ_FAILED(sq_getinteger(vm, 5, &division))){
+                return sq_throwerror(vm, "argument 4 \"division\" is not of type integer");
+            }
+
+            // get parameter 5 "channel" as integer
+            SQInteger channel;
+            if (SQ_FAILED(sq_getinteger(vm, 6, &channel))){
+                return sq_throwerror(vm, "argument 5 \"channel\" is not of type integer");
+            }
+
+            // call the implementation
+            try {
+                obj->schedule(*note, bar, position, division, channel);
+            }
+            catch(std::exception const& e) {
+                return sq_throwerror(vm, e.what());
+            }
+        }
+
+        else {
+            // call the implementation
+            try {
+                obj->schedule(*note, bar);
+            }
+            catch(std::exception const& e) {
+                return sq_throwerror(vm, e.what());
+            }
+        }
+
+        // void method, returns no value
+        return 0;
+    }
+    else if(midi::Pattern *pattern = getMidiPattern(vm, 2)) {
+        SQInteger numargs = sq_gettop(vm);
+        // check parameter count
+        if(numargs > 6) {
+            return sq_throwerror(vm, "too many parameters, expected at most 5");
+        }
+        if(numargs < 3) {
+            return sq_throwerror(vm, "insufficient parameters, expected at least 2");
+        }
+        // get "this" pointer
+        SQUserPointer userPtr = 0;
+        if (SQ_FAILED(sq_getinstanceup(vm, 1, &userPtr, 0))) {
+            return sq_throwerror(vm, "schedule method needs an instance of Router");
+        }
+        Router *obj = static_cast<Router*>(userPtr);
+        if(!obj) {
+            return sq_throwerror(vm, "schedule method called before Midi.Router constructor");
+        }
+        // get parameter 2 "bar" as integer
+        SQInteger bar;
+        if (SQ_FAILED(sq_getinteger(vm, 3, &bar))){
+            return sq_throwerror(vm, "argument 2 \"bar\" is not of type integer");
+        }
+
+        // 3 parameters passed in
+        if(numargs == 4) {
+
+            // get parameter 3 "position" as integer
+            SQInteger position;
+            if (SQ_FAILED(sq_getinteger(vm, 4, &position))){
+                return sq_throwerror(vm, "argument 3 \"position\" is not of type integer");
+            }
+
+            // call the implementation
+            try {
+                obj->schedule(*pattern, bar, position);
+            }
+            catch(std::exception const& e) {
+                return sq_throwerror(vm, e.what());
+            }
+        }
+
+        // 4 parameters passed in
+        else if(numargs == 5) {
+
+            // get parameter 3 "position" as integer
+            SQInteger position;
+            if (SQ_FAILED(sq_getinteger(vm, 4, &position))){
+                return sq_throwerror(vm, "argument 3 \"position\" is not of type integer");
+            }
+
+            // get parameter 4 "division" as integer
+            SQInteger division;
+            if (SQ_FAILED(sq_getinteger(vm, 5, &division))){
+                return sq_throwerror(vm, "argument 4 \"division\" is not of type integer");
+            }
+
+            // call the implementation
+            try {
+                obj->schedule(*pattern, bar, position, division);
+            }
+            catch(std::exception const& e) {
+                return sq_throwerror(vm, e.what());
+            }
+        }
+
+        // 5 parameters passed in
+        else if(numargs == 6) {
+
+            // get parameter 3 "position" as integer
+            SQInteger position;
+            if (SQ_FAILED(sq_getinteger(vm, 4, &position))){
+                return sq_throwerror(vm, "argument 3 \"position\" is not of type integer");
+            }
+
+            // get parameter 4 "division" as integer
+            SQInteger division;
+            if (SQ_FAILED(sq_getinteger(vm, 5, &division))){
+                return sq_throwerror(vm, "argument 4 \"division\" is not of type integer");
+            }
+
+            // get parameter 5 "channel" as integer
+            SQInteger channel;
+            if (SQ_FAILED(sq_getinteger(vm, 6, &channel))){
+                return sq_throwerror(vm, "argument 5 \"channel\" is not of type integer");
+            }
+
+            // call the implementation
+            try {
+                obj->schedule(*pattern, bar, position, division, channel);
+            }
+            catch(std::exception const& e) {
+                return sq_throwerror(vm, e.what());
+            }
+        }
+
+        else {
+            // call the implementation
+            try {
+                obj->schedule(*pattern, bar);
+            }
+            catch(std::exception const& e) {
+                return sq_throwerror(vm, e.what());
+            }
+        }
+
+        // void method, returns no value
+        return 0;
+    }
+    else if(midi::Message *message = getMidiMessage(vm, 2)) {
+        SQInteger numargs = sq_gettop(vm);
+        // check parameter count
+        if(numargs > 6) {
+            return sq_throwerror(vm, "too many parameters, expected at most 5");
+        }
+        if(numargs < 3) {
+            return sq_throwerror(vm, "insufficient parameters, expected at least 2");
+        }
+        // get "this" pointer
+        SQUserPointer userPtr = 0;
+        if (SQ_FAILED(sq_getinstanceup(vm, 1, &userPtr, 0))) {
+            return sq_throwerror(vm, "schedule method needs an instance of Router");
+        }
+        Router *obj = static_cast<Router*>(userPtr);
+        if(!obj) {
+            return sq_throwerror(vm, "schedule method called before Midi.Router constructor");
+        }
+        // get parameter 2 "bar" as integer
+        SQInteger bar;
+        if (SQ_FAILED(sq_getinteger(vm, 3, &bar))){
+            return sq_throwerror(vm, "argument 2 \"bar\" is not of type integer");
+        }
+
+        // 3 parameters passed in
+        if(numargs == 4) {
+
+            // get parameter 3 "position" as integer
+            SQInteger position;
+            if (SQ_FAILED(sq_getinteger(vm, 4, &position))){
+                return sq_throwerror(vm, "argument 3 \"position\" is not of type integer");
+            }
+
+            // call the implementation
+            try {
+                obj->schedule(*message, bar, position);
+            }
+            catch(std::exception const& e) {
+                return sq_throwerror(vm, e.what());
+            }
+        }
+
+        // 4 parameters passed in
+        else if(numargs == 5) {
+
+            // get parameter 3 "position" as integer
+            SQInteger position;
+            if (SQ_FAILED(sq_getinteger(vm, 4, &position))){
+                return sq_throwerror(vm, "argument 3 \"position\" is not of type integer");
+            }
+
+            // get parameter 4 "division" as integer
+            SQInteger division;
+            if (SQ_FAILED(sq_getinteger(vm, 5, &division))){
+                return sq_throwerror(vm, "argument 4 \"division\" is not of type integer");
+            }
+
+            // call the implementation
+            try {
+                obj->schedule(*message, bar, position, division);
+            }
+            catch(std::exception const& e) {
+                return sq_throwerror(vm, e.what());
+            }
+        }
+
+        // 5 parameters passed in
+        else if(numargs == 6) {
+
+            // get parameter 3 "position" as integer
+            SQInteger position;
+            if (SQ_FAILED(sq_getinteger(vm, 4, &position))){
+                return sq_throwerror(vm, "argument 3 \"position\" is not of type integer");
+            }
+
+            // get parameter 4 "division" as integer
+            SQInteger division;
+            if (SQ_FAILED(sq_getinteger(vm, 5, &division))){
+                return sq_throwerror(vm, "argument 4 \"division\" is not of type integer");
+            }
+
+            // get parameter 5 "channel" as integer
+            SQInteger channel;
+            if (SQ_FAILED(sq_getinteger(vm, 6, &channel))){
+                return sq_throwerror(vm, "argument 5 \"channel\" is not of type integer");
+            }
+
+            // call the implementation
+            try {
+                obj->schedule(*message, bar, position, division, channel);
+            }
+            catch(std::exception const& e) {
+                return sq_throwerror(vm, e.what());
+            }
+        }
+
+        else {
+            // call the implementation
+            try {
+                obj->schedule(*message, bar);
+            }
+            catch(std::exception const& e) {
+                return sq_throwerror(vm, e.what());
+            }
+        }
+
+        // void method, returns no value
+        return 0;
+    }
+    else {
+        return sq_throwerror(vm, "argument 1 is not of type {Midi.Note, Midi.Pattern, Midi.Message}");
+    }
+}
+
+//
+// Midi.Router split
+//
+SQInteger MidiRoutersplit(HSQUIRRELVM vm)
+{
+    SQInteger numargs = sq_gettop(vm);
+    // check parameter count
+    if(numargs > 2) {
+        return sq_throwerror(vm, "too many parameters, expected at most 1");
+    }
+    if(numargs < 2) {
+        return sq_throwerror(vm, "insufficient parameters, expected at least 1");
+    }
+    // get "this" pointer
+    SQUserPointer userPtr = 0;
+    if (SQ_FAILED(sq_getinstanceup(vm, 1, &userPtr, 0))) {
+        return sq_throwerror(vm, "split method needs an instance of Router");
+    }
+    Router *obj = static_cast<Router*>(userPtr);
+    if(!obj) {
+        return sq_throwerror(vm, "split method called before Midi.Router constructor");
+    }
+    // get parameter 1 "note" as integer
+    SQInteger note;
+    if (SQ_FAILED(sq_getinteger(vm, 2, &note))){
+        return sq_throwerror(vm, "argument 1 \"note\" is not of type integer");
+    }
+
+    // call the implementation
+    try {
+        obj->split(note);
+    }
+    catch(std::exception const& e) {
+        return sq_throwerror(vm, e.what());
+    }
+
+    // void method, returns no value
+    return 0;
+}
+
+//
+// Midi.Router swing
+//
+SQInteger MidiRouterswing(HSQUIRRELVM vm)
+{
+    SQInteger numargs = sq_gettop(vm);
+    // check parameter count
+    if(numargs > 3) {
+        return sq_throwerror(vm, "too many parameters, expected at most 2");
+    }
+    if(numargs < 3) {
+        return sq_throwerror(vm, "insufficient parameters, expected at least 2");
+    }
+    // get "this" pointer
+    SQUserPointer userPtr = 0;
+    if (SQ_FAILED(sq_getinstanceup(vm, 1, &userPtr, 0))) {
+        return sq_throwerror(vm, "swing method needs an instance of Router");
+    }
+    Router *obj = static_cast<Router*>(userPtr);
+    if(!obj) {
+        return sq_throwerror(vm, "swing method called before Midi.Router constructor");
+    }
+    // get parameter 1 "division" as integer
+    SQInteger division;
+    if (SQ_FAILED(sq_getinteger(vm, 2, &division))){
+        return sq_throwerror(vm, "argument 1 \"division\" is not of type integer");
+    }
+    // get parameter 2 "amount" as float
+    SQFloat amount;
+    if (SQ_FAILED(sq_getfloat(vm, 3, &amount))){
+        return sq_throwerror(vm, "argument 2 \"amount\" is not of type float");
+    }
+
+    // call the implementation
+    try {
+        obj->swing(division, amount);
+    }
+    catch(std::exception const& e) {
+        return sq_throwerror(vm, e.what());
+    }
+
+    // void method, returns no value
+    return 0;
+}
+
+//
+// Midi.Router transpose
+//
+SQInteger MidiRoutertranspose(HSQUIRRELVM vm)
+{
+    SQInteger numargs = sq_gettop(vm);
+    // check parameter count
+    if(numargs > 2) {
+        return sq_throwerror(vm, "too many parameters, expected at most 1");
+    }
+    if(numargs < 2) {
+        return sq_throwerror(vm, "insufficient parameters, expected at least 1");
+    }
+    // get "this" pointer
+    SQUserPointer userPtr = 0;
+    if (SQ_FAILED(sq_getinstanceup(vm, 1, &userPtr, 0))) {
+        return sq_throwerror(vm, "transpose method needs an instance of Router");
+    }
+    Router *obj = static_cast<Router*>(userPtr);
+    if(!obj) {
+        return sq_throwerror(vm, "transpose method called before Midi.Router constructor");
+    }
+    // get parameter 1 "semitones" as integer
+    SQInteger semitones;
+    if (SQ_FAILED(sq_getinteger(vm, 2, &semitones))){
+        return sq_throwerror(vm, "argument 1 \"semitones\" is not of type integer");
+    }
+
+    // call the implementation
+    try {
+        obj->transpose(semitones);
+    }
+    catch(std::exception const& e) {
+        return sq_throwerror(vm, e.what());
+    }
+
+    // void method, returns no value
+    return 0;
+}
+
+//
+// Midi.Router velocityCurve
+//
+SQInteger MidiRoutervelocityCurve(HSQUIRRELVM vm)
+{
+    SQInteger numargs = sq_gettop(vm);
+    // check parameter count
+    if(numargs > 2) {
+        return sq_throwerror(vm, "too many parameters, expected at most 1");
+    }
+    if(numargs < 2) {
+        return sq_throwerror(vm, "insufficient parameters, expected at least 1");
+    }
+    // get "this" pointer
+    SQUserPointer userPtr = 0;
+    if (SQ_FAILED(sq_getinstanceup(vm, 1, &userPtr, 0))) {
+        return sq_throwerror(vm, "velocityCurve method needs an instance of Router");
+    }
+    Router *obj = static_cast<Router*>(userPtr);
+    if(!obj) {
+        return sq_throwerror(vm, "velocityCurve method called before Midi.Router constructor");
+    }
+    // get parameter 1 "exponent" as float
+    SQFloat exponent;
+    if (SQ_FAILED(sq_getfloat(vm, 2, &exponent))){
+        return sq_throwerror(vm, "argument 1 \"exponent\" is not of type float");
+    }
+
+    // call the implementation
+    try {
+        obj->velocityCurve(exponent);
+    }
+    catch(std::exception const& e) {
+        return sq_throwerror(vm, e.what());
+    }
+
+    // void method, returns no value
+    return 0;
+}
+
+
+//
+// Midi.ClockOut class
+//
+SQInteger MidiClockOutCtor(HSQUIRRELVM vm)
+{
+    SQInteger numargs = sq_gettop(vm);
+    // check parameter count
+    if(numargs > 1) {
+        return sq_throwerror(vm, "too many parameters, expected at most 0");
+    }
+    ClockOut *obj;
+    // call the implementation
+    try {
+        obj = midi::ClockOutCache::instance().getClockOut();
+    }
+    catch(std::exception const& e) {
+        return sq_throwerror(vm, e.what());
+    }
+
+    // return pointer to new object
+    sq_setinstanceup(vm, 1, (SQUserPointer*)obj);
+    return 1;
+}
+
+//
+// Midi.ClockOut midiOutput
+//
+SQInteger MidiClockOutmidiOutput(HSQUIRRELVM vm)
+{
+    SQInteger numargs = sq_gettop(vm);
+    // check parameter count
+    if(numargs > 2) {
+        return sq_throwerror(vm, "too many parameters, expected at most 1");
+    }
+    if(numargs < 2) {
+        return sq_throwerror(vm, "insufficient parameters, expected at least 1");
+    }
+    // get "this" pointer
+    SQUserPointer userPtr = 0;
+    if (SQ_FAILED(sq_getinstanceup(vm, 1, &userPtr, 0))) {
+        return sq_throwerror(vm, "midiOutput method needs an instance of ClockOut");
+    }
+    ClockOut *obj = static_cast<ClockOut*>(userPtr);
+    if(!obj) {
+        return sq_throwerror(vm, "midiOutput method called before Midi.ClockOut constructor");
+    }
+    // get parameter 1 "index" as integer
+    SQInteger index;
+    if (SQ_FAILED(sq_getinteger(vm, 2, &index))){
+        return sq_throwerror(vm, "argument 1 \"index\" is not of type integer");
+    }
+
+    // return value
+    midi::MidiConnection* ret;
+    // call the implementation
+    try {
+        ret = obj->getMidiConnection(index);
+    }
+    catch(std::exception const& e) {
+        return sq_throwerror(vm, e.what());
+    }
+
+    // push return value
+    sq_pushobject(vm, MidiOutputObject);
+    sq_createinstance(vm, -1);
+    sq_remove(vm, -2);
+    sq_setinstanceup(vm, -1, ret);
+    // no release hook, release ignored per binding
+
+    return 1;
+}
+
+//
+// Midi.ClockOut onControl
+//
+SQInteger MidiClockOutonControl(HSQUIRRELVM vm)
+{
+    SQInteger numargs = sq_gettop(vm);
+    // check parameter count
+    if(numargs > 2) {
+        return sq_throwerror(vm, "too many parameters, expected at most 1");
+    }
+    if(numargs < 2) {
+        return sq_throwerror(vm, "insufficient parameters, expected at least 1");
+    }
+    // get "this" pointer
+    SQUserPointer userPtr = 0;
+    if (SQ_FAILED(sq_getinstanceup(vm, 1, &userPtr, 0))) {
+        return sq_throwerror(vm, "onControl method needs an instance of ClockOut");
+    }
+    ClockOut *obj = static_cast<ClockOut*>(userPtr);
+    if(!obj) {
+        return sq_throwerror(vm, "onControl method called before Midi.ClockOut constructor");
+    }
+    // get parameter 1 "handler" as function
+    HSQOBJECT handlerObj;
+    if (SQ_FAILED(sq_getstackobj(vm, 2, &handlerObj))) {
+        return sq_throwerror(vm, "argument 1 \"handler\" is not of type function");
+    }
+    if (sq_gettype(vm, 2) != OT_CLOSURE) {
+        return sq_throwerror(vm, "argument 1 \"handler\" is not of type function");
+    }
+    SQUnsignedInteger nparams, nfreevars;
+    sq_getclosureinfo(vm, 2, &nparams, &nfreevars);
+    sq_addref(vm, &handlerObj);
+    ScriptFunction handler(vm, handlerObj, nparams);
+
+    // call the implementation
+    try {
+        obj->onControl(handler);
+    }
+    catch(std::exception const& e) {
+        return sq_throwerror(vm, e.what());
+    }
+
+    // void method, returns no value
+    return 0;
+}
+
+//
+// Midi.ClockOut onNoteOff
+//
+SQInteger MidiClockOutonNoteOff(HSQUIRRELVM vm)
+{
+    SQInteger numargs = sq_gettop(vm);
+    // check parameter count
+    if(numargs > 2) {
+        return sq_throwerror(vm, "too many parameters, expected at most 1");
+    }
+    if(numargs < 2) {
+        return sq_throwerror(vm, "insufficient parameters, expected at least 1");
+    }
+    // get "this" pointer
+    SQUserPointer userPtr = 0;
+    if (SQ_FAILED(sq_getinstanceup(vm, 1, &userPtr, 0))) {
+        return sq_throwerror(vm, "onNoteOff method needs an instance of ClockOut");
+    }
+    ClockOut *obj = static_cast<ClockOut*>(userPtr);
+    if(!obj) {
+        return sq_throwerror(vm, "onNoteOff method called before Midi.ClockOut constructor");
+    }
+    // get parameter 1 "handler" as function
+    HSQOBJECT handlerObj;
+    if (SQ_FAILED(sq_getstackobj(vm, 2, &handlerObj))) {
+        return sq_throwerror(vm, "argument 1 \"handler\" is not of type function");
+    }
+    if (sq_gettype(vm, 2) != OT_CLOSURE) {
+        return sq_throwerror(vm, "argument 1 \"handler\" is not of type function");
+    }
+    SQUnsignedInteger nparams, nfreevars;
+    sq_getclosureinfo(vm, 2, &nparams, &nfreevars);
+    sq_addref(vm, &handlerObj);
+    ScriptFunction handler(vm, handlerObj, nparams);
+
+    // call the implementation
+    try {
+        obj->onNoteOff(handler);
+    }
+    catch(std::exception const& e) {
+        return sq_throwerror(vm, e.what());
+    }
+
+    // void method, returns no value
+    return 0;
+}
+
+//
+// Midi.ClockOut onNoteOn
+//
+SQInteger MidiClockOutonNoteOn(HSQUIRRELVM vm)
+{
+    SQInteger numargs = sq_gettop(vm);
+    // check parameter count
+    if(numargs > 2) {
+        return sq_throwerror(vm, "too many parameters, expected at most 1");
+    }
+    if(numargs < 2) {
+        return sq_throwerror(vm, "insufficient parameters, expected at least 1");
+    }
+    // get "this" pointer
+    SQUserPointer userPtr = 0;
+    if (SQ_FAILED(sq_getinstanceup(vm, 1, &userPtr, 0))) {
+        return sq_throwerror(vm, "onNoteOn method needs an instance of ClockOut");
+    }
+    ClockOut *obj = static_cast<ClockOut*>(userPtr);
+    if(!obj) {
+        return sq_throwerror(vm, "onNoteOn method called before Midi.ClockOut constructor");
+    }
+    // get parameter 1 "handler" as function
+    HSQOBJECT handlerObj;
+    if (SQ_FAILED(sq_getstackobj(vm, 2, &handlerObj))) {
+        return sq_throwerror(vm, "argument 1 \"handler\" is not of type function");
+    }
+    if (sq_gettype(vm, 2) != OT_CLOSURE) {
+        return sq_throwerror(vm, "argument 1 \"handler\" is not of type function");
+    }
+    SQUnsignedInteger nparams, nfreevars;
+    sq_getclosureinfo(vm, 2, &nparams, &nfreevars);
+    sq_addref(vm, &handlerObj);
+    ScriptFunction handler(vm, handlerObj, nparams);
+
+    // call the implementation
+    try {
+        obj->onNoteOn(handler);
+    }
+    catch(std::exception const& e) {
+        return sq_throwerror(vm, e.what());
+    }
+
+    // void method, returns no value
+    return 0;
+}
+
+//
+// Midi.ClockIn class
+//
+SQInteger MidiClockInCtor(HSQUIRRELVM vm)
+{
+    SQInteger numargs = sq_gettop(vm);
+    // check parameter count
+    if(numargs > 4) {
+        return sq_throwerror(vm, "too many parameters, expected at most 3");
+    }
+    if(numargs < 2) {
+        return sq_throwerror(vm, "insufficient parameters, expected at least 1");
+    }
+    // get parameter 1 "bpm" as float
+    SQFloat bpm;
+    if (SQ_FAILED(sq_getfloat(vm, 2, &bpm))){
+        return sq_throwerror(vm, "argument 1 \"bpm\" is not of type float");
+    }
+
+    ClockIn *obj;
+    // 2 parameters passed in
+    if(numargs == 3) {
+
+        // get parameter 2 "numerator" as integer
+        SQInteger numerator;
+        if (SQ_FAILED(sq_getinteger(vm, 3, &numerator))){
+            return sq_throwerror(vm, "argument 2 \"numerator\" is not of type integer");
+        }
+
+        // call the implementation
+        try {
+            obj = midi::ClockInCache::instance().getClockIn(bpm, numerator);
+        }
+        catch(std::exception const& e) {
+            return sq_throwerror(vm, e.what());
+        }
     }
-    SQUnsignedInteger nparams, nfreevars;
-    sq_getclosureinfo(vm, 2, &nparams, &nfreevars);
-    sq_addref(vm, &handlerObj);
-    ScriptFunction handler(vm, handlerObj, nparams);
 
-    // call the implementation
-    try {
-        obj->onCount(handler);
+    // 3 parameters passed in
+    else if(numargs == 4) {
+
+        // get parameter 2 "numerator" as integer
+        SQInteger numerator;
+        if (SQ_FAILED(sq_getinteger(vm, 3, &numerator))){
+            return sq_throwerror(vm, "argument 2 \"numerator\" is not of type integer");
+        }
+
+        // get parameter 3 "denominator" as integer
+        SQInteger denominator;
+        if (SQ_FAILED(sq_getinteger(vm, 4, &denominator))){
+            return sq_throwerror(vm, "argument 3 \"denominator\" is not of type integer");
+        }
+
+        // call the implementation
+        try {
+            obj = midi::ClockInCache::instance().getClockIn(bpm, numerator, denominator);
+        }
+        catch(std::exception const& e) {
+            return sq_throwerror(vm, e.what());
+        }
     }
-    catch(std::exception const& e) {
-        return sq_throwerror(vm, e.what());
+
+    else {
+        // call the implementation
+        try {
+            obj = midi::ClockInCache::instance().getClockIn(bpm);
+        }
+        catch(std::exception const& e) {
+            return sq_throwerror(vm, e.what());
+        }
     }
 
-    // void method, returns no value
-    return 0;
+    // return pointer to new object
+    sq_setinstanceup(vm, 1, (SQUserPointer*)obj);
+    return 1;
 }
 
 //
-// Midi.BeatTracker stopOnSilence
+// Midi.ClockIn connectMidi
 //
-SQInteger MidiBeatTrackerstopOnSilence(HSQUIRRELVM vm)
+SQInteger MidiClockInconnectMidi(HSQUIRRELVM vm)
 {
     SQInteger numargs = sq_gettop(vm);
     // check parameter count
@@ -3005,21 +5450,21 @@ SQInteger MidiBeatTrackerstopOnSilence(HSQUIRRELVM vm)
     // get "this" pointer
     SQUserPointer userPtr = 0;
     if (SQ_FAILED(sq_getinstanceup(vm, 1, &userPtr, 0))) {
-        return sq_throwerror(vm, "stopOnSilence method needs an instance of BeatTracker");
+        return sq_throwerror(vm, "connectMidi method needs an instance of ClockIn");
     }
-    BeatTracker *obj = static_cast<BeatTracker*>(userPtr);
+    ClockIn *obj = static_cast<ClockIn*>(userPtr);
     if(!obj) {
-        return sq_throwerror(vm, "stopOnSilence method called before Midi.BeatTracker constructor");
+        return sq_throwerror(vm, "connectMidi method called before Midi.ClockIn constructor");
     }
-    // get parameter 1 "seconds" as integer
-    SQInteger seconds;
-    if (SQ_FAILED(sq_getinteger(vm, 2, &seconds))){
-        return sq_throwerror(vm, "argument 1 \"seconds\" is not of type integer");
+    // get parameter 1 "source" as Midi.Source
+    midi::Source *source = getMidiSource(vm, 2);
+    if(source == 0) {
+        return sq_throwerror(vm, "argument 1 \"source\" is not of type Midi.Source");
     }
 
     // call the implementation
     try {
-        obj->stopOnSilence(seconds);
+        obj->connectMidi(*source);
     }
     catch(std::exception const& e) {
         return sq_throwerror(vm, e.what());
@@ -3029,7 +5474,6 @@ SQInteger MidiBeatTrackerstopOnSilence(HSQUIRRELVM vm)
     return 0;
 }
 
-
 void bindMidi(HSQUIRRELVM vm)
 {
     // create package table
@@ -3326,6 +5770,10 @@ void bindMidi(HSQUIRRELVM vm)
     sq_newclosure(vm, &MidiPatternadd, 0);
     sq_newslot(vm, -3, false);
 
+    sq_pushstring(vm, _SC("merge"), -1);
+    sq_newclosure(vm, &MidiPatternmerge, 0);
+    sq_newslot(vm, -3, false);
+
     sq_pushstring(vm, _SC("note"), -1);
     sq_newclosure(vm, &MidiPatternnote, 0);
     sq_newslot(vm, -3, false);
@@ -3334,6 +5782,18 @@ void bindMidi(HSQUIRRELVM vm)
     sq_newclosure(vm, &MidiPatternprint, 0);
     sq_newslot(vm, -3, false);
 
+    sq_pushstring(vm, _SC("quantize"), -1);
+    sq_newclosure(vm, &MidiPatternquantize, 0);
+    sq_newslot(vm, -3, false);
+
+    sq_pushstring(vm, _SC("scaleVelocity"), -1);
+    sq_newclosure(vm, &MidiPatternscaleVelocity, 0);
+    sq_newslot(vm, -3, false);
+
+    sq_pushstring(vm, _SC("shift"), -1);
+    sq_newclosure(vm, &MidiPatternshift, 0);
+    sq_newslot(vm, -3, false);
+
     sq_pushstring(vm, _SC("size"), -1);
     sq_newclosure(vm, &MidiPatternsize, 0);
     sq_newslot(vm, -3, false);
@@ -3398,14 +5858,30 @@ void bindMidi(HSQUIRRELVM vm)
     sq_newslot(vm, -3, false);
 
     // methods for class SystemOut
+    sq_pushstring(vm, _SC("connectMidi"), -1);
+    sq_newclosure(vm, &MidiSystemOutconnectMidi, 0);
+    sq_newslot(vm, -3, false);
+
+    sq_pushstring(vm, _SC("humanize"), -1);
+    sq_newclosure(vm, &MidiSystemOuthumanize, 0);
+    sq_newslot(vm, -3, false);
+
     sq_pushstring(vm, _SC("midiChannel"), -1);
     sq_newclosure(vm, &MidiSystemOutmidiChannel, 0);
     sq_newslot(vm, -3, false);
 
+    sq_pushstring(vm, _SC("quantize"), -1);
+    sq_newclosure(vm, &MidiSystemOutquantize, 0);
+    sq_newslot(vm, -3, false);
+
     sq_pushstring(vm, _SC("schedule"), -1);
     sq_newclosure(vm, &MidiSystemOutschedule, 0);
     sq_newslot(vm, -3, false);
 
+    sq_pushstring(vm, _SC("swing"), -1);
+    sq_newclosure(vm, &MidiSystemOutswing, 0);
+    sq_newslot(vm, -3, false);
+
     // push SystemOut to Midi package table
     sq_newslot(vm, -3, false);
 
@@ -3449,6 +5925,26 @@ void bindMidi(HSQUIRRELVM vm)
     // push ProgramChange to Midi package table
     sq_newslot(vm, -3, false);
 
+    // create class Midi.SysEx
+    sq_pushstring(vm, "SysEx", -1);
+    sq_newclass(vm, false);
+    sq_getstackobj(vm, -1, &MidiSysExObject);
+    sq_settypetag(vm, -1, &MidiSysExObject);
+
+    // ctor for class SysEx
+    sq_pushstring(vm, _SC("constructor"), -1);
+    sq_newclosure(vm, &MidiSysExCtor, 0);
+    sq_newslot(vm, -3, false);
+
+    // clone for class SysEx
+    sq_pushstring(vm, _SC("_cloned"), -1);
+    sq_newclosure(vm, &MidiSysExClone, 0);
+    sq_newslot(vm, -3, false);
+
+    // methods for class SysEx
+    // push SysEx to Midi package table
+    sq_newslot(vm, -3, false);
+
     // create class Midi.BeatTracker
     sq_pushstring(vm, "BeatTracker", -1);
     sq_newclass(vm, false);
@@ -3474,6 +5970,18 @@ void bindMidi(HSQUIRRELVM vm)
     sq_newclosure(vm, &MidiBeatTrackercountIn, 0);
     sq_newslot(vm, -3, false);
 
+    sq_pushstring(vm, _SC("countInVelocity"), -1);
+    sq_newclosure(vm, &MidiBeatTrackercountInVelocity, 0);
+    sq_newslot(vm, -3, false);
+
+    sq_pushstring(vm, _SC("countInWindow"), -1);
+    sq_newclosure(vm, &MidiBeatTrackercountInWindow, 0);
+    sq_newslot(vm, -3, false);
+
+    sq_pushstring(vm, _SC("hopSize"), -1);
+    sq_newclosure(vm, &MidiBeatTrackerhopSize, 0);
+    sq_newslot(vm, -3, false);
+
     sq_pushstring(vm, _SC("noteWeight"), -1);
     sq_newclosure(vm, &MidiBeatTrackernoteWeight, 0);
     sq_newslot(vm, -3, false);
@@ -3493,6 +6001,242 @@ void bindMidi(HSQUIRRELVM vm)
     // push BeatTracker to Midi package table
     sq_newslot(vm, -3, false);
 
+    // create class Midi.Loop
+    sq_pushstring(vm, "Loop", -1);
+    sq_newclass(vm, false);
+    sq_getstackobj(vm, -1, &MidiLoopObject);
+    sq_settypetag(vm, -1, &MidiLoopObject);
+
+    // ctor for class Loop
+    sq_pushstring(vm, _SC("constructor"), -1);
+    sq_newclosure(vm, &MidiLoopCtor, 0);
+    sq_newslot(vm, -3, false);
+
+    // clone for class Loop
+    sq_pushstring(vm, _SC("_cloned"), -1);
+    sq_newclosure(vm, &unclonable, 0);
+    sq_newslot(vm, -3, false);
+
+    // methods for class Loop
+    sq_pushstring(vm, _SC("midiOutput"), -1);
+    sq_newclosure(vm, &MidiLoopmidiOutput, 0);
+    sq_newslot(vm, -3, false);
+
+    sq_pushstring(vm, _SC("onControl"), -1);
+    sq_newclosure(vm, &MidiLooponControl, 0);
+    sq_newslot(vm, -3, false);
+
+    sq_pushstring(vm, _SC("onNoteOff"), -1);
+    sq_newclosure(vm, &MidiLooponNoteOff, 0);
+    sq_newslot(vm, -3, false);
+
+    sq_pushstring(vm, _SC("onNoteOn"), -1);
+    sq_newclosure(vm, &MidiLooponNoteOn, 0);
+    sq_newslot(vm, -3, false);
+
+    sq_pushstring(vm, _SC("play"), -1);
+    sq_newclosure(vm, &MidiLoopplay, 0);
+    sq_newslot(vm, -3, false);
+
+    // push Loop to Midi package table
+    sq_newslot(vm, -3, false);
+
+    // create class Midi.SMFReader
+    sq_pushstring(vm, "SMFReader", -1);
+    sq_newclass(vm, false);
+    sq_getstackobj(vm, -1, &MidiSMFReaderObject);
+    sq_settypetag(vm, -1, &MidiSMFReaderObject);
+
+    // ctor for class SMFReader
+    sq_pushstring(vm, _SC("constructor"), -1);
+    sq_newclosure(vm, &MidiSMFReaderCtor, 0);
+    sq_newslot(vm, -3, false);
+
+    // clone for class SMFReader
+    sq_pushstring(vm, _SC("_cloned"), -1);
+    sq_newclosure(vm, &MidiSMFReaderClone, 0);
+    sq_newslot(vm, -3, false);
+
+    // methods for class SMFReader
+    sq_pushstring(vm, _SC("read"), -1);
+    sq_newclosure(vm, &MidiSMFReaderread, 0);
+    sq_newslot(vm, -3, false);
+
+    sq_pushstring(vm, _SC("readTune"), -1);
+    sq_newclosure(vm, &MidiSMFReaderreadTune, 0);
+    sq_newslot(vm, -3, false);
+
+    // push SMFReader to Midi package table
+    sq_newslot(vm, -3, false);
+
+    // create class Midi.SMFWriter
+    sq_pushstring(vm, "SMFWriter", -1);
+    sq_newclass(vm, false);
+    sq_getstackobj(vm, -1, &MidiSMFWriterObject);
+    sq_settypetag(vm, -1, &MidiSMFWriterObject);
+
+    // ctor for class SMFWriter
+    sq_pushstring(vm, _SC("constructor"), -1);
+    sq_newclosure(vm, &MidiSMFWriterCtor, 0);
+    sq_newslot(vm, -3, false);
+
+    // clone for class SMFWriter
+    sq_pushstring(vm, _SC("_cloned"), -1);
+    sq_newclosure(vm, &unclonable, 0);
+    sq_newslot(vm, -3, false);
+
+    // methods for class SMFWriter
+    sq_pushstring(vm, _SC("connectMidi"), -1);
+    sq_newclosure(vm, &MidiSMFWriterconnectMidi, 0);
+    sq_newslot(vm, -3, false);
+
+    // push SMFWriter to Midi package table
+    sq_newslot(vm, -3, false);
+
+    // create class Midi.Router
+    sq_pushstring(vm, "Router", -1);
+    sq_newclass(vm, false);
+    sq_getstackobj(vm, -1, &MidiRouterObject);
+    sq_settypetag(vm, -1, &MidiRouterObject);
+
+    // ctor for class Router
+    sq_pushstring(vm, _SC("constructor"), -1);
+    sq_newclosure(vm, &MidiRouterCtor, 0);
+    sq_newslot(vm, -3, false);
+
+    // clone for class Router
+    sq_pushstring(vm, _SC("_cloned"), -1);
+    sq_newclosure(vm, &unclonable, 0);
+    sq_newslot(vm, -3, false);
+
+    // methods for class Router
+    sq_pushstring(vm, _SC("connectMidi"), -1);
+    sq_newclosure(vm, &MidiRouterconnectMidi, 0);
+    sq_newslot(vm, -3, false);
+
+    sq_pushstring(vm, _SC("humanize"), -1);
+    sq_newclosure(vm, &MidiRouterhumanize, 0);
+    sq_newslot(vm, -3, false);
+
+    sq_pushstring(vm, _SC("mapChannel"), -1);
+    sq_newclosure(vm, &MidiRoutermapChannel, 0);
+    sq_newslot(vm, -3, false);
+
+    sq_pushstring(vm, _SC("mapControl"), -1);
+    sq_newclosure(vm, &MidiRoutermapControl, 0);
+    sq_newslot(vm, -3, false);
+
+    sq_pushstring(vm, _SC("midiChannel"), -1);
+    sq_newclosure(vm, &MidiRoutermidiChannel, 0);
+    sq_newslot(vm, -3, false);
+
+    sq_pushstring(vm, _SC("midiOutput"), -1);
+    sq_newclosure(vm, &MidiRoutermidiOutput, 0);
+    sq_newslot(vm, -3, false);
+
+    sq_pushstring(vm, _SC("noteRange"), -1);
+    sq_newclosure(vm, &MidiRouternoteRange, 0);
+    sq_newslot(vm, -3, false);
+
+    sq_pushstring(vm, _SC("onControl"), -1);
+    sq_newclosure(vm, &MidiRouteronControl, 0);
+    sq_newslot(vm, -3, false);
+
+    sq_pushstring(vm, _SC("onNoteOff"), -1);
+    sq_newclosure(vm, &MidiRouteronNoteOff, 0);
+    sq_newslot(vm, -3, false);
+
+    sq_pushstring(vm, _SC("onNoteOn"), -1);
+    sq_newclosure(vm, &MidiRouteronNoteOn, 0);
+    sq_newslot(vm, -3, false);
+
+    sq_pushstring(vm, _SC("quantize"), -1);
+    sq_newclosure(vm, &MidiRouterquantize, 0);
+    sq_newslot(vm, -3, false);
+
+    sq_pushstring(vm, _SC("schedule"), -1);
+    sq_newclosure(vm, &MidiRouterschedule, 0);
+    sq_newslot(vm, -3, false);
+
+    sq_pushstring(vm, _SC("split"), -1);
+    sq_newclosure(vm, &MidiRoutersplit, 0);
+    sq_newslot(vm, -3, false);
+
+    sq_pushstring(vm, _SC("swing"), -1);
+    sq_newclosure(vm, &MidiRouterswing, 0);
+    sq_newslot(vm, -3, false);
+
+    sq_pushstring(vm, _SC("transpose"), -1);
+    sq_newclosure(vm, &MidiRoutertranspose, 0);
+    sq_newslot(vm, -3, false);
+
+    sq_pushstring(vm, _SC("velocityCurve"), -1);
+    sq_newclosure(vm, &MidiRoutervelocityCurve, 0);
+    sq_newslot(vm, -3, false);
+
+    // push Router to Midi package table
+    sq_newslot(vm, -3, false);
+
+    // create class Midi.ClockOut
+    sq_pushstring(vm, "ClockOut", -1);
+    sq_newclass(vm, false);
+    sq_getstackobj(vm, -1, &MidiClockOutObject);
+    sq_settypetag(vm, -1, &MidiClockOutObject);
+
+    // ctor for class ClockOut
+    sq_pushstring(vm, _SC("constructor"), -1);
+    sq_newclosure(vm, &MidiClockOutCtor, 0);
+    sq_newslot(vm, -3, false);
+
+    // clone for class ClockOut
+    sq_pushstring(vm, _SC("_cloned"), -1);
+    sq_newclosure(vm, &unclonable, 0);
+    sq_newslot(vm, -3, false);
+
+    // methods for class ClockOut
+    sq_pushstring(vm, _SC("midiOutput"), -1);
+    sq_newclosure(vm, &MidiClockOutmidiOutput, 0);
+    sq_newslot(vm, -3, false);
+
+    sq_pushstring(vm, _SC("onControl"), -1);
+    sq_newclosure(vm, &MidiClockOutonControl, 0);
+    sq_newslot(vm, -3, false);
+
+    sq_pushstring(vm, _SC("onNoteOff"), -1);
+    sq_newclosure(vm, &MidiClockOutonNoteOff, 0);
+    sq_newslot(vm, -3, false);
+
+    sq_pushstring(vm, _SC("onNoteOn"), -1);
+    sq_newclosure(vm, &MidiClockOutonNoteOn, 0);
+    sq_newslot(vm, -3, false);
+
+    // push ClockOut to Midi package table
+    sq_newslot(vm, -3, false);
+
+    // create class Midi.ClockIn
+    sq_pushstring(vm, "ClockIn", -1);
+    sq_newclass(vm, false);
+    sq_getstackobj(vm, -1, &MidiClockInObject);
+    sq_settypetag(vm, -1, &MidiClockInObject);
+
+    // ctor for class ClockIn
+    sq_pushstring(vm, _SC("constructor"), -1);
+    sq_newclosure(vm, &MidiClockInCtor, 0);
+    sq_newslot(vm, -3, false);
+
+    // clone for class ClockIn
+    sq_pushstring(vm, _SC("_cloned"), -1);
+    sq_newclosure(vm, &unclonable, 0);
+    sq_newslot(vm, -3, false);
+
+    // methods for class ClockIn
+    sq_pushstring(vm, _SC("connectMidi"), -1);
+    sq_newclosure(vm, &MidiClockInconnectMidi, 0);
+    sq_newslot(vm, -3, false);
+
+    // push ClockIn to Midi package table
+    sq_newslot(vm, -3, false);
+
     // push package "Midi" to root table
     sq_newslot(vm, -3, false);
 }
@@ -46,7 +46,14 @@ namespace binding
     extern HSQOBJECT MidiSystemOutObject;
     extern HSQOBJECT MidiPitchBendObject;
     extern HSQOBJECT MidiProgramChangeObject;
+    extern HSQOBJECT MidiSysExObject;
     extern HSQOBJECT MidiBeatTrackerObject;
+    extern HSQOBJECT MidiLoopObject;
+    extern HSQOBJECT MidiSMFReaderObject;
+    extern HSQOBJECT MidiSMFWriterObject;
+    extern HSQOBJECT MidiRouterObject;
+    extern HSQOBJECT MidiClockOutObject;
+    extern HSQOBJECT MidiClockInObject;
     SQInteger MidiNoteOnPush(HSQUIRRELVM vm, midi::NoteOn *);
     SQInteger MidiNoteOffPush(HSQUIRRELVM vm, midi::NoteOff *);
     SQInteger MidiControlPush(HSQUIRRELVM vm, midi::Control *);
@@ -64,6 +71,8 @@ namespace binding
     SQInteger MidiTuneRelease(SQUserPointer p, SQInteger size);
     SQInteger MidiPitchBendRelease(SQUserPointer p, SQInteger size);
     SQInteger MidiProgramChangeRelease(SQUserPointer p, SQInteger size);
+    SQInteger MidiSysExRelease(SQUserPointer p, SQInteger size);
+    SQInteger MidiSMFReaderRelease(SQUserPointer p, SQInteger size);
     // method to bind this package
     void bindMidi(HSQUIRRELVM vm);
 }}
@@ -247,6 +247,174 @@ SQInteger TransportMasterCtor(HSQUIRRELVM vm)
     return 1;
 }
 
+//
+// Transport.Master scheduleBpm
+//
+SQInteger TransportMasterscheduleBpm(HSQUIRRELVM vm)
+{
+    SQInteger numargs = sq_gettop(vm);
+    // check parameter count
+    if(numargs > 5) {
+        return sq_throwerror(vm, "too many parameters, expected at most 4");
+    }
+    if(numargs < 5) {
+        return sq_throwerror(vm, "insufficient parameters, expected at least 4");
+    }
+    // get "this" pointer
+    SQUserPointer userPtr = 0;
+    if (SQ_FAILED(sq_getinstanceup(vm, 1, &userPtr, 0))) {
+        return sq_throwerror(vm, "scheduleBpm method needs an instance of Master");
+    }
+    Master *obj = static_cast<Master*>(userPtr);
+    if(!obj) {
+        return sq_throwerror(vm, "scheduleBpm method called before Transport.Master constructor");
+    }
+    // get parameter 1 "bpm" as float
+    SQFloat bpm;
+    if (SQ_FAILED(sq_getfloat(vm, 2, &bpm))){
+        return sq_throwerror(vm, "argument 1 \"bpm\" is not of type float");
+    }
+
+    // get parameter 2 "bar" as integer
+    SQInteger bar;
+    if (SQ_FAILED(sq_getinteger(vm, 3, &bar))){
+        return sq_throwerror(vm, "argument 2 \"bar\" is not of type integer");
+    }
+
+    // get parameter 3 "position" as integer
+    SQInteger position;
+    if (SQ_FAILED(sq_getinteger(vm, 4, &position))){
+        return sq_throwerror(vm, "argument 3 \"position\" is not of type integer");
+    }
+
+    // get parameter 4 "division" as integer
+    SQInteger division;
+    if (SQ_FAILED(sq_getinteger(vm, 5, &division))){
+        return sq_throwerror(vm, "argument 4 \"division\" is not of type integer");
+    }
+
+    // call the implementation
+    try {
+        obj->scheduleBpm(bpm, bar, position, division);
+    }
+    catch(std::exception const& e) {
+        return sq_throwerror(vm, e.what());
+    }
+
+    // void method, returns no value
+    return 0;
+}
+
+//
+// Transport.Master scheduleRamp
+//
+SQInteger TransportMasterscheduleRamp(HSQUIRRELVM vm)
+{
+    SQInteger numargs = sq_gettop(vm);
+    // check parameter count
+    if(numargs > 5) {
+        return sq_throwerror(vm, "too many parameters, expected at most 4");
+    }
+    if(numargs < 5) {
+        return sq_throwerror(vm, "insufficient parameters, expected at least 4");
+    }
+    // get "this" pointer
+    SQUserPointer userPtr = 0;
+    if (SQ_FAILED(sq_getinstanceup(vm, 1, &userPtr, 0))) {
+        return sq_throwerror(vm, "scheduleRamp method needs an instance of Master");
+    }
+    Master *obj = static_cast<Master*>(userPtr);
+    if(!obj) {
+        return sq_throwerror(vm, "scheduleRamp method called before Transport.Master constructor");
+    }
+    // get parameter 1 "bpm" as float
+    SQFloat bpm;
+    if (SQ_FAILED(sq_getfloat(vm, 2, &bpm))){
+        return sq_throwerror(vm, "argument 1 \"bpm\" is not of type float");
+    }
+
+    // get parameter 2 "bar" as integer
+    SQInteger bar;
+    if (SQ_FAILED(sq_getinteger(vm, 3, &bar))){
+        return sq_throwerror(vm, "argument 2 \"bar\" is not of type integer");
+    }
+
+    // get parameter 3 "position" as integer
+    SQInteger position;
+    if (SQ_FAILED(sq_getinteger(vm, 4, &position))){
+        return sq_throwerror(vm, "argument 3 \"position\" is not of type integer");
+    }
+
+    // get parameter 4 "division" as integer
+    SQInteger division;
+    if (SQ_FAILED(sq_getinteger(vm, 5, &division))){
+        return sq_throwerror(vm, "argument 4 \"division\" is not of type integer");
+    }
+
+    // call the implementation
+    try {
+        obj->scheduleRamp(bpm, bar, position, division);
+    }
+    catch(std::exception const& e) {
+        return sq_throwerror(vm, e.what());
+    }
+
+    // void method, returns no value
+    return 0;
+}
+
+//
+// Transport.Master scheduleTimeSignature
+//
+SQInteger TransportMasterscheduleTimeSignature(HSQUIRRELVM vm)
+{
+    SQInteger numargs = sq_gettop(vm);
+    // check parameter count
+    if(numargs > 4) {
+        return sq_throwerror(vm, "too many parameters, expected at most 3");
+    }
+    if(numargs < 4) {
+        return sq_throwerror(vm, "insufficient parameters, expected at least 3");
+    }
+    // get "this" pointer
+    SQUserPointer userPtr = 0;
+    if (SQ_FAILED(sq_getinstanceup(vm, 1, &userPtr, 0))) {
+        return sq_throwerror(vm, "scheduleTimeSignature method needs an instance of Master");
+    }
+    Master *obj = static_cast<Master*>(userPtr);
+    if(!obj) {
+        return sq_throwerror(vm, "scheduleTimeSignature method called before Transport.Master constructor");
+    }
+    // get parameter 1 "numerator" as integer
+    SQInteger numerator;
+    if (SQ_FAILED(sq_getinteger(vm, 2, &numerator))){
+        return sq_throwerror(vm, "argument 1 \"numerator\" is not of type integer");
+    }
+
+    // get parameter 2 "denominator" as integer
+    SQInteger denominator;
+    if (SQ_FAILED(sq_getinteger(vm, 3, &denominator))){
+        return sq_throwerror(vm, "argument 2 \"denominator\" is not of type integer");
+    }
+
+    // get parameter 3 "bar" as integer
+    SQInteger bar;
+    if (SQ_FAILED(sq_getinteger(vm, 4, &bar))){
+        return sq_throwerror(vm, "argument 3 \"bar\" is not of type integer");
+    }
+
+    // call the implementation
+    try {
+        obj->scheduleTimeSignature(numerator, denominator, bar);
+    }
+    catch(std::exception const& e) {
+        return sq_throwerror(vm, e.what());
+    }
+
+    // void method, returns no value
+    return 0;
+}
+
 //
 // Transport.Master timeSignature
 //
@@ -705,6 +873,18 @@ void bindTransport(HSQUIRRELVM vm)
     sq_newslot(vm, -3, false);
 
     // methods for class Master
+    sq_pushstring(vm, _SC("scheduleBpm"), -1);
+    sq_newclosure(vm, &TransportMasterscheduleBpm, 0);
+    sq_newslot(vm, -3, false);
+
+    sq_pushstring(vm, _SC("scheduleRamp"), -1);
+    sq_newclosure(vm, &TransportMasterscheduleRamp, 0);
+    sq_newslot(vm, -3, false);
+
+    sq_pushstring(vm, _SC("scheduleTimeSignature"), -1);
+    sq_newclosure(vm, &TransportMasterscheduleTimeSignature, 0);
+    sq_newslot(vm, -3, false);
+
     sq_pushstring(vm, _SC("timeSignature"), -1);
     sq_newclosure(vm, &TransportMastertimeSignature, 0);
     sq_newslot(vm, -3, false);
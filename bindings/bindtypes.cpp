@@ -22,7 +22,10 @@
 #include "bindlv2.h"
 #include "bindmidi.h"
 #include "lv2plugin.h"
+#include "midiclock.h"
+#include "midiloop.h"
 #include "midiport.h"
+#include "midirouter.h"
 #include "mixer.h"
 
 namespace bipscript {
@@ -63,6 +66,9 @@ namespace binding {
         if (!SQ_FAILED(sq_getinstanceup(vm, index, (SQUserPointer*)&sourcePtr, &MidiProgramChangeObject))) {
             return static_cast<midi::ProgramChange*>(sourcePtr);
         }
+        if (!SQ_FAILED(sq_getinstanceup(vm, index, (SQUserPointer*)&sourcePtr, &MidiSysExObject))) {
+            return static_cast<midi::SysEx*>(sourcePtr);
+        }
         return 0;
     }
     
@@ -74,6 +80,15 @@ namespace binding {
         if (!SQ_FAILED(sq_getinstanceup(vm, index, (SQUserPointer*)&sourcePtr, &MidiSystemInObject))) {
             return static_cast<midi::MidiInputPort*>(sourcePtr);
         }
+        if (!SQ_FAILED(sq_getinstanceup(vm, index, (SQUserPointer*)&sourcePtr, &MidiLoopObject))) {
+            return static_cast<midi::Loop*>(sourcePtr);
+        }
+        if (!SQ_FAILED(sq_getinstanceup(vm, index, (SQUserPointer*)&sourcePtr, &MidiRouterObject))) {
+            return static_cast<midi::Router*>(sourcePtr);
+        }
+        if (!SQ_FAILED(sq_getinstanceup(vm, index, (SQUserPointer*)&sourcePtr, &MidiClockOutObject))) {
+            return static_cast<midi::ClockOut*>(sourcePtr);
+        }
         return 0;
     }
     
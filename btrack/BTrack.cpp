@@ -50,10 +50,10 @@ BTrack::~BTrack()
 {
 #ifdef USE_FFTW
     // destroy fft plan
-    fftw_destroy_plan (acfForwardFFT);
-    fftw_destroy_plan (acfBackwardFFT);
-    fftw_free (complexIn);
-    fftw_free (complexOut);
+    FFTPlanCache::release (FFTPlanCache::RealToComplex, FFTLengthForACFCalculation);
+    FFTPlanCache::release (FFTPlanCache::ComplexToReal, FFTLengthForACFCalculation);
+    fftwf_free (realIn);
+    fftwf_free (complexOut);
 #endif
     
 #ifdef USE_KISS_FFT
@@ -146,11 +146,12 @@ void BTrack::initialise (int hopSize_, int frameSize_)
     FFTLengthForACFCalculation = 1024;
     
 #ifdef USE_FFTW
-    complexIn = (fftw_complex*) fftw_malloc (sizeof(fftw_complex) * FFTLengthForACFCalculation);		// complex array to hold fft data
-    complexOut = (fftw_complex*) fftw_malloc (sizeof(fftw_complex) * FFTLengthForACFCalculation);	// complex array to hold fft data
+    realIn = fftwf_alloc_real (FFTLengthForACFCalculation);								// real array to hold fft data
+    complexOut = fftwf_alloc_complex (FFTLengthForACFCalculation / 2 + 1);				// complex array to hold fft data
     
-    acfForwardFFT = fftw_plan_dft_1d (FFTLengthForACFCalculation, complexIn, complexOut, FFTW_FORWARD, FFTW_ESTIMATE);	// FFT plan initialisation
-    acfBackwardFFT = fftw_plan_dft_1d (FFTLengthForACFCalculation, complexOut, complexIn, FFTW_BACKWARD, FFTW_ESTIMATE);	// FFT plan initialisation
+    // the input is real so only half the spectrum is computed, plans are shared with other instances
+    acfForwardFFT = FFTPlanCache::acquire (FFTPlanCache::RealToComplex, FFTLengthForACFCalculation);	// FFT plan initialisation
+    acfBackwardFFT = FFTPlanCache::acquire (FFTPlanCache::ComplexToReal, FFTLengthForACFCalculation);	// FFT plan initialisation
 #endif
     
 #ifdef USE_KISS_FFT
@@ -204,6 +205,12 @@ bool BTrack::beatDueInCurrentFrame()
     return beatDueInFrame;
 }
 
+//=======================================================================
+int BTrack::getSamplesUntilBeat()
+{
+    return beatCounter;
+}
+
 //=======================================================================
 double BTrack::getCurrentTempoEstimate()
 {
@@ -537,33 +544,31 @@ void BTrack::calculateBalancedACF (double* onsetDetectionFunction)
     int onsetDetectionFunctionLength = 512;
     
 #ifdef USE_FFTW
-    // copy into complex array and zero pad
+    // copy into real array and zero pad
     for (int i = 0;i < FFTLengthForACFCalculation;i++)
     {
         if (i < onsetDetectionFunctionLength)
         {
-            complexIn[i][0] = onsetDetectionFunction[i];
-            complexIn[i][1] = 0.0;
+            realIn[i] = onsetDetectionFunction[i];
         }
         else
         {
-            complexIn[i][0] = 0.0;
-            complexIn[i][1] = 0.0;
+            realIn[i] = 0.0;
         }
     }
     
     // perform the fft
-    fftw_execute (acfForwardFFT);
+    fftwf_execute_dft_r2c (acfForwardFFT, realIn, complexOut);
     
     // multiply by complex conjugate
-    for (int i = 0;i < FFTLengthForACFCalculation;i++)
+    for (int i = 0;i < FFTLengthForACFCalculation / 2 + 1;i++)
     {
         complexOut[i][0] = complexOut[i][0]*complexOut[i][0] + complexOut[i][1]*complexOut[i][1];
         complexOut[i][1] = 0.0;
     }
     
-    // perform the ifft
-    fftw_execute (acfBackwardFFT);
+    // perform the ifft, the result is real
+    fftwf_execute_dft_c2r (acfBackwardFFT, complexOut, realIn);
     
 #endif
     
@@ -604,7 +609,7 @@ void BTrack::calculateBalancedACF (double* onsetDetectionFunction)
     {
 #ifdef USE_FFTW
         // calculate absolute value of result
-        double absValue = sqrt (complexIn[i][0]*complexIn[i][0] + complexIn[i][1]*complexIn[i][1]);
+        double absValue = fabs (realIn[i]);
 #endif
         
 #ifdef USE_KISS_FFT
@@ -24,6 +24,7 @@
 
 #include "OnsetDetectionFunction.h"
 #include "CircularBuffer.h"
+#include "FFTPlanCache.h"
 #include <vector>
 
 //=======================================================================
@@ -80,6 +81,10 @@ public:
     /** @returns true if a beat should occur in the current audio frame */
     bool beatDueInCurrentFrame();
 
+    /** @returns the number of onset detection function samples until the predicted beat,
+     * zero if a beat is due in the current frame or negative if no beat is predicted */
+    int getSamplesUntilBeat();
+
     /** @returns the current tempo estimate being used by the beat tracker */
     double getCurrentTempoEstimate();
     
@@ -217,10 +222,10 @@ private:
     int FFTLengthForACFCalculation;         /**< the FFT length for the auto-correlation function calculation */
     
 #ifdef USE_FFTW
-    fftw_plan acfForwardFFT;                /**< forward fftw plan for calculating auto-correlation function */
-    fftw_plan acfBackwardFFT;               /**< inverse fftw plan for calculating auto-correlation function */
-    fftw_complex* complexIn;                /**< to hold complex fft values for input */
-    fftw_complex* complexOut;               /**< to hold complex fft values for output */
+    fftwf_plan acfForwardFFT;               /**< forward (real to complex) fftw plan for calculating auto-correlation function, shared */
+    fftwf_plan acfBackwardFFT;              /**< inverse (complex to real) fftw plan for calculating auto-correlation function, shared */
+    float* realIn;                          /**< to hold real fft values for input and the auto-correlation function */
+    fftwf_complex* complexOut;              /**< to hold the (N/2)+1 complex fft values for output */
 #endif
     
 #ifdef USE_KISS_FFT
@@ -0,0 +1,84 @@
+//=======================================================================
+/** @file FFTPlanCache.cpp
+ *  @brief fftw plans shared between analysis instances of the same size
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+//=======================================================================
+
+#include "FFTPlanCache.h"
+
+#ifdef USE_FFTW
+
+#include <map>
+#include <mutex>
+#include <utility>
+
+//=======================================================================
+/** A shared plan and the number of instances holding it */
+struct SharedPlan
+{
+    fftwf_plan plan;
+    int references;
+};
+
+static std::mutex plannerMutex;
+static std::map<std::pair<int, int>, SharedPlan> plans;
+
+//=======================================================================
+fftwf_plan FFTPlanCache::acquire (Kind kind, int size)
+{
+    std::lock_guard<std::mutex> lock (plannerMutex);
+    
+    SharedPlan& shared = plans[std::make_pair ((int) kind, size)];
+    
+    if (shared.references++ > 0)
+    {
+        return shared.plan;
+    }
+    
+    // plan on scratch arrays, instances execute the plan on their own
+    float* real = fftwf_alloc_real (size);
+    fftwf_complex* complex = fftwf_alloc_complex (size / 2 + 1);
+    
+    if (kind == RealToComplex)
+    {
+        shared.plan = fftwf_plan_dft_r2c_1d (size, real, complex, FFTW_MEASURE);
+    }
+    else
+    {
+        shared.plan = fftwf_plan_dft_c2r_1d (size, complex, real, FFTW_MEASURE);
+    }
+    
+    fftwf_free (real);
+    fftwf_free (complex);
+    
+    return shared.plan;
+}
+
+//=======================================================================
+void FFTPlanCache::release (Kind kind, int size)
+{
+    std::lock_guard<std::mutex> lock (plannerMutex);
+    
+    auto it = plans.find (std::make_pair ((int) kind, size));
+    
+    if (it != plans.end() && --it->second.references == 0)
+    {
+        fftwf_destroy_plan (it->second.plan);
+        plans.erase (it);
+    }
+}
+
+#endif
@@ -0,0 +1,63 @@
+//=======================================================================
+/** @file FFTPlanCache.h
+ *  @brief fftw plans shared between analysis instances of the same size
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+//=======================================================================
+
+#ifndef __FFTPLANCACHE_H
+#define __FFTPLANCACHE_H
+
+#ifdef USE_FFTW
+#include "fftw3.h"
+
+//=======================================================================
+/** Reference counted single precision fftw plans, one per kind and size.
+ *
+ * Plans are measured once and then shared by every onset detection function
+ * and beat tracker of that size, each executing the plan on its own arrays
+ * with the fftw new-array execute functions; arrays must come from
+ * fftwf_alloc_real / fftwf_alloc_complex so their alignment matches.
+ *
+ * The fftw planner is not thread safe so all planning and plan destruction
+ * goes through here under one lock. Executing plans needs no lock.
+ */
+class FFTPlanCache
+{
+public:
+    /** The kind of transform */
+    enum Kind
+    {
+        RealToComplex,
+        ComplexToReal
+    };
+    
+    /** Get the plan for a transform, measuring it if no instance holds one yet
+     * @param kind the kind of transform
+     * @param size the transform size
+     * @returns the plan, to be released with release()
+     */
+    static fftwf_plan acquire (Kind kind, int size);
+    
+    /** Release a plan, it is destroyed once no instance holds it
+     * @param kind the kind of transform
+     * @param size the transform size
+     */
+    static void release (Kind kind, int size);
+};
+
+#endif
+
+#endif
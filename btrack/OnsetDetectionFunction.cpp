@@ -20,7 +20,11 @@
 //=======================================================================
 
 #include <math.h>
+#include <algorithm>
+#include <map>
+#include <mutex>
 #include "OnsetDetectionFunction.h"
+#include "FFTPlanCache.h"
 
 //=======================================================================
 OnsetDetectionFunction::OnsetDetectionFunction (int hopSize_,int frameSize_)
@@ -29,6 +33,9 @@ OnsetDetectionFunction::OnsetDetectionFunction (int hopSize_,int frameSize_)
     // indicate that we have not initialised yet
 	initialised = false;
 	
+	// use the fastest kernels this CPU supports
+	kernels = &SpectralKernels::get();
+	
 	// set pi
 	pi = 3.14159265358979;
 	
@@ -43,6 +50,9 @@ OnsetDetectionFunction::OnsetDetectionFunction(int hopSize_,int frameSize_,int o
 	// indicate that we have not initialised yet
 	initialised = false;
 	
+	// use the fastest kernels this CPU supports
+	kernels = &SpectralKernels::get();
+	
 	// set pi
 	pi = 3.14159265358979;	
 	
@@ -73,48 +83,41 @@ void OnsetDetectionFunction::initialise(int hopSize_,int frameSize_,int onsetDet
 {
 	hopSize = hopSize_; // set hopsize
 	frameSize = frameSize_; // set framesize
+	numBins = (frameSize / 2) + 1; // bins of the real fft
 	
 	onsetDetectionFunctionType = onsetDetectionFunctionType_; // set detection function type
     windowType = windowType_; // set window type
 		
 	// initialise buffers
     frame.resize (frameSize);
-    window.resize (frameSize);
-    magSpec.resize (frameSize);
-    prevMagSpec.resize (frameSize);
-    phase.resize (frameSize);
-    prevPhase.resize (frameSize);
-    prevPhase2.resize (frameSize);
+    magSpec.resize (numBins);
+    prevMagSpec.resize (numBins);
+    phase.resize (numBins);
+    prevPhase.resize (numBins);
+    prevPhase2.resize (numBins);
+    prevPhasorReal.resize (numBins);
+    prevPhasorImag.resize (numBins);
+    prevPhasorReal2.resize (numBins);
+    prevPhasorImag2.resize (numBins);
 	
 	
-	// set the window to the specified type
-	switch (windowType)
-    {
-		case RectangularWindow:
-			calculateRectangularWindow();		// Rectangular window
-			break;	
-		case HanningWindow:
-			calculateHanningWindow();			// Hanning Window
-			break;
-		case HammingWindow:
-			calclulateHammingWindow();			// Hamming Window
-			break;
-		case BlackmanWindow:
-			calculateBlackmanWindow();			// Blackman Window
-			break;
-		case TukeyWindow:
-			calculateTukeyWindow();             // Tukey Window
-			break;
-		default:
-			calculateHanningWindow();			// DEFAULT: Hanning Window
-	}
+	// set the window to the specified type, shared with other instances
+	window = sharedWindow();
 	
 	// initialise previous magnitude spectrum to zero
-	for (int i = 0; i < frameSize; i++)
+	for (int i = 0; i < numBins; i++)
 	{
 		prevMagSpec[i] = 0.0;
 		prevPhase[i] = 0.0;
 		prevPhase2[i] = 0.0;
+		prevPhasorReal[i] = 1.0;	// phase zero
+		prevPhasorImag[i] = 0.0;
+		prevPhasorReal2[i] = 1.0;
+		prevPhasorImag2[i] = 0.0;
+	}
+	
+	for (int i = 0; i < frameSize; i++)
+	{
 		frame[i] = 0.0;
 	}
 	
@@ -132,18 +135,18 @@ void OnsetDetectionFunction::initialiseFFT()
     }
     
 #ifdef USE_FFTW
-    complexIn = (fftw_complex*) fftw_malloc (sizeof(fftw_complex) * frameSize);		// complex array to hold fft data
-    complexOut = (fftw_complex*) fftw_malloc (sizeof(fftw_complex) * frameSize);	// complex array to hold fft data
-    p = fftw_plan_dft_1d (frameSize, complexIn, complexOut, FFTW_FORWARD, FFTW_ESTIMATE);	// FFT plan initialisation
+    realIn = fftwf_alloc_real (frameSize);					// real array to hold the windowed frame
+    complexOut = fftwf_alloc_complex (numBins);			// complex array to hold fft data
+    
+    // FFT plan shared with all instances of this frame size
+    fftSize = frameSize;
+    p = FFTPlanCache::acquire (FFTPlanCache::RealToComplex, fftSize);
+    spectrum = (float*) complexOut;
 #endif
     
 #ifdef USE_KISS_FFT
-    complexOut.resize (frameSize);
-    
-    for (int i = 0; i < frameSize;i++)
-    {
-        complexOut[i].resize(2);
-    }
+    complexOut.resize (2 * numBins);
+    spectrum = &complexOut[0];
     
     fftIn = new kiss_fft_cpx[frameSize];
     fftOut = new kiss_fft_cpx[frameSize];
@@ -157,9 +160,9 @@ void OnsetDetectionFunction::initialiseFFT()
 void OnsetDetectionFunction::freeFFT()
 {
 #ifdef USE_FFTW
-    fftw_destroy_plan (p);
-    fftw_free (complexIn);
-    fftw_free (complexOut);
+    FFTPlanCache::release (FFTPlanCache::RealToComplex, fftSize);
+    fftwf_free (realIn);
+    fftwf_free (complexOut);
 #endif
     
 #ifdef USE_KISS_FFT
@@ -175,11 +178,21 @@ void OnsetDetectionFunction::setOnsetDetectionFunctionType (int onsetDetectionFu
 	onsetDetectionFunctionType = onsetDetectionFunctionType_; // set detection function type
 }
 
+//=======================================================================
+const float* OnsetDetectionFunction::getMagnitudeSpectrum()
+{
+	return &magSpec[0];
+}
+
+//=======================================================================
+int OnsetDetectionFunction::getNumBins()
+{
+	return numBins;
+}
+
 //=======================================================================
 double OnsetDetectionFunction::calculateOnsetDetectionFunctionSample (double* buffer)
 {	
-	double odfSample;
-		
 	// shift audio samples back in frame by hop size
 	for (int i = 0; i < (frameSize-hopSize);i++)
 	{
@@ -193,6 +206,26 @@ double OnsetDetectionFunction::calculateOnsetDetectionFunctionSample (double* bu
 		frame[i] = buffer[j];
 		j++;
 	}
+	
+	return calculateOnsetDetectionFunctionSample();
+}
+
+//=======================================================================
+double OnsetDetectionFunction::calculateOnsetDetectionFunctionSample (const float* buffer)
+{	
+	// shift audio samples back in frame by hop size
+	std::copy (frame.begin() + hopSize, frame.end(), frame.begin());
+	
+	// add new samples to frame from input buffer, no conversion needed
+	std::copy (buffer, buffer + hopSize, frame.end() - hopSize);
+	
+	return calculateOnsetDetectionFunctionSample();
+}
+
+//=======================================================================
+double OnsetDetectionFunction::calculateOnsetDetectionFunctionSample()
+{	
+	double odfSample;
 		
 	switch (onsetDetectionFunctionType)
     {
@@ -272,36 +305,34 @@ void OnsetDetectionFunction::performFFT()
     int fsize2 = (frameSize/2);
     
 #ifdef USE_FFTW
-	// window frame and copy to complex array, swapping the first and second half of the signal
-	for (int i = 0;i < fsize2;i++)
-	{
-		complexIn[i][0] = frame[i + fsize2] * window[i + fsize2];
-		complexIn[i][1] = 0.0;
-		complexIn[i+fsize2][0] = frame[i] * window[i];
-		complexIn[i+fsize2][1] = 0.0;
-	}
+	// window frame and copy to real array, swapping the first and second half of the signal
+	const float* windowValues = &(*window)[0];
+	kernels->multiply (&frame[fsize2], windowValues + fsize2, realIn, fsize2);
+	kernels->multiply (&frame[0], windowValues, realIn + fsize2, fsize2);
 	
-	// perform the fft
-	fftw_execute (p);
+	// perform the fft on the arrays of this instance
+	fftwf_execute_dft_r2c (p, realIn, complexOut);
 #endif
     
 #ifdef USE_KISS_FFT
+    const std::vector<float>& windowValues = *window;
+    
     for (int i = 0; i < fsize2; i++)
     {
-        fftIn[i].r = frame[i + fsize2] * window[i + fsize2];
+        fftIn[i].r = frame[i + fsize2] * windowValues[i + fsize2];
         fftIn[i].i = 0.0;
-        fftIn[i + fsize2].r = frame[i] * window[i];
+        fftIn[i + fsize2].r = frame[i] * windowValues[i];
         fftIn[i + fsize2].i = 0.0;
     }
     
     // execute kiss fft
     kiss_fft (cfg, fftIn, fftOut);
     
-    // store real and imaginary parts of FFT
-    for (int i = 0; i < frameSize; i++)
+    // store real and imaginary parts of FFT, interleaved
+    for (int i = 0; i < numBins; i++)
     {
-        complexOut[i][0] = fftOut[i].r;
-        complexOut[i][1] = fftOut[i].i;
+        complexOut[2*i] = fftOut[i].r;
+        complexOut[2*i+1] = fftOut[i].i;
     }
 #endif
 }
@@ -320,7 +351,7 @@ double OnsetDetectionFunction::energyEnvelope()
 	// sum the squares of the samples
 	for (int i = 0;i < frameSize;i++)
 	{
-		sum = sum + (frame[i] * frame[i]);
+		sum = sum + ((double) frame[i] * frame[i]);
 	}
 	
 	return sum;		// return sum
@@ -337,7 +368,7 @@ double OnsetDetectionFunction::energyDifference()
 	// sum the squares of the samples
 	for (int i = 0; i < frameSize; i++)
 	{
-		sum = sum + (frame[i] * frame[i]);
+		sum = sum + ((double) frame[i] * frame[i]);
 	}
 	
 	sample = sum - prevEnergySum;	// sample is first order difference in energy
@@ -357,85 +388,27 @@ double OnsetDetectionFunction::energyDifference()
 //=======================================================================
 double OnsetDetectionFunction::spectralDifference()
 {
-	double diff;
-	double sum;
-	
 	// perform the FFT
 	performFFT();
 	
-	// compute first (N/2)+1 mag values
-	for (int i = 0;i < (frameSize/2)+1;i++)
-	{
-		magSpec[i] = sqrt (pow (complexOut[i][0], 2) + pow (complexOut[i][1], 2));
-	}
-	// mag spec symmetric above (N/2)+1 so copy previous values
-	for (int i = (frameSize/2)+1; i < frameSize; i++)
-	{
-		magSpec[i] = magSpec[frameSize-i];
-	}
-	
-	sum = 0;	// initialise sum to zero
-
-	for (int i = 0; i < frameSize; i++)
-	{
-		// calculate difference
-		diff = magSpec[i] - prevMagSpec[i];
-		
-		// ensure all difference values are positive
-		if (diff < 0)
-		{
-			diff = diff*-1;
-		}
-		
-		// add difference to sum
-		sum = sum + diff;
-		
-		// store magnitude spectrum bin for next detection function sample calculation
-		prevMagSpec[i] = magSpec[i];
-	}
+	// compute (N/2)+1 mag values, mag spec is symmetric above (N/2)+1
+	kernels->magnitude (spectrum, &magSpec[0], numBins);
 	
-	return sum;		
+	// sum absolute differences
+	return sumSpectralDifference (false, false);
 }
 
 //=======================================================================
 double OnsetDetectionFunction::spectralDifferenceHWR()
 {
-	double diff;
-	double sum;
-	
 	// perform the FFT
 	performFFT();
 	
-	// compute first (N/2)+1 mag values
-	for (int i = 0;i < (frameSize/2) + 1; i++)
-	{
-		magSpec[i] = sqrt (pow (complexOut[i][0],2) + pow (complexOut[i][1],2));
-	}
-	// mag spec symmetric above (N/2)+1 so copy previous values
-	for (int i = (frameSize/2)+1;i < frameSize;i++)
-	{
-		magSpec[i] = magSpec[frameSize-i];
-	}
-	
-	sum = 0;	// initialise sum to zero
-	
-	for (int i = 0;i < frameSize;i++)
-	{
-		// calculate difference
-		diff = magSpec[i] - prevMagSpec[i];
-		
-		// only add up positive differences
-		if (diff > 0)
-		{
-			// add difference to sum
-			sum = sum+diff;
-		}
-		
-		// store magnitude spectrum bin for next detection function sample calculation
-		prevMagSpec[i] = magSpec[i];
-	}
+	// compute (N/2)+1 mag values, mag spec is symmetric above (N/2)+1
+	kernels->magnitude (spectrum, &magSpec[0], numBins);
 	
-	return sum;		
+	// only add up positive differences
+	return sumSpectralDifference (true, false);
 }
 
 
@@ -451,13 +424,13 @@ double OnsetDetectionFunction::phaseDeviation()
 	sum = 0; // initialise sum to zero
 	
 	// compute phase values from fft output and sum deviations
-	for (int i = 0;i < frameSize;i++)
+	for (int i = 0;i < numBins;i++)
 	{
 		// calculate phase value
-		phase[i] = atan2 (complexOut[i][1], complexOut[i][0]);
+		phase[i] = atan2 (spectrum[2*i+1], spectrum[2*i]);
 		
 		// calculate magnitude value
-		magSpec[i] = sqrt (pow (complexOut[i][0],2) + pow (complexOut[i][1],2));
+		magSpec[i] = sqrt (pow (spectrum[2*i],2) + pow (spectrum[2*i+1],2));
 		
 		
 		// if bin is not just a low energy bin then examine phase deviation
@@ -472,8 +445,8 @@ double OnsetDetectionFunction::phaseDeviation()
 				pdev = pdev*-1;
 			}
 						
-			// add to sum
-			sum = sum + pdev;
+			// add to sum, the mirrored bin deviates by the same amount
+			sum = sum + pdev * mirroredBinWeight (i);
 		}
 				
 		// store values for next calculation
@@ -487,112 +460,40 @@ double OnsetDetectionFunction::phaseDeviation()
 //=======================================================================
 double OnsetDetectionFunction::complexSpectralDifference()
 {
-	double phaseDeviation;
-	double sum;
-	double csd;
-	
 	// perform the FFT
 	performFFT();
 	
-	sum = 0; // initialise sum to zero
-	
-	// compute phase values from fft output and sum deviations
-	for (int i = 0;i < frameSize;i++)
-	{
-		// calculate phase value
-		phase[i] = atan2 (complexOut[i][1], complexOut[i][0]);
-		
-		// calculate magnitude value
-		magSpec[i] = sqrt (pow (complexOut[i][0],2) + pow(complexOut[i][1],2));
-		
-		// phase deviation
-		phaseDeviation = phase[i] - (2 * prevPhase[i]) + prevPhase2[i];
-		
-        // calculate complex spectral difference for the current spectral bin
-		csd = sqrt (pow (magSpec[i], 2) + pow (prevMagSpec[i], 2) - 2 * magSpec[i] * prevMagSpec[i] * cos (phaseDeviation));
-			
-		// add to sum
-		sum = sum + csd;
-		
-		// store values for next calculation
-		prevPhase2[i] = prevPhase[i];
-		prevPhase[i] = phase[i];
-		prevMagSpec[i] = magSpec[i];
-	}
-	
-	return sum;		
+	return sumComplexSpectralDifference (false);
 }
 
 //=======================================================================
 double OnsetDetectionFunction::complexSpectralDifferenceHWR()
 {
-	double phaseDeviation;
-	double sum;
-	double magnitudeDifference;
-	double csd;
-	
 	// perform the FFT
 	performFFT();
 	
-	sum = 0; // initialise sum to zero
-	
-	// compute phase values from fft output and sum deviations
-	for (int i = 0;i < frameSize;i++)
-	{
-		// calculate phase value
-		phase[i] = atan2 (complexOut[i][1], complexOut[i][0]);
-		
-		// calculate magnitude value
-		magSpec[i] = sqrt (pow (complexOut[i][0],2) + pow(complexOut[i][1],2));
-		
-        // phase deviation
-        phaseDeviation = phase[i] - (2 * prevPhase[i]) + prevPhase2[i];
-        
-        // calculate magnitude difference (real part of Euclidean distance between complex frames)
-        magnitudeDifference = magSpec[i] - prevMagSpec[i];
-        
-        // if we have a positive change in magnitude, then include in sum, otherwise ignore (half-wave rectification)
-        if (magnitudeDifference > 0)
-        {
-            // calculate complex spectral difference for the current spectral bin
-            csd = sqrt (pow (magSpec[i], 2) + pow (prevMagSpec[i], 2) - 2 * magSpec[i] * prevMagSpec[i] * cos (phaseDeviation));
-        
-            // add to sum
-            sum = sum + csd;
-        }
-        
-		// store values for next calculation
-		prevPhase2[i] = prevPhase[i];
-		prevPhase[i] = phase[i];
-		prevMagSpec[i] = magSpec[i];
-	}
-	
-	return sum;		
+	// only include bins with a positive change in magnitude
+	return sumComplexSpectralDifference (true);
 }
 
 
 //=======================================================================
 double OnsetDetectionFunction::highFrequencyContent()
 {
-	double sum;
-	
 	// perform the FFT
 	performFFT();
 	
-	sum = 0; // initialise sum to zero
+	// compute (N/2)+1 mag values
+	kernels->magnitude (spectrum, &magSpec[0], numBins);
 	
-	// compute phase values from fft output and sum deviations
-	for (int i = 0; i < frameSize; i++)
-	{		
-		// calculate magnitude value
-		magSpec[i] = sqrt (pow (complexOut[i][0],2) + pow (complexOut[i][1],2));
-		
-		
-		sum = sum + (magSpec[i] * ((double) (i+1)));
-		
-		// store values for next calculation
-		prevMagSpec[i] = magSpec[i];
-	}
+	int last = numBins - 1;
+	
+	// DC and Nyquist bins, then the bins between which all carry the same weight with their mirror image
+	double sum = magSpec[0] * mirroredBinFrequencyWeight (0) + magSpec[last] * mirroredBinFrequencyWeight (last);
+	sum = sum + kernels->sum (&magSpec[1], numBins - 2) * mirroredBinFrequencyWeight (1);
+	
+	// store values for next calculation
+	prevMagSpec = magSpec;
 	
 	return sum;		
 }
@@ -600,67 +501,65 @@ double OnsetDetectionFunction::highFrequencyContent()
 //=======================================================================
 double OnsetDetectionFunction::highFrequencySpectralDifference()
 {
-	double sum;
-	double mag_diff;
-	
 	// perform the FFT
 	performFFT();
 	
-	sum = 0; // initialise sum to zero
+	// compute (N/2)+1 mag values
+	kernels->magnitude (spectrum, &magSpec[0], numBins);
 	
-	// compute phase values from fft output and sum deviations
-	for (int i = 0;i < frameSize;i++)
-	{		
-		// calculate magnitude value
-		magSpec[i] = sqrt (pow (complexOut[i][0],2) + pow (complexOut[i][1],2));
-		
-		// calculate difference
-		mag_diff = magSpec[i] - prevMagSpec[i];
-		
-		if (mag_diff < 0)
-		{
-			mag_diff = -mag_diff;
-		}
-		
-		sum = sum + (mag_diff * ((double) (i+1)));
-		
-		// store values for next calculation
-		prevMagSpec[i] = magSpec[i];
-	}
-	
-	return sum;		
+	// sum absolute differences
+	return sumSpectralDifference (false, true);
 }
 
 //=======================================================================
 double OnsetDetectionFunction::highFrequencySpectralDifferenceHWR()
 {
-	double sum;
-	double mag_diff;
-	
 	// perform the FFT
 	performFFT();
 	
-	sum = 0; // initialise sum to zero
+	// compute (N/2)+1 mag values
+	kernels->magnitude (spectrum, &magSpec[0], numBins);
 	
-	// compute phase values from fft output and sum deviations
-	for (int i = 0;i < frameSize;i++)
-	{		
-		// calculate magnitude value
-		magSpec[i] = sqrt (pow (complexOut[i][0],2) + pow (complexOut[i][1],2));
-		
-		// calculate difference
-		mag_diff = magSpec[i] - prevMagSpec[i];
-		
-		if (mag_diff > 0)
-		{
-			sum = sum + (mag_diff * ((double) (i+1)));
-		}
+	// only add up positive differences
+	return sumSpectralDifference (true, true);
+}
 
-		// store values for next calculation
-		prevMagSpec[i] = magSpec[i];
+//=======================================================================
+double OnsetDetectionFunction::sumSpectralDifference (bool halfWaveRectify, bool frequencyWeighted)
+{
+	int last = numBins - 1;
+	
+	// DC and Nyquist bins
+	double edges[2];
+	edges[0] = kernels->spectralDifference (&magSpec[0], &prevMagSpec[0], 1, halfWaveRectify);
+	edges[1] = kernels->spectralDifference (&magSpec[last], &prevMagSpec[last], 1, halfWaveRectify);
+	
+	// the bins between all carry the same weight with their mirror image
+	double middle = kernels->spectralDifference (&magSpec[1], &prevMagSpec[1], numBins - 2, halfWaveRectify);
+	
+	if (frequencyWeighted)
+	{
+		return edges[0] * mirroredBinFrequencyWeight (0) + edges[1] * mirroredBinFrequencyWeight (last) + middle * mirroredBinFrequencyWeight (1);
 	}
 	
-	return sum;		
+	return edges[0] + edges[1] + middle * mirroredBinWeight (1);
+}
+
+//=======================================================================
+double OnsetDetectionFunction::sumComplexSpectralDifference (bool halfWaveRectify)
+{
+	int last = numBins - 1;
+	
+	ComplexSpectrumHistory history = {&prevMagSpec[0], &prevPhasorReal[0], &prevPhasorImag[0], &prevPhasorReal2[0], &prevPhasorImag2[0]};
+	ComplexSpectrumHistory middle = {&prevMagSpec[1], &prevPhasorReal[1], &prevPhasorImag[1], &prevPhasorReal2[1], &prevPhasorImag2[1]};
+	ComplexSpectrumHistory nyquist = {&prevMagSpec[last], &prevPhasorReal[last], &prevPhasorImag[last], &prevPhasorReal2[last], &prevPhasorImag2[last]};
+	
+	// DC and Nyquist bins, then the bins between which all carry the same weight with their mirror image
+	double sum = kernels->complexSpectralDifference (spectrum, history, 1, halfWaveRectify);
+	sum = sum + kernels->complexSpectralDifference (spectrum + 2*last, nyquist, 1, halfWaveRectify);
+	sum = sum + kernels->complexSpectralDifference (spectrum + 2, middle, numBins - 2, halfWaveRectify) * mirroredBinWeight (1);
+	
+	return sum;
 }
 
 
@@ -669,7 +568,52 @@ double OnsetDetectionFunction::highFrequencySpectralDifferenceHWR()
 ////////////////////////////// Methods to Calculate Windows ////////////////////////////////////
 
 //=======================================================================
-void OnsetDetectionFunction::calculateHanningWindow()
+std::shared_ptr<const std::vector<float> > OnsetDetectionFunction::sharedWindow()
+{
+    static std::mutex windowMutex;
+    static std::map<std::pair<int, int>, std::weak_ptr<const std::vector<float> > > windows;
+    
+    std::lock_guard<std::mutex> lock (windowMutex);
+    
+    std::weak_ptr<const std::vector<float> >& cached = windows[std::make_pair (windowType, frameSize)];
+    std::shared_ptr<const std::vector<float> > shared = cached.lock();
+    
+    if (shared)
+    {
+        return shared;
+    }
+    
+    std::vector<float>* newWindow = new std::vector<float> (frameSize);
+    
+	switch (windowType)
+    {
+		case RectangularWindow:
+			calculateRectangularWindow (*newWindow);		// Rectangular window
+			break;	
+		case HanningWindow:
+			calculateHanningWindow (*newWindow);			// Hanning Window
+			break;
+		case HammingWindow:
+			calclulateHammingWindow (*newWindow);			// Hamming Window
+			break;
+		case BlackmanWindow:
+			calculateBlackmanWindow (*newWindow);			// Blackman Window
+			break;
+		case TukeyWindow:
+			calculateTukeyWindow (*newWindow);             // Tukey Window
+			break;
+		default:
+			calculateHanningWindow (*newWindow);			// DEFAULT: Hanning Window
+	}
+    
+    shared.reset (newWindow);
+    cached = shared;
+    
+    return shared;
+}
+
+//=======================================================================
+void OnsetDetectionFunction::calculateHanningWindow (std::vector<float>& window)
 {
 	double N;		// variable to store framesize minus 1
 	
@@ -683,7 +627,7 @@ void OnsetDetectionFunction::calculateHanningWindow()
 }
 
 //=======================================================================
-void OnsetDetectionFunction::calclulateHammingWindow()
+void OnsetDetectionFunction::calclulateHammingWindow (std::vector<float>& window)
 {
 	double N;		// variable to store framesize minus 1
 	double n_val;	// double version of index 'n'
@@ -700,7 +644,7 @@ void OnsetDetectionFunction::calclulateHammingWindow()
 }
 
 //=======================================================================
-void OnsetDetectionFunction::calculateBlackmanWindow()
+void OnsetDetectionFunction::calculateBlackmanWindow (std::vector<float>& window)
 {
 	double N;		// variable to store framesize minus 1
 	double n_val;	// double version of index 'n'
@@ -717,7 +661,7 @@ void OnsetDetectionFunction::calculateBlackmanWindow()
 }
 
 //=======================================================================
-void OnsetDetectionFunction::calculateTukeyWindow()
+void OnsetDetectionFunction::calculateTukeyWindow (std::vector<float>& window)
 {
 	double N;		// variable to store framesize minus 1
 	double n_val;	// double version of index 'n'
@@ -752,7 +696,7 @@ void OnsetDetectionFunction::calculateTukeyWindow()
 }
 
 //=======================================================================
-void OnsetDetectionFunction::calculateRectangularWindow()
+void OnsetDetectionFunction::calculateRectangularWindow (std::vector<float>& window)
 {
 	// Rectangular window calculation
 	for (int n = 0;n < frameSize;n++)
@@ -765,6 +709,27 @@ void OnsetDetectionFunction::calculateRectangularWindow()
 ////////////////////////////////////////////////////////////////////////////////////////////////
 ///////////////////////////////// Other Handy Methods //////////////////////////////////////////
 
+//=======================================================================
+double OnsetDetectionFunction::mirroredBinWeight (int bin)
+{
+    if (bin == 0 || 2 * bin == frameSize)
+    {
+        return 1.0;
+    }
+    return 2.0;
+}
+
+//=======================================================================
+double OnsetDetectionFunction::mirroredBinFrequencyWeight (int bin)
+{
+    // bin weighted by (i+1) plus its mirror image at N-i weighted by (N-i+1)
+    if (bin == 0 || 2 * bin == frameSize)
+    {
+        return (double) (bin+1);
+    }
+    return (double) (frameSize+2);
+}
+
 //=======================================================================
 double OnsetDetectionFunction::princarg(double phaseVal)
 {	
@@ -30,6 +30,9 @@
 #include "kiss_fft.h"
 #endif
 
+#include "SpectralKernels.h"
+
+#include <memory>
 #include <vector>
 
 //=======================================================================
@@ -105,13 +108,31 @@ public:
      */
 	double calculateOnsetDetectionFunctionSample (double* buffer);
     
+    /** Process input frame and calculate detection function sample 
+     * @param buffer a pointer to an array containing the hop size single precision audio samples to be processed
+     * @returns the onset detection function sample
+     */
+	double calculateOnsetDetectionFunctionSample (const float* buffer);
+    
     /** Set the detection function type 
      * @param onsetDetectionFunctionType_ the type of onset detection function to use - (see OnsetDetectionFunctionType)
      */
 	void setOnsetDetectionFunctionType (int onsetDetectionFunctionType_);
+    
+    /** Get the magnitude spectrum of the last frame processed, only calculated by the
+     * spectral difference and high frequency content detection function types
+     * @returns a pointer to the (N/2)+1 magnitude values
+     */
+	const float* getMagnitudeSpectrum();
+    
+    /** @returns the number of spectral bins calculated, (N/2)+1 */
+	int getNumBins();
 	
 private:
 	
+    /** Calculate the detection function sample for the current frame */
+	double calculateOnsetDetectionFunctionSample();
+	
     /** Perform the FFT on the data in 'frame' */
 	void performFFT();
 
@@ -145,22 +166,40 @@ private:
     
     /** Calculate high frequency spectral difference detection function sample (half-wave rectified) */
 	double highFrequencySpectralDifferenceHWR();
+    
+    /** Sum the magnitude differences between magSpec and prevMagSpec over the full spectrum, prevMagSpec is then updated
+     * @param halfWaveRectify true to only sum positive differences
+     * @param frequencyWeighted true to weight each bin by its index
+     * @returns the sum
+     */
+	double sumSpectralDifference (bool halfWaveRectify, bool frequencyWeighted);
+    
+    /** Sum the complex spectral difference over the full spectrum and advance the history
+     * @param halfWaveRectify true to only include bins rising in magnitude
+     * @returns the sum
+     */
+	double sumComplexSpectralDifference (bool halfWaveRectify);
 
     //=======================================================================
+    /** Get the window for the window type and frame size, windows are shared between instances
+     * @returns the window
+     */
+    std::shared_ptr<const std::vector<float> > sharedWindow();
+    
     /** Calculate a Rectangular window */
-	void calculateRectangularWindow();
+	void calculateRectangularWindow (std::vector<float>& window);
     
     /** Calculate a Hanning window */
-	void calculateHanningWindow();
+	void calculateHanningWindow (std::vector<float>& window);
     
     /** Calculate a Hamming window */
-	void calclulateHammingWindow();
+	void calclulateHammingWindow (std::vector<float>& window);
     
     /** Calculate a Blackman window */
-	void calculateBlackmanWindow();
+	void calculateBlackmanWindow (std::vector<float>& window);
     
     /** Calculate a Tukey window */
-	void calculateTukeyWindow();
+	void calculateTukeyWindow (std::vector<float>& window);
 
     //=======================================================================
 	/** Set phase values between [-pi, pi] 
@@ -169,44 +208,67 @@ private:
      */
 	double princarg(double phaseVal);
 	
+    /** The spectrum of a real frame is conjugate symmetric so only the first (N/2)+1
+     * bins are computed, every bin other than DC and Nyquist also stands in for its mirror image
+     * @param bin the spectral bin
+     * @returns the number of bins of the full spectrum the given bin represents
+     */
+    double mirroredBinWeight (int bin);
+    
+    /** As mirroredBinWeight for the high frequency content functions, which weight each bin by its index
+     * @param bin the spectral bin
+     * @returns the summed weight of the given bin and its mirror image
+     */
+    double mirroredBinFrequencyWeight (int bin);
+    
     void initialiseFFT();
     void freeFFT();
 	
 	double pi;							/**< pi, the constant */
 	
 	int frameSize;						/**< audio framesize */
+	int numBins;						/**< number of spectral bins computed, (N/2)+1 */
 	int hopSize;						/**< audio hopsize */
 	int onsetDetectionFunctionType;		/**< type of detection function */
     int windowType;                     /**< type of window used in calculations */
 
     //=======================================================================
 #ifdef USE_FFTW
-	fftw_plan p;						/**< fftw plan */
-	fftw_complex* complexIn;			/**< to hold complex fft values for input */
-	fftw_complex* complexOut;			/**< to hold complex fft values for output */
+	fftwf_plan p;						/**< fftw plan (real to complex), shared */
+	int fftSize;						/**< size the fftw plan was acquired for */
+	float* realIn;						/**< to hold the windowed frame for input */
+	fftwf_complex* complexOut;			/**< to hold the (N/2)+1 complex fft values for output */
 #endif
     
+    float* spectrum;                    /**< the (N/2)+1 complex fft values, interleaved */
+    const SpectralKernels* kernels;     /**< the spectral kernels for this CPU */
+    
 #ifdef USE_KISS_FFT
     kiss_fft_cfg cfg;                   /**< Kiss FFT configuration */
     kiss_fft_cpx* fftIn;                /**< FFT input samples, in complex form */
     kiss_fft_cpx* fftOut;               /**< FFT output samples, in complex form */
-    std::vector<std::vector<double> > complexOut;
+    std::vector<float> complexOut;      /**< to hold the (N/2)+1 complex fft values, interleaved */
 #endif
 	
     //=======================================================================
 	bool initialised;					/**< flag indicating whether buffers and FFT plans are initialised */
 
-    std::vector<double> frame;          /**< audio frame */
-    std::vector<double> window;         /**< window */
+    std::vector<float> frame;           /**< audio frame */
+    std::shared_ptr<const std::vector<float> > window; /**< window, shared */
 	
 	double prevEnergySum;				/**< to hold the previous energy sum value */
 	
-    std::vector<double> magSpec;        /**< magnitude spectrum */
-    std::vector<double> prevMagSpec;    /**< previous magnitude spectrum */
+    std::vector<float> magSpec;         /**< magnitude spectrum */
+    std::vector<float> prevMagSpec;     /**< previous magnitude spectrum */
 	
     std::vector<double> phase;          /**< FFT phase values */
     std::vector<double> prevPhase;      /**< previous phase values */
     std::vector<double> prevPhase2;     /**< second order previous phase values */
+	
+    std::vector<float> prevPhasorReal;  /**< previous unit phasors, real part */
+    std::vector<float> prevPhasorImag;  /**< previous unit phasors, imaginary part */
+    std::vector<float> prevPhasorReal2; /**< second order previous unit phasors, real part */
+    std::vector<float> prevPhasorImag2; /**< second order previous unit phasors, imaginary part */
 
 };
 
@@ -0,0 +1,491 @@
+//=======================================================================
+/** @file SpectralKernels.cpp
+ *  @brief Single precision kernels for the spectral onset detection functions
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+//=======================================================================
+
+#include <math.h>
+#include "SpectralKernels.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define SPECTRAL_KERNELS_X86
+#include <immintrin.h>
+#endif
+
+////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////// Plain Implementation /////////////////////////////////////
+
+//=======================================================================
+static void multiplyPlain (const float* a, const float* b, float* out, int n)
+{
+    for (int i = 0; i < n; i++)
+    {
+        out[i] = a[i] * b[i];
+    }
+}
+
+//=======================================================================
+static void magnitudePlain (const float* spectrum, float* mag, int n)
+{
+    for (int i = 0; i < n; i++)
+    {
+        mag[i] = sqrtf (spectrum[2*i] * spectrum[2*i] + spectrum[2*i+1] * spectrum[2*i+1]);
+    }
+}
+
+//=======================================================================
+static double spectralDifferencePlain (const float* mag, float* prevMag, int n, bool halfWaveRectify)
+{
+    double sum = 0;
+    
+    for (int i = 0; i < n; i++)
+    {
+        float diff = mag[i] - prevMag[i];
+        
+        if (diff > 0)
+        {
+            sum = sum + diff;
+        }
+        else if (!halfWaveRectify)
+        {
+            sum = sum - diff;
+        }
+        
+        prevMag[i] = mag[i];
+    }
+    
+    return sum;
+}
+
+//=======================================================================
+static double sumPlain (const float* values, int n)
+{
+    double sum = 0;
+    
+    for (int i = 0; i < n; i++)
+    {
+        sum = sum + values[i];
+    }
+    
+    return sum;
+}
+
+//=======================================================================
+static double complexSpectralDifferencePlain (const float* spectrum, const ComplexSpectrumHistory& history, int n, bool halfWaveRectify)
+{
+    double sum = 0;
+    
+    for (int i = 0; i < n; i++)
+    {
+        float real = spectrum[2*i];
+        float imag = spectrum[2*i+1];
+        float mag = sqrtf (real * real + imag * imag);
+        
+        // unit phasor of this frame, phase zero if there is no energy
+        float unitReal = 1;
+        float unitImag = 0;
+        
+        if (mag > 0)
+        {
+            unitReal = real / mag;
+            unitImag = imag / mag;
+        }
+        
+        // conj(u1)^2 * u2 = e^(j * (phase2 - 2 * phase1))
+        float a = history.prevReal[i];
+        float b = history.prevImag[i];
+        float c = history.prevReal2[i];
+        float d = history.prevImag2[i];
+        float squareReal = a * a - b * b;
+        float squareImag = -2 * a * b;
+        float advanceReal = squareReal * c - squareImag * d;
+        float advanceImag = squareReal * d + squareImag * c;
+        
+        // cosine of the phase deviation
+        float cosDeviation = unitReal * advanceReal - unitImag * advanceImag;
+        
+        float prevMag = history.prevMag[i];
+        
+        if (!halfWaveRectify || mag - prevMag > 0)
+        {
+            float distance = mag * mag + prevMag * prevMag - 2 * mag * prevMag * cosDeviation;
+            
+            if (distance > 0)
+            {
+                sum = sum + sqrtf (distance);
+            }
+        }
+        
+        history.prevReal2[i] = a;
+        history.prevImag2[i] = b;
+        history.prevReal[i] = unitReal;
+        history.prevImag[i] = unitImag;
+        history.prevMag[i] = mag;
+    }
+    
+    return sum;
+}
+
+static const SpectralKernels plainKernels =
+{
+    multiplyPlain,
+    magnitudePlain,
+    spectralDifferencePlain,
+    sumPlain,
+    complexSpectralDifferencePlain,
+    "plain"
+};
+
+#ifdef SPECTRAL_KERNELS_X86
+
+////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////// SSE2 Implementation /////////////////////////////////////
+
+#define SSE2 __attribute__ ((target ("sse2")))
+
+//=======================================================================
+SSE2 static inline double horizontalSum (__m128 v)
+{
+    float lanes[4];
+    _mm_storeu_ps (lanes, v);
+    return ((double) lanes[0] + lanes[1]) + ((double) lanes[2] + lanes[3]);
+}
+
+//=======================================================================
+SSE2 static void multiplySSE2 (const float* a, const float* b, float* out, int n)
+{
+    int i = 0;
+    
+    for (; i + 4 <= n; i += 4)
+    {
+        _mm_storeu_ps (out + i, _mm_mul_ps (_mm_loadu_ps (a + i), _mm_loadu_ps (b + i)));
+    }
+    
+    multiplyPlain (a + i, b + i, out + i, n - i);
+}
+
+//=======================================================================
+SSE2 static void magnitudeSSE2 (const float* spectrum, float* mag, int n)
+{
+    int i = 0;
+    
+    for (; i + 4 <= n; i += 4)
+    {
+        __m128 low = _mm_loadu_ps (spectrum + 2*i);
+        __m128 high = _mm_loadu_ps (spectrum + 2*i + 4);
+        __m128 real = _mm_shuffle_ps (low, high, _MM_SHUFFLE (2, 0, 2, 0));
+        __m128 imag = _mm_shuffle_ps (low, high, _MM_SHUFFLE (3, 1, 3, 1));
+        _mm_storeu_ps (mag + i, _mm_sqrt_ps (_mm_add_ps (_mm_mul_ps (real, real), _mm_mul_ps (imag, imag))));
+    }
+    
+    magnitudePlain (spectrum + 2*i, mag + i, n - i);
+}
+
+//=======================================================================
+SSE2 static double spectralDifferenceSSE2 (const float* mag, float* prevMag, int n, bool halfWaveRectify)
+{
+    const __m128 signBit = _mm_set1_ps (-0.0f);
+    const __m128 zero = _mm_setzero_ps();
+    __m128 sum = zero;
+    int i = 0;
+    
+    for (; i + 4 <= n; i += 4)
+    {
+        __m128 current = _mm_loadu_ps (mag + i);
+        __m128 diff = _mm_sub_ps (current, _mm_loadu_ps (prevMag + i));
+        diff = halfWaveRectify ? _mm_max_ps (diff, zero) : _mm_andnot_ps (signBit, diff);
+        sum = _mm_add_ps (sum, diff);
+        _mm_storeu_ps (prevMag + i, current);
+    }
+    
+    return horizontalSum (sum) + spectralDifferencePlain (mag + i, prevMag + i, n - i, halfWaveRectify);
+}
+
+//=======================================================================
+SSE2 static double sumSSE2 (const float* values, int n)
+{
+    __m128 sum = _mm_setzero_ps();
+    int i = 0;
+    
+    for (; i + 4 <= n; i += 4)
+    {
+        sum = _mm_add_ps (sum, _mm_loadu_ps (values + i));
+    }
+    
+    return horizontalSum (sum) + sumPlain (values + i, n - i);
+}
+
+//=======================================================================
+SSE2 static double complexSpectralDifferenceSSE2 (const float* spectrum, const ComplexSpectrumHistory& history, int n, bool halfWaveRectify)
+{
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 one = _mm_set1_ps (1.0f);
+    const __m128 two = _mm_set1_ps (2.0f);
+    __m128 sum = zero;
+    int i = 0;
+    
+    for (; i + 4 <= n; i += 4)
+    {
+        __m128 low = _mm_loadu_ps (spectrum + 2*i);
+        __m128 high = _mm_loadu_ps (spectrum + 2*i + 4);
+        __m128 real = _mm_shuffle_ps (low, high, _MM_SHUFFLE (2, 0, 2, 0));
+        __m128 imag = _mm_shuffle_ps (low, high, _MM_SHUFFLE (3, 1, 3, 1));
+        __m128 mag = _mm_sqrt_ps (_mm_add_ps (_mm_mul_ps (real, real), _mm_mul_ps (imag, imag)));
+        
+        // unit phasor of this frame, phase zero if there is no energy
+        __m128 hasEnergy = _mm_cmpgt_ps (mag, zero);
+        __m128 unitReal = _mm_or_ps (_mm_and_ps (hasEnergy, _mm_div_ps (real, mag)), _mm_andnot_ps (hasEnergy, one));
+        __m128 unitImag = _mm_and_ps (hasEnergy, _mm_div_ps (imag, mag));
+        
+        // conj(u1)^2 * u2 = e^(j * (phase2 - 2 * phase1))
+        __m128 a = _mm_loadu_ps (history.prevReal + i);
+        __m128 b = _mm_loadu_ps (history.prevImag + i);
+        __m128 c = _mm_loadu_ps (history.prevReal2 + i);
+        __m128 d = _mm_loadu_ps (history.prevImag2 + i);
+        __m128 squareReal = _mm_sub_ps (_mm_mul_ps (a, a), _mm_mul_ps (b, b));
+        __m128 squareImag = _mm_mul_ps (_mm_mul_ps (two, a), b); // negated
+        __m128 advanceReal = _mm_add_ps (_mm_mul_ps (squareReal, c), _mm_mul_ps (squareImag, d));
+        __m128 advanceImag = _mm_sub_ps (_mm_mul_ps (squareReal, d), _mm_mul_ps (squareImag, c));
+        
+        // cosine of the phase deviation
+        __m128 cosDeviation = _mm_sub_ps (_mm_mul_ps (unitReal, advanceReal), _mm_mul_ps (unitImag, advanceImag));
+        
+        __m128 prevMag = _mm_loadu_ps (history.prevMag + i);
+        __m128 distance = _mm_sub_ps (_mm_add_ps (_mm_mul_ps (mag, mag), _mm_mul_ps (prevMag, prevMag)),
+                                      _mm_mul_ps (_mm_mul_ps (two, mag), _mm_mul_ps (prevMag, cosDeviation)));
+        __m128 csd = _mm_sqrt_ps (_mm_max_ps (distance, zero));
+        
+        if (halfWaveRectify)
+        {
+            csd = _mm_and_ps (_mm_cmpgt_ps (_mm_sub_ps (mag, prevMag), zero), csd);
+        }
+        
+        sum = _mm_add_ps (sum, csd);
+        
+        _mm_storeu_ps (history.prevReal2 + i, a);
+        _mm_storeu_ps (history.prevImag2 + i, b);
+        _mm_storeu_ps (history.prevReal + i, unitReal);
+        _mm_storeu_ps (history.prevImag + i, unitImag);
+        _mm_storeu_ps (history.prevMag + i, mag);
+    }
+    
+    ComplexSpectrumHistory rest = {history.prevMag + i, history.prevReal + i, history.prevImag + i, history.prevReal2 + i, history.prevImag2 + i};
+    
+    return horizontalSum (sum) + complexSpectralDifferencePlain (spectrum + 2*i, rest, n - i, halfWaveRectify);
+}
+
+static const SpectralKernels sse2Kernels =
+{
+    multiplySSE2,
+    magnitudeSSE2,
+    spectralDifferenceSSE2,
+    sumSSE2,
+    complexSpectralDifferenceSSE2,
+    "sse2"
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////// AVX2 Implementation /////////////////////////////////////
+
+#define AVX2 __attribute__ ((target ("avx2,fma")))
+
+//=======================================================================
+AVX2 static inline double horizontalSum (__m256 v)
+{
+    float lanes[8];
+    _mm256_storeu_ps (lanes, v);
+    return (((double) lanes[0] + lanes[1]) + ((double) lanes[2] + lanes[3]))
+         + (((double) lanes[4] + lanes[5]) + ((double) lanes[6] + lanes[7]));
+}
+
+//=======================================================================
+/** Split 8 interleaved complex values into real and imaginary parts */
+AVX2 static inline void deinterleave (const float* spectrum, __m256& real, __m256& imag)
+{
+    __m256 low = _mm256_loadu_ps (spectrum);
+    __m256 high = _mm256_loadu_ps (spectrum + 8);
+    
+    // shuffles work within 128 bit lanes: 0 1 4 5 2 3 6 7, so swap the middle quarters back
+    real = _mm256_shuffle_ps (low, high, _MM_SHUFFLE (2, 0, 2, 0));
+    imag = _mm256_shuffle_ps (low, high, _MM_SHUFFLE (3, 1, 3, 1));
+    real = _mm256_castpd_ps (_mm256_permute4x64_pd (_mm256_castps_pd (real), _MM_SHUFFLE (3, 1, 2, 0)));
+    imag = _mm256_castpd_ps (_mm256_permute4x64_pd (_mm256_castps_pd (imag), _MM_SHUFFLE (3, 1, 2, 0)));
+}
+
+//=======================================================================
+AVX2 static void multiplyAVX2 (const float* a, const float* b, float* out, int n)
+{
+    int i = 0;
+    
+    for (; i + 8 <= n; i += 8)
+    {
+        _mm256_storeu_ps (out + i, _mm256_mul_ps (_mm256_loadu_ps (a + i), _mm256_loadu_ps (b + i)));
+    }
+    
+    multiplyPlain (a + i, b + i, out + i, n - i);
+}
+
+//=======================================================================
+AVX2 static void magnitudeAVX2 (const float* spectrum, float* mag, int n)
+{
+    int i = 0;
+    
+    for (; i + 8 <= n; i += 8)
+    {
+        __m256 real, imag;
+        deinterleave (spectrum + 2*i, real, imag);
+        _mm256_storeu_ps (mag + i, _mm256_sqrt_ps (_mm256_fmadd_ps (real, real, _mm256_mul_ps (imag, imag))));
+    }
+    
+    magnitudePlain (spectrum + 2*i, mag + i, n - i);
+}
+
+//=======================================================================
+AVX2 static double spectralDifferenceAVX2 (const float* mag, float* prevMag, int n, bool halfWaveRectify)
+{
+    const __m256 signBit = _mm256_set1_ps (-0.0f);
+    const __m256 zero = _mm256_setzero_ps();
+    __m256 sum = zero;
+    int i = 0;
+    
+    for (; i + 8 <= n; i += 8)
+    {
+        __m256 current = _mm256_loadu_ps (mag + i);
+        __m256 diff = _mm256_sub_ps (current, _mm256_loadu_ps (prevMag + i));
+        diff = halfWaveRectify ? _mm256_max_ps (diff, zero) : _mm256_andnot_ps (signBit, diff);
+        sum = _mm256_add_ps (sum, diff);
+        _mm256_storeu_ps (prevMag + i, current);
+    }
+    
+    return horizontalSum (sum) + spectralDifferencePlain (mag + i, prevMag + i, n - i, halfWaveRectify);
+}
+
+//=======================================================================
+AVX2 static double sumAVX2 (const float* values, int n)
+{
+    __m256 sum = _mm256_setzero_ps();
+    int i = 0;
+    
+    for (; i + 8 <= n; i += 8)
+    {
+        sum = _mm256_add_ps (sum, _mm256_loadu_ps (values + i));
+    }
+    
+    return horizontalSum (sum) + sumPlain (values + i, n - i);
+}
+
+//=======================================================================
+AVX2 static double complexSpectralDifferenceAVX2 (const float* spectrum, const ComplexSpectrumHistory& history, int n, bool halfWaveRectify)
+{
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 one = _mm256_set1_ps (1.0f);
+    const __m256 two = _mm256_set1_ps (2.0f);
+    __m256 sum = zero;
+    int i = 0;
+    
+    for (; i + 8 <= n; i += 8)
+    {
+        __m256 real, imag;
+        deinterleave (spectrum + 2*i, real, imag);
+        __m256 mag = _mm256_sqrt_ps (_mm256_fmadd_ps (real, real, _mm256_mul_ps (imag, imag)));
+        
+        // unit phasor of this frame, phase zero if there is no energy
+        __m256 hasEnergy = _mm256_cmp_ps (mag, zero, _CMP_GT_OQ);
+        __m256 unitReal = _mm256_blendv_ps (one, _mm256_div_ps (real, mag), hasEnergy);
+        __m256 unitImag = _mm256_and_ps (hasEnergy, _mm256_div_ps (imag, mag));
+        
+        // conj(u1)^2 * u2 = e^(j * (phase2 - 2 * phase1))
+        __m256 a = _mm256_loadu_ps (history.prevReal + i);
+        __m256 b = _mm256_loadu_ps (history.prevImag + i);
+        __m256 c = _mm256_loadu_ps (history.prevReal2 + i);
+        __m256 d = _mm256_loadu_ps (history.prevImag2 + i);
+        __m256 squareReal = _mm256_fmsub_ps (a, a, _mm256_mul_ps (b, b));
+        __m256 squareImag = _mm256_mul_ps (_mm256_mul_ps (two, a), b); // negated
+        __m256 advanceReal = _mm256_fmadd_ps (squareReal, c, _mm256_mul_ps (squareImag, d));
+        __m256 advanceImag = _mm256_fmsub_ps (squareReal, d, _mm256_mul_ps (squareImag, c));
+        
+        // cosine of the phase deviation
+        __m256 cosDeviation = _mm256_fmsub_ps (unitReal, advanceReal, _mm256_mul_ps (unitImag, advanceImag));
+        
+        __m256 prevMag = _mm256_loadu_ps (history.prevMag + i);
+        __m256 distance = _mm256_fmadd_ps (mag, mag, _mm256_mul_ps (prevMag, prevMag));
+        distance = _mm256_fnmadd_ps (_mm256_mul_ps (two, mag), _mm256_mul_ps (prevMag, cosDeviation), distance);
+        __m256 csd = _mm256_sqrt_ps (_mm256_max_ps (distance, zero));
+        
+        if (halfWaveRectify)
+        {
+            csd = _mm256_and_ps (_mm256_cmp_ps (mag, prevMag, _CMP_GT_OQ), csd);
+        }
+        
+        sum = _mm256_add_ps (sum, csd);
+        
+        _mm256_storeu_ps (history.prevReal2 + i, a);
+        _mm256_storeu_ps (history.prevImag2 + i, b);
+        _mm256_storeu_ps (history.prevReal + i, unitReal);
+        _mm256_storeu_ps (history.prevImag + i, unitImag);
+        _mm256_storeu_ps (history.prevMag + i, mag);
+    }
+    
+    ComplexSpectrumHistory rest = {history.prevMag + i, history.prevReal + i, history.prevImag + i, history.prevReal2 + i, history.prevImag2 + i};
+    
+    return horizontalSum (sum) + complexSpectralDifferencePlain (spectrum + 2*i, rest, n - i, halfWaveRectify);
+}
+
+static const SpectralKernels avx2Kernels =
+{
+    multiplyAVX2,
+    magnitudeAVX2,
+    spectralDifferenceAVX2,
+    sumAVX2,
+    complexSpectralDifferenceAVX2,
+    "avx2"
+};
+
+#endif
+
+////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////// Runtime Selection ///////////////////////////////////////
+
+//=======================================================================
+static const SpectralKernels& selectKernels()
+{
+#ifdef SPECTRAL_KERNELS_X86
+    __builtin_cpu_init();
+    
+    if (__builtin_cpu_supports ("avx2") && __builtin_cpu_supports ("fma"))
+    {
+        return avx2Kernels;
+    }
+    
+    if (__builtin_cpu_supports ("sse2"))
+    {
+        return sse2Kernels;
+    }
+#endif
+    
+    return plainKernels;
+}
+
+//=======================================================================
+const SpectralKernels& SpectralKernels::get()
+{
+    static const SpectralKernels& kernels = selectKernels();
+    return kernels;
+}
@@ -0,0 +1,102 @@
+//=======================================================================
+/** @file SpectralKernels.h
+ *  @brief Single precision kernels for the spectral onset detection functions
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+//=======================================================================
+
+#ifndef __SPECTRALKERNELS_H
+#define __SPECTRALKERNELS_H
+
+//=======================================================================
+/** State of the complex spectral difference: the previous magnitude and the
+ * previous two unit phasors (e^(j * phase)) of each bin, as separate arrays
+ */
+struct ComplexSpectrumHistory
+{
+    float* prevMag;                     /**< previous magnitude spectrum */
+    float* prevReal;                    /**< real part of the previous unit phasors */
+    float* prevImag;                    /**< imaginary part of the previous unit phasors */
+    float* prevReal2;                   /**< real part of the second order previous unit phasors */
+    float* prevImag2;                   /**< imaginary part of the second order previous unit phasors */
+};
+
+//=======================================================================
+/** The inner loops of the spectral difference, complex spectral difference
+ * and high frequency content detection functions in single precision.
+ *
+ * Implementations for SSE2 and AVX2 are chosen at runtime from the features
+ * of the CPU, with a plain implementation for everything else. Complex
+ * spectra are interleaved (real, imaginary) as fftwf_complex. The arrays
+ * need not be aligned.
+ */
+struct SpectralKernels
+{
+    /** Multiply two arrays element by element, e.g. to window a frame
+     * @param a the first input array
+     * @param b the second input array
+     * @param out the output array, out[i] = a[i] * b[i]
+     * @param n the number of elements
+     */
+    void (*multiply) (const float* a, const float* b, float* out, int n);
+    
+    /** Calculate the magnitudes of a complex spectrum
+     * @param spectrum the n interleaved complex values
+     * @param mag the output magnitudes
+     * @param n the number of bins
+     */
+    void (*magnitude) (const float* spectrum, float* mag, int n);
+    
+    /** Sum the differences between a magnitude spectrum and the previous one,
+     * the previous spectrum is then set to the current one
+     * @param mag the magnitude spectrum
+     * @param prevMag the previous magnitude spectrum
+     * @param n the number of bins
+     * @param halfWaveRectify true to only sum positive differences, otherwise absolute differences are summed
+     * @returns the sum of differences
+     */
+    double (*spectralDifference) (const float* mag, float* prevMag, int n, bool halfWaveRectify);
+    
+    /** Sum an array
+     * @param values the array
+     * @param n the number of elements
+     * @returns the sum
+     */
+    double (*sum) (const float* values, int n);
+    
+    /** Sum the distance of each bin of a complex spectrum to its prediction from
+     * the previous magnitude and the phase advance of the previous two frames,
+     * the history is then advanced
+     *
+     * The phase deviation is applied as a product of unit phasors which avoids
+     * evaluating atan2 and cos per bin; bins with no energy take phase zero.
+     * @param spectrum the n interleaved complex values
+     * @param history the history of the same n bins
+     * @param n the number of bins
+     * @param halfWaveRectify true to only sum bins rising in magnitude
+     * @returns the sum of distances
+     */
+    double (*complexSpectralDifference) (const float* spectrum, const ComplexSpectrumHistory& history, int n, bool halfWaveRectify);
+    
+    /** Name of the implementation */
+    const char* name;
+    
+    /** Get the fastest implementation supported by this CPU
+     * @returns the kernels
+     */
+    static const SpectralKernels& get();
+};
+
+#endif
@@ -0,0 +1,252 @@
+/*
+ * This file is part of Bipscript.
+ *
+ * Bipscript is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Bipscript is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Bipscript.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "analyzer.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace bipscript {
+namespace audio {
+
+FeatureSnapshot::FeatureSnapshot() : sequence(0)
+{
+    for(unsigned int i = 0; i < FEATURE_COUNT; i++) {
+        values[i].store(0);
+    }
+}
+
+/**
+ * Runs in the process thread. No allocations.
+ */
+void FeatureSnapshot::store(const Features &features)
+{
+    uint32_t count = sequence.load(std::memory_order_relaxed);
+    sequence.store(count + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    values[0].store(features.rmsValue, std::memory_order_relaxed);
+    values[1].store(features.peakValue, std::memory_order_relaxed);
+    values[2].store(features.centroidValue, std::memory_order_relaxed);
+    values[3].store(features.fluxValue, std::memory_order_relaxed);
+    values[4].store(features.pitchValue, std::memory_order_relaxed);
+    sequence.store(count + 2, std::memory_order_release);
+}
+
+/**
+ * Runs in the script thread.
+ */
+Features FeatureSnapshot::load()
+{
+    Features features;
+    uint32_t before, after;
+    do {
+        before = sequence.load(std::memory_order_acquire);
+        features.rmsValue = values[0].load(std::memory_order_relaxed);
+        features.peakValue = values[1].load(std::memory_order_relaxed);
+        features.centroidValue = values[2].load(std::memory_order_relaxed);
+        features.fluxValue = values[3].load(std::memory_order_relaxed);
+        features.pitchValue = values[4].load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        after = sequence.load(std::memory_order_relaxed);
+    } while(before != after || (before & 1));
+    return features;
+}
+
+Analyzer::Analyzer() :
+    odf(ANALYZER_HOP_SIZE, 2 * ANALYZER_HOP_SIZE, SpectralDifferenceHWR, HanningWindow),
+    index(0), audioInput(0), onFeaturesHandler(0), interval(ANALYZER_INTERVAL), lastCallbackFrame(0)
+{
+    buffer = new float[2 * ANALYZER_HOP_SIZE]();
+    difference = new float[ANALYZER_HOP_SIZE];
+}
+
+Analyzer::~Analyzer()
+{
+    delete[] buffer;
+    delete[] difference;
+}
+
+void Analyzer::onFeatures(ScriptFunction &handler)
+{
+    if(handler.getNumargs() != 2) {
+        throw std::logic_error("onFeatures handler should take one argument");
+    }
+    onFeaturesHandler.store(new ScriptFunction(handler));
+}
+
+/**
+ * Sets the minimum time between feature callbacks.
+ *
+ * Runs in the script thread.
+ */
+float Analyzer::updateInterval(float milliseconds)
+{
+    if(milliseconds < 0) {
+        throw std::logic_error("update interval cannot be negative");
+    }
+    interval.store(milliseconds);
+    return milliseconds;
+}
+
+void Analyzer::reset()
+{
+    if(onFeaturesHandler) {
+        onFeaturesHandler.load()->release();
+        delete onFeaturesHandler;
+        onFeaturesHandler = 0;
+    }
+    interval.store(ANALYZER_INTERVAL);
+}
+
+/**
+ * Spectral centroid in Hz of the magnitude spectrum calculated by the onset
+ * detection function for the last hop.
+ *
+ * Runs in the process thread. No allocations.
+ */
+float Analyzer::centroid(jack_nframes_t sampleRate)
+{
+    const float *magnitude = odf.getMagnitudeSpectrum();
+    int numBins = odf.getNumBins();
+    double weighted = 0;
+    double total = 0;
+    for(int bin = 0; bin < numBins; bin++) {
+        weighted += bin * magnitude[bin];
+        total += magnitude[bin];
+    }
+    if(!total) {
+        return 0;
+    }
+    return weighted / total * sampleRate / (2 * ANALYZER_HOP_SIZE);
+}
+
+/**
+ * YIN pitch estimate in Hz over the previous and current hop: the first lag
+ * where the cumulative mean normalized difference dips below the threshold,
+ * followed down to its minimum and refined by parabolic interpolation.
+ *
+ * Lags run up to one hop so the lowest pitch found is the sample rate over
+ * the hop size, about 94Hz at 48kHz. Returns zero if no lag falls below the
+ * threshold.
+ *
+ * Runs in the process thread. No allocations.
+ */
+float Analyzer::pitch(jack_nframes_t sampleRate)
+{
+    const unsigned int window = ANALYZER_HOP_SIZE;
+    difference[0] = 1;
+    double runningSum = 0;
+    unsigned int best = 0;
+    unsigned int tau;
+    for(tau = 1; tau < window; tau++) {
+        float sum = 0;
+        for(unsigned int i = 0; i < window; i++) {
+            float delta = buffer[i] - buffer[i + tau];
+            sum += delta * delta;
+        }
+        runningSum += sum;
+        difference[tau] = runningSum ? sum * tau / runningSum : 1;
+        // stop once past the minimum of the first dip
+        if(best) {
+            if(difference[tau] >= difference[best]) {
+                break;
+            }
+            best = tau;
+        } else if(tau > 1 && difference[tau] < PITCH_THRESHOLD) {
+            best = tau;
+        }
+    }
+    if(!best) {
+        return 0;
+    }
+    double lag = best;
+    if(best + 1 < window) {
+        double curvature = difference[best - 1] - 2 * difference[best] + difference[best + 1];
+        if(curvature > 0) {
+            lag += 0.5 * (difference[best - 1] - difference[best + 1]) / curvature;
+        }
+    }
+    return sampleRate / lag;
+}
+
+void Analyzer::doProcess(bool rolling, jack_position_t &pos, jack_nframes_t nframes, jack_nframes_t time)
+{
+    // get incoming audio
+    AudioConnection *connection = audioInput.load();
+    float *audio;
+    if(connection) {
+        connection->getSource()->process(rolling, pos, nframes, time);
+        audio = connection->getAudio();
+    } else {
+        audio = AudioConnection::getDummyBuffer();
+    }
+
+    // pick up settings once per period
+    ScriptFunction *handler = onFeaturesHandler.load();
+    jack_nframes_t minFrames = interval.load() * pos.frame_rate / 1000;
+
+    // add new audio to buffer a hop at a time
+    for(jack_nframes_t i = 0; i < nframes; ) {
+        jack_nframes_t count = std::min(nframes - i, ANALYZER_HOP_SIZE - index);
+        std::copy(audio + i, audio + i + count, buffer + ANALYZER_HOP_SIZE + index);
+        index += count;
+        i += count;
+        if(index == ANALYZER_HOP_SIZE) {
+            float *hop = buffer + ANALYZER_HOP_SIZE;
+            // level
+            float sum = 0;
+            float peak = 0;
+            for(unsigned int j = 0; j < ANALYZER_HOP_SIZE; j++) {
+                sum += hop[j] * hop[j];
+                peak = std::max(peak, std::fabs(hop[j]));
+            }
+            float rms = std::sqrt(sum / ANALYZER_HOP_SIZE);
+            // spectrum
+            float flux = odf.calculateOnsetDetectionFunctionSample(hop);
+            Features features(rms, peak, centroid(pos.frame_rate), flux,
+                              rms > PITCH_SILENCE ? pitch(pos.frame_rate) : 0);
+            snapshot.store(features);
+            // callback at most once per interval
+            jack_nframes_t frame = time + i;
+            if(handler && frame - lastCallbackFrame >= minFrames) {
+                (new OnFeaturesClosure(*handler, features))->dispatch();
+                lastCallbackFrame = frame;
+            }
+            // current hop becomes the previous
+            std::copy(hop, hop + ANALYZER_HOP_SIZE, buffer);
+            index = 0;
+        }
+    }
+}
+
+/**
+ * runs in script thread
+ */
+Analyzer *AnalyzerCache::getAnalyzer()
+{
+    // instances are keyed by the order they are created in the script
+    int key = instanceCount++;
+    Analyzer *analyzer = findObject(key);
+    if(!analyzer) {
+        analyzer = new Analyzer();
+        registerObject(key, analyzer);
+    } else {
+        analyzer->reset();
+    }
+    return analyzer;
+}
+
+}}
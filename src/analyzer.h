@@ -0,0 +1,143 @@
+/*
+ * This file is part of Bipscript.
+ *
+ * Bipscript is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Bipscript is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Bipscript.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef ANALYZER_H
+#define ANALYZER_H
+
+#include "audioconnection.h"
+#include "objectcache.h"
+#include "eventclosure.h"
+#include "OnsetDetectionFunction.h"
+#include "bindaudio.h"
+
+#include <atomic>
+
+namespace bipscript {
+namespace audio {
+
+const unsigned int ANALYZER_HOP_SIZE = 512;
+const float ANALYZER_INTERVAL = 100; // default minimum time between callbacks in milliseconds
+const float PITCH_THRESHOLD = 0.15; // YIN absolute threshold
+const float PITCH_SILENCE = 0.0001; // RMS below which no pitch is estimated
+
+/**
+ * Features of one hop of audio.
+ */
+class Features
+{
+    float rmsValue;
+    float peakValue;
+    float centroidValue;
+    float fluxValue;
+    float pitchValue;
+public:
+    Features() : rmsValue(0), peakValue(0), centroidValue(0), fluxValue(0), pitchValue(0) {}
+    Features(float rms, float peak, float centroid, float flux, float pitch)
+        : rmsValue(rms), peakValue(peak), centroidValue(centroid), fluxValue(flux), pitchValue(pitch) {}
+    float centroid() { return centroidValue; }
+    float flux() { return fluxValue; }
+    float peak() { return peakValue; }
+    float pitch() { return pitchValue; }
+    float rms() { return rmsValue; }
+    friend class FeatureSnapshot;
+};
+
+/**
+ * The latest features, published by the process thread and read from the
+ * script thread without locks: the writer bumps the sequence number before
+ * and after each update and readers retry if it changed while they read.
+ */
+class FeatureSnapshot
+{
+    static const unsigned int FEATURE_COUNT = 5;
+    std::atomic<uint32_t> sequence;
+    std::atomic<float> values[FEATURE_COUNT];
+public:
+    FeatureSnapshot();
+    void store(const Features &features);
+    Features load();
+};
+
+/**
+ * Extracts level, spectral and pitch features from an audio input a hop at
+ * a time: RMS and peak level, spectral centroid and flux from the onset
+ * detection function spectrum, and a YIN pitch estimate.
+ *
+ * Scripts read the latest features at any time or get a callback at most
+ * once per update interval.
+ */
+class Analyzer : public Processor
+{
+    OnsetDetectionFunction odf;
+    float *buffer; // previous and current hop
+    float *difference; // YIN difference function
+    unsigned int index;
+    FeatureSnapshot snapshot;
+    std::atomic<AudioConnection *> audioInput;
+    std::atomic<ScriptFunction*> onFeaturesHandler;
+    std::atomic<float> interval;
+    jack_nframes_t lastCallbackFrame;
+    float centroid(jack_nframes_t sampleRate);
+    float pitch(jack_nframes_t sampleRate);
+public:
+    Analyzer();
+    ~Analyzer();
+    void connect(Source &source) {
+        this->audioInput.store(source.getAudioConnection(0));
+    }
+    void connect(AudioConnection &connection) {
+        this->audioInput.store(&connection);
+    }
+    Features *features() {
+        return new Features(snapshot.load());
+    }
+    void onFeatures(ScriptFunction &handler);
+    float updateInterval() {
+        return interval.load();
+    }
+    float updateInterval(float milliseconds);
+    void reset();
+    void doProcess(bool rolling, jack_position_t &pos, jack_nframes_t nframes, jack_nframes_t time);
+    void reposition() {}
+};
+
+class OnFeaturesClosure : public EventClosure {
+    Features features;
+protected:
+    void addParameters() { addObject(&features, binding::AudioFeaturesObject); }
+public:
+    OnFeaturesClosure(ScriptFunction function, const Features &features) :
+        EventClosure(function), features(features) {}
+};
+
+class AnalyzerCache : public ProcessorCache<Analyzer>
+{
+    int instanceCount;
+    void scriptReset() {
+        instanceCount = 0;
+    }
+public:
+    AnalyzerCache() : instanceCount(0) {}
+    static AnalyzerCache &instance() {
+        static AnalyzerCache instance;
+        return instance;
+    }
+    Analyzer *getAnalyzer();
+};
+
+}}
+
+#endif // ANALYZER_H
@@ -0,0 +1,147 @@
+/*
+ * This file is part of Bipscript.
+ *
+ * Bipscript is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Bipscript is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Bipscript.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "audiobuffer.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+#include <sys/mman.h>
+
+namespace bipscript {
+namespace audio {
+
+/**
+ * BufferArena ctor.
+ *
+ * Reserves the dummy slot, blocks are allocated once the buffer size is known.
+ */
+BufferArena::BufferArena()
+    : stride(strideFor(0)), bufferSize(0), blockCount(0), slotCount(DUMMY_SLOT + 1)
+{
+    for(unsigned int i = 0; i < MAX_BLOCKS; i++) {
+        blocks[i].store(0);
+    }
+}
+
+BufferArena::~BufferArena()
+{
+    for(unsigned int i = 0; i < blockCount; i++) {
+        freeBlock(blocks[i].load(), stride.load());
+    }
+}
+
+/**
+ * Allocates a zeroed, aligned block and locks it into memory.
+ *
+ * Runs in the script thread or the jack buffer size callback.
+ */
+float *BufferArena::allocateBlock(unsigned int stride)
+{
+    size_t size = sizeof(float) * stride * SLOTS_PER_BLOCK;
+    void *block;
+    if(posix_memalign(&block, ALIGNMENT, size)) {
+        throw std::bad_alloc();
+    }
+    // best effort: fails without sufficient RLIMIT_MEMLOCK
+    mlock(block, size);
+    // touch every page now rather than in the process thread
+    std::memset(block, 0, size);
+    return static_cast<float*>(block);
+}
+
+void BufferArena::freeBlock(float *block, unsigned int stride)
+{
+    munlock(block, sizeof(float) * stride * SLOTS_PER_BLOCK);
+    free(block);
+}
+
+/**
+ * Reserves a buffer slot, the buffer is silent on return.
+ *
+ * Runs in the script thread.
+ *
+ * Allocates a new block when all existing blocks are in use.
+ */
+unsigned int BufferArena::allocate()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    unsigned int slot;
+    if(freeSlots.size()) {
+        slot = freeSlots.back();
+        freeSlots.pop_back();
+    } else {
+        if(slotCount == MAX_BLOCKS * SLOTS_PER_BLOCK) {
+            throw std::logic_error("too many audio connections");
+        }
+        slot = slotCount++;
+    }
+    unsigned int currentStride = stride.load();
+    while(slot / SLOTS_PER_BLOCK >= blockCount) {
+        blocks[blockCount].store(allocateBlock(currentStride), std::memory_order_release);
+        blockCount++;
+    }
+    std::memset(getBuffer(slot), 0, sizeof(float) * currentStride);
+    return slot;
+}
+
+/**
+ * Returns a slot to the arena.
+ *
+ * Runs in the script thread.
+ */
+void BufferArena::release(unsigned int slot)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    freeSlots.push_back(slot);
+}
+
+/**
+ * Re-lays out all blocks for a new buffer size.
+ *
+ * Runs in the jack buffer size callback, jack guarantees no process cycle is
+ * running so the blocks can be swapped out from under existing connections;
+ * buffer contents are not preserved.
+ *
+ * Allocates replacement blocks before releasing the old ones.
+ */
+void BufferArena::setBufferSize(jack_nframes_t size)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    unsigned int oldStride = stride.load();
+    unsigned int newStride = strideFor(size);
+    bufferSize = size;
+    if(blockCount && newStride == oldStride) {
+        return;
+    }
+    unsigned int newCount = blockCount ? blockCount : 1;
+    float *newBlocks[MAX_BLOCKS];
+    for(unsigned int i = 0; i < newCount; i++) {
+        newBlocks[i] = allocateBlock(newStride);
+    }
+    stride.store(newStride);
+    for(unsigned int i = 0; i < newCount; i++) {
+        float *old = blocks[i].exchange(newBlocks[i]);
+        if(old) {
+            freeBlock(old, oldStride);
+        }
+    }
+    blockCount = newCount;
+}
+
+}}
@@ -0,0 +1,83 @@
+/*
+ * This file is part of Bipscript.
+ *
+ * Bipscript is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Bipscript is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Bipscript.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef AUDIOBUFFER_H
+#define AUDIOBUFFER_H
+
+#include <jack/types.h>
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+namespace bipscript {
+namespace audio {
+
+/**
+ * Shared storage for all mono audio buffers.
+ *
+ * Buffers are handed out as slots within fixed-size blocks; each block is one
+ * contiguous, cache-line aligned, locked and pre-faulted region so the
+ * process thread never takes a page fault on first touch. Every slot is
+ * padded to a multiple of the alignment so each buffer starts on its own
+ * cache line.
+ *
+ * Slots are allocated and released in the script thread, blocks are
+ * re-laid out in the jack buffer size callback (when no process cycle is
+ * running) and buffers are read in the process thread.
+ */
+class BufferArena
+{
+public:
+    static const unsigned int ALIGNMENT = 64;
+    static const unsigned int SLOTS_PER_BLOCK = 64;
+    static const unsigned int MAX_BLOCKS = 256;
+    static const unsigned int DUMMY_SLOT = 0;
+private:
+    std::atomic<float *> blocks[MAX_BLOCKS];
+    std::atomic<unsigned int> stride;
+    jack_nframes_t bufferSize;
+    unsigned int blockCount;
+    unsigned int slotCount;
+    std::vector<unsigned int> freeSlots;
+    std::mutex mutex;
+    float *allocateBlock(unsigned int stride);
+    void freeBlock(float *block, unsigned int stride);
+    static unsigned int strideFor(jack_nframes_t size) {
+        const unsigned int perLine = ALIGNMENT / sizeof(float);
+        unsigned int frames = size ? size : perLine;
+        return (frames + perLine - 1) / perLine * perLine;
+    }
+public:
+    BufferArena();
+    ~BufferArena();
+    unsigned int allocate();
+    void release(unsigned int slot);
+    void setBufferSize(jack_nframes_t size);
+    jack_nframes_t getBufferSize() { return bufferSize; }
+    /**
+     * Returns the buffer for the given slot.
+     *
+     * Runs in the process thread. No allocations.
+     */
+    float *getBuffer(unsigned int slot) {
+        return blocks[slot / SLOTS_PER_BLOCK].load(std::memory_order_acquire)
+                + (slot % SLOTS_PER_BLOCK) * stride.load(std::memory_order_relaxed);
+    }
+};
+
+}}
+
+#endif // AUDIOBUFFER_H
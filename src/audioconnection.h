@@ -18,6 +18,7 @@
 #define AUDIOCONNECTION_H
 
 #include "source.h"
+#include "audiobuffer.h"
 #include <atomic>
 #include <stdexcept>
 #include <cstring>
@@ -31,34 +32,35 @@ class Source;
  * Represents a mono audio connection
  */
 class AudioConnection {
-    static float *dummyBuffer;
-    static jack_nframes_t bufferSize;
-    Source *source;    
+    static BufferArena arena;
+    Source *source;
+    unsigned int slot;
     float *buffer;
 public:
     // static
     static void setBufferSize(jack_nframes_t size) {
-        if(dummyBuffer) {
-            delete[] dummyBuffer;
-        }
-        dummyBuffer = new float[size];
-        bufferSize = size;
+        arena.setBufferSize(size);
     }
     static float *getDummyBuffer() {
-        return dummyBuffer;
+        return arena.getBuffer(BufferArena::DUMMY_SLOT);
     }
     // instance
     AudioConnection(Source *source, bool allocate = true)
-        : source(source) {
+        : source(source), slot(BufferArena::DUMMY_SLOT), buffer(0) {
         if(allocate) {
-            buffer = new float[bufferSize];
+            slot = arena.allocate();
+        }
+    }
+    ~AudioConnection() {
+        if(slot != BufferArena::DUMMY_SLOT) {
+            arena.release(slot);
         }
     }
     void setBuffer(float *buffer) { this->buffer = buffer; }
     Source *getSource() { return source; }
-    float *getAudio() { return buffer; }
+    float *getAudio() { return buffer ? buffer : arena.getBuffer(slot); }
     void clear() {
-        std::memset(buffer, 0, sizeof(float) * bufferSize);
+        std::memset(getAudio(), 0, sizeof(float) * arena.getBufferSize());
     }
 };
 
@@ -30,8 +30,7 @@ namespace bipscript {
 
 namespace audio {
 
-float *AudioConnection::dummyBuffer = 0;
-jack_nframes_t AudioConnection::bufferSize;
+BufferArena AudioConnection::arena;
 
 }
 
@@ -157,6 +156,7 @@ void AudioEngine::releaseTransportMaster()
 {    
     jack_release_timebase(client);
     transportMaster = 0;
+    tempoMap.store(0);
 }
 
 // from the API docs: TRUE (non-zero) when ready to roll
@@ -258,6 +258,12 @@ int AudioEngine::process(jack_nframes_t nframes)
         obj = activeProcessors.getNext(obj);
     }
 
+    // objects retired by the script thread are no longer in use
+    Listable *retired;
+    while(retiredObjects.pop(retired)) {
+        ObjectCollector::scriptCollector().recycle(retired);
+    }
+
     // push out objects to delete
     ObjectCollector::scriptCollector().update();
 
@@ -18,6 +18,7 @@
 #define AUDIOENGINE_H
 
 #include <jack/jack.h>
+#include <atomic>
 
 #include "timesignature.h"
 #include "processor.h"
@@ -26,6 +27,7 @@ namespace bipscript {
 
 namespace transport {
 class Master;
+class TempoMap;
 }
 
 class AudioEngine
@@ -39,18 +41,20 @@ class AudioEngine
 
     // transport
     transport::Master *transportMaster;
+    std::atomic<const transport::TempoMap *> tempoMap;
     unsigned int multiplePeriodRestart;
     transport::TimeSignature currentTimeSignature;
 
     // processors
     QueueList<Processor> activeProcessors;
     boost::lockfree::spsc_queue<Processor*> deletedProcessors; // TODO: also a QueueList?
+    boost::lockfree::spsc_queue<Listable*> retiredObjects; // script thread -> process thread
 
     // private methods
     bool reposition(uint16_t attempt);
 
     // singleton
-    AudioEngine() : client(0), activeProcessors(128), deletedProcessors(16) {}
+    AudioEngine() : client(0), tempoMap(0), activeProcessors(128), deletedProcessors(16), retiredObjects(16) {}
     AudioEngine(AudioEngine const&);
     void operator=(AudioEngine const&);
 public:
@@ -74,6 +78,13 @@ public:
     void removeProcessor(Processor *obj) {
         while(!deletedProcessors.push(obj));
     }
+    /**
+     * Delete an object the process thread may still be reading once the
+     * current cycle is over.
+     */
+    void retire(Listable *obj) {
+        while(!retiredObjects.push(obj));
+    }
     // public methods
     int activate(const char *clientName);
     int process(jack_nframes_t nframes);
@@ -117,6 +128,15 @@ public:
     }
     transport::Master *getTransportMaster(double bpm, float beatsPerBar, float beatUnit);
     void releaseTransportMaster();
+    /**
+     * The tempo map of the transport master, null when not the master.
+     */
+    const transport::TempoMap *getTempoMap() {
+        return tempoMap.load(std::memory_order_acquire);
+    }
+    void setTempoMap(const transport::TempoMap *map) {
+        tempoMap.store(map, std::memory_order_release);
+    }
 };
 
 }
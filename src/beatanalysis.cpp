@@ -0,0 +1,219 @@
+/*
+ * This file is part of Bipscript.
+ *
+ * Bipscript is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Bipscript is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Bipscript.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "beatanalysis.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+namespace bipscript {
+
+static void *run_beat_analysis(void *arg)
+{
+    ((BeatAnalysisThread*)arg)->run();
+    return 0;
+}
+
+BeatAnalysisThread::BeatAnalysisThread()
+    : running(false), stopping(false)
+{
+    sem_init(&semaphore, 0, 0);
+}
+
+BeatAnalysisThread::~BeatAnalysisThread()
+{
+    if(running) {
+        stopping.store(true);
+        sem_post(&semaphore);
+        pthread_join(thread, NULL);
+    }
+    sem_destroy(&semaphore);
+}
+
+/**
+ * Register an analysis, the thread is started with the first one.
+ *
+ * Runs in the script thread.
+ */
+void BeatAnalysisThread::add(BeatAnalysis *analysis)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    if(!running) {
+        if(pthread_create(&thread, NULL, run_beat_analysis, this)) {
+            throw std::runtime_error("could not create beat analysis thread");
+        }
+        running = true;
+    }
+    analyses.push_back(analysis);
+}
+
+/**
+ * Unregister an analysis, on return the thread no longer touches it.
+ *
+ * Runs in the thread deleting the tracker after it has left the process thread.
+ */
+void BeatAnalysisThread::remove(BeatAnalysis *analysis)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    analyses.erase(std::remove(analyses.begin(), analyses.end(), analysis), analyses.end());
+}
+
+/**
+ * Analysis thread: runs every registered tracker on samples as they arrive.
+ */
+void BeatAnalysisThread::run()
+{
+    while(true) {
+        sem_wait(&semaphore);
+        if(stopping.load()) {
+            break;
+        }
+        std::lock_guard<std::mutex> lock(mutex);
+        for(BeatAnalysis *analysis : analyses) {
+            analysis->analyse();
+        }
+    }
+}
+
+/**
+ * Runs in the script thread.
+ */
+BeatAnalysis::BeatAnalysis(double bpm)
+    : analysisThread(BeatAnalysisThread::instance()), analysedHops(0), publishedBeat(0),
+      requestedTempo(bpm), prediction(0), hop(0), firedHop(0), appliedTempo(bpm)
+{
+    publish(0, bpm);
+    sampleBuffer = jack_ringbuffer_create(sizeof(double) * 1024);
+    jack_ringbuffer_mlock(sampleBuffer);
+    try {
+        analysisThread.add(this);
+    } catch(...) {
+        jack_ringbuffer_free(sampleBuffer);
+        throw;
+    }
+}
+
+/**
+ * Runs in the thread deleting the tracker after it has left the process thread.
+ */
+BeatAnalysis::~BeatAnalysis()
+{
+    analysisThread.remove(this);
+    jack_ringbuffer_free(sampleBuffer);
+}
+
+/**
+ * Reset the tracker to the given tempo, applied by the analysis thread
+ * before the next sample. No beat is forced, the next beat comes from the
+ * tracker at the new tempo.
+ *
+ * Runs in the script thread or the process thread.
+ */
+void BeatAnalysis::setTempo(double bpm)
+{
+    requestedTempo.store(bpm);
+    analysisThread.wake();
+}
+
+void BeatAnalysis::publish(uint32_t beatHop, float tempo)
+{
+    publishedBeat = beatHop;
+    uint32_t tempoBits;
+    std::memcpy(&tempoBits, &tempo, sizeof(tempoBits));
+    prediction.store((uint64_t)beatHop << 32 | tempoBits, std::memory_order_release);
+}
+
+/**
+ * Hand over the onset detection function sample of the next hop.
+ *
+ * Runs in the process thread. No allocations.
+ */
+void BeatAnalysis::addSample(double sample)
+{
+    hop++;
+    if(jack_ringbuffer_write_space(sampleBuffer) >= sizeof(double)) {
+        jack_ringbuffer_write(sampleBuffer, (const char*)&sample, sizeof(double));
+        analysisThread.wake();
+    }
+}
+
+/**
+ * Returns true if a beat is predicted for the hop just added, with the
+ * current tempo estimate.
+ *
+ * Runs in the process thread. No allocations.
+ */
+bool BeatAnalysis::beatDue(double &tempo)
+{
+    uint64_t snapshot = prediction.load(std::memory_order_acquire);
+    uint32_t beatHop = snapshot >> 32;
+    uint32_t tempoBits = snapshot;
+    float estimate;
+    std::memcpy(&estimate, &tempoBits, sizeof(estimate));
+    if(beatHop == firedHop || hop - beatHop >= LATE_HOPS) {
+        return false;
+    }
+    firedHop = beatHop;
+    tempo = appliedTempo = estimate;
+    return true;
+}
+
+/**
+ * Returns true if the tempo estimate changed since the last beat, tempo
+ * estimates are updated on the beat so the new estimate usually arrives
+ * shortly after it.
+ *
+ * Runs in the process thread. No allocations.
+ */
+bool BeatAnalysis::tempoChanged(double &tempo)
+{
+    uint32_t tempoBits = prediction.load(std::memory_order_acquire);
+    float estimate;
+    std::memcpy(&estimate, &tempoBits, sizeof(estimate));
+    if(estimate == appliedTempo) {
+        return false;
+    }
+    tempo = appliedTempo = estimate;
+    return true;
+}
+
+/**
+ * Runs the tracker on the samples handed over so far.
+ *
+ * Runs in the analysis thread.
+ */
+void BeatAnalysis::analyse()
+{
+    double bpm = requestedTempo.exchange(0);
+    if(bpm) {
+        btrack.setTempo(bpm);
+        publish(publishedBeat, bpm);
+    }
+    double sample;
+    while(jack_ringbuffer_read_space(sampleBuffer) >= sizeof(double)) {
+        jack_ringbuffer_read(sampleBuffer, (char*)&sample, sizeof(double));
+        btrack.processOnsetDetectionFunctionSample(sample);
+        analysedHops++;
+        int samplesUntilBeat = btrack.getSamplesUntilBeat();
+        if(samplesUntilBeat >= 0) {
+            publish(analysedHops + samplesUntilBeat, btrack.getCurrentTempoEstimate());
+        }
+    }
+}
+
+}
@@ -0,0 +1,107 @@
+/*
+ * This file is part of Bipscript.
+ *
+ * Bipscript is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Bipscript is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Bipscript.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef BEATANALYSIS_H
+#define BEATANALYSIS_H
+
+#include "BTrack.h"
+
+#include <jack/ringbuffer.h>
+#include <pthread.h>
+#include <semaphore.h>
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+namespace bipscript {
+
+class BeatAnalysis;
+
+/**
+ * The analysis thread shared by all beat trackers.
+ *
+ * One normal priority thread (below the jack thread) services every
+ * registered analysis; the process thread wakes it with a semaphore post
+ * whenever a tracker hands over a sample.
+ */
+class BeatAnalysisThread
+{
+    std::mutex mutex; // guards analyses against the script thread
+    std::vector<BeatAnalysis*> analyses;
+    pthread_t thread;
+    sem_t semaphore;
+    bool running;
+    std::atomic<bool> stopping;
+    BeatAnalysisThread();
+public:
+    static BeatAnalysisThread &instance() {
+        static BeatAnalysisThread instance;
+        return instance;
+    }
+    ~BeatAnalysisThread();
+    void add(BeatAnalysis *analysis);
+    void remove(BeatAnalysis *analysis);
+    /**
+     * Runs in the process thread or the script thread. No allocations.
+     */
+    void wake() {
+        sem_post(&semaphore);
+    }
+    void run();
+};
+
+/**
+ * Runs the BTrack tempo and beat phase estimation in the shared analysis
+ * thread.
+ *
+ * The process thread hands over one onset detection function sample per
+ * hop and does nothing else; the analysis thread runs the cumulative score,
+ * beat prediction and tempo estimation and publishes the predicted beat as
+ * one atomic snapshot: the hop the next beat falls on plus the tempo. Beats
+ * are predicted half a beat ahead so the analysis has that long to catch up.
+ */
+class BeatAnalysis
+{
+    static const uint32_t LATE_HOPS = 4; // beats predicted late still fire
+    BeatAnalysisThread &analysisThread;
+    // analysis thread
+    BTrack btrack;
+    uint32_t analysedHops;
+    uint32_t publishedBeat;
+    std::atomic<double> requestedTempo;
+    void publish(uint32_t beatHop, float tempo);
+    // process thread -> analysis thread
+    jack_ringbuffer_t *sampleBuffer;
+    std::atomic<uint64_t> prediction;
+    // process thread
+    uint32_t hop;
+    uint32_t firedHop;
+    float appliedTempo;
+public:
+    BeatAnalysis(double bpm);
+    ~BeatAnalysis();
+    void setTempo(double bpm);
+    void addSample(double sample);
+    bool beatDue(double &tempo);
+    bool tempoChanged(double &tempo);
+    void analyse();
+};
+
+}
+
+#endif // BEATANALYSIS_H
@@ -17,7 +17,9 @@
 #include "beattracker.h"
 
 #include "audioengine.h"
+#include <algorithm>
 #include <iostream>
+#include <string>
 
 namespace bipscript {
 
@@ -25,7 +27,7 @@ namespace audio {
 
 void BeatTracker::reset(double bpm, float beatsPerBar, float beatUnit) {
     master = transport::MasterCache::instance().getTransportMaster(bpm, beatsPerBar, beatUnit);
-    btrack.setTempo(bpm);
+    analysis.setTempo(bpm);
 }
 
 void BeatTracker::doProcess(bool rolling, jack_position_t &pos, jack_nframes_t nframes, jack_nframes_t time)
@@ -40,16 +42,20 @@ void BeatTracker::doProcess(bool rolling, jack_position_t &pos, jack_nframes_t n
         audio = audio::AudioConnection::getDummyBuffer();
     }
 
-    // add new audio to buffer
-    for(jack_nframes_t i = 0; i < nframes; i++) {
-        btbuffer[index++] = (double) audio[i];
+    // add new audio to buffer a hop at a time
+    for(jack_nframes_t i = 0; i < nframes; ) {
+        jack_nframes_t count = std::min(nframes - i, BT_HOP_SIZE - index);
+        std::copy(audio + i, audio + i + count, btbuffer + index);
+        index += count;
+        i += count;
         if(index == BT_HOP_SIZE) {
-            // process buffer if full
-            btrack.processAudioFrame(btbuffer);
-            if(btrack.beatDueInCurrentFrame()) {
-                // set bpm
-                master->forceBeat(btrack.getCurrentTempoEstimate());
-                // printf("beat, bpm is %f\n", btrack.getCurrentTempoEstimate());
+            // onset sample here, tempo and beat prediction in the analysis thread
+            analysis.addSample(odf.calculateOnsetDetectionFunctionSample(btbuffer));
+            double tempo;
+            if(analysis.beatDue(tempo)) {
+                master->forceBeat(tempo);
+            } else if(analysis.tempoChanged(tempo)) {
+                master->setBpm(tempo);
             }
             index = 0;
         }
@@ -61,12 +67,14 @@ void BeatTracker::doProcess(bool rolling, jack_position_t &pos, jack_nframes_t n
  */
 BeatTracker *BeatTrackerCache::getBeatTracker(float bpm, float beatsPerBar, float beatUnit)
 {
-    BeatTracker *tracker = findObject(1); // TODO: allow multiple?
+    // instances are keyed by the order they are created in the script
+    int key = instanceCount++;
+    BeatTracker *tracker = findObject(key);
     if(tracker) {
         tracker->reset(bpm, beatsPerBar, beatUnit);
     } else {
         tracker = new BeatTracker(bpm, beatsPerBar, beatUnit);
-        registerObject(1, tracker);
+        registerObject(key, tracker);
     }
     return tracker;
 }
@@ -78,18 +86,19 @@ namespace midi {
 /**
  * process thread
  */
-void BeatTracker::countInEvent(midi::Event *nextEvent, jack_position_t &pos, jack_nframes_t time)
+void BeatTracker::countInEvent(const midi::ConnectionEvent &nextEvent, jack_position_t &pos, jack_nframes_t time)
 {
     if(countInCount) {
 
         // calculate beat periods: ideal, real and difference
-        jack_nframes_t realBeatPeriod = time + nextEvent->getFrameOffset() - lastCountTime[countInCount-1];
+        jack_nframes_t realBeatPeriod = time + nextEvent.frame - lastCountTime[countInCount-1];
         jack_nframes_t idealBeatPeriod = 60 * pos.frame_rate / pos.beats_per_minute; // one beat
         uint32_t beatDelta = 100 * realBeatPeriod / idealBeatPeriod;
 
         // check this event is within expect time for count-in
-        if(beatDelta >= 60 && beatDelta <= 140) { // TODO: optional parameter for window size
-            lastCountTime[countInCount] = time + nextEvent->getFrameOffset();
+        uint32_t tolerance = countInTolerance.load();
+        if(beatDelta >= 100 - tolerance && beatDelta <= 100 + tolerance) {
+            lastCountTime[countInCount] = time + nextEvent.frame;
             dispatchCountInEvent((int)(countInCount + 1));
 
             // is this the last count-in
@@ -104,13 +113,13 @@ void BeatTracker::countInEvent(midi::Event *nextEvent, jack_position_t &pos, jac
 
                 // set bpm and schedule start
                 double avgBpm = (double)pos.frame_rate * 60 / avgBeatPeriod;
-                btrack.setTempo(avgBpm);
+                analysis.setTempo(trackerTempo(avgBpm, hop));
                 master->setBpm(avgBpm);
-                countStartTime = time + nextEvent->getFrameOffset() + avgBeatPeriod;
+                countStartTime = time + nextEvent.frame + avgBeatPeriod;
             }
         }
     } else { // first count in
-        lastCountTime[0] = time + nextEvent->getFrameOffset();
+        lastCountTime[0] = time + nextEvent.frame;
         countInCount = 1;
         // set off handler
         dispatchCountInEvent(1);
@@ -140,14 +149,15 @@ void BeatTracker::detectCountIn(jack_position_t &pos, jack_nframes_t nframes, ja
     else {
         uint8_t note = countInNote.load();
         if(note && countInCount < 4) {
-            Event *nextEvent = eventCount ? connection->getEvent(0) : 0;
-            uint32_t eventIndex = 1;
-            while(nextEvent) {
-                // TODO: configurable velocity
-                if(nextEvent->matches(Event::TYPE_NOTE_ON, note, 72, 127)) {
+            uint8_t minVelocity = countInMinVelocity.load();
+            uint8_t maxVelocity = countInMaxVelocity.load();
+            for(uint32_t eventIndex = 0; eventIndex < eventCount; eventIndex++) {
+                const ConnectionEvent &nextEvent = connection->getEvent(eventIndex);
+                uint8_t velocity = nextEvent.getDatabyte2();
+                if(nextEvent.matches(Event::TYPE_NOTE_ON) && nextEvent.getDatabyte1() == note
+                        && velocity >= minVelocity && velocity <= maxVelocity) {
                     countInEvent(nextEvent, pos, time);
                 }
-                nextEvent = eventIndex < eventCount ? connection->getEvent(eventIndex++) : 0;
             }
         }
     }
@@ -200,38 +210,46 @@ void BeatTracker::doProcess(bool rolling, jack_position_t &pos, jack_nframes_t n
         detectCountIn(pos, nframes, time, eventCount, connection);
     }
 
-    // loop over frames
-    midi::Event *nextEvent = eventCount ? connection->getEvent(0) : 0;
-    uint32_t eventIndex = 1;
-    for(jack_nframes_t i = 0; i < nframes; i++) {
-
-        // add events at this frame to current onset
-        while(nextEvent && nextEvent->getFrameOffset() == i) {
-            if(nextEvent->matches(Event::TYPE_NOTE_ON)) {
-                currentOnset += nextEvent->getDatabyte2() * noteWeight[nextEvent->getDatabyte1()];
+    // loop over hops, adding the events that fall in each to its onset
+    uint32_t eventIndex = 0;
+    for(jack_nframes_t i = 0; i < nframes; ) {
+        jack_nframes_t end = std::min(nframes, i + hop - frameIndex);
+        while(eventIndex < eventCount && connection->getEvent(eventIndex).frame < end) {
+            const midi::ConnectionEvent &nextEvent = connection->getEvent(eventIndex++);
+            if(nextEvent.matches(Event::TYPE_NOTE_ON)) {
+                currentOnset += nextEvent.getDatabyte2() * noteWeight[nextEvent.getDatabyte1()];
                 lastEventTime = time;
             }
-            nextEvent = eventIndex < eventCount ? connection->getEvent(eventIndex++) : 0;
         }
-
-        // full buffer, run beat tracker
-        if(frameIndex == BT_HOP_SIZE) {
-            // process onset sample
-            btrack.processOnsetDetectionFunctionSample(currentOnset);
-            if(btrack.beatDueInCurrentFrame()) {
+        frameIndex += end - i;
+        i = end;
+
+        // full hop, run beat tracker
+        if(frameIndex == hop) {
+            // hand onset sample to the analysis thread
+            analysis.addSample(currentOnset);
+            double tempo;
+            if(analysis.beatDue(tempo)) {
                 // set bpm
-                double tempo = btrack.getCurrentTempoEstimate();
+                tempo = transportTempo(tempo);
                 master->forceBeat(tempo);
                 // fire event if handler
                 ScriptFunction *handler = onBeatHandler.load();
                 if(handler) {
                     (new OnBeatClosure(*handler, tempo))->dispatch();
                 }
+            } else if(analysis.tempoChanged(tempo)) {
+                master->setBpm(transportTempo(tempo));
             }
             frameIndex = 0;
             currentOnset = 0;
+            // pick up a new hop size between hops, restarting the tracker at the current tempo
+            uint32_t frames = hopSize.load();
+            if(frames != hop) {
+                hop = frames;
+                analysis.setTempo(trackerTempo(pos.beats_per_minute, hop));
+            }
         }
-        frameIndex++;
     }
 
     // stop on silence
@@ -246,6 +264,50 @@ void BeatTracker::dispatchCountInEvent(uint32_t count)
     }
 }
 
+/**
+ * Sets the velocities a count-in note must fall between to count.
+ *
+ * Runs in the script thread.
+ */
+void BeatTracker::countInVelocity(int minimum, int maximum)
+{
+    if(minimum < 1 || maximum > 127 || minimum > maximum) {
+        throw std::logic_error("count-in velocities must be between 1 and 127");
+    }
+    countInMinVelocity.store(minimum);
+    countInMaxVelocity.store(maximum);
+}
+
+/**
+ * Sets how far each count-in note can be off the current beat period, as a
+ * percentage of the period.
+ *
+ * Runs in the script thread.
+ */
+void BeatTracker::countInWindow(int percent)
+{
+    if(percent < 0 || percent > 99) {
+        throw std::logic_error("count-in window must be between 0 and 99 percent");
+    }
+    countInTolerance.store(percent);
+}
+
+/**
+ * Sets the number of frames of MIDI input summed into each onset sample.
+ * Smaller hops track faster tempos: the tracker follows 80 to 160 bpm at the
+ * default hop size and the range scales inversely with the hop size.
+ *
+ * Runs in the script thread.
+ */
+void BeatTracker::setHopSize(int frames)
+{
+    if(frames < (int)BT_MIN_HOP_SIZE || frames > (int)BT_MAX_HOP_SIZE) {
+        throw std::logic_error("hop size must be between " + std::to_string(BT_MIN_HOP_SIZE)
+                               + " and " + std::to_string(BT_MAX_HOP_SIZE) + " frames");
+    }
+    hopSize.store(frames);
+}
+
 void BeatTracker::setNoteWeight(uint32_t note, float weight)
 {
     if(note > 127) {
@@ -266,7 +328,12 @@ void BeatTracker::reset(double bpm, float beatsPerBar, float beatUnit)
 {
     // set bpm on btrack and transport master
     master = transport::MasterCache::instance().getTransportMaster(bpm, beatsPerBar, beatUnit);
-    btrack.setTempo(bpm);
+    analysis.setTempo(bpm);
+    hopSize.store(BT_HOP_SIZE);
+    // reset count-in settings
+    countInMinVelocity.store(72);
+    countInMaxVelocity.store(127);
+    countInTolerance.store(40);
     // reset note weights
     for(int i = 0; i < 128; i++) {
         noteWeight[i] = 1.0;
@@ -285,13 +352,15 @@ void BeatTracker::reset(double bpm, float beatsPerBar, float beatUnit)
  */
 BeatTracker *BeatTrackerCache::getMidiBeatTracker(float bpm, float beatsPerBar, float beatUnit)
 {
-    BeatTracker *tracker = findObject(1); // TODO: allow multiple
+    // instances are keyed by the order they are created in the script
+    int key = instanceCount++;
+    BeatTracker *tracker = findObject(key);
     if(tracker) {
         tracker->reset(bpm, beatsPerBar, beatUnit);
     } else {
         tracker = new BeatTracker(bpm, beatsPerBar, beatUnit);
-        registerObject(1, tracker);
-    }    
+        registerObject(key, tracker);
+    }
     return tracker;
 }
 
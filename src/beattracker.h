@@ -19,7 +19,7 @@
 
 #include <atomic>
 
-#include "BTrack.h"
+#include "beatanalysis.h"
 #include "transportmaster.h"
 #include "audioconnection.h"
 #include "midiconnection.h"
@@ -29,20 +29,24 @@
 namespace bipscript {
 
 const unsigned int BT_HOP_SIZE = 512;
+const unsigned int BT_MIN_HOP_SIZE = 128;
+const unsigned int BT_MAX_HOP_SIZE = 2048;
 
 namespace audio {
 
 class BeatTracker : public Processor
 {
-    BTrack btrack;
-    double *btbuffer;
+    OnsetDetectionFunction odf;
+    BeatAnalysis analysis;
+    float *btbuffer;
     unsigned int index;
     transport::Master *master;
     std::atomic<audio::AudioConnection *> audioInput;
 public:
     BeatTracker(double bpm, float beatsPerBar, float beatUnit)
-        : index(0), audioInput(0) {
-        btbuffer = new double[BT_HOP_SIZE];
+        : odf(BT_HOP_SIZE, 2 * BT_HOP_SIZE, ComplexSpectralDifferenceHWR, HanningWindow),
+          analysis(bpm), index(0), audioInput(0) {
+        btbuffer = new float[BT_HOP_SIZE];
         reset(bpm, beatsPerBar, beatUnit);
     }
     void connect(audio::Source &source) {
@@ -58,7 +62,12 @@ public:
 
 class BeatTrackerCache : public ProcessorCache<BeatTracker>
 {
+    int instanceCount;
+    void scriptReset() {
+        instanceCount = 0;
+    }
 public:
+    BeatTrackerCache() : instanceCount(0) {}
     static BeatTrackerCache &instance() {
         static BeatTrackerCache instance;
         return instance;
@@ -95,7 +104,9 @@ public:
 namespace midi {
 
 class BeatTracker : public Processor {
-    BTrack btrack;
+    BeatAnalysis analysis;
+    std::atomic<uint32_t> hopSize;
+    uint32_t hop; // local to process thread
     uint32_t frameIndex;
     double currentOnset;
     transport::Master *master;
@@ -104,6 +115,9 @@ class BeatTracker : public Processor {
     std::atomic<ScriptFunction*> onBeatHandler;
     // for count-in
     std::atomic<uint8_t> countInNote;
+    std::atomic<uint8_t> countInMinVelocity;
+    std::atomic<uint8_t> countInMaxVelocity;
+    std::atomic<uint32_t> countInTolerance;
     uint8_t countInCount;
     jack_nframes_t lastCountTime[4];
     jack_nframes_t countStartTime;
@@ -113,8 +127,8 @@ class BeatTracker : public Processor {
     jack_nframes_t lastEventTime;
 public:
     BeatTracker(double bpm, float beatsPerBar, float beatUnit)
-        : frameIndex(0), currentOnset(0), onBeatHandler(0), countInNote(0),
-          countInCount(0), onCountHandler(0), lastEventTime(0) {
+        : analysis(bpm), hopSize(BT_HOP_SIZE), hop(BT_HOP_SIZE), frameIndex(0), currentOnset(0),
+          onBeatHandler(0), countInNote(0), countInCount(0), onCountHandler(0), lastEventTime(0) {
         reset(bpm, beatsPerBar, beatUnit);
     }
     void connectMidi(midi::Source &source) {
@@ -122,6 +136,9 @@ public:
     }
     void setNoteWeight(uint32_t note, float weight);
     void countIn(uint8_t note) { countInNote.store(note); }
+    void countInVelocity(int minimum, int maximum);
+    void countInWindow(int percent);
+    void setHopSize(int frames);
     void onCount(ScriptFunction &handler);
     void onBeat(ScriptFunction &handler);
     void stopOnSilence(uint32_t seconds) { stopSeconds.store(seconds); }
@@ -129,14 +146,25 @@ public:
     void doProcess(bool rolling, jack_position_t &pos, jack_nframes_t nframes, jack_nframes_t time);
     void reposition() {}
 private:
+    /**
+     * BTrack counts time in hops, tempos are scaled between the transport
+     * and the tracker when the hop size differs from the default.
+     */
+    double trackerTempo(double bpm, uint32_t frames) { return bpm * frames / BT_HOP_SIZE; }
+    double transportTempo(double tempo) { return tempo * BT_HOP_SIZE / hop; }
     void dispatchCountInEvent(uint32_t count);
     void detectCountIn(jack_position_t &pos, jack_nframes_t nframes, jack_nframes_t time, uint32_t eventCount, midi::MidiConnection *connection);
-    void countInEvent(midi::Event *nextEvent, jack_position_t &pos, jack_nframes_t time);
+    void countInEvent(const midi::ConnectionEvent &nextEvent, jack_position_t &pos, jack_nframes_t time);
     void stopIfSilent(bool rolling, jack_position_t &pos, jack_nframes_t time);
 };
 
 class BeatTrackerCache : public ProcessorCache<BeatTracker> {
+    int instanceCount;
+    void scriptReset() {
+        instanceCount = 0;
+    }
 public:
+    BeatTrackerCache() : instanceCount(0) {}
     static BeatTrackerCache &instance() {
         static BeatTrackerCache instance;
         return instance;
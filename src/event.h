@@ -32,6 +32,10 @@ class Event : public Position, public Listable
 public:
     Event(Position &pos) : Position(pos) {} // refCount++; refSet.insert(this); }
     Event(const Event &other) : Position(other) {}
+    Event &operator=(const Event &other) {
+        Position::operator=(other);
+        return *this;
+    }
     Event(unsigned int bar, unsigned int position, unsigned int division) :
         Position(bar, position, division) {} // refCount++; refSet.insert(this); }
     long getFrameOffset() const {
@@ -35,7 +35,7 @@ public:
     EventBuffer() : eventQueue(2048) {}
     void addEvent(T* evt);
     void update();
-    T *getNextEvent(bool rolling, jack_position_t &pos, jack_nframes_t nframes);
+    T *getNextEvent(bool rolling, jack_position_t &pos, jack_nframes_t nframes, jack_nframes_t grace = 0);
     void recycleRemaining();
 };
 
@@ -57,9 +57,9 @@ void EventBuffer<T>::update()
     }
 }
 
-// process thread
+// process thread, events up to grace frames later than usual are still returned
 template <class T>
-T *EventBuffer<T>::getNextEvent(bool rolling, jack_position_t &pos, jack_nframes_t nframes)
+T *EventBuffer<T>::getNextEvent(bool rolling, jack_position_t &pos, jack_nframes_t nframes, jack_nframes_t grace)
 {
     update();
     T *first = sortedEvents.getFirst();
@@ -70,7 +70,7 @@ T *EventBuffer<T>::getNextEvent(bool rolling, jack_position_t &pos, jack_nframes
     }
     if(rolling) {
         // drop events that have already passed
-        while(first && first->updateFrameOffset(pos) < -256) { // TODO: grace period depends on framerate
+        while(first && first->updateFrameOffset(pos) < -256 - (long)grace) { // TODO: grace period depends on framerate
             T *late = first; // grab reference, cannot delete before pop()
             first = sortedEvents.pop();
             ObjectCollector::scriptCollector().recycle(late);
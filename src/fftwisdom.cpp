@@ -0,0 +1,76 @@
+/*
+ * This file is part of Bipscript.
+ *
+ * Bipscript is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Bipscript is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Bipscript.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "fftwisdom.h"
+
+#include <cstdlib>
+#include <boost/filesystem.hpp>
+
+#ifdef USE_FFTW
+#include "fftw3.h"
+#endif
+
+namespace fs = boost::filesystem;
+
+namespace bipscript {
+namespace audio {
+
+/**
+ * Wisdom lives in the user cache directory.
+ */
+FftWisdom::FftWisdom()
+{
+    const char *cacheHome = std::getenv("XDG_CACHE_HOME");
+    const char *home = std::getenv("HOME");
+    if(cacheHome && *cacheHome) {
+        path = std::string(cacheHome) + "/bipscript/fftw-wisdom";
+    } else if(home && *home) {
+        path = std::string(home) + "/.cache/bipscript/fftw-wisdom";
+    }
+}
+
+/**
+ * Runs in the main thread before the script.
+ */
+void FftWisdom::load()
+{
+#ifdef USE_FFTW
+    if(path.size()) {
+        // no wisdom on the first run
+        fftwf_import_wisdom_from_filename(path.c_str());
+    }
+#endif
+}
+
+/**
+ * Runs in the main thread after the script.
+ */
+void FftWisdom::save()
+{
+#ifdef USE_FFTW
+    if(path.empty()) {
+        return;
+    }
+    boost::system::error_code error;
+    fs::create_directories(fs::path(path).parent_path(), error);
+    if(!error) {
+        fftwf_export_wisdom_to_filename(path.c_str());
+    }
+#endif
+}
+
+}}
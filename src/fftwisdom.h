@@ -0,0 +1,50 @@
+/*
+ * This file is part of Bipscript.
+ *
+ * Bipscript is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Bipscript is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Bipscript.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef FFTWISDOM_H
+#define FFTWISDOM_H
+
+#include <string>
+
+namespace bipscript {
+namespace audio {
+
+/**
+ * Keeps the FFTW planner wisdom on disk.
+ *
+ * The analysis FFT plans are measured rather than estimated, which takes a
+ * while the first time a size is planned; with the wisdom loaded at startup
+ * later runs get the same plans without measuring again.
+ *
+ * FFTW planning is not thread safe: load and save only while no plans are
+ * being made, i.e. before and after the script runs.
+ */
+class FftWisdom
+{
+    std::string path;
+    FftWisdom();
+public:
+    static FftWisdom &instance() {
+        static FftWisdom instance;
+        return instance;
+    }
+    void load();
+    void save();
+};
+
+}}
+
+#endif // FFTWISDOM_H
@@ -0,0 +1,66 @@
+/*
+ * This file is part of Bipscript.
+ *
+ * Bipscript is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Bipscript is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Bipscript.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LOCKEDBUFFER_H
+#define LOCKEDBUFFER_H
+
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <sys/mman.h>
+
+namespace bipscript {
+
+/**
+ * A fixed-size scratch buffer for the process thread. It is page aligned,
+ * locked into memory and pre-faulted when created so the process thread
+ * never takes a page fault on first touch.
+ *
+ * Created and destroyed in the script thread.
+ */
+template <class T> class LockedBuffer
+{
+    static const size_t ALIGNMENT = 4096;
+    T *elements;
+    size_t size;
+    LockedBuffer(const LockedBuffer&);
+    void operator=(const LockedBuffer&);
+public:
+    LockedBuffer(size_t count) : size(sizeof(T) * count) {
+        void *block;
+        if(posix_memalign(&block, ALIGNMENT, size)) {
+            throw std::bad_alloc();
+        }
+        // best effort: fails without sufficient RLIMIT_MEMLOCK
+        mlock(block, size);
+        std::memset(block, 0, size);
+        elements = static_cast<T*>(block);
+    }
+    ~LockedBuffer() {
+        munlock(elements, size);
+        free(elements);
+    }
+    T &operator[](size_t index) {
+        return elements[index];
+    }
+    T *data() {
+        return elements;
+    }
+};
+
+}
+
+#endif // LOCKEDBUFFER_H
@@ -15,6 +15,7 @@
  * along with Bipscript.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <cstring>
 #include <iostream>
 #include <boost/filesystem.hpp>
 
@@ -24,6 +25,7 @@
 
 #include "lv2/lv2plug.in/ns/ext/presets/presets.h"
 #include "lv2/lv2plug.in/ns/ext/buf-size/buf-size.h"
+#include "lv2/lv2plug.in/ns/ext/patch/patch.h"
 
 namespace fs = boost::filesystem;
 
@@ -68,29 +70,150 @@ static LV2_Worker_Status workerRespond(LV2_Worker_Respond_Handle handle, uint32_
     return ((Worker*)handle)->queueResponse(data, size);
 }
 
+UridMapper::Table::Table(uint32_t capacity) : mask(capacity - 1)
+{
+    hashes = new std::size_t[capacity];
+    ids = new std::atomic<LV2_URID>[capacity];
+    for(uint32_t i = 0; i < capacity; i++) {
+        ids[i].store(0);
+    }
+}
+
+UridMapper::Table::~Table()
+{
+    delete[] hashes;
+    delete[] ids;
+}
+
+/**
+ * Called with the mapper lock held, the id is published last.
+ */
+void UridMapper::Table::insert(std::size_t hash, LV2_URID id)
+{
+    uint32_t slot = hash & mask;
+    while(ids[slot].load(std::memory_order_relaxed)) {
+        slot = (slot + 1) & mask;
+    }
+    hashes[slot] = hash;
+    ids[slot].store(id, std::memory_order_release);
+}
+
+UridMapper::UridMapper() : table(new Table(1024)), lastId(0)
+{
+    for(uint32_t i = 0; i < MAX_CHUNKS; i++) {
+        uriChunks[i].store(0);
+    }
+    // seed the URIs nearly every plugin maps at instantiation
+    const char *common[] = {
+        LV2_ATOM__Blank, LV2_ATOM__Bool, LV2_ATOM__Chunk, LV2_ATOM__Double,
+        LV2_ATOM__Float, LV2_ATOM__Int, LV2_ATOM__Long, LV2_ATOM__Object,
+        LV2_ATOM__Path, LV2_ATOM__Sequence, LV2_ATOM__String, LV2_ATOM__URID,
+        LV2_ATOM__frameTime, LILV_URI_MIDI_EVENT,
+        LV2_PATCH__Get, LV2_PATCH__Set, LV2_PATCH__property, LV2_PATCH__subject, LV2_PATCH__value,
+        LV2_BUF_SIZE__maxBlockLength, LV2_BUF_SIZE__minBlockLength,
+        LV2_BUF_SIZE__nominalBlockLength, LV2_BUF_SIZE__sequenceSize
+    };
+    for(const char *uri : common) {
+        uriToId(uri);
+    }
+}
+
+UridMapper::~UridMapper()
+{
+    for(uint32_t i = 0; i < MAX_CHUNKS; i++) {
+        const char **chunk = uriChunks[i].load();
+        if(chunk) {
+            for(uint32_t j = 0; j < CHUNK_SIZE; j++) {
+                free((void*)chunk[j]);
+            }
+            delete[] chunk;
+        }
+    }
+    delete table.load();
+    for(Table *retired : retiredTables) {
+        delete retired;
+    }
+}
+
+std::size_t UridMapper::hashUri(const char *uri)
+{
+    // FNV-1a
+    std::size_t hash = 2166136261u;
+    while(*uri) {
+        hash = (hash ^ (unsigned char)*uri++) * 16777619u;
+    }
+    return hash;
+}
+
+/**
+ * Lock-free lookup in the given table, zero if not present.
+ */
+LV2_URID UridMapper::find(Table *table, std::size_t hash, const char *uri)
+{
+    uint32_t slot = hash & table->mask;
+    LV2_URID id;
+    while((id = table->ids[slot].load(std::memory_order_acquire))) {
+        if(table->hashes[slot] == hash && !strcmp(idToUri(id), uri)) {
+            return id;
+        }
+        slot = (slot + 1) & table->mask;
+    }
+    return 0;
+}
+
+/**
+ * Runs in any thread, locks only when mapping a new URI.
+ */
 LV2_URID UridMapper::uriToId(const char *uri) {
-    const std::string uriString(uri);
-    const Lv2UridMap::const_iterator iter = uridMap.find(uriString);
-    if(iter == uridMap.end()) {
-        const uint32_t newId = uridMap.size() + 10;
-        uridMap.insert(std::make_pair(uriString, newId));
-        //std::cout << "uridMap storing for " << uri << ": " << newId << std::endl;
-        return newId;
+    std::size_t hash = hashUri(uri);
+    LV2_URID id = find(table.load(std::memory_order_acquire), hash, uri);
+    if(id) {
+        return id;
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    Table *current = table.load();
+    // another thread may have mapped it meanwhile
+    id = find(current, hash, uri);
+    if(id) {
+        return id;
+    }
+    if(lastId + 1 == CHUNK_SIZE * MAX_CHUNKS) {
+        std::cerr << "!!! uridMap is full, cannot map " << uri << std::endl;
+        return 0;
+    }
+    id = ++lastId;
+    // store uri text
+    const char **chunk = uriChunks[id / CHUNK_SIZE].load();
+    if(!chunk) {
+        chunk = new const char *[CHUNK_SIZE]();
+        uriChunks[id / CHUNK_SIZE].store(chunk);
     }
-    //std::cout << "uridMap returning for " << uri << ": " << iter->second << std::endl;
-    return iter->second;
+    chunk[id % CHUNK_SIZE] = strdup(uri);
+    // grow at half load, readers may still hold the old table
+    if(id * 2 > current->mask + 1) {
+        Table *larger = new Table((current->mask + 1) * 2);
+        for(LV2_URID i = 1; i < id; i++) {
+            larger->insert(hashUri(idToUri(i)), i);
+        }
+        table.store(larger);
+        retiredTables.push_back(current);
+        current = larger;
+    }
+    current->insert(hash, id);
+    return id;
 }
 
+/**
+ * Runs in any thread. No locks.
+ */
 const char *UridMapper::idToUri(LV2_URID urid) {
-    Lv2UridMap::iterator iter;
-    for(iter = uridMap.begin(); iter != uridMap.end(); iter++) {
-        if(iter->second == urid) {
-            //std::cout << "uridUnMap returning for " << urid << ": " << iter->first << std::endl;
-            return iter->first.c_str();
-        }
+    const char **chunk = urid && urid < CHUNK_SIZE * MAX_CHUNKS ?
+                uriChunks[urid / CHUNK_SIZE].load(std::memory_order_acquire) : 0;
+    if(!chunk || !chunk[urid % CHUNK_SIZE]) {
+        std::cerr << "!!! uridUnMap failed to find uri for " << urid << std::endl;
+        return NULL;
     }
-    std::cerr << "!!! uridUnMap failed to find uri for " << urid << std::endl;
-    return NULL;
+    return chunk[urid % CHUNK_SIZE];
 }
 
 
@@ -129,10 +252,32 @@ Constants::Constants(LilvWorld *world) {
     lv2WorkerSchedule = lilv_new_uri(world, LV2_WORKER__schedule);
     lv2WorkerInterface = lilv_new_uri(world, LV2_WORKER__interface);
     lv2RdfsLabel = lilv_new_uri(world, LILV_NS_RDFS "label");
+    lv2PatchReadable = lilv_new_uri(world, LV2_PATCH__readable);
 }
 
 // ----------------------------- Lv2MidiInput
 
+/**
+ * Reserve space for a MIDI message of the given size at the end of a sequence.
+ *
+ * Returns the message body to fill in, or zero if the sequence is full.
+ *
+ * Runs in the process thread. No allocations.
+ */
+static uint8_t *reserveMidiEvent(LV2_Atom_Sequence *sequence, uint32_t capacity, int64_t frames, uint32_t size)
+{
+    uint32_t totalSize = sizeof(LV2_Atom_Event) + size;
+    if(capacity - sequence->atom.size < totalSize) {
+        return 0;
+    }
+    LV2_Atom_Event *event = lv2_atom_sequence_end(&sequence->body, sequence->atom.size);
+    event->time.frames = frames;
+    event->body.type = MidiEvent::midiEventTypeId;
+    event->body.size = size;
+    sequence->atom.size += lv2_atom_pad_size(totalSize);
+    return reinterpret_cast<uint8_t*>(event + 1);
+}
+
 /**
  * process this MIDI input: pack LV2 input buffer from EventBuffer + EventConnection
  */
@@ -140,18 +285,16 @@ void MidiInput::process(bool rolling, jack_position_t &pos, jack_nframes_t nfram
     // clear atom sequence
     lv2_atom_sequence_clear(atomSequence);
 
-    // send all notes off messages if newly stopped
-    if(localRolling && !rolling) {
-        MidiEvent lv2Event;
-        lv2Event.event.time.frames = 0;
-        lv2Event.buffer[1] = 0x7b; // CC 123 = all notes off
-        lv2Event.buffer[2] = 0;
-        for(uint8_t channel = 0; channel < 16; channel++) {
-            lv2Event.buffer[0] = midi::Event::TYPE_CONTROL + channel;
-            lv2_atom_sequence_append_event(atomSequence, CAPACITY, &lv2Event.event);
+    // release sounding notes on stop or reposition
+    if(activeNotes.releaseDue(rolling)) {
+        uint8_t release[3];
+        while(activeNotes.nextRelease(release)) {
+            uint8_t *body = reserveMidiEvent(atomSequence, CAPACITY, 0, 3);
+            if(body) {
+                std::memcpy(body, release, 3);
+            }
         }
     }
-    localRolling = rolling;
 
     // get connection and event count
     midi::MidiConnection *connection = eventConnector.getConnection();
@@ -163,83 +306,200 @@ void MidiInput::process(bool rolling, jack_position_t &pos, jack_nframes_t nfram
 
     // get top events from buffer + connection
     midi::Event* bufferEvent = eventBuffer.getNextEvent(rolling, pos, nframes);
-    midi::Event *connectionEvent = eventCount ? connection->getEvent(0) : 0;
-    uint32_t eventIndex = 1;
+    uint32_t eventIndex = 0;
 
     // loop while events on either buffer or connection
-    while(bufferEvent || connectionEvent) {
-        bool bufferNext = bufferEvent &&
-                (!connectionEvent || bufferEvent->getFrameOffset() < connectionEvent->getFrameOffset());
-        midi::Event *event = bufferNext ? bufferEvent : connectionEvent;
-        // lv2 event
-        MidiEvent lv2Event;
-        long frame = event->getFrameOffset();
-        lv2Event.event.time.frames = frame >= 0 ? frame : 0;
-        // copy event data
-        event->pack(&lv2Event.buffer);
-        // append this event to sequence
-        lv2_atom_sequence_append_event(atomSequence, CAPACITY, &lv2Event.event);
-        // get next event
+    while(bufferEvent || eventIndex < eventCount) {
+        bool bufferNext = bufferEvent && (eventIndex == eventCount
+                || bufferEvent->getFrameOffset() < (long)connection->getEvent(eventIndex).frame);
         if(bufferNext) {
+            long frame = bufferEvent->getFrameOffset();
+            uint8_t *body = reserveMidiEvent(atomSequence, CAPACITY, frame >= 0 ? frame : 0,
+                                             bufferEvent->messageSize());
+            if(body) {
+                bufferEvent->pack(body);
+                activeNotes.update(body, bufferEvent->messageSize());
+            }
             // recycle and get next buffer event
-            ObjectCollector::scriptCollector().recycle(bufferEvent);
+            eventBuffer.recycle(bufferEvent);
             bufferEvent = eventBuffer.getNextEvent(rolling, pos, nframes);
         } else {
-            connectionEvent = eventIndex < eventCount ? connection->getEvent(eventIndex++) : 0;
+            const midi::ConnectionEvent &connectionEvent = connection->getEvent(eventIndex++);
+            uint8_t *body = reserveMidiEvent(atomSequence, CAPACITY, connectionEvent.frame, connectionEvent.size);
+            if(body) {
+                std::memcpy(body, connectionEvent.data, connectionEvent.size);
+                activeNotes.update(body, connectionEvent.size);
+            }
         }
     }
 }
 
-// ----------------------------- Lv2MidiOutput
-
-uint32_t MidiOutput::getEventCount()
+/**
+ * Copy the events of this period falling in [start, end) to the block
+ * sequence with times relative to the block start, for split runs.
+ *
+ * Runs in the process thread. No allocations.
+ */
+LV2_Atom_Sequence *MidiInput::getBlockSequence(jack_nframes_t start, jack_nframes_t end)
 {
-    uint32_t counter = 0;
+    lv2_atom_sequence_clear(blockSequence);
+    blockSequence->atom.type = atomSequence->atom.type;
     LV2_ATOM_SEQUENCE_FOREACH(atomSequence, ev) {
-        if (ev->body.type == MidiEvent::midiEventTypeId) {
-            counter++;
+        if(ev->time.frames >= end) {
+            break;
+        }
+        if(ev->time.frames >= start) {
+            LV2_Atom_Event *copy = lv2_atom_sequence_append_event(blockSequence, CAPACITY, ev);
+            if(copy) {
+                copy->time.frames -= start;
+            }
         }
     }
-    return counter;
+    return blockSequence;
 }
 
-midi::Event *MidiOutput::getEvent(uint32_t i)
+// ----------------------------- Lv2MidiOutput
+
+/**
+ * Append the events written during a split run to the period sequence,
+ * offset by the block start.
+ *
+ * Runs in the process thread. No allocations.
+ */
+void MidiOutput::appendBlock(jack_nframes_t start)
 {
-    // TODO: direct access?
-    uint32_t counter = 0;
+    if(!start) {
+        lv2_atom_sequence_clear(atomSequence);
+        atomSequence->atom.type = blockSequence->atom.type;
+    }
+    LV2_ATOM_SEQUENCE_FOREACH(blockSequence, ev) {
+        ev->time.frames += start;
+        lv2_atom_sequence_append_event(atomSequence, CAPACITY, ev);
+    }
+}
+
+/**
+ * Decode the MIDI events the plugin wrote in this period.
+ *
+ * Runs in the process thread. No allocations.
+ */
+void MidiOutput::decode()
+{
+    events.clear();
     LV2_ATOM_SEQUENCE_FOREACH(atomSequence, ev) {
         if (ev->body.type == MidiEvent::midiEventTypeId) {
-            if(counter == i) {
-                event.unpack((const uint8_t*)(ev + 1), ev->body.size);
-                event.setFrameOffset(ev->time.frames);
-                return &event;
-            }
-            counter++;
+            events.add(ev->time.frames, (const uint8_t*)(ev + 1), ev->body.size);
         }
     }
-    return 0;
 }
 
-void ControlConnection::process(bool rolling, jack_position_t &pos, jack_nframes_t nframes, jack_nframes_t time)
+/**
+ * Insert a control change keeping the list sorted by frame, changes at the
+ * same frame keep their order.
+ *
+ * Runs in the process thread. No allocations.
+ */
+void ControlChangeList::add(jack_nframes_t frame, ControlPort *port, float value)
+{
+    if(count == CAPACITY) {
+        // overflow: apply immediately
+        port->value = value;
+        return;
+    }
+    uint32_t i = count++;
+    while(i && changes[i - 1].frame > frame) {
+        changes[i] = changes[i - 1];
+        i--;
+    }
+    changes[i].frame = frame;
+    changes[i].port = port;
+    changes[i].value = value;
+}
+
+/**
+ * Collect mapped control changes from the connection for this period.
+ *
+ * Runs in the process thread. No allocations.
+ */
+void ControlConnection::process(bool rolling, jack_position_t &pos, jack_nframes_t nframes, jack_nframes_t time,
+                                ControlChangeList &changes)
 {
     connection->getSource()->process(rolling, pos, nframes, time);
-    u_int32_t eventIndex = 0;
     u_int32_t eventCount = connection->getEventCount();
-    while(eventIndex < eventCount) {
-        midi::Event *nextEvent = connection->getEvent(eventIndex);
-        if(nextEvent->matches(midi::Event::TYPE_CONTROL)) {
+    for(u_int32_t eventIndex = 0; eventIndex < eventCount; eventIndex++) {
+        const midi::ConnectionEvent &nextEvent = connection->getEvent(eventIndex);
+        if(nextEvent.matches(midi::Event::TYPE_CONTROL)) {
             // check mappings
             ControlMapping *mapping = mappings.getFirst();
             while(mapping) {
-                mapping->update(nextEvent->getDatabyte1(), nextEvent->getDatabyte2());
+                mapping->update(nextEvent.getDatabyte1(), nextEvent.getDatabyte2(),
+                                nextEvent.frame, changes);
                 mapping = mappings.getNext(mapping);
             }
         }
-        // pull up next event
-        nextEvent = eventIndex < eventCount ? connection->getEvent(eventIndex++) : 0;
     }
 }
 
+// ----------------------------- ControlOutput
+
+/**
+ * Runs in the script thread.
+ */
+void ControlOutput::onChange(ScriptFunction &handler)
+{
+    if(handler.getNumargs() != 2) {
+        throw std::logic_error("onOutput handler should take one argument");
+    }
+    retire(this->handler.exchange(new OutputHandler(handler)));
+}
+
+/**
+ * Deletes a replaced handler once the process thread is out of update(), it
+ * only reads the handler there and new updates already see its replacement.
+ *
+ * Runs in the script thread.
+ */
+void ControlOutput::retire(OutputHandler *previous)
+{
+    if(!previous) {
+        return;
+    }
+    while(updating.load()) {
+        struct timespec req = {0, 100000};
+        nanosleep(&req, 0);
+    }
+    delete previous;
+}
+
+/**
+ * Publish the value for this period and dispatch the handler if the value
+ * changed and no call is already pending.
+ *
+ * Runs in the process thread. Allocates closure from the process pool.
+ */
+void ControlOutput::update()
+{
+    if(value == snapshot.load(std::memory_order_relaxed)) {
+        return;
+    }
+    snapshot.store(value);
+    updating.store(true);
+    OutputHandler *function = handler.load();
+    if(function && !pending.exchange(true)) {
+        (new ControlOutputClosure(*function, this))->dispatch();
+    }
+    updating.store(false);
+}
+
+/**
+ * Runs in the script thread.
+ */
+void ControlOutput::reset()
+{
+    retire(handler.exchange(0));
+    pending.store(false);
+}
+
 void ControlConnection::reset()
 {
     // recycle mappings
@@ -254,14 +514,16 @@ void ControlConnection::reset()
 // ----------------------------- Lv2Plugin
 
 Plugin::Plugin(const LilvPlugin *plugin, LilvInstance *instance,
-                     const Constants &uris, Worker *worker) :
-    plugin(plugin), instance(instance), midiOutputCount(0),
-    controlConnections(4), newControlMappingsQueue(16), worker(worker)
+                     const Constants &uris, Worker *worker, uint32_t patchOutputCount) :
+    plugin(plugin), instance(instance), midiOutputCount(0), splitMinimum(0),
+    controlOutputs(lilv_plugin_get_num_ports(plugin) + patchOutputCount + 16), worker(worker),
+    restoring(false), running(false), appliedState(0), controlConnections(4), newControlMappingsQueue(16)
 {
     // audio inputs
     audioInputCount = lilv_plugin_get_num_ports_of_class(plugin, uris.lv2AudioPort, uris.lv2InputPort, 0);
     audioInputIndex = new uint32_t[audioInputCount];
     audioInput = new audio::AudioConnector[audioInputCount];
+    audioInputBuffer = new float*[audioInputCount];
 
     // audio outputs
     audioOutputCount = lilv_plugin_get_num_ports_of_class(plugin, uris.lv2AudioPort, uris.lv2OutputPort, 0);
@@ -301,6 +563,15 @@ Plugin::Plugin(const LilvPlugin *plugin, LilvInstance *instance,
             lilv_instance_connect_port(instance, i, &(newPort->value));
             controlMap[portName] = newPort;
 
+        } else if(lilv_port_is_a(plugin, port, uris.lv2ControlPort)
+                  && lilv_port_is_a(plugin, port, uris.lv2OutputPort)) {
+            // create, connect and hash new control output
+            const LilvNode* symbol = lilv_port_get_symbol(plugin, port);
+            ControlOutput *output = new ControlOutput(0);
+            lilv_instance_connect_port(instance, i, &(output->value));
+            outputMap[lilv_node_as_string(symbol)] = output;
+            controlOutputs.add(output);
+
         } else if(lilv_port_is_a(plugin, port, uris.lv2AtomPort)) {
             // is it a MIDI/atom input?
             LilvNodes *atomBufferType = lilv_port_get_value(plugin, port, uris.lv2AtomBufferType);
@@ -309,13 +580,13 @@ Plugin::Plugin(const LilvPlugin *plugin, LilvInstance *instance,
                     lilv_nodes_contains(atomBufferType, uris.lv2AtomSequence)
                     && lilv_nodes_contains(atomSupports, uris.lv2MidiEvent)) {
                 // create new inputs and connect to atom sequence location
-                MidiInput *newAtomPort = new MidiInput();
+                MidiInput *newAtomPort = new MidiInput(i, timing);
                 lilv_instance_connect_port(instance, i, newAtomPort->getAtomSequence());
                 midiInputList.add(newAtomPort);
             }
             else if (lilv_port_is_a(plugin, port, uris.lv2OutputPort)) {
                 //atomSequence->atom.type = Lv2PluginFactory::instance()->uridMapper.uriToId(LV2_ATOM__Sequence);
-                MidiOutput *midiOutput = new MidiOutput(this);
+                MidiOutput *midiOutput = new MidiOutput(this, i);
                 lilv_instance_connect_port(instance, i, midiOutput->getAtomSequence());
                 midiOutputList.add(midiOutput);
                 midiOutputCount++;
@@ -336,6 +607,10 @@ Plugin::Plugin(const LilvPlugin *plugin, LilvInstance *instance,
 Plugin::~Plugin()
 {
     lilv_instance_free(instance);
+    for(uint32_t i = 0; i < audioOutputCount; i++) {
+        delete audioOutput[i];
+    }
+    delete[] audioOutput;
 }
 
 void Plugin::connect(audio::Source &source)
@@ -382,12 +657,12 @@ void Plugin::connectMidi(midi::Source &source)
     }
 }
 
-State::State(const char *filename)
+State::State(const char *filename) : hash(0)
 {
     throw std::logic_error("LV2 State from file not yet implemented"); // TODO implement
 }
 
-State::State(ScriptHashIterator &stateHash)
+State::State(ScriptHashIterator &stateHash) : hash(0)
 {
     UridMapper &uridMapper = PluginCache::instance().uridMapper;
     while(stateHash.hasNext()) {
@@ -398,6 +673,11 @@ State::State(ScriptHashIterator &stateHash)
         uint32_t key = uridMapper.uriToId(pair.key.stringValue);
         stateMap[key] = pair.value.stringValue;
     }
+    // content hash, identical states hash the same regardless of table order
+    for(auto const &entry : stateMap) {
+        hash ^= std::hash<uint32_t>()(entry.first) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+        hash ^= std::hash<std::string>()(entry.second) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+    }
 }
 
 const void *State::retrieveState(uint32_t key, size_t *size, uint32_t *type, uint32_t *flags)
@@ -413,15 +693,43 @@ const void *State::retrieveState(uint32_t key, size_t *size, uint32_t *type, uin
     }
 }
 
-const int State::getHash()
+void *run_state_restorer(void *arg)
 {
-    int hash = 0;
-    for(auto const &entry : stateMap) {
-        hash = hash ^ (entry.first << 1);
-        int valueHash = std::hash<std::string>()(entry.second);
-        hash = hash ^ (valueHash << 1);
+    ((StateRestorer*)arg)->run();
+    return 0;
+}
+
+/**
+ * Queue a state to be applied to a plugin instance.
+ *
+ * Runs in the script thread.
+ */
+void StateRestorer::schedule(Plugin *plugin, State *state)
+{
+    if(!started) {
+        sem_init(&semaphore, 0, 0);
+        if(pthread_create(&thread, NULL, run_state_restorer, this)) {
+            throw std::runtime_error("could not create LV2 state thread");
+        }
+        started = true;
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    jobs.push_back(std::make_pair(plugin, state));
+    sem_post(&semaphore);
+}
+
+void StateRestorer::run()
+{
+    while (true) {
+        sem_wait(&semaphore);
+        std::pair<Plugin*, State*> job;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            job = jobs.front();
+            jobs.pop_front();
+        }
+        job.first->restoreState(job.second, PluginCache::instance().getFeatures());
     }
-    return hash;
 }
 
 void *run_worker(void *arg)
@@ -585,6 +893,73 @@ void Plugin::addController(midi::Source &source, unsigned int cc, const char *sy
     addController(source, cc, symbol, port->minimum, port->maximum);
 }
 
+/**
+ * Split each period at control change boundaries so scheduled and mapped
+ * control values take effect at their frame; changes closer than the minimum
+ * block size to the start of a block are applied with that block.
+ * Zero disables splitting.
+ *
+ * Runs in the script thread.
+ */
+void Plugin::setSplitBlocks(int minimum) {
+    if(minimum < 0) {
+        throw std::logic_error("Minimum block size cannot be negative");
+    }
+    splitMinimum.store(minimum);
+}
+
+/**
+ * Track a property reported by the plugin with patch:Set on its atom outputs.
+ *
+ * Runs in the script thread.
+ */
+void Plugin::addPatchOutput(const char *uri)
+{
+    if(outputMap.find(uri) != outputMap.end()) {
+        return;
+    }
+    ControlOutput *output = new ControlOutput(PluginCache::instance().uridMapper.uriToId(uri));
+    outputMap[uri] = output;
+    controlOutputs.add(output);
+}
+
+/**
+ * Looks up an output by control port symbol or patch property URI; unknown
+ * URIs are tracked from now on.
+ *
+ * Runs in the script thread.
+ */
+ControlOutput *Plugin::findOutput(const char *name)
+{
+    std::map<std::string, ControlOutput *>::iterator iter = outputMap.find(name);
+    if(iter != outputMap.end()) {
+        return iter->second;
+    }
+    if(!strchr(name, ':')) {
+        throw std::logic_error(std::string("Plugin has no such output: ") + name);
+    }
+    addPatchOutput(name);
+    return outputMap[name];
+}
+
+/**
+ * Latest value of a control output port or patch property.
+ *
+ * Runs in the script thread.
+ */
+float Plugin::getOutput(const char *name)
+{
+    return findOutput(name)->getValue();
+}
+
+/**
+ * Runs in the script thread.
+ */
+void Plugin::onOutput(const char *name, ScriptFunction &handler)
+{
+    findOutput(name)->onChange(handler);
+}
+
 /**
  * Restore clean state on a cached plugin before reuse
  *
@@ -593,9 +968,40 @@ void Plugin::addController(midi::Source &source, unsigned int cc, const char *sy
 void Plugin::restore()
 {
     controlConnectionMap.clear();
+    splitMinimum.store(0);
+    resetTiming();
+    for(auto const &entry : outputMap) {
+        entry.second->reset();
+    }
 	// TODO: reset control values
 }
 
+/**
+ * Apply a state to this instance via the LV2 state interface.
+ *
+ * Runs in the state restorer thread, the process thread skips the plugin
+ * (outputs silence) until the restore is complete.
+ */
+void Plugin::restoreState(State *state, const LV2_Feature *const *features)
+{
+    LV2_State_Interface* iState = (LV2_State_Interface*)lilv_instance_get_extension_data(instance, LV2_STATE__interface);
+    if(!iState) {
+        return;
+    }
+    // keep the process thread out of the instance
+    restoring.store(true);
+    while(running.load()) {
+        struct timespec req = {0, 100000};
+        nanosleep(&req, 0);
+    }
+    LV2_State_Status status = iState->restore(instance->lv2_handle, &stateRetrieve,
+                                              (LV2_State_Handle)state, 0, features);
+    restoring.store(false);
+    if(status != LV2_STATE_SUCCESS) {
+        std::cerr << "warning: plugin setting state failed with code " << status << std::endl;
+    }
+}
+
 void Plugin::addMidiEvent(midi::Event *evt) {
     // for now just add to first midi port
     MidiInput *midiInput = midiInputList.getFirst();
@@ -604,6 +1010,16 @@ void Plugin::addMidiEvent(midi::Event *evt) {
     }
 }
 
+void Plugin::addPatternBlock(midi::PatternBlock *block) {
+    // for now just add to first midi port
+    MidiInput *midiInput = midiInputList.getFirst();
+    if(midiInput) {
+        midiInput->addBlock(block);
+    } else {
+        delete block;
+    }
+}
+
 bool Plugin::connectsTo(AbstractSource *source) {
     // event inputs
     MidiInput *midiInput = midiInputList.getFirst();
@@ -635,6 +1051,21 @@ midi::MidiConnection *Plugin::getMidiConnection(unsigned int index) {
 
 void Plugin::doProcess(bool rolling, jack_position_t &pos, jack_nframes_t nframes, jack_nframes_t time) {
 
+    // output silence while state is restored
+    running.store(true);
+    if(restoring.load()) {
+        running.store(false);
+        for(uint32_t i = 0; i < audioOutputCount; i++) {
+            audioOutput[i]->clear();
+        }
+        MidiOutput *midiOutput = midiOutputList.getFirst();
+        while(midiOutput) {
+            midiOutput->empty();
+            midiOutput = midiOutputList.getNext(midiOutput);
+        }
+        return;
+    }
+
     // pull in new control mappings
     ControlMapping *freshMapping;
     while(newControlMappingsQueue.pop(freshMapping)) {
@@ -653,24 +1084,27 @@ void Plugin::doProcess(bool rolling, jack_position_t &pos, jack_nframes_t nframe
         audio::AudioConnection *connection = audioInput[i].getConnection();
         if(connection) {
             connection->getSource()->process(rolling, pos, nframes, time);
-            lilv_instance_connect_port(instance, audioInputIndex[i], connection->getAudio());
+            audioInputBuffer[i] = connection->getAudio();
         } else {
-            lilv_instance_connect_port(instance, audioInputIndex[i], audio::AudioConnection::getDummyBuffer());
+            audioInputBuffer[i] = audio::AudioConnection::getDummyBuffer();
         }
+        lilv_instance_connect_port(instance, audioInputIndex[i], audioInputBuffer[i]);
     }
 
-    // update control port values from scheduled control events
+    // collect control changes from scheduled control events
+    controlChanges.clear();
     ControlEvent* evt = controlBuffer.getNextEvent(rolling, pos, nframes);
     while(evt) {
-        evt->getPort()->value = evt->getValue();
+        long frame = evt->getBar() ? evt->getFrameOffset() : 0;
+        controlChanges.add(frame > 0 ? frame : 0, evt->getPort(), evt->getValue());
         ObjectCollector::scriptCollector().recycle(evt);
         evt = controlBuffer.getNextEvent(rolling, pos, nframes);
     }
 
-    // process control connections
+    // collect control changes from control connections
     ControlConnection *connection = this->controlConnections.getFirst();
     while(connection) {
-        connection->process(rolling, pos, nframes, time);
+        connection->process(rolling, pos, nframes, time, controlChanges);
         connection = controlConnections.getNext(connection);
     }
 
@@ -687,15 +1121,151 @@ void Plugin::doProcess(bool rolling, jack_position_t &pos, jack_nframes_t nframe
     }
 
     // run the plugin
-    lilv_instance_run(instance, nframes);
+    jack_nframes_t minimum = splitMinimum.load();
+    if(minimum && controlChanges.getCount()) {
+        runSplit(nframes, minimum);
+    } else {
+        for(uint32_t i = 0; i < controlChanges.getCount(); i++) {
+            ControlChange &change = controlChanges.get(i);
+            change.port->value = change.value;
+        }
+        lilv_instance_run(instance, nframes);
+    }
 
-    // fire MIDI events
+    // decode and fire MIDI events
+    midiOutput = midiOutputList.getFirst();
+    while(midiOutput) {
+        midiOutput->decode();
+        midiOutput = midiOutputList.getNext(midiOutput);
+    }
     fireMidiEvents(pos);
 
+    // capture patch outputs and publish output values
+    midiOutput = midiOutputList.getFirst();
+    while(midiOutput) {
+        capturePatchOutputs(midiOutput->getAtomSequence());
+        midiOutput = midiOutputList.getNext(midiOutput);
+    }
+    ControlOutput *controlOutput = controlOutputs.getFirst();
+    while(controlOutput) {
+        controlOutput->update();
+        controlOutput = controlOutputs.getNext(controlOutput);
+    }
+
     // emit worker responses
     if(worker) {
         worker->respond();
     }
+
+    running.store(false);
+}
+
+/**
+ * Run the plugin in sub-blocks split at control change frames, with ports
+ * connected at the block offset.
+ *
+ * Runs in the process thread. No allocations.
+ */
+void Plugin::runSplit(jack_nframes_t nframes, jack_nframes_t minimum)
+{
+    uint32_t changeCount = controlChanges.getCount();
+    uint32_t nextChange = 0;
+    jack_nframes_t start = 0;
+    while(start < nframes) {
+        // apply changes due before this block reaches the minimum size
+        while(nextChange < changeCount && controlChanges.get(nextChange).frame < start + minimum) {
+            ControlChange &change = controlChanges.get(nextChange++);
+            change.port->value = change.value;
+        }
+        jack_nframes_t end = nextChange < changeCount ? controlChanges.get(nextChange).frame : nframes;
+        if(end > nframes) {
+            end = nframes;
+        }
+        // connect ports at block offset
+        for(uint32_t i = 0; i < audioInputCount; i++) {
+            lilv_instance_connect_port(instance, audioInputIndex[i], audioInputBuffer[i] + start);
+        }
+        for(uint32_t i = 0; i < audioOutputCount; i++) {
+            lilv_instance_connect_port(instance, audioOutputIndex[i], audioOutput[i]->getAudio() + start);
+        }
+        MidiInput *midiInput = midiInputList.getFirst();
+        while(midiInput) {
+            lilv_instance_connect_port(instance, midiInput->getPortIndex(), midiInput->getBlockSequence(start, end));
+            midiInput = midiInputList.getNext(midiInput);
+        }
+        MidiOutput *midiOutput = midiOutputList.getFirst();
+        while(midiOutput) {
+            lilv_instance_connect_port(instance, midiOutput->getPortIndex(), midiOutput->getBlockSequence());
+            midiOutput = midiOutputList.getNext(midiOutput);
+        }
+        // run this block
+        lilv_instance_run(instance, end - start);
+        // gather event output
+        midiOutput = midiOutputList.getFirst();
+        while(midiOutput) {
+            midiOutput->appendBlock(start);
+            midiOutput = midiOutputList.getNext(midiOutput);
+        }
+        start = end;
+    }
+    // reconnect event ports to period sequences
+    MidiInput *midiInput = midiInputList.getFirst();
+    while(midiInput) {
+        lilv_instance_connect_port(instance, midiInput->getPortIndex(), midiInput->getAtomSequence());
+        midiInput = midiInputList.getNext(midiInput);
+    }
+    MidiOutput *midiOutput = midiOutputList.getFirst();
+    while(midiOutput) {
+        lilv_instance_connect_port(instance, midiOutput->getPortIndex(), midiOutput->getAtomSequence());
+        midiOutput = midiOutputList.getNext(midiOutput);
+    }
+}
+
+/**
+ * Store numeric patch:Set values from an output sequence to the matching
+ * tracked outputs; the last value in the period wins.
+ *
+ * Runs in the process thread. No allocations.
+ */
+void Plugin::capturePatchOutputs(LV2_Atom_Sequence *sequence)
+{
+    LV2_ATOM_SEQUENCE_FOREACH(sequence, ev) {
+        if(ev->body.type != atomTypes.objectType && ev->body.type != atomTypes.blankType) {
+            continue;
+        }
+        const LV2_Atom_Object *object = (const LV2_Atom_Object *)&ev->body;
+        if(object->body.otype != atomTypes.patchSet) {
+            continue;
+        }
+        LV2_URID property = 0;
+        const LV2_Atom *value = 0;
+        LV2_ATOM_OBJECT_FOREACH(object, prop) {
+            if(prop->key == atomTypes.patchProperty && prop->value.type == atomTypes.uridType) {
+                property = ((const LV2_Atom_URID *)&prop->value)->body;
+            } else if(prop->key == atomTypes.patchValue) {
+                value = &prop->value;
+            }
+        }
+        if(!property || !value) {
+            continue;
+        }
+        ControlOutput *output = controlOutputs.getFirst();
+        while(output && output->getProperty() != property) {
+            output = controlOutputs.getNext(output);
+        }
+        if(!output) {
+            continue;
+        }
+        if (value->type == atomTypes.floatType) {
+            output->value = ((const LV2_Atom_Float *)value)->body;
+        } else if (value->type == atomTypes.doubleType) {
+            output->value = ((const LV2_Atom_Double *)value)->body;
+        } else if (value->type == atomTypes.intType || value->type == atomTypes.boolType) {
+            output->value = ((const LV2_Atom_Int *)value)->body;
+        } else if (value->type == atomTypes.longType) {
+            output->value = ((const LV2_Atom_Long *)value)->body;
+        }
+    }
 }
 
 void Plugin::reposition() {
@@ -741,7 +1311,7 @@ void Plugin::print() {
 
 AtomTypes Plugin::atomTypes;
 
-PluginCache::PluginCache() : world(lilv_world_new()), lv2Constants(world) {
+PluginCache::PluginCache() : world(lilv_world_new()), lv2Constants(world), minBlockLength(1) {
 
     // plugins
     lilv_world_load_all(world);
@@ -768,7 +1338,7 @@ PluginCache::PluginCache() : world(lilv_world_new()), lv2Constants(world) {
 
     // Options feature
     options[0] = { LV2_OPTIONS_INSTANCE, 0, uridMapper.uriToId(LV2_BUF_SIZE__minBlockLength),
-            sizeof(float), uridMapper.uriToId(LV2_ATOM__Int), &blockLength };
+            sizeof(float), uridMapper.uriToId(LV2_ATOM__Int), &minBlockLength }; // split runs
     options[1] = { LV2_OPTIONS_INSTANCE, 0, uridMapper.uriToId(LV2_BUF_SIZE__maxBlockLength),
             sizeof(float), uridMapper.uriToId(LV2_ATOM__Int), &blockLength };
     options[2] = { LV2_OPTIONS_INSTANCE, 0, 0, 0, 0, NULL };
@@ -801,21 +1371,30 @@ PluginCache::PluginCache() : world(lilv_world_new()), lv2Constants(world) {
     Plugin::atomTypes.floatType = uridMapper.uriToId(LV2_ATOM__Float);
     Plugin::atomTypes.doubleType = uridMapper.uriToId(LV2_ATOM__Double);
     Plugin::atomTypes.stringType = uridMapper.uriToId(LV2_ATOM__String);
+    Plugin::atomTypes.boolType = uridMapper.uriToId(LV2_ATOM__Bool);
+    Plugin::atomTypes.uridType = uridMapper.uriToId(LV2_ATOM__URID);
+    Plugin::atomTypes.objectType = uridMapper.uriToId(LV2_ATOM__Object);
+    Plugin::atomTypes.blankType = uridMapper.uriToId(LV2_ATOM__Blank);
+    Plugin::atomTypes.patchSet = uridMapper.uriToId(LV2_PATCH__Set);
+    Plugin::atomTypes.patchProperty = uridMapper.uriToId(LV2_PATCH__property);
+    Plugin::atomTypes.patchValue = uridMapper.uriToId(LV2_PATCH__value);
     MidiEvent::midiEventTypeId = uridMapper.uriToId(LILV_URI_MIDI_EVENT);
 }
 
 
 Plugin *PluginCache::getPlugin(const char *uri, const char *preset, State *state) {
-    // create a unique key for uri/preset/state
+    // create a unique key for uri/preset, stateful instances are kept apart
+    // since a state is reapplied in place but never removed
     std::string keyString(uri);
     if(preset) {
         keyString.append(":");
         keyString.append(preset);
     }
-    std::size_t hash = std::hash<std::string>()(keyString);
     if(state) {
-        hash = hash ^ (state->getHash() << 1);
+        keyString.append("#state");
+        state = cacheState(*state);
     }
+    std::size_t hash = std::hash<std::string>()(keyString);
 
     // count tells how many instances of this type of plugin
     int count = ++instanceCount[hash];
@@ -825,6 +1404,11 @@ Plugin *PluginCache::getPlugin(const char *uri, const char *preset, State *state
     Plugin *cachedPlugin = findObject(key);
     if(cachedPlugin) {
         cachedPlugin->restore();
+        // reapply changed state in place, cached states are unique so the pointers tell
+        if(state && cachedPlugin->getAppliedState() != state) {
+            cachedPlugin->setAppliedState(state);
+            stateRestorer.schedule(cachedPlugin, state);
+        }
         return cachedPlugin;
     }
 
@@ -869,8 +1453,18 @@ Plugin *PluginCache::getPlugin(const char *uri, const char *preset, State *state
         worker->setInstance(instance);
     }
 
-    // create plugin object
-    Plugin *plugin = new Plugin(lilvPlugin, instance, lv2Constants, worker);
+    // readable parameters reported with patch:Set
+    LilvNodes *readable = lilv_world_find_nodes(world, lilv_plugin_get_uri(lilvPlugin),
+                                                lv2Constants.lv2PatchReadable, NULL);
+
+    // create plugin object, outputs are queued before the process thread takes them
+    Plugin *plugin = new Plugin(lilvPlugin, instance, lv2Constants, worker, lilv_nodes_size(readable));
+
+    // track readable parameters
+    LILV_FOREACH(nodes, i, readable) {
+        plugin->addPatchOutput(lilv_node_as_uri(lilv_nodes_get(readable, i)));
+    }
+    lilv_nodes_free(readable);
 
     // restore baseline default state
     LilvState *defaultState =  lilv_state_new_from_world(world, &map, lilv_plugin_get_uri(lilvPlugin));
@@ -913,6 +1507,7 @@ Plugin *PluginCache::getPlugin(const char *uri, const char *preset, State *state
                 throw std::logic_error(std::string("Plugin ") + uriString
                                        + " setting state failed with code " + std::to_string(status));
             }
+            plugin->setAppliedState(state);
         }
     }
 
@@ -925,6 +1520,26 @@ Plugin *PluginCache::getPlugin(const char *uri, const char *preset, State *state
     return plugin;
 }
 
+/**
+ * Returns the cached copy of a state with identical content, caching a copy
+ * of this one if there is none.
+ *
+ * Runs in the script thread.
+ */
+State *PluginCache::cacheState(State &state)
+{
+    auto range = stateCache.equal_range(state.getHash());
+    for(auto it = range.first; it != range.second; it++) {
+        if(it->second->equals(state)) {
+            return it->second;
+        }
+    }
+    // states with colliding hashes are kept side by side
+    State *copy = new State(state);
+    stateCache.insert(std::make_pair(state.getHash(), copy));
+    return copy;
+}
+
 PluginCache::~PluginCache()
 {
     lilv_world_free(world);
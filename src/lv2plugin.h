@@ -26,9 +26,13 @@
 #include <jack/ringbuffer.h>
 #include <semaphore.h>
 
+#include <cstring>
 #include <map>
 #include <list>
 #include <set>
+#include <deque>
+#include <mutex>
+#include <vector>
 
 #include "audioconnection.h"
 #include "midiconnection.h"
@@ -36,16 +40,41 @@
 #include "midisink.h"
 #include "scripttypes.h"
 #include "objectcache.h"
+#include "eventclosure.h"
 
 namespace bipscript {
 namespace lv2 {
 
-typedef std::map<std::string, uint32_t> Lv2UridMap;
-
+/**
+ * Maps URIs to URIDs and back.
+ *
+ * Lookups of known URIs and all unmaps are lock-free so plugins can call
+ * them from any thread; new URIs are inserted under a lock. URIDs are
+ * assigned sequentially from 1 and index directly into the URI chunks.
+ */
 class UridMapper
 {
-    Lv2UridMap uridMap;
+    static const uint32_t CHUNK_SIZE = 1024;
+    static const uint32_t MAX_CHUNKS = 256;
+    class Table {
+    public:
+        const uint32_t mask;
+        std::size_t *hashes;
+        std::atomic<LV2_URID> *ids;
+        Table(uint32_t capacity);
+        ~Table();
+        void insert(std::size_t hash, LV2_URID id);
+    };
+    std::atomic<Table*> table;
+    std::vector<Table*> retiredTables;
+    std::atomic<const char **> uriChunks[MAX_CHUNKS];
+    LV2_URID lastId;
+    std::mutex mutex;
+    LV2_URID find(Table *table, std::size_t hash, const char *uri);
+    static std::size_t hashUri(const char *uri);
 public:
+    UridMapper();
+    ~UridMapper();
     LV2_URID uriToId(const char *uri);
     const char *idToUri(LV2_URID urid);
 };
@@ -80,6 +109,8 @@ public:
     LilvNode *lv2WorkerSchedule;
     // rdf
     LilvNode *lv2RdfsLabel;
+    // patch
+    LilvNode *lv2PatchReadable;
 };
 
 class AtomTypes
@@ -90,6 +121,13 @@ public:
     LV2_URID intType;
     LV2_URID longType;
     LV2_URID stringType;
+    LV2_URID boolType;
+    LV2_URID uridType;
+    LV2_URID objectType;
+    LV2_URID blankType;
+    LV2_URID patchSet;
+    LV2_URID patchProperty;
+    LV2_URID patchValue;
 };
 
 class MidiEvent {
@@ -105,18 +143,28 @@ public:
 
 class MidiInput : public Listable
 {
-    const u_int32_t CAPACITY = 1024;
+    const u_int32_t CAPACITY = 65536;
+    const uint32_t portIndex;
     LV2_Atom_Sequence *atomSequence;
+    LV2_Atom_Sequence *blockSequence;
     midi::MidiConnector eventConnector;
-    EventBuffer<midi::Event> eventBuffer;
-    bool localRolling;
+    midi::SinkBuffer eventBuffer;
+    midi::ActiveNotes activeNotes;
 public:
-    MidiInput() : localRolling(false) {
+    MidiInput(uint32_t portIndex, const midi::Timing &timing) : portIndex(portIndex), eventBuffer(timing) {
         atomSequence = static_cast<LV2_Atom_Sequence *>(malloc(sizeof(LV2_Atom_Sequence) + CAPACITY));
+        blockSequence = static_cast<LV2_Atom_Sequence *>(malloc(sizeof(LV2_Atom_Sequence) + CAPACITY));
+        // plugins may read body.unit, lv2_atom_sequence_clear leaves it alone
+        std::memset(atomSequence, 0, sizeof(LV2_Atom_Sequence));
+        std::memset(blockSequence, 0, sizeof(LV2_Atom_Sequence));
+    }
+    uint32_t getPortIndex() {
+        return portIndex;
     }
     LV2_Atom_Sequence *getAtomSequence() {
         return atomSequence;
     }
+    LV2_Atom_Sequence *getBlockSequence(jack_nframes_t start, jack_nframes_t end);
     void connect(midi::MidiConnection *connection, midi::Source *source) {
         eventConnector.setConnection(connection, source);
     }
@@ -127,34 +175,49 @@ public:
     void addEvent(midi::Event *evt) {
         eventBuffer.addEvent(evt);
     }
+    void addBlock(midi::PatternBlock *block) {
+        eventBuffer.addBlock(block);
+    }
     void reset() {
         eventBuffer.recycleRemaining();
+        activeNotes.reposition();
     }
     void process(bool rolling, jack_position_t &pos, jack_nframes_t nframes, jack_nframes_t time);
-    void update() {
-        eventBuffer.update();
-    }
 };
 
 class MidiOutput : public Listable, public midi::MidiConnection
 {
-    const u_int32_t CAPACITY = 1024;
+    const u_int32_t CAPACITY = 65536;
+    const uint32_t portIndex;
     LV2_Atom_Sequence *atomSequence;    
-    midi::Event event;
+    LV2_Atom_Sequence *blockSequence;
 public:
-    MidiOutput(midi::Source *source) : midi::MidiConnection(source) {
+    MidiOutput(midi::Source *source, uint32_t portIndex) : midi::MidiConnection(source), portIndex(portIndex) {
         atomSequence = (LV2_Atom_Sequence *)malloc(sizeof(LV2_Atom_Sequence) + CAPACITY);
+        blockSequence = (LV2_Atom_Sequence *)malloc(sizeof(LV2_Atom_Sequence) + CAPACITY);
+        std::memset(atomSequence, 0, sizeof(LV2_Atom_Sequence));
+        std::memset(blockSequence, 0, sizeof(LV2_Atom_Sequence));
         atomSequence->atom.size = CAPACITY;
     }
+    uint32_t getPortIndex() {
+        return portIndex;
+    }
     LV2_Atom_Sequence *getAtomSequence() {
         return atomSequence;
     }
+    LV2_Atom_Sequence *getBlockSequence() {
+        blockSequence->atom.size = CAPACITY;
+        return blockSequence;
+    }
+    void appendBlock(jack_nframes_t start);
     void clear() {
         atomSequence->atom.size = CAPACITY;
     }
-    // EventConnection interface
-    uint32_t getEventCount();
-    midi::Event *getEvent(uint32_t i);
+    void empty() {
+        lv2_atom_sequence_clear(atomSequence);
+        events.clear();
+    }
+    void decode();
 };
 
 class ControlPort {
@@ -166,6 +229,60 @@ public:
     float maximum;
 };
 
+/**
+ * Output change handler, the script function is released with it.
+ */
+class OutputHandler : public ScriptFunction {
+public:
+    OutputHandler(ScriptFunction &function) : ScriptFunction(function) {}
+    ~OutputHandler() {
+        release();
+    }
+};
+
+/**
+ * A plugin output value: either a control output port or a property
+ * reported on an atom output with patch:Set.
+ *
+ * The process thread publishes the latest value once per period; the script
+ * thread reads it without locking. Handler calls are coalesced so at most one
+ * is pending at a time and it reports the value current when it runs.
+ */
+class ControlOutput : public Listable {
+    const LV2_URID property;
+    std::atomic<float> snapshot;
+    std::atomic<bool> pending;
+    std::atomic<OutputHandler*> handler;
+    std::atomic<bool> updating; // process thread may be reading the handler
+    void retire(OutputHandler *previous);
+public:
+    float value;
+    ControlOutput(LV2_URID property) : property(property), snapshot(0), pending(false),
+        handler(0), updating(false), value(0) {}
+    LV2_URID getProperty() {
+        return property;
+    }
+    float getValue() {
+        return snapshot.load();
+    }
+    float takeValue() {
+        pending.store(false);
+        return snapshot.load();
+    }
+    void onChange(ScriptFunction &handler);
+    void update();
+    void reset();
+};
+
+class ControlOutputClosure : public EventClosure {
+    ControlOutput *output;
+protected:
+    void addParameters() { addFloat(output->takeValue()); }
+public:
+    ControlOutputClosure(ScriptFunction function, ControlOutput *output) :
+        EventClosure(function), output(output) {}
+};
+
 class ControlEvent : public Event {
     ControlPort *port;
     float value;
@@ -180,6 +297,33 @@ public:
     }
 };
 
+/**
+ * A control value change at a frame within the current period.
+ */
+class ControlChange {
+public:
+    jack_nframes_t frame;
+    ControlPort *port;
+    float value;
+};
+
+/**
+ * Control changes for the current period sorted by frame.
+ *
+ * Local to the process thread.
+ */
+class ControlChangeList {
+    static const uint32_t CAPACITY = 256;
+    ControlChange changes[CAPACITY];
+    uint32_t count;
+public:
+    ControlChangeList() : count(0) {}
+    void add(jack_nframes_t frame, ControlPort *port, float value);
+    uint32_t getCount() { return count; }
+    ControlChange &get(uint32_t index) { return changes[index]; }
+    void clear() { count = 0; }
+};
+
 class ControlConnection;
 
 class ControlMapping : public Listable
@@ -200,9 +344,9 @@ public:
     ControlConnection *getConnection() {
         return connection;
     }
-    void update(uint8_t cc, uint8_t value) {
+    void update(uint8_t cc, uint8_t value, jack_nframes_t frame, ControlChangeList &changes) {
         if(this->cc == cc) {
-            port->value = getScaled(value);
+            changes.add(frame, port, getScaled(value));
         }
     }
 };
@@ -215,18 +359,25 @@ public:
     ControlConnection(midi::MidiConnection *connection) :
         connection(connection) {}
     void addMapping(ControlMapping *mapping) { mappings.add(mapping); }
-    void process(bool rolling, jack_position_t &pos, jack_nframes_t nframes, jack_nframes_t time);
+    void process(bool rolling, jack_position_t &pos, jack_nframes_t nframes, jack_nframes_t time,
+                 ControlChangeList &changes);
     void reset();
 };
 
 class State
 {
     std::map<uint32_t, std::string> stateMap;
+    std::size_t hash;
 public:
     State(const char *filename);
     State(ScriptHashIterator &state);
     const void* retrieveState(uint32_t key, size_t* size, uint32_t* type, uint32_t* flags);
-    const int getHash();
+    std::size_t getHash() const {
+        return hash;
+    }
+    bool equals(const State &other) const {
+        return hash == other.hash && stateMap == other.stateMap;
+    }
 };
 
 class Worker
@@ -248,6 +399,24 @@ public:
     void setInstance(LilvInstance *instance);
 };
 
+class Plugin;
+
+/**
+ * Applies state to running plugin instances from a background thread.
+ */
+class StateRestorer
+{
+    std::deque<std::pair<Plugin*, State*>> jobs;
+    std::mutex mutex;
+    pthread_t thread;
+    sem_t semaphore;
+    bool started;
+public:
+    StateRestorer() : started(false) {}
+    void schedule(Plugin *plugin, State *state);
+    void run();
+};
+
 class Plugin : public audio::Source, public midi::Source, public midi::Sink
 {
     const LilvPlugin *plugin;
@@ -261,6 +430,7 @@ class Plugin : public audio::Source, public midi::Source, public midi::Sink
     uint32_t audioInputCount;
     uint32_t *audioInputIndex;
     audio::AudioConnector *audioInput;
+    float **audioInputBuffer;
     // audio outputs
     uint32_t audioOutputCount;
     uint32_t *audioOutputIndex;
@@ -268,15 +438,25 @@ class Plugin : public audio::Source, public midi::Source, public midi::Sink
     // control ports
     EventBuffer<ControlEvent> controlBuffer;
     std::map<std::string, ControlPort *> controlMap;
+    ControlChangeList controlChanges;
+    std::atomic<uint32_t> splitMinimum;
+    // control outputs
+    std::map<std::string, ControlOutput *> outputMap;
+    QueueList<ControlOutput> controlOutputs;
     // worker
     Worker *worker;
+    // state restore
+    std::atomic<bool> restoring;
+    std::atomic<bool> running;
+    State *appliedState; // canonical copy held by the plugin cache
     // control connections
     std::map<midi::MidiConnection*,ControlConnection*> controlConnectionMap;
     QueueList<ControlConnection> controlConnections;
     boost::lockfree::spsc_queue<ControlMapping*> newControlMappingsQueue;
 public:
     static AtomTypes atomTypes;
-    Plugin(const LilvPlugin *plugin, LilvInstance *instance, const Constants &uris, Worker *worker);
+    Plugin(const LilvPlugin *plugin, LilvInstance *instance, const Constants &uris, Worker *worker,
+           uint32_t patchOutputCount);
     ~Plugin();
     // public methods
     void connect(audio::Source &source);
@@ -288,9 +468,21 @@ public:
     void addController(midi::Source &source, unsigned int cc, const char *symbol, float minimum, float maximum);
     void addController(midi::Source &source, unsigned int cc, const char *symbol, float minimum);
     void addController(midi::Source &source, unsigned int cc, const char *symbol);
+    void setSplitBlocks(int minimum);
+    void addPatchOutput(const char *uri);
+    float getOutput(const char *name);
+    void onOutput(const char *name, ScriptFunction &handler);
     void restore();
+    void restoreState(State *state, const LV2_Feature *const *features);
+    State *getAppliedState() {
+        return appliedState;
+    }
+    void setAppliedState(State *state) {
+        appliedState = state;
+    }
     // MidiSink
     void addMidiEvent(midi::Event* evt);
+    void addPatternBlock(midi::PatternBlock *block);
     // Source interface
     bool connectsTo(AbstractSource *source);
     // Processor interface
@@ -306,6 +498,9 @@ public:
     midi::MidiConnection *getMidiConnection(unsigned int index);
 private:
     ControlPort *getPort(const char *symbol);
+    void runSplit(jack_nframes_t nframes, jack_nframes_t minimum);
+    ControlOutput *findOutput(const char *name);
+    void capturePatchOutputs(LV2_Atom_Sequence *sequence);
     void connectPort(int index, Plugin *other, int otherIndex);
     void print();
 };
@@ -324,6 +519,7 @@ class PluginCache : public ProcessorCache<Plugin>
     std::map<std::string, bool> supported;
     // options feature
     jack_nframes_t blockLength;
+    jack_nframes_t minBlockLength;
     LV2_Options_Option options[3];
     // urid features
     LV2_URID_Map map;
@@ -332,6 +528,10 @@ class PluginCache : public ProcessorCache<Plugin>
     LV2_State_Map_Path mapPath;
     // worker schedule feature
     LV2_Worker_Schedule schedule;
+    // content-addressed states
+    std::multimap<std::size_t, State*> stateCache;
+    StateRestorer stateRestorer;
+    State *cacheState(State &state);
     // use instance()
     PluginCache();
     void scriptReset() {
@@ -350,6 +550,9 @@ public:
     void setBufferSize(jack_nframes_t size) {
         this->blockLength = size;
     }
+    const LV2_Feature *const *getFeatures() {
+        return lv2Features;
+    }
     Plugin *getPlugin(const char *uri, const char *preset, State *state);
     Plugin *getPlugin(const char *uri, const char *preset) {
         return getPlugin(uri, preset, 0);
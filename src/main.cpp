@@ -34,9 +34,11 @@
 #include "audioport.h"
 #include "beattracker.h"
 #include "onsetdetector.h"
+#include "analyzer.h"
 #include "oscinput.h"
 #include "oscoutput.h"
 #include "extension.h"
+#include "fftwisdom.h"
 #include "transport.h"
 
 namespace fs = boost::filesystem;
@@ -49,6 +51,7 @@ void signal_handler(int sig)
     ExtensionManager::instance().shutdown();
     osc::OutputFactory::instance().shutdown();
     AudioEngine::instance().shutdown();
+    audio::FftWisdom::instance().save();
     exit(0);
 }
 
@@ -74,6 +77,9 @@ int main(int argc, char **argv)
     // initialize system
     system::System::setArguments(argc, argv);
 
+    // analysis FFT plans are measured, reuse what earlier runs measured
+    audio::FftWisdom::instance().load();
+
     // create script host
     ScriptHost &host = ScriptHost::instance();
     host.setScriptFile(parentPath.c_str(), argv[1]);
@@ -92,9 +98,10 @@ int main(int argc, char **argv)
                             &midi::BeatTrackerCache::instance(),
                             &osc::InputFactory::instance(),
                             &osc::OutputFactory::instance(),
-                            &audio::OnsetDetectorCache::instance()
+                            &audio::OnsetDetectorCache::instance(),
+                            &audio::AnalyzerCache::instance()
                             };
-    host.setObjectCaches(13, caches);
+    host.setObjectCaches(14, caches);
 
     // create and  start audioengine
     AudioEngine &audioEngine = AudioEngine::instance();
@@ -122,5 +129,6 @@ int main(int argc, char **argv)
     ExtensionManager::instance().shutdown();
     osc::OutputFactory::instance().shutdown();
     audioEngine.shutdown();
+    audio::FftWisdom::instance().save();
     return status;
 }
@@ -0,0 +1,390 @@
+/*
+ * This file is part of Bipscript.
+ *
+ * Bipscript is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Bipscript is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Bipscript.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "midiblock.h"
+
+#include <algorithm>
+#include <cmath>
+#include <ctime>
+
+namespace bipscript {
+namespace midi {
+
+static bool eventBefore(const Event &one, const Event &other)
+{
+    if(one.getBar() != other.getBar()) {
+        return one.getBar() < other.getBar();
+    }
+    return (uint64_t)one.getPosition() * other.getDivision()
+            < (uint64_t)other.getPosition() * one.getDivision();
+}
+
+/**
+ * Heap order, the earliest frame comes out first.
+ */
+static bool pendingAfter(const PendingEvent &one, const PendingEvent &other)
+{
+    if(one.frame != other.frame) {
+        return one.frame > other.frame;
+    }
+    return one.order > other.order;
+}
+
+/**
+ * Quantize to the given number of divisions per bar, a strength of zero
+ * leaves events as they are and one moves them fully onto the grid.
+ *
+ * Runs in the script thread.
+ */
+void Timing::quantize(int division, float strength)
+{
+    if(division < 0) {
+        throw std::logic_error("quantize division cannot be negative");
+    }
+    if(strength < 0 || strength > 1) {
+        throw std::logic_error("quantize strength must be between 0 and 1");
+    }
+    quantizeStrength.store(strength);
+    quantizeDivision.store(division);
+}
+
+/**
+ * Swing every second division of the bar later by the given fraction of a
+ * division, zero is straight.
+ *
+ * Runs in the script thread.
+ */
+void Timing::swing(int division, float amount)
+{
+    if(division < 0) {
+        throw std::logic_error("swing division cannot be negative");
+    }
+    if(amount < 0 || amount >= 1) {
+        throw std::logic_error("swing amount must be at least 0 and less than 1");
+    }
+    swingAmount.store(amount);
+    swingDivision.store(division);
+}
+
+/**
+ * Offset events by a random time of up to the given milliseconds either way.
+ *
+ * Runs in the script thread.
+ */
+void Timing::humanize(float milliseconds)
+{
+    if(milliseconds < 0) {
+        throw std::logic_error("humanize time cannot be negative");
+    }
+    humanizeTime.store(milliseconds);
+}
+
+/**
+ * Turn all timing transforms off.
+ *
+ * Runs in the script thread.
+ */
+void Timing::reset()
+{
+    quantizeDivision.store(0);
+    swingDivision.store(0);
+    humanizeTime.store(0);
+}
+
+TimingTransform::TimingTransform(const Timing &timing)
+    : timing(timing), random(std::time(0) ^ (uintptr_t)this)
+{
+    for(int channel = 0; channel < 16; channel++) {
+        for(int pitch = 0; pitch < 128; pitch++) {
+            noteShift[channel][pitch] = 0;
+        }
+    }
+}
+
+/**
+ * Runs in the process thread. No allocations.
+ */
+int32_t TimingTransform::drawShift(Event &evt, jack_position_t &pos)
+{
+    uint8_t type = evt.getType();
+    if(type == Event::TYPE_NOTE_OFF || (type == Event::TYPE_NOTE_ON && !evt.getDatabyte2())) {
+        return noteShift[evt.channel & 0x0F][evt.getDatabyte1() & 0x7F];
+    }
+    int32_t shift = shiftFor(evt, pos);
+    if(type == Event::TYPE_NOTE_ON) {
+        noteShift[evt.channel & 0x0F][evt.getDatabyte1() & 0x7F] = shift;
+    }
+    return shift;
+}
+
+/**
+ * Runs in the process thread. No allocations.
+ */
+int32_t TimingTransform::shiftFor(Event &evt, jack_position_t &pos)
+{
+    int quantizeDivision = timing.quantizeDivision.load(std::memory_order_relaxed);
+    int swingDivision = timing.swingDivision.load(std::memory_order_relaxed);
+    float humanizeTime = timing.humanizeTime.load(std::memory_order_relaxed);
+    if(!quantizeDivision && !swingDivision && !humanizeTime) {
+        return 0;
+    }
+    // position in bars
+    double original = (double)evt.getPosition() / evt.getDivision();
+    double shifted = original;
+    if(quantizeDivision) {
+        double grid = std::floor(shifted * quantizeDivision + 0.5) / quantizeDivision;
+        shifted += timing.quantizeStrength.load(std::memory_order_relaxed) * (grid - shifted);
+    }
+    if(swingDivision) {
+        // stretch the first division of each pair, compress the second
+        float amount = timing.swingAmount.load(std::memory_order_relaxed);
+        double divisions = shifted * swingDivision;
+        double pair = 2 * std::floor(divisions / 2);
+        double phase = divisions - pair;
+        phase = phase < 1 ? phase * (1 + amount) : 1 + amount + (phase - 1) * (1 - amount);
+        shifted = (pair + phase) / swingDivision;
+    }
+    double framesPerBar = pos.beats_per_bar * 60 * pos.frame_rate / pos.beats_per_minute;
+    double shift = (shifted - original) * framesPerBar;
+    if(humanizeTime) {
+        shift += random.bipolar() * humanizeTime * pos.frame_rate / 1000;
+    }
+    return std::lround(shift);
+}
+
+/**
+ * Calculates the frame offset of the event including its timing shift.
+ *
+ * Runs in the process thread. No allocations.
+ */
+long TimingTransform::frameOffset(Event &evt, jack_position_t &pos)
+{
+    long frame = evt.updateFrameOffset(pos);
+    if(!evt.getBar()) {
+        return frame;
+    }
+    if(!evt.hasShift()) {
+        evt.setShift(drawShift(evt, pos));
+    }
+    frame += evt.getShift();
+    evt.setFrameOffset(frame);
+    return frame;
+}
+
+/**
+ * How far ahead of their position events can be shifted, in frames.
+ *
+ * Runs in the process thread. No allocations.
+ */
+long TimingTransform::lookahead(jack_position_t &pos)
+{
+    double frames = timing.humanizeTime.load(std::memory_order_relaxed) * pos.frame_rate / 1000;
+    int quantizeDivision = timing.quantizeDivision.load(std::memory_order_relaxed);
+    if(quantizeDivision) {
+        double framesPerBar = pos.beats_per_bar * 60 * pos.frame_rate / pos.beats_per_minute;
+        frames += timing.quantizeStrength.load(std::memory_order_relaxed) * framesPerBar / quantizeDivision / 2;
+    }
+    return std::ceil(frames);
+}
+
+/**
+ * Compile a pattern scheduled at the given position.
+ *
+ * Runs in the script thread.
+ *
+ * Allocates the event array.
+ */
+PatternBlock::PatternBlock(Pattern &pattern, Position &position, unsigned char channel)
+    : cursor(0), taken(0)
+{
+    events.reserve(pattern.size() * 2);
+    for(unsigned int i = 0; i < pattern.size(); i++) {
+        Position start = position + Pattern::tickDuration(pattern.startTick(i));
+        events.push_back(Event(start, pattern.pitch(i), pattern.velocity(i), Event::TYPE_NOTE_ON, channel - 1));
+        Position end = start + Pattern::tickDuration(pattern.durationTick(i));
+        events.push_back(Event(end, pattern.pitch(i), 0, Event::TYPE_NOTE_OFF, channel - 1));
+    }
+    // stable: events at the same position keep the order they were scheduled in
+    std::stable_sort(events.begin(), events.end(), eventBefore);
+}
+
+/**
+ * Returns the event at the cursor if its unshifted offset is before the
+ * limit, skipping events that have already passed.
+ *
+ * Runs in the process thread. No allocations.
+ */
+Event *PatternBlock::peek(jack_position_t &pos, long limit, TimingTransform &transform, long lookahead)
+{
+    while(cursor < events.size()) {
+        Event &evt = events[cursor];
+        long frame = transform.frameOffset(evt, pos);
+        if(frame >= -256 - lookahead) { // TODO: grace period depends on framerate
+            return frame - evt.getShift() < limit ? &evt : 0;
+        }
+        cursor++;
+    }
+    return 0;
+}
+
+/**
+ * Frame offset including the timing shift, events without a position are due
+ * at the start of the period.
+ *
+ * Runs in the process thread. No allocations.
+ */
+long SinkBuffer::frameOffset(Event &evt, jack_position_t &pos)
+{
+    if(!evt.getBar()) {
+        evt.setFrameOffset(0);
+        return 0;
+    }
+    return transform.frameOffset(evt, pos);
+}
+
+/**
+ * Runs in the process thread. No allocations.
+ */
+void SinkBuffer::collect(Event *evt, PatternBlock *block, jack_position_t &pos)
+{
+    PendingEvent entry = {evt, block, frameOffset(*evt, pos), pendingOrder++};
+    pending.push_back(entry);
+    std::push_heap(pending.begin(), pending.end(), pendingAfter);
+}
+
+/**
+ * Recalculate the offsets of events collected in an earlier period, the
+ * transport may have moved in any direction since.
+ *
+ * Runs in the process thread. No allocations.
+ */
+void SinkBuffer::refresh(jack_position_t &pos)
+{
+    if(pos.frame == pendingPeriod) {
+        return;
+    }
+    pendingPeriod = pos.frame;
+    for(PendingEvent &entry : pending) {
+        entry.frame = frameOffset(*entry.event, pos);
+    }
+    std::make_heap(pending.begin(), pending.end(), pendingAfter);
+}
+
+/**
+ * Runs in the process thread.
+ */
+void SinkBuffer::discard(const PendingEvent &entry)
+{
+    if(entry.block) {
+        entry.block->release();
+    } else {
+        ObjectCollector::scriptCollector().recycle(entry.event);
+    }
+}
+
+/**
+ * Returns the next event due in this period from either the event buffer or
+ * the pattern blocks, in shifted frame order. Hand the event back with
+ * recycle(). Collected events wait in place while the transport is stopped.
+ *
+ * Runs in the process thread. No allocations.
+ */
+Event *SinkBuffer::getNextEvent(bool rolling, jack_position_t &pos, jack_nframes_t nframes)
+{
+    // pick up new blocks
+    PatternBlock *freshBlock;
+    while(blockQueue.pop(freshBlock)) {
+        blocks.add(freshBlock);
+    }
+    lastBlock = 0;
+    if(!rolling) {
+        return eventBuffer.getNextEvent(rolling, pos, nframes);
+    }
+    refresh(pos);
+    // collect everything that can be shifted into this period
+    long lookahead = transform.lookahead(pos);
+    long limit = nframes + lookahead;
+    Event *evt;
+    while(pending.size() < PENDING_CAPACITY
+          && (evt = eventBuffer.getNextEvent(rolling, pos, limit, lookahead))) {
+        collect(evt, 0, pos);
+    }
+    PatternBlock *block = blocks.getFirst();
+    while(block) {
+        while(pending.size() < PENDING_CAPACITY && block->peek(pos, limit, transform, lookahead)) {
+            collect(block->take(), block, pos);
+        }
+        PatternBlock *next = blocks.getNext(block);
+        if(block->done()) {
+            blocks.remove(block);
+            ObjectCollector::scriptCollector().recycle(block);
+        }
+        block = next;
+    }
+    // earliest collected event
+    while(pending.size() && pending.front().frame < (long)nframes) {
+        std::pop_heap(pending.begin(), pending.end(), pendingAfter);
+        PendingEvent entry = pending.back();
+        pending.pop_back();
+        if(entry.frame < -256 - lookahead) { // passed while the transport was elsewhere
+            discard(entry);
+            continue;
+        }
+        lastBlock = entry.block;
+        return entry.event;
+    }
+    return 0;
+}
+
+/**
+ * Runs in the process thread.
+ */
+void SinkBuffer::recycle(Event *evt)
+{
+    // block events are owned by their block
+    if(lastBlock) {
+        lastBlock->release();
+        lastBlock = 0;
+    } else {
+        ObjectCollector::scriptCollector().recycle(evt);
+    }
+}
+
+void SinkBuffer::recycleRemaining()
+{
+    ObjectCollector &collector = ObjectCollector::scriptCollector();
+    for(PendingEvent &entry : pending) {
+        if(!entry.block) {
+            collector.recycle(entry.event);
+        }
+    }
+    pending.clear();
+    lastBlock = 0;
+    eventBuffer.recycleRemaining();
+    PatternBlock *freshBlock;
+    while(blockQueue.pop(freshBlock)) {
+        collector.recycle(freshBlock);
+    }
+    PatternBlock *block = blocks.getFirst();
+    while(block) {
+        PatternBlock *done = block;
+        block = blocks.pop();
+        collector.recycle(done);
+    }
+}
+
+}}
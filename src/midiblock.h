@@ -0,0 +1,160 @@
+/*
+ * This file is part of Bipscript.
+ *
+ * Bipscript is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Bipscript is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Bipscript.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef MIDIBLOCK_H
+#define MIDIBLOCK_H
+
+#include "midipattern.h"
+#include "eventbuffer.h"
+#include "random.h"
+
+#include <atomic>
+#include <vector>
+
+namespace bipscript {
+namespace midi {
+
+/**
+ * Timing transform settings of a MIDI sink: quantize, swing and humanize.
+ *
+ * Set in the script thread and read by the process thread per event.
+ */
+class Timing
+{
+    std::atomic<int> quantizeDivision;
+    std::atomic<float> quantizeStrength;
+    std::atomic<int> swingDivision;
+    std::atomic<float> swingAmount;
+    std::atomic<float> humanizeTime;
+public:
+    Timing() : quantizeDivision(0), quantizeStrength(0), swingDivision(0), swingAmount(0), humanizeTime(0) {}
+    void quantize(int division, float strength);
+    void swing(int division, float amount);
+    void humanize(float milliseconds);
+    void reset();
+    friend class TimingTransform;
+};
+
+/**
+ * Applies the timing settings of a sink to its scheduled events as their
+ * frame offsets are calculated.
+ *
+ * Note ons and other messages are quantized and swung on a grid of bar
+ * divisions then offset by a random amount; note offs take the shift of
+ * their note on so note lengths are kept. The shift is drawn once per event,
+ * in position order.
+ *
+ * Local to the process thread.
+ */
+class TimingTransform
+{
+    const Timing &timing;
+    math::FastRandom random;
+    int32_t noteShift[16][128]; // shift of the last note on
+    int32_t drawShift(Event &evt, jack_position_t &pos);
+    int32_t shiftFor(Event &evt, jack_position_t &pos);
+public:
+    TimingTransform(const Timing &timing);
+    long frameOffset(Event &evt, jack_position_t &pos);
+    long lookahead(jack_position_t &pos);
+};
+
+/**
+ * A pattern compiled for scheduling: the note on/off events of one
+ * scheduled pattern in one contiguous array, sorted by position.
+ *
+ * Built in the script thread and read-only afterwards except for the read
+ * cursor, which belongs to the process thread.
+ */
+class PatternBlock : public Listable
+{
+    std::vector<Event> events;
+    uint32_t cursor;
+    uint32_t taken; // events handed out and not yet recycled
+public:
+    PatternBlock(Pattern &pattern, Position &position, unsigned char channel);
+    uint32_t size() {
+        return events.size();
+    }
+    Event *peek(jack_position_t &pos, long limit, TimingTransform &transform, long lookahead);
+    Event *take() {
+        taken++;
+        return &events[cursor++];
+    }
+    void release() {
+        taken--;
+    }
+    bool done() {
+        return cursor == events.size() && !taken;
+    }
+};
+
+/**
+ * An event collected by a sink buffer, ordered by its shifted frame offset
+ * then by the order it was collected in.
+ */
+struct PendingEvent
+{
+    Event *event;
+    PatternBlock *block; // owner of the event, zero for individually scheduled events
+    long frame;
+    uint32_t order;
+};
+
+/**
+ * Event buffer for a MIDI sink: merges individually scheduled events with
+ * the events of compiled pattern blocks, applying the sink timing.
+ *
+ * The timing shift can move an event ahead of events scheduled before it,
+ * so events within reach of the period are collected into a heap on their
+ * shifted frame and handed out from there in frame order.
+ *
+ * Blocks are transferred to the process thread as a single pointer.
+ */
+class SinkBuffer
+{
+    static const size_t PENDING_CAPACITY = 1024;
+    EventBuffer<Event> eventBuffer;
+    boost::lockfree::spsc_queue<PatternBlock*> blockQueue; // script thread -> process thread
+    List<PatternBlock> blocks; // local to process thread
+    TimingTransform transform; // local to process thread
+    std::vector<PendingEvent> pending; // local to process thread
+    uint32_t pendingOrder;
+    jack_nframes_t pendingPeriod; // transport frame the pending offsets were calculated at
+    PatternBlock *lastBlock;
+    long frameOffset(Event &evt, jack_position_t &pos);
+    void collect(Event *evt, PatternBlock *block, jack_position_t &pos);
+    void refresh(jack_position_t &pos);
+    void discard(const PendingEvent &entry);
+public:
+    SinkBuffer(const Timing &timing) : blockQueue(64), transform(timing),
+        pendingOrder(0), pendingPeriod(0), lastBlock(0) {
+        pending.reserve(PENDING_CAPACITY);
+    }
+    void addEvent(Event *evt) {
+        eventBuffer.addEvent(evt);
+    }
+    void addBlock(PatternBlock *block) {
+        while(!blockQueue.push(block));
+    }
+    Event *getNextEvent(bool rolling, jack_position_t &pos, jack_nframes_t nframes);
+    void recycle(Event *evt);
+    void recycleRemaining();
+};
+
+}}
+
+#endif // MIDIBLOCK_H
@@ -0,0 +1,335 @@
+/*
+ * This file is part of Bipscript.
+ *
+ * Bipscript is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Bipscript is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Bipscript.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "midiclock.h"
+#include "audioengine.h"
+#include "tempomap.h"
+
+#include <cmath>
+#include <cstdlib>
+
+namespace bipscript {
+namespace midi {
+
+static const uint8_t CLOCK = 0xF8;
+static const uint8_t START = 0xFA;
+static const uint8_t CONTINUE = 0xFB;
+static const uint8_t STOP = 0xFC;
+static const uint8_t SONG_POSITION = 0xF2;
+static const uint8_t QUARTER_FRAME = 0xF1;
+
+// delay-locked loop coefficients for a bandwidth of 1/100 of the pulse rate
+static const double DLL_OMEGA = 2 * M_PI * 0.01;
+static const double DLL_B = std::sqrt(2.0) * DLL_OMEGA;
+static const double DLL_C = DLL_OMEGA * DLL_OMEGA;
+
+/**
+ * Send song position and continue at the start of the period, clock resumes
+ * on the next sixteenth note.
+ *
+ * Runs in the process thread. No allocations.
+ */
+void ClockOut::sendPosition(double pulse)
+{
+    uint64_t sixteenth = std::ceil(pulse / 6 - 1e-9);
+    if(sixteenth > 0x3FFF) {
+        sixteenth = 0x3FFF;
+    }
+    uint8_t position[3] = { SONG_POSITION, (uint8_t)(sixteenth & 0x7F), (uint8_t)(sixteenth >> 7) };
+    connection.add(0, position, 3);
+    connection.add(0, &CONTINUE, 1);
+    nextPulse = sixteenth * 6;
+}
+
+void ClockOut::doProcess(bool rolling, jack_position_t &pos, jack_nframes_t nframes, jack_nframes_t)
+{
+    connection.clear();
+    if(!rolling || !(pos.valid & JackPositionBBT)) {
+        if(wasRolling) {
+            connection.add(0, &STOP, 1);
+        }
+        wasRolling = false;
+        synced = false;
+        fireMidiEvents(pos);
+        return;
+    }
+    // position and pulse length in MIDI clocks
+    double pulses;
+    const transport::TempoMap *map = AudioEngine::instance().getTempoMap();
+    if(map) {
+        pulses = map->quarterOf(pos) * 24;
+    } else {
+        double beats = (pos.bar - 1) * pos.beats_per_bar + (pos.beat - 1) + pos.tick / pos.ticks_per_beat;
+        pulses = beats * 96 / pos.beat_type;
+    }
+    double framesPerPulse = pos.frame_rate * 60.0 / pos.beats_per_minute * pos.beat_type / 96;
+    if(!wasRolling) {
+        if(pulses < 0.5) {
+            connection.add(0, &START, 1);
+            nextPulse = 0;
+        } else {
+            sendPosition(pulses);
+        }
+    }
+    else if(!synced || std::fabs(pulses - expectedPulse) > 1) {
+        // relocated while rolling
+        connection.add(0, &STOP, 1);
+        sendPosition(pulses);
+    }
+    wasRolling = true;
+    synced = true;
+    // pulses due in this period
+    while(true) {
+        double offset = (nextPulse - pulses) * framesPerPulse;
+        if(offset >= nframes) {
+            break;
+        }
+        connection.add(offset > 0 ? offset : 0, &CLOCK, 1);
+        nextPulse++;
+    }
+    expectedPulse = pulses + nframes / framesPerPulse;
+    fireMidiEvents(pos);
+}
+
+ClockOut *ClockOutCache::getClockOut()
+{
+    int key = instanceCount++;
+    ClockOut *clock = findObject(key);
+    if(!clock) {
+        clock = new ClockOut();
+        registerObject(key, clock);
+    }
+    return clock;
+}
+
+void ClockIn::connectMidi(Source &source)
+{
+    if(source.getMidiOutputCount() == 0) {
+        throw std::logic_error("cannot connect: the source has no MIDI outputs");
+    }
+    midiInput.store(source.getMidiConnection(0));
+}
+
+/**
+ * Runs in the script thread.
+ */
+void ClockIn::reset(double bpm, float beatsPerBar, float beatUnit)
+{
+    master = transport::MasterCache::instance().getTransportMaster(bpm, beatsPerBar, beatUnit);
+}
+
+/**
+ * Runs in the process thread. No allocations.
+ */
+void ClockIn::clockPulse(jack_nframes_t now, jack_position_t &pos)
+{
+    jack_nframes_t elapsed = now - lastPulse;
+    lastPulse = now;
+    // first pulse or clock restarted after a gap
+    if(!pulsesSeen || elapsed > pos.frame_rate) {
+        pulsesSeen = 1;
+        return;
+    }
+    if(pulsesSeen == 1) {
+        period = elapsed;
+        base = now;
+        predicted = period;
+        pulsesSeen = 2;
+        return;
+    }
+    // filter the pulse time
+    double error = (jack_nframes_t)(now - base) - predicted;
+    double current = predicted;
+    predicted += DLL_B * error + period;
+    period += DLL_C * error;
+    jack_nframes_t shift = current;
+    base += shift;
+    predicted -= shift;
+    pulsesSeen++;
+    if(period <= 0) {
+        pulsesSeen = 0;
+        return;
+    }
+    // tempo in beats of the current meter
+    double beatType = (pos.valid & JackPositionBBT) ? pos.beat_type : 4;
+    double bpm = 60.0 * pos.frame_rate / (period * 24) * beatType / 4;
+    uint32_t pulsesPerBeat = 96 / beatType;
+    if(running && pulsesPerBeat * beatType == 96 && songPulse % pulsesPerBeat == 0) {
+        master->forceBeat(bpm);
+    } else {
+        master->setBpm(bpm);
+    }
+    if(running) {
+        songPulse++;
+    }
+}
+
+/**
+ * Relocates to the song position pointer, following the tempo map when there
+ * is one and the current tempo otherwise.
+ *
+ * Runs in the process thread. No allocations.
+ */
+void ClockIn::songPosition(const ConnectionEvent &evt, jack_position_t &pos)
+{
+    uint32_t sixteenths = evt.data[1] | (evt.data[2] << 7);
+    songPulse = sixteenths * 6;
+    const transport::TempoMap *map = AudioEngine::instance().getTempoMap();
+    if(map) {
+        AudioEngine::instance().transportRelocate(map->frameOfQuarter(sixteenths / 4.0));
+        return;
+    }
+    if(!(pos.valid & JackPositionBBT)) {
+        return;
+    }
+    double beats = sixteenths / 4.0 * pos.beat_type / 4;
+    AudioEngine::instance().transportRelocate(beats * 60 * pos.frame_rate / pos.beats_per_minute);
+}
+
+/**
+ * Time code position in frames.
+ */
+static jack_nframes_t timecodeFrame(uint8_t hours, uint8_t minutes, uint8_t seconds, uint8_t frames,
+                                    uint8_t rate, double offset, jack_nframes_t frameRate)
+{
+    static const double fps[4] = { 24, 25, 29.97, 30 };
+    double time = hours * 3600 + minutes * 60 + seconds + (frames + offset) / fps[rate & 3];
+    return time * frameRate;
+}
+
+/**
+ * Runs in the process thread. No allocations.
+ */
+void ClockIn::quarterFrame(uint8_t data, jack_nframes_t now, jack_nframes_t frame,
+                           jack_position_t &pos, bool rolling)
+{
+    uint8_t piece = data >> 4;
+    quarterFrames[piece & 7] = data & 0x0f;
+    quarterFrameMask |= 1 << (piece & 7);
+    lastTimecode = now;
+    chasing = true;
+    if(piece != 7 || quarterFrameMask != 0xff) {
+        return;
+    }
+    quarterFrameMask = 0;
+    if((int32_t)(now - holdUntil) < 0) {
+        return; // still relocating
+    }
+    // a complete time code is two frames old when the last piece arrives
+    jack_nframes_t target = timecodeFrame((quarterFrames[7] & 1) << 4 | quarterFrames[6],
+                                          (quarterFrames[5] & 3) << 4 | quarterFrames[4],
+                                          (quarterFrames[3] & 3) << 4 | quarterFrames[2],
+                                          (quarterFrames[1] & 1) << 4 | quarterFrames[0],
+                                          quarterFrames[7] >> 1, 2, pos.frame_rate);
+    AudioEngine &engine = AudioEngine::instance();
+    long drift = (long)target - (long)frame;
+    if(!rolling || std::labs(drift) > pos.frame_rate / 20) {
+        engine.transportRelocate(target);
+        holdUntil = now + pos.frame_rate / 2;
+    }
+    if(!rolling) {
+        engine.transportStart();
+    }
+}
+
+/**
+ * Full time code message: locate without starting.
+ *
+ * Runs in the process thread. No allocations.
+ */
+void ClockIn::fullFrame(const ConnectionEvent &evt, jack_position_t &pos)
+{
+    const uint8_t *data = evt.data;
+    if(evt.size != 10 || data[1] != 0x7F || data[3] != 0x01 || data[4] != 0x01) {
+        return;
+    }
+    AudioEngine::instance().transportRelocate(
+                timecodeFrame(data[5] & 0x1F, data[6], data[7], data[8], data[5] >> 5, 0, pos.frame_rate));
+}
+
+void ClockIn::doProcess(bool rolling, jack_position_t &pos, jack_nframes_t nframes, jack_nframes_t time)
+{
+    MidiConnection *connection = midiInput.load();
+    if(!connection) {
+        return;
+    }
+    connection->getSource()->process(rolling, pos, nframes, time);
+    AudioEngine &engine = AudioEngine::instance();
+    uint32_t eventCount = connection->getEventCount();
+    for(uint32_t i = 0; i < eventCount; i++) {
+        const ConnectionEvent &evt = connection->getEvent(i);
+        switch(evt.data[0]) {
+        case CLOCK:
+            clockPulse(time + evt.frame, pos);
+            break;
+        case START:
+            running = true;
+            songPulse = 0;
+            engine.transportRelocate(0);
+            engine.transportStart();
+            break;
+        case CONTINUE:
+            running = true;
+            engine.transportStart();
+            break;
+        case STOP:
+            running = false;
+            engine.transportStop();
+            break;
+        case SONG_POSITION:
+            if(evt.size == 3) {
+                songPosition(evt, pos);
+            }
+            break;
+        case QUARTER_FRAME:
+            if(evt.size == 2) {
+                quarterFrame(evt.data[1], time + evt.frame, pos.frame + evt.frame, pos, rolling);
+            }
+            break;
+        case 0xF0:
+            fullFrame(evt, pos);
+            break;
+        }
+    }
+    // time code stopped
+    if(chasing && time + nframes - lastTimecode > pos.frame_rate / 4) {
+        chasing = false;
+        quarterFrameMask = 0;
+        if(rolling) {
+            engine.transportStop();
+        }
+    }
+}
+
+/**
+ * One follower drives the transport master.
+ *
+ * Runs in the script thread.
+ */
+ClockIn *ClockInCache::getClockIn(float bpm, float beatsPerBar, float beatUnit)
+{
+    ClockIn *clock = findObject(1);
+    if(clock) {
+        clock->reset(bpm, beatsPerBar, beatUnit);
+    } else {
+        clock = new ClockIn(bpm, beatsPerBar, beatUnit);
+        registerObject(1, clock);
+    }
+    return clock;
+}
+
+}}
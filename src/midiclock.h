@@ -0,0 +1,157 @@
+/*
+ * This file is part of Bipscript.
+ *
+ * Bipscript is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Bipscript is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Bipscript.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef MIDICLOCK_H
+#define MIDICLOCK_H
+
+#include "midiconnection.h"
+#include "objectcache.h"
+#include "transportmaster.h"
+
+#include <atomic>
+
+namespace bipscript {
+namespace midi {
+
+/**
+ * Connection of a clock generator, refilled every period.
+ */
+class ClockConnection : public MidiConnection
+{
+public:
+    ClockConnection(Source *source) : MidiConnection(source) {}
+    void clear() {
+        events.clear();
+    }
+    void add(uint32_t frame, const uint8_t *data, size_t size) {
+        events.add(frame, data, size);
+    }
+};
+
+/**
+ * Generates MIDI clock (24 pulses per quarter note) from the jack BBT
+ * position, each pulse placed at its exact frame in the period.
+ *
+ * Sends start when the transport starts from the beginning, song position
+ * and continue when it starts anywhere else or relocates while rolling,
+ * and stop when it stops.
+ */
+class ClockOut : public Source
+{
+    ClockConnection connection;
+    bool wasRolling;
+    bool synced;
+    uint64_t nextPulse;
+    double expectedPulse;
+    void sendPosition(double pulse);
+public:
+    ClockOut() : connection(this), wasRolling(false), synced(false),
+        nextPulse(0), expectedPulse(0) {}
+    // Source interface
+    MidiConnection *getMidiConnection(unsigned int) {
+        return &connection;
+    }
+    unsigned int getMidiOutputCount() { return 1; }
+    bool connectsTo(AbstractSource *) { return false; }
+    // Processor interface
+    void doProcess(bool rolling, jack_position_t &pos, jack_nframes_t nframes, jack_nframes_t time);
+    void reposition() {
+        synced = false;
+    }
+};
+
+class ClockOutCache : public ProcessorCache<ClockOut>
+{
+    int instanceCount;
+    void scriptReset() {
+        instanceCount = 0;
+    }
+public:
+    ClockOutCache() : instanceCount(0) {}
+    static ClockOutCache &instance() {
+        static ClockOutCache instance;
+        return instance;
+    }
+    ClockOut *getClockOut();
+};
+
+/**
+ * Follows external MIDI clock and MIDI time code.
+ *
+ * Clock pulses go through a delay-locked loop to filter out jitter, the
+ * filtered tempo is set on the transport master and every beat is forced
+ * like the beat trackers do. Start, stop, continue and song position
+ * messages drive the transport.
+ *
+ * Time code chases the external position: the transport is started and
+ * relocated when it drifts too far and stopped when the time code stops.
+ */
+class ClockIn : public Processor
+{
+    transport::Master *master;
+    std::atomic<MidiConnection*> midiInput;
+    // clock
+    uint32_t pulsesSeen;
+    jack_nframes_t lastPulse;
+    jack_nframes_t base;
+    double predicted; // next pulse, frames after base
+    double period; // filtered frames per pulse
+    bool running;
+    uint64_t songPulse;
+    void clockPulse(jack_nframes_t now, jack_position_t &pos);
+    void songPosition(const ConnectionEvent &evt, jack_position_t &pos);
+    // time code
+    uint8_t quarterFrames[8];
+    uint8_t quarterFrameMask;
+    bool chasing;
+    jack_nframes_t lastTimecode;
+    jack_nframes_t holdUntil;
+    void quarterFrame(uint8_t data, jack_nframes_t now, jack_nframes_t frame,
+                      jack_position_t &pos, bool rolling);
+    void fullFrame(const ConnectionEvent &evt, jack_position_t &pos);
+public:
+    ClockIn(double bpm, float beatsPerBar, float beatUnit)
+        : midiInput(0), pulsesSeen(0), lastPulse(0), base(0), predicted(0), period(0),
+          running(false), songPulse(0), quarterFrameMask(0), chasing(false),
+          lastTimecode(0), holdUntil(0) {
+        reset(bpm, beatsPerBar, beatUnit);
+    }
+    void connectMidi(Source &source);
+    void reset(double bpm, float beatsPerBar, float beatUnit);
+    // Processor interface
+    void doProcess(bool rolling, jack_position_t &pos, jack_nframes_t nframes, jack_nframes_t time);
+    void reposition() {}
+};
+
+class ClockInCache : public ProcessorCache<ClockIn>
+{
+public:
+    static ClockInCache &instance() {
+        static ClockInCache instance;
+        return instance;
+    }
+    ClockIn *getClockIn(float bpm, float beatsPerBar, float beatUnit);
+    ClockIn *getClockIn(float bpm, float beatsPerBar) {
+        return getClockIn(bpm, beatsPerBar, 4);
+    }
+    ClockIn *getClockIn(float bpm) {
+        return getClockIn(bpm, 4);
+    }
+};
+
+}}
+
+#endif // MIDICLOCK_H
@@ -18,6 +18,7 @@
 #define MIDICONNECTION_H
 
 #include <atomic>
+#include <cstring>
 #include <jack/types.h>
 #include "source.h"
 #include "midievent.h"
@@ -26,6 +27,7 @@
 #include "bindmidi.h"
 #include "bindtransport.h"
 #include "timeposition.h"
+#include "lockedbuffer.h"
 
 namespace bipscript {
 namespace midi {
@@ -72,6 +74,77 @@ public:
       : EventClosure(function), noteOff(noteOff), position(position) {}
 };
 
+/**
+ * A MIDI message on a connection in the current period. The message bytes
+ * live in the arena of the connection and are valid until the next period.
+ */
+struct ConnectionEvent {
+    uint32_t frame;
+    uint32_t size;
+    const uint8_t *data;
+    uint8_t getType() const {
+        return data[0] & 0xf0;
+    }
+    uint8_t getChannel() const {
+        return data[0] & 0x0f;
+    }
+    uint8_t getDatabyte1() const {
+        return size > 1 ? data[1] : 0;
+    }
+    uint8_t getDatabyte2() const {
+        return size > 2 ? data[2] : 0;
+    }
+    bool matches(uint8_t type) const {
+        return getType() == type;
+    }
+};
+
+/**
+ * The messages of one connection for the current period: decoded once by the
+ * connection and read by index by every consumer.
+ *
+ * Messages of any length (including complete sysex) are stored back to back
+ * in a fixed byte arena, nothing is allocated per message. The event and
+ * byte storage is locked and pre-faulted when the connection is created.
+ */
+class EventArray
+{
+public:
+    static const uint32_t CAPACITY = 1024;
+    static const uint32_t ARENA_SIZE = 65536;
+private:
+    LockedBuffer<ConnectionEvent> events;
+    LockedBuffer<uint8_t> arena;
+    uint32_t count;
+    uint32_t used;
+public:
+    EventArray() : events(CAPACITY), arena(ARENA_SIZE), count(0), used(0) {}
+    void clear() {
+        count = 0;
+        used = 0;
+    }
+    /**
+     * Runs in the process thread. No allocations.
+     */
+    void add(uint32_t frame, const uint8_t *data, size_t size) {
+        if(count == CAPACITY || !size || size > ARENA_SIZE - used) {
+            return;
+        }
+        ConnectionEvent &evt = events[count++];
+        evt.frame = frame;
+        evt.size = size;
+        evt.data = arena.data() + used;
+        std::memcpy(arena.data() + used, data, size);
+        used += size;
+    }
+    uint32_t size() {
+        return count;
+    }
+    const ConnectionEvent &get(uint32_t i) {
+        return events[i];
+    }
+};
+
 class Source;
 
 class MidiConnection {
@@ -80,13 +153,19 @@ class MidiConnection {
     std::atomic<ScriptFunction*> onControlHandler;
     std::atomic<ScriptFunction*> onNoteOnHandler;
     std::atomic<ScriptFunction*> onNoteOffHandler;
+protected:
+    EventArray events; // written by the connection in its process step
 public:
     MidiConnection(Source *source) :
       source(source), handlerDefined(false), onControlHandler(0),
       onNoteOnHandler(0), onNoteOffHandler(0) {}
     Source *getSource() { return source; }
-    virtual uint32_t getEventCount() = 0;
-    virtual Event *getEvent(uint32_t i) = 0;
+    uint32_t getEventCount() {
+        return events.size();
+    }
+    const ConnectionEvent &getEvent(uint32_t i) {
+        return events.get(i);
+    }
     void onControl(ScriptFunction &handler) {
         if(handler.getNumargs() != 3) {
             throw std::logic_error("onControl handler should take two arguments");
@@ -113,21 +192,21 @@ public:
             ScriptFunction *ccHandler = onControlHandler.load();
             ScriptFunction *onHandler = onNoteOnHandler.load();
             ScriptFunction *offHandler = onNoteOffHandler.load();
-            for(int j = 0; j < getEventCount(); j++) {
-                Event *evt = getEvent(j);
-                if(evt->getType() == Event::TYPE_CONTROL && ccHandler) {
-                    transport::TimePosition position(pos, evt->getFrameOffset());
-                    Control control(evt->getDatabyte1(), evt->getDatabyte2());
+            for(uint32_t j = 0; j < events.size(); j++) {
+                const ConnectionEvent &evt = events.get(j);
+                if(evt.matches(Event::TYPE_CONTROL) && ccHandler) {
+                    transport::TimePosition position(pos, evt.frame);
+                    Control control(evt.getDatabyte1(), evt.getDatabyte2());
                     (new MidiControlEventClosure(*ccHandler, control, position))->dispatch();
                 }
-                else if(evt->getType() == Event::TYPE_NOTE_ON && onHandler) {
-                    transport::TimePosition position(pos, evt->getFrameOffset());
-                    NoteOn noteOn(evt->getDatabyte1(), evt->getDatabyte2());
+                else if(evt.matches(Event::TYPE_NOTE_ON) && onHandler) {
+                    transport::TimePosition position(pos, evt.frame);
+                    NoteOn noteOn(evt.getDatabyte1(), evt.getDatabyte2());
                     (new MidiNoteOnEventClosure(*onHandler, noteOn, position))->dispatch();
                 }
-                else if(evt->getType() == Event::TYPE_NOTE_OFF && offHandler) {
-                    transport::TimePosition position(pos, evt->getFrameOffset());
-                    NoteOff noteOff(evt->getDatabyte1(), evt->getDatabyte2());
+                else if(evt.matches(Event::TYPE_NOTE_OFF) && offHandler) {
+                    transport::TimePosition position(pos, evt.frame);
+                    NoteOff noteOff(evt.getDatabyte1(), evt.getDatabyte2());
                     (new MidiNoteOffEventClosure(*offHandler, noteOff, position))->dispatch();
                 }
             }
@@ -174,6 +253,9 @@ public:
         }
         connection.store(conn);
     }
+    void disconnect() {
+        connection.store(0);
+    }
     MidiConnection *getConnection() {
         return connection.load();
     }
@@ -17,20 +17,20 @@
 
 #include "midievent.h"
 
+#include <cstring>
+
 //int Event::refCount = 0;
 //std::set<Event*> Event::refSet;
 
 namespace bipscript {
 namespace midi {
 
-Event::Event(const Event &other) :
-    bipscript::Event(other), type(other.type),
-    databyte1(other.databyte1),
-    databyte2(other.databyte2),
-    channel(other.channel) {}
-
 Event::Event(Position &position, int n, int vel, int t, unsigned char ch)
-    : bipscript::Event(position), type(t), databyte1(n), databyte2(vel), channel(ch)  {}
+    : bipscript::Event(position), type(t), databyte1(n), databyte2(vel),
+      shifted(false), shift(0), channel(ch)  {}
+
+SysExEvent::SysExEvent(Position &position, const std::vector<uint8_t> &data)
+    : Event(position, 0, 0, TYPE_SYSEX, 0), data(data) {}
 
 
 uint8_t Event::dataSize() {
@@ -41,8 +41,26 @@ uint8_t Event::dataSize() {
     return 2;
 }
 
+/**
+ * Complete message of a system exclusive event.
+ */
+const std::vector<uint8_t> &Event::getSysex() {
+    return static_cast<SysExEvent*>(this)->getData();
+}
+
+uint32_t Event::messageSize() {
+    return type == TYPE_SYSEX ? getSysex().size() : dataSize() + 1;
+}
+
+/**
+ * Write the message to the given space, which must hold messageSize() bytes.
+ */
 void Event::pack(void *space) {
     unsigned char *buffer = (unsigned char*)space;
+    if(type == TYPE_SYSEX) {
+        std::memcpy(buffer, getSysex().data(), getSysex().size());
+        return;
+    }
     buffer[0] = this->type + this->channel;
     buffer[1] = this->databyte1;
     if(dataSize() == 2) {
@@ -50,18 +68,6 @@ void Event::pack(void *space) {
     }
 }
 
-void Event::unpack(const uint8_t *buffer, size_t size)
-{
-    this->type = buffer[0] & 0xf0;
-    this->channel = buffer[0] & 0x0f;
-    if(size > 1) {
-        this->databyte1 = buffer[1];
-    }
-    if(size > 2) {
-        this->databyte2 = buffer[2];
-    }
-}
-
 bool Event::matches(int type) { // TODO: what about channels
     return type == this->type;
 }
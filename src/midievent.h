@@ -19,6 +19,8 @@
 
 #include "event.h"
 
+#include <vector>
+
 namespace bipscript {
 namespace midi {
 
@@ -27,15 +29,17 @@ class Event : public bipscript::Event
     unsigned char type;
     unsigned char databyte1;
     unsigned char databyte2;
+    bool shifted;
+    int32_t shift; // timing transform in frames, fixed once drawn
 public:
     static const unsigned char TYPE_NOTE_OFF = 0x80;
     static const unsigned char TYPE_NOTE_ON = 0x90;
     static const unsigned char TYPE_CONTROL = 0xB0;
     static const unsigned char TYPE_PITCH_BEND = 0xE0;
+    static const unsigned char TYPE_SYSEX = 0xF0;
     uint8_t channel;
-    Event() : bipscript::Event(1, 1, 1) {}
+    Event() : bipscript::Event(1, 1, 1), shifted(false), shift(0) {}
     Event(Position &position, int databyte1, int databyte2, int type, unsigned char channel);
-    Event(const Event&);
     friend std::ostream& operator<< (std::ostream &out, Event &evt);
     void setPosition(int bar, int position, int division) {
         Position(bar, position, division);
@@ -56,12 +60,38 @@ public:
         return type;
     }
     uint8_t dataSize();
+    const std::vector<uint8_t> &getSysex();
+    uint32_t messageSize();
     void pack(void *buffer);
-    void unpack(const uint8_t *buffer, size_t size);
+    bool hasShift() {
+        return shifted;
+    }
+    int32_t getShift() {
+        return shift;
+    }
+    void setShift(int32_t frames) {
+        shift = frames;
+        shifted = true;
+    }
     bool matches(int type);
     bool matches(int type, int databyte1, int low, int high);
 };
 
+/**
+ * A scheduled system exclusive message. The payload is kept out of the
+ * common event so pattern blocks and channel messages stay small; it is
+ * only ever handled by pointer and deleted by the script collector.
+ */
+class SysExEvent : public Event
+{
+    std::vector<uint8_t> data; // complete message including framing bytes
+public:
+    SysExEvent(Position &position, const std::vector<uint8_t> &data);
+    const std::vector<uint8_t> &getData() {
+        return data;
+    }
+};
+
 }}
 
 #endif // MIDIEVENT_H
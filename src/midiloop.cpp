@@ -0,0 +1,248 @@
+/*
+ * This file is part of Bipscript.
+ *
+ * Bipscript is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Bipscript is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Bipscript.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "midiloop.h"
+#include "objectcollector.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace bipscript {
+namespace midi {
+
+struct LoopStep {
+    uint32_t tick;
+    bool on;
+    uint32_t index;
+};
+
+static bool stepBefore(const LoopStep &one, const LoopStep &other)
+{
+    if(one.tick != other.tick) {
+        return one.tick < other.tick;
+    }
+    return !one.on && other.on;
+}
+
+/**
+ * Compile a pattern for a loop of the given length.
+ *
+ * Runs in the script thread.
+ *
+ * Allocates the event arrays, notes starting at or after the loop end and
+ * notes of zero length are dropped.
+ */
+LoopClip::LoopClip(Pattern &pattern, uint32_t length, unsigned char channel, uint32_t generation)
+    : generation(generation)
+{
+    std::vector<LoopStep> steps;
+    steps.reserve(pattern.size() * 2);
+    for(uint32_t i = 0; i < pattern.size(); i++) {
+        uint32_t start = pattern.startTick(i);
+        if(start >= length) {
+            continue;
+        }
+        uint32_t end = std::min<uint64_t>((uint64_t)start + pattern.durationTick(i), length);
+        if(end == start) {
+            // the off would sort ahead of the on and leave the note hanging
+            continue;
+        }
+        steps.push_back(LoopStep{start, true, i});
+        steps.push_back(LoopStep{end, false, i});
+    }
+    std::stable_sort(steps.begin(), steps.end(), stepBefore);
+    ticks.reserve(steps.size());
+    status.reserve(steps.size());
+    pitches.reserve(steps.size());
+    velocities.reserve(steps.size());
+    for(auto it = steps.begin(); it != steps.end(); it++) {
+        ticks.push_back(it->tick);
+        status.push_back((it->on ? Event::TYPE_NOTE_ON : Event::TYPE_NOTE_OFF) | (channel - 1));
+        pitches.push_back(pattern.pitch(it->index));
+        velocities.push_back(it->on ? pattern.velocity(it->index) : 0);
+    }
+}
+
+Loop::Loop(uint32_t bars)
+    : length(bars * Pattern::TICKS_PER_BAR), connection(this), pendingClip(0), generation(0), clip(0),
+      cursor(0), cycle(0), synced(false), expectedFrame(0)
+{
+    std::fill(sounding, sounding + 128, 0);
+}
+
+Loop::~Loop()
+{
+    delete pendingClip.load();
+    delete clip;
+}
+
+/**
+ * Stop playing on a cached loop before reuse, sounding notes are released by
+ * the process thread when it drops the playing clip.
+ *
+ * Runs in the script thread.
+ */
+void Loop::reset()
+{
+    generation++;
+    delete pendingClip.exchange(0);
+}
+
+/**
+ * Sets the pattern to play: immediately if nothing is playing yet, otherwise
+ * from the next loop boundary.
+ *
+ * Runs in the script thread.
+ */
+void Loop::play(Pattern &pattern, int channel)
+{
+    if(channel < 1 || channel > 16) {
+        throw std::logic_error("MIDI channel must be between 1 and 16");
+    }
+    // a pattern not yet picked up is replaced
+    delete pendingClip.exchange(new LoopClip(pattern, length, channel, generation.load()));
+}
+
+/**
+ * Points the cursor at the first event at or after the given tick.
+ *
+ * Runs in the process thread. No allocations.
+ */
+void Loop::locate(double tick)
+{
+    cycle = tick / length;
+    uint32_t offset = std::ceil(tick - (double)cycle * length);
+    cursor = std::lower_bound(clip->ticks.begin(), clip->ticks.end(), offset) - clip->ticks.begin();
+    synced = true;
+}
+
+/**
+ * Runs in the process thread. No allocations.
+ */
+void Loop::emit(uint8_t status, uint8_t pitch, uint8_t velocity, long frame)
+{
+    uint8_t type = status & 0xf0;
+    if(type == Event::TYPE_NOTE_ON) {
+        sounding[pitch] = (status & 0x0f) + 1;
+    }
+    else if(type == Event::TYPE_NOTE_OFF) {
+        sounding[pitch] = 0;
+    }
+    connection.add(status, pitch, velocity, frame);
+}
+
+/**
+ * Sends note offs for all sounding notes.
+ *
+ * Runs in the process thread. No allocations.
+ */
+void Loop::releaseNotes(long frame)
+{
+    for(uint8_t pitch = 0; pitch < 128; pitch++) {
+        if(sounding[pitch]) {
+            emit(Event::TYPE_NOTE_OFF | (sounding[pitch] - 1), pitch, 0, frame);
+        }
+    }
+}
+
+/**
+ * Runs in the process thread. No allocations.
+ */
+void Loop::doProcess(bool rolling, jack_position_t &pos, jack_nframes_t nframes, jack_nframes_t)
+{
+    connection.clear();
+    // clip from before a reset
+    if(clip && clip->generation != generation.load()) {
+        releaseNotes(0);
+        ObjectCollector::scriptCollector().recycle(clip);
+        clip = 0;
+    }
+    // first pattern starts right away
+    if(!clip) {
+        clip = pendingClip.exchange(0);
+        synced = false;
+    }
+    if(!rolling || !clip || !(pos.valid & JackPositionBBT)) {
+        releaseNotes(0);
+        synced = false;
+        fireMidiEvents(pos);
+        return;
+    }
+    // period start and speed in pattern ticks
+    const double barTicks = pos.beats_per_bar * pos.ticks_per_beat;
+    const double start = (pos.bar - 1) * (double)Pattern::TICKS_PER_BAR
+            + ((pos.beat - 1) * pos.ticks_per_beat + pos.tick) * Pattern::TICKS_PER_BAR / barTicks;
+    const double ticksPerFrame = pos.beats_per_minute * Pattern::TICKS_PER_BAR
+            / (60.0 * pos.frame_rate * pos.beats_per_bar);
+    // relocated or restarted
+    if(!synced || pos.frame != expectedFrame) {
+        releaseNotes(0);
+        locate(start);
+    }
+    expectedFrame = pos.frame + nframes;
+    // emit events due in this period
+    while(true) {
+        if(cursor == clip->size()) {
+            long frame = ((double)(cycle + 1) * length - start) / ticksPerFrame;
+            if(frame >= (long)nframes) {
+                break;
+            }
+            // loop boundary: pick up the next pattern
+            cycle++;
+            cursor = 0;
+            LoopClip *next = pendingClip.exchange(0);
+            if(next) {
+                releaseNotes(frame >= 0 ? frame : 0);
+                ObjectCollector::scriptCollector().recycle(clip);
+                clip = next;
+            }
+            continue;
+        }
+        long frame = ((double)cycle * length + clip->ticks[cursor] - start) / ticksPerFrame;
+        if(frame >= (long)nframes) {
+            break;
+        }
+        emit(clip->status[cursor], clip->pitches[cursor], clip->velocities[cursor], frame >= 0 ? frame : 0);
+        cursor++;
+    }
+    fireMidiEvents(pos);
+}
+
+Loop *LoopCache::getLoop(int bars)
+{
+    if(bars < 1) {
+        throw std::logic_error("Loop must be at least one bar long");
+    }
+    if((uint32_t)bars > UINT32_MAX / Pattern::TICKS_PER_BAR) {
+        throw std::logic_error("Loop is too long");
+    }
+    // count tells how many loops of this length
+    int count = instanceCount[bars];
+    instanceCount[bars] = count + 1;
+    // key for this loop instance
+    int key = (bars << 16) + count;
+    Loop *loop = findObject(key);
+    if(loop) {
+        loop->reset();
+    } else {
+        loop = new Loop(bars);
+        registerObject(key, loop);
+    }
+    return loop;
+}
+
+}}
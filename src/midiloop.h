@@ -0,0 +1,132 @@
+/*
+ * This file is part of Bipscript.
+ *
+ * Bipscript is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Bipscript is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Bipscript.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef MIDILOOP_H
+#define MIDILOOP_H
+
+#include "midiconnection.h"
+#include "midipattern.h"
+#include "objectcache.h"
+
+#include <atomic>
+#include <map>
+#include <vector>
+
+namespace bipscript {
+namespace midi {
+
+/**
+ * A pattern compiled for looping: the note on/off events of one loop cycle
+ * as parallel arrays sorted by tick, note offs ahead of note ons on the same
+ * tick. Note offs are clipped to the loop end so no note sounds across the
+ * loop boundary.
+ *
+ * Built in the script thread and read-only afterwards.
+ */
+class LoopClip : public Listable
+{
+public:
+    std::vector<uint32_t> ticks;
+    std::vector<uint8_t> status;
+    std::vector<uint8_t> pitches;
+    std::vector<uint8_t> velocities;
+    uint32_t generation; // loop generation the clip was played in
+    LoopClip(Pattern &pattern, uint32_t length, unsigned char channel, uint32_t generation);
+    uint32_t size() {
+        return ticks.size();
+    }
+};
+
+/**
+ * Connection of a loop, refilled every period.
+ */
+class LoopConnection : public MidiConnection
+{
+public:
+    LoopConnection(Source *source) : MidiConnection(source) {}
+    void clear() {
+        events.clear();
+    }
+    void add(uint8_t status, uint8_t pitch, uint8_t velocity, long frame) {
+        uint8_t data[3] = { status, pitch, velocity };
+        events.add(frame, data, 3);
+    }
+};
+
+/**
+ * Plays a pattern repeatedly, one cycle every given number of bars counting
+ * from bar 1.
+ *
+ * The pattern is compiled once and walked with a read cursor, nothing is
+ * allocated per cycle. A new pattern replaces the playing one at the next
+ * loop boundary.
+ *
+ * A reset starts a new generation; the process thread drops a clip from an
+ * older generation as soon as it sees it.
+ */
+class Loop : public Source
+{
+    const uint32_t length; // in pattern ticks
+    LoopConnection connection;
+    std::atomic<LoopClip*> pendingClip; // script thread -> process thread
+    std::atomic<uint32_t> generation;
+    LoopClip *clip; // local to process thread
+    uint32_t cursor;
+    uint64_t cycle;
+    bool synced;
+    jack_nframes_t expectedFrame;
+    uint8_t sounding[128]; // channel + 1 of the sounding note, zero if silent
+    void locate(double tick);
+    void emit(uint8_t status, uint8_t pitch, uint8_t velocity, long frame);
+    void releaseNotes(long frame);
+public:
+    Loop(uint32_t bars);
+    ~Loop();
+    void reset();
+    void play(Pattern &pattern, int channel);
+    void play(Pattern &pattern) {
+        play(pattern, 1);
+    }
+    // Source interface
+    MidiConnection *getMidiConnection(unsigned int) {
+        return &connection;
+    }
+    unsigned int getMidiOutputCount() { return 1; }
+    bool connectsTo(AbstractSource *) { return false; }
+    // Processor interface
+    void doProcess(bool rolling, jack_position_t &pos, jack_nframes_t nframes, jack_nframes_t time);
+    void reposition() {
+        synced = false;
+    }
+};
+
+class LoopCache : public ProcessorCache<Loop>
+{
+    std::map<int, int> instanceCount;
+    void scriptReset() {
+        instanceCount.clear();
+    }
+public:
+    static LoopCache &instance() {
+        static LoopCache instance;
+        return instance;
+    }
+    Loop *getLoop(int bars);
+};
+
+}}
+
+#endif // MIDILOOP_H
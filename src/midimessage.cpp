@@ -0,0 +1,59 @@
+/*
+ * This file is part of Bipscript.
+ *
+ * Bipscript is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Bipscript is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Bipscript.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "midimessage.h"
+#include "scripttypes.h"
+
+#include <stdexcept>
+
+namespace bipscript {
+namespace midi {
+
+/**
+ * System exclusive message from an array of byte values, the F0 and F7
+ * framing bytes are added if missing.
+ *
+ * Runs in the script thread.
+ */
+SysEx::SysEx(ScriptArray &bytes)
+{
+    uint32_t size = bytes.size();
+    data.reserve(size + 2);
+    for(uint32_t i = 0; i < size; i++) {
+        ScriptValue &value = bytes[i];
+        if(value.type != INTEGER) {
+            throw std::logic_error("sysex data should be integers");
+        }
+        bool first = i == 0 && value.intValue == 0xF0;
+        bool last = i == size - 1 && value.intValue == 0xF7;
+        if(!first && !last && (value.intValue < 0 || value.intValue > 0x7F)) {
+            throw std::logic_error("sysex data bytes must be between 0 and 127");
+        }
+        if(i == 0 && !first) {
+            data.push_back(0xF0);
+        }
+        data.push_back(value.intValue);
+    }
+    if(data.empty()) {
+        data.push_back(0xF0);
+    }
+    if(data.back() != 0xF7 || data.size() == 1) {
+        data.push_back(0xF7);
+    }
+}
+
+}}
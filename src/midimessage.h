@@ -17,14 +17,26 @@
 #ifndef MIDIMESSAGE_H
 #define MIDIMESSAGE_H
 
+#include <stdint.h>
+#include <vector>
+
+namespace bipscript {
+
+class ScriptArray;
+
+}
+
 namespace bipscript {
 namespace midi {
 
 class Message
 {
 public:
+  virtual ~Message() {}
   virtual char type() = 0;
   virtual char byte(char index) = 0;
+  // complete message for variable-length types, zero otherwise
+  virtual const std::vector<uint8_t> *sysexData() { return 0; }
 };
 
 class Control : public Message
@@ -96,6 +108,16 @@ public:
     char byte(char index) { return program; }
 };
 
+class SysEx : public Message
+{
+    std::vector<uint8_t> data;
+public:
+    SysEx(ScriptArray &bytes);
+    char type() { return 0xF0; }
+    char byte(char index) { return data[index + 1]; }
+    const std::vector<uint8_t> *sysexData() { return &data; }
+};
+
 }}
 
 #endif // MIDIMESSAGE_H
@@ -16,50 +16,274 @@
  */
 #include "midipattern.h"
 
+#include <cstdint>
 #include <sstream>
 
 namespace bipscript {
 namespace midi {
 
+PatternNote::PatternNote(Pattern *pattern, uint32_t index) :
+    Note(pattern->pitches[index], pattern->velocities[index], Pattern::tickDuration(pattern->durations[index])),
+    pattern(pattern), index(index)
+{
+    pattern->liveNotes.insert(this);
+}
+
+PatternNote::~PatternNote()
+{
+    if(pattern) {
+        pattern->liveNotes.erase(this);
+    }
+}
+
+/**
+ * Transposes the note as it currently is in the pattern, bulk transforms
+ * may have changed it since it was fetched.
+ */
+void PatternNote::transpose(int amount)
+{
+    if(pattern) {
+        value = pattern->pitches[index];
+    }
+    Note::transpose(amount);
+    if(pattern) {
+        pattern->pitches[index] = value;
+    }
+}
+
+uint8_t PatternNote::velocity(uint8_t velocity)
+{
+    Note::velocity(velocity);
+    if(pattern) {
+        pattern->velocities[index] = vel;
+    }
+    return velocity;
+}
+
+/**
+ * Replaces the notes, notes fetched from this pattern before no longer refer to it.
+ */
+Pattern &Pattern::operator=(const Pattern &other)
+{
+    if(&other != this) {
+        detachNotes();
+        pitches = other.pitches;
+        velocities = other.velocities;
+        starts = other.starts;
+        durations = other.durations;
+    }
+    return *this;
+}
+
+Pattern::~Pattern()
+{
+    detachNotes();
+}
+
+void Pattern::detachNotes()
+{
+    for(PatternNote *note : liveNotes) {
+        note->pattern = 0;
+    }
+    liveNotes.clear();
+}
+
+/**
+ * Converts a rational position or duration to ticks, rounding to the nearest tick.
+ */
+uint32_t Pattern::toTicks(unsigned int whole, unsigned int position, unsigned int division)
+{
+    uint64_t ticks = (uint64_t)whole * TICKS_PER_BAR
+            + ((uint64_t)position * TICKS_PER_BAR + division / 2) / division;
+    if(ticks > UINT32_MAX) {
+        throw std::logic_error("Note is too far from the pattern start");
+    }
+    return ticks;
+}
+
+/**
+ * Converts ticks to a duration, reduced to the smallest division.
+ */
+Duration Pattern::tickDuration(uint32_t ticks)
+{
+    uint32_t position = ticks % TICKS_PER_BAR;
+    uint32_t division = TICKS_PER_BAR;
+    uint32_t a = position, b = division;
+    while(b) {
+        uint32_t t = a % b;
+        a = b;
+        b = t;
+    }
+    if(a > 1) {
+        position /= a;
+        division /= a;
+    }
+    return Duration(ticks / TICKS_PER_BAR, position, division);
+}
+
+void Pattern::checkDivision(int division)
+{
+    if(division <= 0) {
+        throw std::logic_error("division must be greater than zero");
+    }
+}
+
 void Pattern::addNote(Note &note, int bar, int position, int division)
 {
     Position start(bar, position, division);
-    // std::cout << "adding note with duration " << note.duration << " to pattern at " << start << std::endl;
-    noteList.push_back(PatternNote(note, start));
+    addNote(note, start);
 }
 
 void Pattern::addNote(Note &note, Position &position) {
-    // std::cout << "adding note with duration " << note.duration << " to pattern at " << position << std::endl;
-    noteList.push_back(PatternNote(note, position));
+    pitches.push_back(note.pitch());
+    velocities.push_back(note.velocity());
+    starts.push_back(toTicks(position.getBar() - 1, position.getPosition(), position.getDivision()));
+    durations.push_back(toTicks(note.duration.getBar(), note.duration.getPosition(), note.duration.getDivision()));
 }
 
+void Pattern::reserve(uint32_t count)
+{
+    pitches.reserve(count);
+    velocities.reserve(count);
+    starts.reserve(count);
+    durations.reserve(count);
+}
+
+/**
+ * Returns the note at the given index, changes made through the returned note
+ * are written back to the pattern.
+ */
 Note *Pattern::getNote(uint32_t index) {
-    if(index >= noteList.size()) {
+    if(index >= pitches.size()) {
         std::string error("pattern has ");
-        error.append(std::to_string(index));
+        error.append(std::to_string(pitches.size()));
         error.append(" notes");
         throw std::logic_error(error);
     }
-    return noteList[index].getNote();
+    return new PatternNote(this, index);
 }
 
 std::string Pattern::print() {
     std::stringstream sstream;
-    sstream << noteList.size() << " events" << std::endl;
-    for(auto it = noteList.begin(); it != noteList.end(); it++) {
-        sstream << "N" << it->note.pitch();
-        sstream << " duration " << it->note.duration;
-        sstream << " " << it->position;
+    sstream << pitches.size() << " events" << std::endl;
+    for(uint32_t i = 0; i < pitches.size(); i++) {
+        Duration duration = tickDuration(durations[i]);
+        Duration offset = tickDuration(starts[i]);
+        Position position(offset.getBar() + 1, offset.getPosition(), offset.getDivision());
+        sstream << "N" << (unsigned int)pitches[i];
+        sstream << " duration " << duration;
+        sstream << " " << position;
         sstream << std::endl;
    }
     return sstream.str();
 }
 
+/**
+ * Transposes all notes, the pattern is unchanged if any note would leave the MIDI range.
+ */
 void Pattern::transpose(int amount)
 {
-    for(auto it = noteList.begin(); it != noteList.end(); it++) {
-        it->note.transpose(amount);
+    const uint32_t count = pitches.size();
+    uint8_t *pitch = pitches.data();
+    int low = 127, high = 0;
+    for(uint32_t i = 0; i < count; i++) {
+        low = pitch[i] < low ? pitch[i] : low;
+        high = pitch[i] > high ? pitch[i] : high;
+    }
+    if(count && low + amount < 0) {
+        throw std::logic_error("Cannot transpose this note that low");
+    }
+    if(count && high + amount > 127) {
+        throw std::logic_error("Cannot transpose this note that high");
+    }
+    for(uint32_t i = 0; i < count; i++) {
+        pitch[i] += amount;
+    }
+}
+
+/**
+ * Multiplies all velocities by the given factor, clamped to 1..127 so no note
+ * turns into a note off.
+ */
+void Pattern::scaleVelocity(float factor)
+{
+    if(factor < 0) {
+        throw std::logic_error("Velocity factor cannot be negative");
+    }
+    const uint32_t count = velocities.size();
+    uint8_t *velocity = velocities.data();
+    for(uint32_t i = 0; i < count; i++) {
+        float scaled = velocity[i] * factor + 0.5f;
+        scaled = scaled > 127 ? 127 : scaled;
+        scaled = scaled < 1 ? 1 : scaled;
+        velocity[i] = scaled;
+    }
+}
+
+/**
+ * Moves all notes by the given fraction of a bar, negative values move notes
+ * earlier; notes cannot be moved before the start of bar 1.
+ */
+void Pattern::shift(int position, int division)
+{
+    checkDivision(division);
+    int64_t delta = ((int64_t)position * TICKS_PER_BAR + (position < 0 ? -division : division) / 2) / division;
+    const uint32_t count = starts.size();
+    uint32_t *start = starts.data();
+    uint32_t earliest = UINT32_MAX, latest = 0;
+    for(uint32_t i = 0; i < count; i++) {
+        earliest = start[i] < earliest ? start[i] : earliest;
+        latest = start[i] > latest ? start[i] : latest;
+    }
+    if(count && (int64_t)earliest + delta < 0) {
+        throw std::logic_error("Cannot shift notes before the first bar");
+    }
+    if(count && (int64_t)latest + delta > UINT32_MAX) {
+        throw std::logic_error("Note is too far from the pattern start");
+    }
+    const uint32_t offset = delta; // wraps for negative delta
+    for(uint32_t i = 0; i < count; i++) {
+        start[i] += offset;
+    }
+}
+
+/**
+ * Moves each note start to the nearest multiple of 1/division bar.
+ */
+void Pattern::quantize(int division)
+{
+    checkDivision(division);
+    const uint32_t count = starts.size();
+    uint32_t *start = starts.data();
+    if(TICKS_PER_BAR % division == 0) {
+        const uint32_t grid = TICKS_PER_BAR / division;
+        for(uint32_t i = 0; i < count; i++) {
+            start[i] = (start[i] + grid / 2) / grid * grid;
+        }
+    } else {
+        // grid does not fall on ticks, snap to the nearest tick of the nearest step
+        for(uint32_t i = 0; i < count; i++) {
+            uint64_t step = ((uint64_t)start[i] * division + TICKS_PER_BAR / 2) / TICKS_PER_BAR;
+            start[i] = (step * TICKS_PER_BAR + division / 2) / division;
+        }
+    }
+}
+
+/**
+ * Appends all notes of the other pattern to this one.
+ */
+void Pattern::merge(Pattern &other)
+{
+    if(&other == this) {
+        Pattern copy(other);
+        merge(copy);
+        return;
     }
+    reserve(size() + other.size());
+    pitches.insert(pitches.end(), other.pitches.begin(), other.pitches.end());
+    velocities.insert(velocities.end(), other.velocities.begin(), other.velocities.end());
+    starts.insert(starts.end(), other.starts.begin(), other.starts.end());
+    durations.insert(durations.end(), other.durations.begin(), other.durations.end());
 }
 
-}}
\ No newline at end of file
+}}
@@ -21,33 +21,61 @@
 #include "eventlist.h"
 #include "midievent.h"
 
-#include <deque>
+#include <set>
+#include <vector>
 
 namespace bipscript {
 namespace midi {
 
-class PatternNote {
+class Pattern;
+
+/**
+ * A note fetched from a pattern by index, changes made through it are written
+ * back to the pattern. It becomes a plain note if the pattern is deleted first.
+ */
+class PatternNote : public Note
+{
     friend class Pattern;
-    Note note;
-    Position position;
+    Pattern *pattern;
+    uint32_t index;
 public:
-    PatternNote(Note &note, const Position &position)
-        : note(note), position(position) {}
-    const Position &getPosition() const {
-        return position;
-    }
-    const Note &getNoteRef() const {
-        return note;
-    }
-    Note *getNote() {
-        return &note;
-    }
+    PatternNote(Pattern *pattern, uint32_t index);
+    ~PatternNote();
+    void transpose(int amount);
+    using Note::velocity;
+    uint8_t velocity(uint8_t velocity);
 };
 
+/**
+ * A sequence of notes stored as parallel arrays so whole-pattern transforms
+ * run as flat loops over a single field.
+ *
+ * Start and duration are kept in ticks of TICKS_PER_BAR per bar, start tick
+ * zero being the beginning of bar 1; the resolution divides evenly by all
+ * divisions up to 10 and by powers of two up to 512 and their triplets, other
+ * divisions are rounded to the nearest tick.
+ */
 class Pattern
 {
-    std::deque<PatternNote> noteList;
+    friend class PatternNote;
+public:
+    static const uint32_t TICKS_PER_BAR = 161280; // 2^9 * 3^2 * 5 * 7
+private:
+    std::vector<uint8_t> pitches;
+    std::vector<uint8_t> velocities;
+    std::vector<uint32_t> starts;
+    std::vector<uint32_t> durations;
+    std::set<PatternNote*> liveNotes;
+    static uint32_t toTicks(unsigned int whole, unsigned int position, unsigned int division);
+    static void checkDivision(int division);
+    void detachNotes();
 public:
+    Pattern() {}
+    Pattern(const Pattern &other) : pitches(other.pitches), velocities(other.velocities),
+        starts(other.starts), durations(other.durations) {}
+    Pattern &operator=(const Pattern &other);
+    ~Pattern();
+    static Duration tickDuration(uint32_t ticks);
     // methods for notes
     void addNote(Note &note, int bar, int position, int division);
     void addNote(Note &note, int bar, int position) {
@@ -57,15 +85,40 @@ public:
         addNote(note, bar, 0);
     }
     void addNote(Note &note, Position &position);
+    void addNote(uint8_t pitch, uint8_t velocity, uint32_t startTick, uint32_t durationTick) {
+        pitches.push_back(pitch);
+        velocities.push_back(velocity);
+        starts.push_back(startTick);
+        durations.push_back(durationTick);
+    }
+    void reserve(uint32_t count);
     unsigned int size() {
-        return noteList.size();
+        return pitches.size();
     }
     Note *getNote(uint32_t index);
-    const PatternNote &get(unsigned int index) {
-        return noteList[index];
+    // raw access for compiling
+    uint8_t pitch(uint32_t index) const {
+        return pitches[index];
+    }
+    uint8_t velocity(uint32_t index) const {
+        return velocities[index];
+    }
+    uint32_t startTick(uint32_t index) const {
+        return starts[index];
+    }
+    uint32_t durationTick(uint32_t index) const {
+        return durations[index];
     }
     std::string print();
+    // bulk transforms
     void transpose(int amount);
+    void scaleVelocity(float factor);
+    void shift(int position, int division);
+    void shift(int position) {
+        shift(position, 4);
+    }
+    void quantize(int division);
+    void merge(Pattern &other);
 };
 
 }}
@@ -22,12 +22,116 @@
 namespace bipscript {
 namespace midi {
 
-Event *MidiInputConnection::getEvent(uint32_t i) {
-    jack_midi_event_t in_event;
-    jack_midi_event_get(&in_event, buffer, i);
-    lastEvent.unpack(in_event.buffer, in_event.size);
-    lastEvent.setFrameOffset(in_event.time);
-    return &lastEvent;
+/**
+ * Length of a message including the status byte, zero for sysex.
+ */
+static uint8_t statusLength(uint8_t status)
+{
+    switch(status & 0xf0) {
+    case 0xC0:
+    case 0xD0:
+        return 2;
+    case 0xF0:
+        switch(status) {
+        case 0xF0:
+            return 0;
+        case 0xF1:
+        case 0xF3:
+            return 2;
+        case 0xF2:
+            return 3;
+        }
+        return 1;
+    }
+    return 3;
+}
+
+/**
+ * Decode a raw byte stream into complete messages: fills in running status,
+ * reassembles sysex split over several jack events and passes realtime
+ * bytes through wherever they occur.
+ *
+ * Runs in the process thread. No allocations.
+ */
+void MidiInputConnection::decode(uint32_t frame, const uint8_t *bytes, size_t size)
+{
+    for(size_t i = 0; i < size; i++) {
+        uint8_t byte = bytes[i];
+        // realtime messages can appear anywhere
+        if(byte >= 0xF8) {
+            events.add(frame, &byte, 1);
+            continue;
+        }
+        // system exclusive
+        if(byte == 0xF0) {
+            sysex[0] = byte;
+            sysexSize = 1;
+            inSysex = true;
+            sysexOverflow = false;
+            runningStatus = 0;
+            messageCount = 0;
+            continue;
+        }
+        if(inSysex) {
+            if(byte < 0x80 || byte == 0xF7) {
+                if(sysexSize < EventArray::ARENA_SIZE) {
+                    sysex[sysexSize++] = byte;
+                } else {
+                    sysexOverflow = true;
+                }
+                if(byte == 0xF7) {
+                    if(!sysexOverflow) {
+                        events.add(frame, sysex.data(), sysexSize);
+                    }
+                    inSysex = false;
+                }
+                continue;
+            }
+            // unterminated sysex is dropped
+            inSysex = false;
+        }
+        if(byte >= 0x80) {
+            if(byte == 0xF7) {
+                continue; // stray end of exclusive
+            }
+            message[0] = byte;
+            messageCount = 1;
+            messageLength = statusLength(byte);
+            runningStatus = byte < 0xF0 ? byte : 0;
+        }
+        else {
+            if(!messageCount) {
+                if(!runningStatus) {
+                    continue; // data byte without status
+                }
+                message[0] = runningStatus;
+                messageCount = 1;
+                messageLength = statusLength(runningStatus);
+            }
+            message[messageCount++] = byte;
+        }
+        if(messageCount == messageLength) {
+            events.add(frame, message, messageLength);
+            messageCount = 0;
+        }
+    }
+}
+
+/**
+ * Decode the events of this period from the jack port.
+ *
+ * Runs in the process thread. No allocations.
+ */
+void MidiInputConnection::process(jack_nframes_t nframes) {
+    void *buffer = jack_port_get_buffer(jackPort, nframes);
+    events.clear();
+    uint32_t count = jack_midi_get_event_count(buffer);
+    for(uint32_t i = 0; i < count; i++) {
+        jack_midi_event_t in_event;
+        if(!jack_midi_event_get(&in_event, buffer, i)) {
+            decode(in_event.time, in_event.buffer, in_event.size);
+        }
+    }
 }
 
 MidiInputPort *MidiInputPortCache::getMidiInputPort(const char *name, const char *connectTo)
@@ -58,21 +162,56 @@ MidiOutputPort::~MidiOutputPort()
     AudioEngine::instance().unregisterPort(jackPort);
 }
 
-void MidiOutputPort::doProcess(bool rolling, jack_position_t &pos, jack_nframes_t nframes, jack_nframes_t) {
+void MidiOutputPort::doProcess(bool rolling, jack_position_t &pos, jack_nframes_t nframes, jack_nframes_t time) {
 
     // grab and clear the buffer for this port
     void* port_buf = jack_port_get_buffer(jackPort, nframes);
     jack_midi_clear_buffer(port_buf);
-    // schedule events that are waiting in the buffer
-    Event* nextEvent = buffer.getNextEvent(rolling, pos, nframes);
-    while(nextEvent) {
-        long frame = nextEvent->getFrameOffset();
-        size_t size = nextEvent->dataSize() + 1;
-        unsigned char* jackEvent = jack_midi_event_reserve(port_buf, frame >= 0 ? frame : 0, size);
-        nextEvent->pack(jackEvent);
-        ObjectCollector::scriptCollector().recycle(nextEvent);
-        nextEvent = buffer.getNextEvent(rolling, pos, nframes);
+    // release sounding notes on stop or reposition
+    if(activeNotes.releaseDue(rolling)) {
+        uint8_t release[3];
+        while(activeNotes.nextRelease(release)) {
+            jack_midi_event_write(port_buf, 0, release, 3);
+        }
+    }
+    // get connection and event count
+    MidiConnection *connection = midiInput.load();
+    uint32_t eventCount = 0;
+    if(connection) {
+        connection->getSource()->process(rolling, pos, nframes, time);
+        eventCount = connection->getEventCount();
+    }
+    // merge events waiting in the buffer with connection events
+    Event *bufferEvent = buffer.getNextEvent(rolling, pos, nframes);
+    uint32_t eventIndex = 0;
+    while(bufferEvent || eventIndex < eventCount) {
+        bool bufferNext = bufferEvent && (eventIndex == eventCount
+                || bufferEvent->getFrameOffset() <= (long)connection->getEvent(eventIndex).frame);
+        if(bufferNext) {
+            long frame = bufferEvent->getFrameOffset();
+            size_t size = bufferEvent->messageSize();
+            unsigned char* jackEvent = jack_midi_event_reserve(port_buf, frame >= 0 ? frame : 0, size);
+            if(jackEvent) {
+                bufferEvent->pack(jackEvent);
+                activeNotes.update(jackEvent, size);
+            }
+            buffer.recycle(bufferEvent);
+            bufferEvent = buffer.getNextEvent(rolling, pos, nframes);
+        } else {
+            const ConnectionEvent &evt = connection->getEvent(eventIndex++);
+            if(!jack_midi_event_write(port_buf, evt.frame, evt.data, evt.size)) {
+                activeNotes.update(evt.data, evt.size);
+            }
+        }
+    }
+}
+
+void MidiOutputPort::connectMidi(Source &source)
+{
+    if(source.getMidiOutputCount() == 0) {
+        throw std::logic_error("cannot connect: the source has no MIDI outputs");
     }
+    midiInput.store(source.getMidiConnection(0));
 }
 
 void MidiOutputPort::systemConnect(const char *connection) {
@@ -89,6 +228,7 @@ MidiOutputPort *MidiOutputPortCache::getMidiOutputPort(const char* portName, con
 {
     int key = std::hash<std::string>()(portName);
     // see if port already exists in map
+    bool used = usedInScript(key);
     MidiOutputPort *port = findObject(key);
     if(!port) {
         // create system port
@@ -98,6 +238,9 @@ MidiOutputPort *MidiOutputPortCache::getMidiOutputPort(const char* portName, con
         }
         port = new MidiOutputPort(jackPort);
         registerObject(key, port);
+    } else if(!used) {
+        // settings from the last run do not carry over
+        port->resetTiming();
     }
     if(connection) {
         port->systemConnect(connection);
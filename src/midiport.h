@@ -34,21 +34,25 @@ namespace midi {
 class MidiInputConnection : public MidiConnection
 {
     jack_port_t* jackPort;
-    void *buffer;
-    Event lastEvent;
+    // message being assembled, may continue across jack events
+    uint8_t message[3];
+    uint8_t messageCount;
+    uint8_t messageLength;
+    uint8_t runningStatus;
+    // sysex being assembled, may continue across periods
+    LockedBuffer<uint8_t> sysex;
+    uint32_t sysexSize;
+    bool inSysex;
+    bool sysexOverflow;
+    void decode(uint32_t frame, const uint8_t *bytes, size_t size);
 public:
     MidiInputConnection(Source *source, jack_port_t *jackPort)
-        : MidiConnection(source), jackPort(jackPort) {}
-    void process(jack_nframes_t nframes) {
-        buffer = jack_port_get_buffer(jackPort, nframes);
-    }
-    uint32_t getEventCount() {
-        return jack_midi_get_event_count(buffer);
-    }
+        : MidiConnection(source), jackPort(jackPort), messageCount(0), messageLength(0),
+          runningStatus(0), sysex(EventArray::ARENA_SIZE), sysexSize(0), inSysex(false), sysexOverflow(false) {}
+    void process(jack_nframes_t nframes);
     void systemConnect(const char *name) {
         AudioEngine::instance().connectPort(name, jackPort);
     }
-    Event *getEvent(uint32_t i);
 };
 
 class MidiInputPort : public Source
@@ -89,16 +93,23 @@ public:
 class MidiOutputPort : public Processor, public Sink
 {
     jack_port_t* jackPort;
-    EventBuffer<Event> buffer;
+    SinkBuffer buffer;
+    ActiveNotes activeNotes;
+    std::atomic<MidiConnection*> midiInput;
     std::string connected;
 public:
-    MidiOutputPort(jack_port_t *jackPort) : jackPort(jackPort) {}
+    MidiOutputPort(jack_port_t *jackPort) : jackPort(jackPort), buffer(timing), midiInput(0) {}
     ~MidiOutputPort();
     void systemConnect(const char *connection);
+    void connectMidi(Source &source);
     void addMidiEvent(Event* evt)  { buffer.addEvent(evt);}
+    void addPatternBlock(PatternBlock *block) { buffer.addBlock(block); }
     // Processor interface
     void doProcess(bool rolling, jack_position_t &pos, jack_nframes_t nframes, jack_nframes_t time);
-    void reposition() { buffer.recycleRemaining(); }
+    void reposition() {
+        buffer.recycleRemaining();
+        activeNotes.reposition();
+    }
 };
 
 class MidiOutputPortCache : public ProcessorCache<MidiOutputPort>
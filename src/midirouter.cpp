@@ -0,0 +1,271 @@
+/*
+ * This file is part of Bipscript.
+ *
+ * Bipscript is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Bipscript is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Bipscript.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "midirouter.h"
+
+#include <cmath>
+
+namespace bipscript {
+namespace midi {
+
+Router::Router() : buffer(timing), lower(this), upper(this)
+{
+    for(int channel = 0; channel < 16; channel++) {
+        for(int pitch = 0; pitch < 128; pitch++) {
+            routes[channel][pitch].active = false;
+        }
+    }
+    reset();
+}
+
+/**
+ * Restore the settings to pass everything through unchanged and drop the input
+ * connection.
+ *
+ * Runs in the script thread.
+ */
+void Router::reset()
+{
+    midiInput.disconnect();
+    resetTiming();
+    lowNote.store(0);
+    highNote.store(127);
+    splitNote.store(0);
+    transposition.store(0);
+    for(int i = 0; i < 128; i++) {
+        velocityMap[i].store(i);
+        controlMap[i].store(i);
+    }
+    for(int i = 0; i < 16; i++) {
+        channelMap[i].store(i);
+    }
+}
+
+void Router::connectMidi(Source &source)
+{
+    if(source.getMidiOutputCount() == 0) {
+        throw std::logic_error("cannot connect: the source has no MIDI outputs");
+    }
+    midiInput.setConnection(source.getMidiConnection(0), this);
+}
+
+/**
+ * Drop notes outside the given range.
+ */
+void Router::noteRange(int low, int high)
+{
+    if(low < 0 || high > 127 || low > high) {
+        throw std::logic_error("note range must be within 0 to 127");
+    }
+    lowNote.store(low);
+    highNote.store(high);
+}
+
+/**
+ * Send notes at or above the given note to the second output, zero for no split.
+ */
+void Router::split(int note)
+{
+    if(note < 0 || note > 127) {
+        throw std::logic_error("split note must be between 0 and 127");
+    }
+    splitNote.store(note);
+}
+
+void Router::transpose(int semitones)
+{
+    if(semitones < -127 || semitones > 127) {
+        throw std::logic_error("transpose must be between -127 and 127 semitones");
+    }
+    transposition.store(semitones);
+}
+
+/**
+ * Apply a power curve to note on velocities: above one softens, below one hardens.
+ */
+void Router::velocityCurve(float exponent)
+{
+    if(exponent <= 0) {
+        throw std::logic_error("velocity curve exponent must be greater than zero");
+    }
+    for(int i = 1; i < 128; i++) {
+        int velocity = std::round(127 * std::pow(i / 127.0, exponent));
+        velocityMap[i].store(velocity < 1 ? 1 : velocity);
+    }
+}
+
+void Router::mapChannel(int from, int to)
+{
+    if(from < 1 || from > 16 || to < 1 || to > 16) {
+        throw std::logic_error("MIDI channel must be between 1 and 16");
+    }
+    channelMap[from - 1].store(to - 1);
+}
+
+void Router::mapControl(int from, int to)
+{
+    if(from < 0 || from > 127 || to < 0 || to > 127) {
+        throw std::logic_error("control number must be between 0 and 127");
+    }
+    controlMap[from].store(to);
+}
+
+bool Router::connectsTo(AbstractSource *source)
+{
+    MidiConnection *connection = midiInput.getConnection();
+    if(!connection) {
+        return false;
+    }
+    Source *connSource = connection->getSource();
+    return connSource == source || connSource->connectsTo(source);
+}
+
+/**
+ * Runs in the process thread. No allocations.
+ */
+void Router::send(uint8_t output, uint32_t frame, const uint8_t *data, size_t size)
+{
+    (output ? upper : lower).add(frame, data, size);
+}
+
+/**
+ * Runs in the process thread. No allocations.
+ */
+void Router::routeNote(uint32_t frame, const uint8_t *data)
+{
+    uint8_t channel = data[0] & 0x0f;
+    NoteRoute &noteRoute = routes[channel][data[1]];
+    bool noteOn = (data[0] & 0xf0) == Event::TYPE_NOTE_ON && data[2];
+    // release the sounding note the way it was routed
+    if(noteRoute.active) {
+        uint8_t off[3] = { (uint8_t)(Event::TYPE_NOTE_OFF | noteRoute.channel),
+                           noteRoute.pitch, (uint8_t)(noteOn ? 0 : data[2]) };
+        send(noteRoute.output, frame, off, 3);
+        noteRoute.active = false;
+    }
+    if(!noteOn || data[1] < lowNote.load() || data[1] > highNote.load()) {
+        return;
+    }
+    int split = splitNote.load();
+    int pitch = data[1] + transposition.load();
+    if(pitch < 0 || pitch > 127) {
+        return;
+    }
+    noteRoute.active = true;
+    noteRoute.output = split && data[1] >= split;
+    noteRoute.channel = channelMap[channel].load();
+    noteRoute.pitch = pitch;
+    uint8_t on[3] = { (uint8_t)(Event::TYPE_NOTE_ON | noteRoute.channel),
+                      noteRoute.pitch, velocityMap[data[2]].load() };
+    send(noteRoute.output, frame, on, 3);
+}
+
+/**
+ * Runs in the process thread. No allocations.
+ */
+void Router::route(uint32_t frame, const uint8_t *data, size_t size)
+{
+    uint8_t type = data[0] & 0xf0;
+    if((type == Event::TYPE_NOTE_ON || type == Event::TYPE_NOTE_OFF) && size == 3) {
+        routeNote(frame, data);
+        return;
+    }
+    // system messages pass through unchanged
+    if(data[0] >= 0xf0) {
+        send(0, frame, data, size);
+        if(splitNote.load()) {
+            send(1, frame, data, size);
+        }
+        return;
+    }
+    if(size > 3) {
+        return;
+    }
+    uint8_t channel = data[0] & 0x0f;
+    uint8_t message[3] = { (uint8_t)(type | channelMap[channel].load()),
+                           size > 1 ? data[1] : (uint8_t)0, size > 2 ? data[2] : (uint8_t)0 };
+    if(type == Event::TYPE_CONTROL && size == 3) {
+        message[1] = controlMap[data[1]].load();
+    }
+    // polyphonic aftertouch follows its note
+    else if(type == 0xA0 && size == 3) {
+        NoteRoute &noteRoute = routes[channel][data[1]];
+        if(!noteRoute.active) {
+            return;
+        }
+        message[0] = type | noteRoute.channel;
+        message[1] = noteRoute.pitch;
+        send(noteRoute.output, frame, message, size);
+        return;
+    }
+    send(0, frame, message, size);
+    if(splitNote.load()) {
+        send(1, frame, message, size);
+    }
+}
+
+void Router::doProcess(bool rolling, jack_position_t &pos, jack_nframes_t nframes, jack_nframes_t time)
+{
+    lower.clear();
+    upper.clear();
+    // get connection and event count
+    MidiConnection *connection = midiInput.getConnection();
+    uint32_t eventCount = 0;
+    if(connection) {
+        connection->getSource()->process(rolling, pos, nframes, time);
+        eventCount = connection->getEventCount();
+    }
+    // merge scheduled events with connection events
+    Event *bufferEvent = buffer.getNextEvent(rolling, pos, nframes);
+    uint32_t eventIndex = 0;
+    while(bufferEvent || eventIndex < eventCount) {
+        bool bufferNext = bufferEvent && (eventIndex == eventCount
+                || bufferEvent->getFrameOffset() <= (long)connection->getEvent(eventIndex).frame);
+        if(bufferNext) {
+            long frame = bufferEvent->getFrameOffset();
+            uint32_t size = bufferEvent->messageSize();
+            if(size > 3) {
+                route(frame >= 0 ? frame : 0, bufferEvent->getSysex().data(), size);
+            } else {
+                uint8_t data[3];
+                bufferEvent->pack(data);
+                route(frame >= 0 ? frame : 0, data, size);
+            }
+            buffer.recycle(bufferEvent);
+            bufferEvent = buffer.getNextEvent(rolling, pos, nframes);
+        } else {
+            const ConnectionEvent &evt = connection->getEvent(eventIndex++);
+            route(evt.frame, evt.data, evt.size);
+        }
+    }
+    fireMidiEvents(pos);
+}
+
+Router *RouterCache::getRouter()
+{
+    int key = instanceCount++;
+    Router *router = findObject(key);
+    if(router) {
+        router->reset();
+    } else {
+        router = new Router();
+        registerObject(key, router);
+    }
+    return router;
+}
+
+}}
@@ -0,0 +1,124 @@
+/*
+ * This file is part of Bipscript.
+ *
+ * Bipscript is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Bipscript is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Bipscript.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef MIDIROUTER_H
+#define MIDIROUTER_H
+
+#include "midiconnection.h"
+#include "midisink.h"
+#include "objectcache.h"
+
+#include <atomic>
+
+namespace bipscript {
+namespace midi {
+
+/**
+ * Output connection of a router, refilled every period.
+ */
+class RouterConnection : public MidiConnection
+{
+public:
+    RouterConnection(Source *source) : MidiConnection(source) {}
+    void clear() {
+        events.clear();
+    }
+    void add(uint32_t frame, const uint8_t *data, size_t size) {
+        events.add(frame, data, size);
+    }
+};
+
+/**
+ * Transforms MIDI in the process thread: note filter, keyboard split,
+ * transpose, velocity curve, channel remap and control number remap.
+ *
+ * Input comes from a connected source and from events scheduled on the
+ * router itself. Notes below the split point (or all messages if there is
+ * no split) go to the first output, notes at or above it to the second;
+ * other messages go to both. The settings are changed from the script
+ * thread and read per message; note offs follow the route of their note on
+ * so changing the settings never leaves a note hanging.
+ */
+class Router : public Source, public Sink
+{
+    struct NoteRoute {
+        bool active;
+        uint8_t output;
+        uint8_t channel;
+        uint8_t pitch;
+    };
+    MidiConnector midiInput;
+    SinkBuffer buffer;
+    RouterConnection lower;
+    RouterConnection upper;
+    // settings: script thread -> process thread
+    std::atomic<int> lowNote;
+    std::atomic<int> highNote;
+    std::atomic<int> splitNote;
+    std::atomic<int> transposition;
+    std::atomic<uint8_t> velocityMap[128];
+    std::atomic<uint8_t> channelMap[16];
+    std::atomic<uint8_t> controlMap[128];
+    // local to process thread
+    NoteRoute routes[16][128];
+    void send(uint8_t output, uint32_t frame, const uint8_t *data, size_t size);
+    void route(uint32_t frame, const uint8_t *data, size_t size);
+    void routeNote(uint32_t frame, const uint8_t *data);
+public:
+    Router();
+    void reset();
+    void connectMidi(Source &source);
+    void noteRange(int low, int high);
+    void split(int note);
+    void transpose(int semitones);
+    void velocityCurve(float exponent);
+    void mapChannel(int from, int to);
+    void mapControl(int from, int to);
+    // Source interface
+    MidiConnection *getMidiConnection(unsigned int index) {
+        if(index > 1) {
+            throw std::logic_error("router has only two MIDI outputs");
+        }
+        return index ? &upper : &lower;
+    }
+    unsigned int getMidiOutputCount() { return 2; }
+    bool connectsTo(AbstractSource *source);
+    // Sink interface
+    void addMidiEvent(Event* evt)  { buffer.addEvent(evt);}
+    void addPatternBlock(PatternBlock *block) { buffer.addBlock(block); }
+    // Processor interface
+    void doProcess(bool rolling, jack_position_t &pos, jack_nframes_t nframes, jack_nframes_t time);
+    void reposition() { buffer.recycleRemaining(); }
+};
+
+class RouterCache : public ProcessorCache<Router>
+{
+    int instanceCount;
+    void scriptReset() {
+        instanceCount = 0;
+    }
+public:
+    RouterCache() : instanceCount(0) {}
+    static RouterCache &instance() {
+        static RouterCache instance;
+        return instance;
+    }
+    Router *getRouter();
+};
+
+}}
+
+#endif // MIDIROUTER_H
@@ -20,6 +20,85 @@
 namespace bipscript {
 namespace midi {
 
+/**
+ * Track a message written to the output.
+ *
+ * Runs in the process thread. No allocations.
+ */
+void ActiveNotes::update(const uint8_t *data, size_t size)
+{
+    if(size != 3) {
+        return;
+    }
+    uint8_t type = data[0] & 0xF0;
+    uint8_t channel = data[0] & 0x0F;
+    if(type == Event::TYPE_NOTE_ON || type == Event::TYPE_NOTE_OFF) {
+        uint8_t pitch = data[1] & 0x7F;
+        uint64_t bit = (uint64_t)1 << (pitch & 63);
+        if(type == Event::TYPE_NOTE_ON && data[2]) {
+            notes[channel][pitch >> 6] |= bit;
+            channels |= 1 << channel;
+        } else {
+            notes[channel][pitch >> 6] &= ~bit;
+        }
+    }
+    else if(type == Event::TYPE_CONTROL && data[1] == 64) {
+        if(data[2] >= 64) {
+            sustained |= 1 << channel;
+            channels |= 1 << channel;
+        } else {
+            sustained &= ~(1 << channel);
+        }
+    }
+}
+
+/**
+ * Returns true if the notes should be released at the start of this period:
+ * the transport has just stopped or a reposition was requested.
+ *
+ * Runs in the process thread. No allocations.
+ */
+bool ActiveNotes::releaseDue(bool rolling)
+{
+    bool due = releasePending || (wasRolling && !rolling);
+    wasRolling = rolling;
+    releasePending = false;
+    return due && channels;
+}
+
+/**
+ * Fills in the next note off (or sustain off) message and clears it from the
+ * map, returns false once nothing is left sounding.
+ *
+ * Runs in the process thread. No allocations.
+ */
+bool ActiveNotes::nextRelease(uint8_t *data)
+{
+    while(channels) {
+        uint8_t channel = __builtin_ctz(channels);
+        for(uint8_t word = 0; word < 2; word++) {
+            uint64_t bits = notes[channel][word];
+            if(bits) {
+                uint8_t bit = __builtin_ctzll(bits);
+                notes[channel][word] = bits & (bits - 1);
+                data[0] = Event::TYPE_NOTE_OFF | channel;
+                data[1] = word * 64 + bit;
+                data[2] = 0;
+                return true;
+            }
+        }
+        channels &= ~(1 << channel);
+        if(sustained & (1 << channel)) {
+            sustained &= ~(1 << channel);
+            data[0] = Event::TYPE_CONTROL | channel;
+            data[1] = 64;
+            data[2] = 0;
+            return true;
+        }
+    }
+    return false;
+}
+
 void Sink::scheduleNote(const Note &note, Position &position, unsigned char channel)
 {
     Event* evt = new Event(position, note.pitch(), note.velocity(), 0x90, channel - 1);
@@ -34,11 +113,8 @@ void Sink::schedule(Pattern &pattern, Position &position, unsigned char channel)
     if(channel < 1 || channel > 16) {
         throw std::logic_error("MIDI channel must be between 1 and 16");
     }
-    for(unsigned int i = 0; i < pattern.size(); i++) {
-        const PatternNote &note = pattern.get(i);
-        Position newPosition = position + note.getPosition();
-        newPosition.setBar(newPosition.getBar() - 1); // pattern bars 1-based
-        this->scheduleNote(note.getNoteRef(), newPosition, channel);
+    if(pattern.size()) {
+        addPatternBlock(new PatternBlock(pattern, position, channel));
     }
 }
 
@@ -47,7 +123,9 @@ void Sink::schedule(Message &mesg, Position &position, unsigned char channel)
     if(channel < 1 || channel > 16) {
         throw std::logic_error("MIDI channel must be between 1 and 16");
     }
-    Event* evt = new Event(position, mesg.byte(0), mesg.byte(1), mesg.type(), channel - 1);
+    const std::vector<uint8_t> *sysex = mesg.sysexData();
+    Event* evt = sysex ? new SysExEvent(position, *sysex)
+                       : new Event(position, mesg.byte(0), mesg.byte(1), mesg.type(), channel - 1);
     addMidiEvent(evt);
 }
 
@@ -21,12 +21,46 @@
 #include "midimessage.h"
 #include "midipattern.h"
 #include "midievent.h"
+#include "midiblock.h"
 
 namespace bipscript {
 namespace midi {
 
+/**
+ * Notes sounding on one MIDI output: a bitmap of 16 channels by 128 pitches
+ * plus the channels with the sustain pedal down.
+ *
+ * Updated in the process thread as messages are written out so exactly the
+ * needed note offs can be sent when the transport stops or relocates.
+ */
+class ActiveNotes
+{
+    uint64_t notes[16][2];
+    uint16_t channels; // channels with notes or sustain
+    uint16_t sustained;
+    bool wasRolling;
+    bool releasePending;
+public:
+    ActiveNotes() : channels(0), sustained(0), wasRolling(false), releasePending(false) {
+        for(int i = 0; i < 16; i++) {
+            notes[i][0] = notes[i][1] = 0;
+        }
+    }
+    void update(const uint8_t *data, size_t size);
+    /**
+     * Release all notes in the next period.
+     */
+    void reposition() {
+        releasePending = true;
+    }
+    bool releaseDue(bool rolling);
+    bool nextRelease(uint8_t *data);
+};
+
 class Sink {
     unsigned char defaultChannel;
+protected:
+    Timing timing;
 public:
     Sink() : defaultChannel(1) {}
     unsigned char midiChannel() {
@@ -84,7 +118,24 @@ public:
         schedule(mesg, bar, 0);
     }
     void schedule(Message &message, Position &position, unsigned char channel);
+    // timing transform
+    void quantize(int division, float strength) {
+        timing.quantize(division, strength);
+    }
+    void quantize(int division) {
+        quantize(division, 1);
+    }
+    void swing(int division, float amount) {
+        timing.swing(division, amount);
+    }
+    void humanize(float milliseconds) {
+        timing.humanize(milliseconds);
+    }
+    void resetTiming() {
+        timing.reset();
+    }
     virtual void addMidiEvent(Event* evt) = 0;
+    virtual void addPatternBlock(PatternBlock *block) = 0;
 private:
     void scheduleNote(const Note &note, Position &position, unsigned char channel);
 };
@@ -8,9 +8,13 @@ Pattern *Tune::track(uint32_t tracknum)
     if(!tracknum) {
         throw std::logic_error("there is no track zero");
     }
-    if(tracknum > numTracks) {
+    if(tracknum > tracks.size()) {
         throw std::logic_error("track number too high");
     }
+    if(!decoded[tracknum - 1]) {
+        source->decode(tracknum - 1, tracks[tracknum - 1]);
+        decoded[tracknum - 1] = true;
+    }
     return &tracks[tracknum - 1];
 }
 
@@ -3,32 +3,42 @@
 
 #include "midipattern.h"
 #include "timesignature.h"
+#include <memory>
 #include <string>
+#include <vector>
 
 namespace bipscript {
 namespace midi {
 
+/**
+ * Decodes the tracks of a tune on first access.
+ */
+class TrackSource
+{
+public:
+    virtual ~TrackSource() {}
+    virtual void decode(uint32_t track, Pattern &pattern) = 0;
+};
+
 class Tune
 {
     std::string title;
-    Pattern *tracks;
-    uint32_t numTracks;
+    std::vector<Pattern> tracks;
+    std::shared_ptr<TrackSource> source;
+    std::vector<bool> decoded;
     transport::TimeSignature timeSignature;
 public:
     Tune(uint32_t numTracks) :
-        numTracks(numTracks) {
-        tracks = new Pattern[numTracks];
-    }
-    ~Tune() {
-        delete[] tracks;
-    }
+        tracks(numTracks), decoded(numTracks, true) {}
+    Tune(uint32_t numTracks, TrackSource *source) :
+        tracks(numTracks), source(source), decoded(numTracks, false) {}
     void setTitle(const char *t) { title = t; }
     const char *getTitle() { return title.c_str(); }
     void addMidiNote(uint32_t tracknum, Note &note, Position &position) {
         tracks[tracknum].addNote(note, position);
     }
     uint32_t trackCount() {
-        return numTracks;
+        return tracks.size();
     }
     Pattern *track(uint32_t number);
     void setTimeSignature(float num, float denom) {
@@ -47,21 +47,17 @@ void MixerControlConnection::process(bool rolling, jack_position_t &pos, jack_nf
  */
 void MixerControlConnection::updateGains(jack_nframes_t frame, float **gain)
 {
-    if(eventCount && eventIndex < eventCount) {
-        midi::Event *nextEvent = connection->getEvent(eventIndex);
-        while(nextEvent && nextEvent->getFrameOffset() == frame) {
-            if(nextEvent->matches(midi::Event::TYPE_CONTROL)) {
-                // check mappings
-                MixerControlMapping *mapping = mappings.getFirst();
-                while(mapping) {
-                    if(mapping->cc == nextEvent->getDatabyte1()) {
-                        gain[mapping->input][mapping->output] = (float) nextEvent->getDatabyte2() / 127;
-                    }
-                    mapping = mappings.getNext(mapping);
+    while(eventIndex < eventCount && connection->getEvent(eventIndex).frame <= frame) {
+        const midi::ConnectionEvent &nextEvent = connection->getEvent(eventIndex++);
+        if(nextEvent.matches(midi::Event::TYPE_CONTROL)) {
+            // check mappings
+            MixerControlMapping *mapping = mappings.getFirst();
+            while(mapping) {
+                if(mapping->cc == nextEvent.getDatabyte1()) {
+                    gain[mapping->input][mapping->output] = (float) nextEvent.getDatabyte2() / 127;
                 }
+                mapping = mappings.getNext(mapping);
             }
-            // pull up next event
-            nextEvent = eventIndex < eventCount ? connection->getEvent(eventIndex++) : 0;
         }
     }
 }
@@ -25,6 +25,7 @@ namespace midi {
 
 class Note
 {
+protected:
     uint8_t vel;
     int value;
 public:
@@ -36,10 +37,11 @@ public:
         value(pitch), vel(velocity), duration(duration), channel(0) {}
     Note(int pitch, uint8_t velocity, int channel) :
         value(pitch), vel(velocity), duration(0, 0, 1), channel(channel) {}
+    virtual ~Note() {}
     unsigned int pitch() const {
         return value;
     }
-    void transpose(int amount) {
+    virtual void transpose(int amount) {
         int newval = value + amount;
         if(newval < 0) {
             throw std::logic_error("Cannot transpose this note that low");
@@ -52,7 +54,7 @@ public:
     uint8_t velocity() const {
         return vel;
     }
-    uint8_t velocity(uint8_t velocity) {
+    virtual uint8_t velocity(uint8_t velocity) {
         if(velocity > 127) {
             throw std::logic_error("Velocity value cannot be greater than 127");
         }
@@ -61,6 +61,13 @@ protected:
         }
         return ret;
     }
+    /**
+     * true if the object with this key was already found in this script run
+     */
+    bool usedInScript(int key) {
+        auto it = instanceMap.find(key);
+        return it != instanceMap.end() && activeScriptObjects.count(it->second);
+    }
     /**
      * add a new object with key
      */
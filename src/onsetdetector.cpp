@@ -15,19 +15,21 @@
  * along with Bipscript.  If not, see <http://www.gnu.org/licenses/>.
  */
 #include "onsetdetector.h"
-#include "audioengine.h"
+
+#include <algorithm>
+#include <cmath>
+#include <string>
 
 namespace bipscript {
 namespace audio {
 
 OnsetDetector::OnsetDetector() :
     odf(512,1024,ComplexSpectralDifferenceHWR,HanningWindow),
-    index(0), thold(1.0), lastOnsetFrame(0), audioInput(0)
+    index(0), history(MAX_HISTORY_SIZE), thold(1.0), historySize(HISTORY_SIZE),
+    interval(ONSET_INTERVAL), lastOnsetFrame(0), audioInput(0)
 {
-    buffer = new double[ONSET_HOP_SIZE];
-    for(int i = 0; i < HISTORY_SIZE; i++) {
-        history[i] = 0.0;
-    }
+    buffer = new float[2 * ONSET_HOP_SIZE]();
+    history.resize(HISTORY_SIZE, 0.0);
 }
 
 OnsetDetector::~OnsetDetector()
@@ -43,6 +45,46 @@ void OnsetDetector::onOnset(ScriptFunction &handler)
     onOnsetHandler.store(new ScriptFunction(handler));
 }
 
+/**
+ * Sets the minimum time between onsets.
+ *
+ * Runs in the script thread.
+ */
+float OnsetDetector::minInterval(float milliseconds)
+{
+    if(milliseconds < 0) {
+        throw std::logic_error("onset interval cannot be negative");
+    }
+    interval.store(milliseconds);
+    return milliseconds;
+}
+
+/**
+ * Sets how far above the median of recent detection function values a hop
+ * must be to count as an onset.
+ *
+ * Runs in the script thread.
+ */
+float OnsetDetector::threshold(float threshold)
+{
+    thold.store(threshold);
+    return threshold;
+}
+
+/**
+ * Sets the number of hops the detection function median is taken over.
+ *
+ * Runs in the script thread.
+ */
+int OnsetDetector::window(int hops)
+{
+    if(hops < 1 || hops > (int)MAX_HISTORY_SIZE) {
+        throw std::logic_error("onset window must be between 1 and " + std::to_string(MAX_HISTORY_SIZE));
+    }
+    historySize.store(hops);
+    return hops;
+}
+
 void OnsetDetector::reset()
 {    
     // TODO: implement type change?
@@ -51,6 +93,52 @@ void OnsetDetector::reset()
         delete onOnsetHandler;
         onOnsetHandler = 0;
     }
+    thold.store(1.0);
+    historySize.store(HISTORY_SIZE);
+    interval.store(ONSET_INTERVAL);
+}
+
+/**
+ * Locates the onset within the previous and current hop: the block where the
+ * short-term energy rises most, refined by parabolic interpolation of the
+ * rise around it. The analysis window tapers off at the newest samples so
+ * an onset is often detected a hop after it arrives.
+ *
+ * Returns the offset of the onset in frames from the start of the previous hop.
+ *
+ * Runs in the process thread. No allocations.
+ */
+double OnsetDetector::locateOnset()
+{
+    const unsigned int blocks = 2 * ONSET_HOP_SIZE / ONSET_BLOCK_SIZE;
+    float energy[blocks];
+    for(unsigned int block = 0; block < blocks; block++) {
+        float *samples = buffer + block * ONSET_BLOCK_SIZE;
+        float sum = 0;
+        for(unsigned int i = 0; i < ONSET_BLOCK_SIZE; i++) {
+            sum += samples[i] * samples[i];
+        }
+        energy[block] = sum;
+    }
+    // rise into each block
+    float rise[blocks];
+    rise[0] = 0;
+    unsigned int peak = 1;
+    for(unsigned int block = 1; block < blocks; block++) {
+        rise[block] = energy[block] - energy[block - 1];
+        if(rise[block] > rise[peak]) {
+            peak = block;
+        }
+    }
+    double delta = 0;
+    if(peak + 1 < blocks) {
+        double curvature = rise[peak - 1] - 2 * rise[peak] + rise[peak + 1];
+        if(curvature < 0) {
+            delta = 0.5 * (rise[peak - 1] - rise[peak + 1]) / curvature;
+            delta = std::max(-0.5, std::min(0.5, delta));
+        }
+    }
+    return (peak + delta) * ONSET_BLOCK_SIZE;
 }
 
 void OnsetDetector::doProcess(bool rolling, jack_position_t &pos, jack_nframes_t nframes, jack_nframes_t time)
@@ -65,40 +153,42 @@ void OnsetDetector::doProcess(bool rolling, jack_position_t &pos, jack_nframes_t
         audio = AudioConnection::getDummyBuffer();
     }
 
-    // add new audio to buffer
-    for(jack_nframes_t i = 0; i < nframes; i++) {
-        buffer[index++] = audio[i];
+    // pick up settings once per period
+    unsigned int window = historySize.load();
+    if(window != history.size()) {
+        history.resize(window, 0.0);
+    }
+    float fire = thold.load() * 150;
+    jack_nframes_t minFrames = interval.load() * pos.frame_rate / 1000;
+
+    // add new audio to buffer a hop at a time
+    for(jack_nframes_t i = 0; i < nframes; ) {
+        jack_nframes_t count = std::min(nframes - i, ONSET_HOP_SIZE - index);
+        std::copy(audio + i, audio + i + count, buffer + ONSET_HOP_SIZE + index);
+        index += count;
+        i += count;
         if(index == ONSET_HOP_SIZE) {
-            // calculate history median
-            double sorted[HISTORY_SIZE];
-            for(int i = 0; i < HISTORY_SIZE; i++) {
-                sorted[i] = history[i];
-            }
-            std::sort(sorted, sorted + HISTORY_SIZE);
-            double median = sorted[(HISTORY_SIZE / 2) + 1];
             // process full buffer
-            double onset = odf.calculateOnsetDetectionFunctionSample(buffer);
-            // calculate time since last onset
-            jack_nframes_t sampleRate = AudioEngine::instance().getSampleRate();
-            float delta = (time - lastOnsetFrame) / (float)sampleRate;
-            // fire if ready
-            // * onset above local median by threshold amount
-            // * long enough period elapsed since last onset
-            float fire = thold * 150;
-            if(onset - median >= fire && delta > 0.025) {
-                ScriptFunction *handler = onOnsetHandler.load();
-                if(handler) {
-                    // TODO: compute position from interpolation?
-                    transport::TimePosition position(pos);
-                    (new OnOnsetClosure(*handler, position))->dispatch();
+            double onset = odf.calculateOnsetDetectionFunctionSample(buffer + ONSET_HOP_SIZE);
+            if(onset - history.median() >= fire) {
+                // frame offset of the onset from the start of this period
+                long frameOffset = (long)i - 2 * ONSET_HOP_SIZE + std::lround(locateOnset());
+                jack_nframes_t onsetFrame = time + frameOffset;
+                // fire if ready
+                // * onset above local median by threshold amount
+                // * long enough period elapsed since last onset
+                if((jack_nframes_t)(onsetFrame - lastOnsetFrame) > minFrames) {
+                    ScriptFunction *handler = onOnsetHandler.load();
+                    if(handler) {
+                        transport::TimePosition position(pos, frameOffset);
+                        (new OnOnsetClosure(*handler, position))->dispatch();
+                    }
+                    lastOnsetFrame = onsetFrame;
                 }
-                lastOnsetFrame = time;
-            }
-            // shift history samples one unit down
-            for(int i = 0; i < HISTORY_SIZE - 1; i++) {
-                history[i] = history[i + 1];
             }
-            history[HISTORY_SIZE - 1] = onset;
+            history.push(onset);
+            // current hop becomes the previous
+            std::copy(buffer + ONSET_HOP_SIZE, buffer + 2 * ONSET_HOP_SIZE, buffer);
             index = 0;
         }
     }
@@ -110,10 +200,12 @@ void OnsetDetector::doProcess(bool rolling, jack_position_t &pos, jack_nframes_t
  */
 OnsetDetector *OnsetDetectorCache::getOnsetDetector()
 {
-    OnsetDetector *detector = findObject(1); // TODO: allow multiple?
+    // instances are keyed by the order they are created in the script
+    int key = instanceCount++;
+    OnsetDetector *detector = findObject(key);
     if(!detector) {
         detector = new OnsetDetector();
-        registerObject(1, detector);
+        registerObject(key, detector);
     } else {
         detector->reset();
     }
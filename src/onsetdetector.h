@@ -23,23 +23,30 @@
 #include "OnsetDetectionFunction.h"
 #include "timeposition.h"
 #include "bindtransport.h"
+#include "runningmedian.h"
 
 namespace bipscript {
 namespace audio {
 
 const unsigned int ONSET_HOP_SIZE = 512;
-const unsigned int HISTORY_SIZE = 8;
+const unsigned int HISTORY_SIZE = 8; // default median window in hops
+const unsigned int MAX_HISTORY_SIZE = 256;
+const float ONSET_INTERVAL = 25; // default minimum time between onsets in milliseconds
+const unsigned int ONSET_BLOCK_SIZE = 32; // resolution of the onset search before interpolation
 
 class OnsetDetector : public Processor
 {
     OnsetDetectionFunction odf;
     unsigned int index;
-    double *buffer;
-    double history[HISTORY_SIZE];
-    float thold;
+    float *buffer; // previous and current hop
+    math::RunningMedian history; // local to process thread
+    std::atomic<float> thold;
+    std::atomic<unsigned int> historySize;
+    std::atomic<float> interval;
     jack_nframes_t lastOnsetFrame;
     std::atomic<AudioConnection *> audioInput;
     std::atomic<ScriptFunction*> onOnsetHandler;
+    double locateOnset();
 public:
     OnsetDetector();
     ~OnsetDetector();
@@ -50,12 +57,18 @@ public:
     void connect(AudioConnection &connection) {
         this->audioInput.store(&connection);
     }
+    float minInterval() {
+        return interval.load();
+    }
+    float minInterval(float milliseconds);
     float threshold() {
-        return thold;
+        return thold.load();
     }
-    float threshold(float threshold) {
-        return thold = threshold;
+    float threshold(float threshold);
+    int window() {
+        return historySize.load();
     }
+    int window(int hops);
     void reset();
     void doProcess(bool rolling, jack_position_t &pos, jack_nframes_t nframes, jack_nframes_t time);
     void reposition() {}
@@ -72,7 +85,12 @@ public:
 
 class OnsetDetectorCache : public ProcessorCache<OnsetDetector>
 {
+    int instanceCount;
+    void scriptReset() {
+        instanceCount = 0;
+    }
 public:
+    OnsetDetectorCache() : instanceCount(0) {}
     static OnsetDetectorCache &instance() {
         static OnsetDetectorCache instance;
         return instance;
@@ -16,6 +16,8 @@
  */
 
 #include "position.h"
+#include "audioengine.h"
+#include "tempomap.h"
 #include <stdexcept>
 
 #include <iostream>
@@ -111,8 +113,18 @@ Position::Position(unsigned int bar, unsigned int position, unsigned int divisio
 }
 
 
+/**
+ * Frames from the given transport position to this one, following the
+ * tempo map when this process is the transport master.
+ *
+ * Runs in the process thread. No allocations.
+ */
 long Position::calculateFrameOffset(jack_position_t &pos)
 {
+    const transport::TempoMap *map = AudioEngine::instance().getTempoMap();
+    if(map && this->whole && (pos.valid & JackPositionBBT)) {
+        return map->frameOffset(*this, pos);
+    }
     // calculate event tick from position/division
     unsigned int evtTick = (this->position * pos.ticks_per_beat * pos.beats_per_bar) / this->division;
     // calculate event tick offset from pos
@@ -20,6 +20,7 @@
 #include <random>
 #include <time.h>
 #include <stdexcept>
+#include <cstdint>
 
 namespace bipscript {
 namespace math {
@@ -38,6 +39,29 @@ public:
     }
 };
 
+/**
+ * Fast random numbers for the process thread (xorshift32): no locks, no
+ * allocations and no shared state.
+ */
+class FastRandom
+{
+    uint32_t state;
+public:
+    FastRandom(uint32_t seed) : state(seed ? seed : 2463534242u) {}
+    uint32_t next() {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        return state;
+    }
+    /**
+     * Uniform in [-1, 1).
+     */
+    float bipolar() {
+        return next() * (2.0f / 4294967296.0f) - 1;
+    }
+};
+
 }}
 
 #endif // RANDOM_H
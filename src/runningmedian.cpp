@@ -0,0 +1,188 @@
+/*
+ * This file is part of Bipscript.
+ *
+ * Bipscript is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Bipscript is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Bipscript.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "runningmedian.h"
+
+#include <stdexcept>
+
+namespace bipscript {
+namespace math {
+
+RunningMedian::RunningMedian(unsigned int capacity)
+    : capacity(capacity), lowerSize(0), upperSize(0), windowSize(0), count(0), oldest(0)
+{
+    if(!capacity) {
+        throw std::logic_error("median capacity cannot be zero");
+    }
+    values = new double[capacity];
+    lower = new unsigned int[capacity];
+    upper = new unsigned int[capacity];
+    heapIndex = new int[capacity];
+}
+
+RunningMedian::~RunningMedian()
+{
+    delete[] values;
+    delete[] lower;
+    delete[] upper;
+    delete[] heapIndex;
+}
+
+void RunningMedian::place(bool inUpper, unsigned int position, unsigned int slot)
+{
+    if(inUpper) {
+        upper[position] = slot;
+        heapIndex[slot] = position + 1;
+    } else {
+        lower[position] = slot;
+        heapIndex[slot] = -(int)(position + 1);
+    }
+}
+
+void RunningMedian::siftUp(bool inUpper, unsigned int position)
+{
+    unsigned int *heap = inUpper ? upper : lower;
+    unsigned int slot = heap[position];
+    while(position) {
+        unsigned int parent = (position - 1) / 2;
+        if(!before(inUpper, slot, heap[parent])) {
+            break;
+        }
+        place(inUpper, position, heap[parent]);
+        position = parent;
+    }
+    place(inUpper, position, slot);
+}
+
+void RunningMedian::siftDown(bool inUpper, unsigned int position)
+{
+    unsigned int *heap = inUpper ? upper : lower;
+    unsigned int size = inUpper ? upperSize : lowerSize;
+    unsigned int slot = heap[position];
+    while(true) {
+        unsigned int child = 2 * position + 1;
+        if(child >= size) {
+            break;
+        }
+        if(child + 1 < size && before(inUpper, heap[child + 1], heap[child])) {
+            child++;
+        }
+        if(!before(inUpper, heap[child], slot)) {
+            break;
+        }
+        place(inUpper, position, heap[child]);
+        position = child;
+    }
+    place(inUpper, position, slot);
+}
+
+/**
+ * Removes and returns the top slot of a heap.
+ */
+unsigned int RunningMedian::pop(bool inUpper)
+{
+    unsigned int *heap = inUpper ? upper : lower;
+    unsigned int &size = inUpper ? upperSize : lowerSize;
+    unsigned int top = heap[0];
+    if(--size) {
+        place(inUpper, 0, heap[size]);
+        siftDown(inUpper, 0);
+    }
+    return top;
+}
+
+/**
+ * Keeps the upper heap the same size as the lower or one larger, so the
+ * median is always the top of the upper heap.
+ */
+void RunningMedian::balance()
+{
+    if(upperSize > lowerSize + 1) {
+        unsigned int slot = pop(true);
+        place(false, lowerSize++, slot);
+        siftUp(false, lowerSize - 1);
+    } else if(lowerSize > upperSize) {
+        unsigned int slot = pop(false);
+        place(true, upperSize++, slot);
+        siftUp(true, upperSize - 1);
+    }
+}
+
+void RunningMedian::insert(unsigned int slot)
+{
+    if(upperSize && values[slot] < values[upper[0]]) {
+        place(false, lowerSize++, slot);
+        siftUp(false, lowerSize - 1);
+    } else {
+        place(true, upperSize++, slot);
+        siftUp(true, upperSize - 1);
+    }
+    balance();
+}
+
+void RunningMedian::remove(unsigned int slot)
+{
+    bool inUpper = heapIndex[slot] > 0;
+    unsigned int *heap = inUpper ? upper : lower;
+    unsigned int &size = inUpper ? upperSize : lowerSize;
+    unsigned int position = (inUpper ? heapIndex[slot] : -heapIndex[slot]) - 1;
+    if(position != --size) {
+        unsigned int moved = heap[size];
+        place(inUpper, position, moved);
+        // the moved slot may belong above or below its new position
+        siftUp(inUpper, position);
+        siftDown(inUpper, (inUpper ? heapIndex[moved] : -heapIndex[moved]) - 1);
+    }
+    balance();
+}
+
+/**
+ * Sets the window size and fills the window with the given value.
+ *
+ * No allocations.
+ */
+void RunningMedian::resize(unsigned int size, double fill)
+{
+    if(!size || size > capacity) {
+        throw std::logic_error("median window out of range");
+    }
+    windowSize = size;
+    lowerSize = upperSize = count = oldest = 0;
+    for(unsigned int i = 0; i < size; i++) {
+        push(fill);
+    }
+}
+
+/**
+ * Adds a value, dropping the oldest once the window is full.
+ *
+ * No allocations.
+ */
+void RunningMedian::push(double value)
+{
+    unsigned int slot;
+    if(count < windowSize) {
+        slot = count++;
+    } else {
+        slot = oldest;
+        oldest = (oldest + 1) % windowSize;
+        remove(slot);
+    }
+    values[slot] = value;
+    insert(slot);
+}
+
+}}
@@ -0,0 +1,70 @@
+/*
+ * This file is part of Bipscript.
+ *
+ * Bipscript is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Bipscript is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Bipscript.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef RUNNINGMEDIAN_H
+#define RUNNINGMEDIAN_H
+
+namespace bipscript {
+namespace math {
+
+/**
+ * Median of the last n values pushed, for n up to a fixed capacity.
+ *
+ * The window is a ring buffer indexed into two heaps: a max-heap holding the
+ * lower half and a min-heap holding the upper half, so each push replaces the
+ * oldest value in O(log n). The median is the element at rank n/2, the upper
+ * median for even windows.
+ *
+ * Storage is allocated up front, push and resize do not allocate.
+ */
+class RunningMedian
+{
+    const unsigned int capacity;
+    double *values; // ring buffer
+    unsigned int *lower; // max-heap of ring slots
+    unsigned int *upper; // min-heap of ring slots
+    int *heapIndex; // per slot: position + 1 in upper, -(position + 1) in lower
+    unsigned int lowerSize;
+    unsigned int upperSize;
+    unsigned int windowSize;
+    unsigned int count;
+    unsigned int oldest;
+    bool before(bool inUpper, unsigned int one, unsigned int other) {
+        return inUpper ? values[one] < values[other] : values[one] > values[other];
+    }
+    void place(bool inUpper, unsigned int position, unsigned int slot);
+    void siftUp(bool inUpper, unsigned int position);
+    void siftDown(bool inUpper, unsigned int position);
+    void insert(unsigned int slot);
+    void remove(unsigned int slot);
+    unsigned int pop(bool inUpper);
+    void balance();
+public:
+    RunningMedian(unsigned int capacity);
+    ~RunningMedian();
+    void resize(unsigned int size, double fill);
+    void push(double value);
+    double median() {
+        return count ? values[upper[0]] : 0;
+    }
+    unsigned int size() {
+        return windowSize;
+    }
+};
+
+}}
+
+#endif // RUNNINGMEDIAN_H
@@ -0,0 +1,349 @@
+/*
+ * This file is part of Bipscript.
+ *
+ * Bipscript is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Bipscript is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Bipscript.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "smfreader.h"
+
+#include <fcntl.h>
+#include <memory>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace bipscript {
+namespace midi {
+
+static uint32_t readBig(const uint8_t *data, int bytes)
+{
+    uint32_t value = 0;
+    for(int i = 0; i < bytes; i++) {
+        value = (value << 8) | data[i];
+    }
+    return value;
+}
+
+/**
+ * Walks the events of one track chunk, keeping running status.
+ */
+class SMFTrackReader
+{
+    const uint8_t *pos;
+    const uint8_t *end;
+    uint8_t running;
+    uint8_t readByte() {
+        if(pos == end) {
+            throw std::logic_error("MIDI file track is truncated");
+        }
+        return *pos++;
+    }
+    uint32_t readVariable() {
+        uint32_t value = 0;
+        for(int i = 0; i < 4; i++) {
+            uint8_t byte = readByte();
+            value = (value << 7) | (byte & 0x7f);
+            if(!(byte & 0x80)) {
+                return value;
+            }
+        }
+        throw std::logic_error("MIDI file has an invalid variable length value");
+    }
+public:
+    uint32_t tick;
+    uint8_t status;
+    uint8_t data1;
+    uint8_t data2;
+    uint8_t metaType;
+    const uint8_t *metaData;
+    uint32_t metaLength;
+    SMFTrackReader(const uint8_t *data, uint32_t length)
+        : pos(data), end(data + length), running(0), tick(0) {}
+    /**
+     * Reads the next event, returns false at the end of the track.
+     */
+    bool next() {
+        if(pos == end) {
+            return false;
+        }
+        tick += readVariable();
+        uint8_t byte = readByte();
+        if(byte == 0xff) {
+            // meta events cancel running status
+            status = byte;
+            running = 0;
+            metaType = readByte();
+            metaLength = readVariable();
+            if(metaLength > (uint32_t)(end - pos)) {
+                throw std::logic_error("MIDI file track is truncated");
+            }
+            metaData = pos;
+            pos += metaLength;
+            return metaType != 0x2f; // end of track
+        }
+        if(byte == 0xf0 || byte == 0xf7) {
+            // sysex is skipped and cancels running status
+            status = byte;
+            running = 0;
+            uint32_t length = readVariable();
+            if(length > (uint32_t)(end - pos)) {
+                throw std::logic_error("MIDI file track is truncated");
+            }
+            pos += length;
+            return true;
+        }
+        if(byte & 0x80) {
+            status = running = byte;
+            data1 = readByte();
+        } else if(running) {
+            status = running;
+            data1 = byte;
+        } else {
+            throw std::logic_error("MIDI file has data without status");
+        }
+        uint8_t type = status & 0xf0;
+        data2 = (type == 0xc0 || type == 0xd0) ? 0 : readByte();
+        return true;
+    }
+};
+
+/**
+ * Maps the file and indexes its tracks.
+ *
+ * Runs in the script thread.
+ */
+SMFFile::SMFFile(const char *filename)
+    : name(filename), map(0), mapLength(0), numerator(4), denominator(4)
+{
+    int fd = open(filename, O_RDONLY);
+    if(fd < 0) {
+        throw std::logic_error("could not read file " + name);
+    }
+    struct stat info;
+    if(fstat(fd, &info) || info.st_size < 14) {
+        close(fd);
+        throw std::logic_error(name + " is not a MIDI file");
+    }
+    mapLength = info.st_size;
+    void *addr = mmap(0, mapLength, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if(addr == MAP_FAILED) {
+        throw std::logic_error("could not map file " + name);
+    }
+    map = static_cast<uint8_t*>(addr);
+    try {
+        indexChunks();
+        readMeter();
+    }
+    catch(...) {
+        munmap(map, mapLength);
+        throw;
+    }
+}
+
+SMFFile::~SMFFile()
+{
+    munmap(map, mapLength);
+}
+
+void SMFFile::indexChunks()
+{
+    if(readBig(map, 4) != 0x4d546864 || readBig(map + 4, 4) < 6) { // MThd
+        throw std::logic_error(name + " is not a MIDI file");
+    }
+    format = readBig(map + 8, 2);
+    uint16_t count = readBig(map + 10, 2);
+    division = readBig(map + 12, 2);
+    if(format > 1) {
+        throw std::logic_error("only MIDI file types 0 and 1 are supported");
+    }
+    if(division & 0x8000 || !division) {
+        throw std::logic_error("MIDI files with SMPTE timing are not supported");
+    }
+    size_t offset = 8 + readBig(map + 4, 4);
+    while(chunks.size() < count && offset + 8 <= mapLength) {
+        uint32_t type = readBig(map + offset, 4);
+        uint32_t length = readBig(map + offset + 4, 4);
+        offset += 8;
+        if(length > mapLength - offset) {
+            throw std::logic_error(name + " is truncated");
+        }
+        if(type == 0x4d54726b) { // MTrk, other chunks are skipped
+            chunks.push_back(TrackChunk{map + offset, length});
+        }
+        offset += length;
+    }
+    if(!chunks.size()) {
+        throw std::logic_error(name + " has no tracks");
+    }
+}
+
+/**
+ * Reads the title and time signature changes from the first track.
+ */
+void SMFFile::readMeter()
+{
+    uint32_t quarterTicks = division;
+    meter.push_back(MeterSegment{0, 1, quarterTicks * 4});
+    SMFTrackReader reader(chunks[0].data, chunks[0].length);
+    while(reader.next()) {
+        if(reader.status != 0xff) {
+            continue;
+        }
+        if(reader.metaType == 0x03 && title.empty()) {
+            title.assign((const char *)reader.metaData, reader.metaLength);
+        }
+        else if(reader.metaType == 0x58 && reader.metaLength >= 2) {
+            uint8_t num = reader.metaData[0];
+            uint8_t denom = 1 << reader.metaData[1];
+            if(!num || reader.metaData[1] > 6) {
+                continue;
+            }
+            MeterSegment &last = meter.back();
+            // a change always starts a new bar
+            uint32_t elapsed = reader.tick - last.tick;
+            uint32_t bar = last.bar + (elapsed + last.ticksPerBar - 1) / last.ticksPerBar;
+            MeterSegment segment{reader.tick, bar, quarterTicks * 4 * num / denom};
+            if(reader.tick == last.tick) {
+                last.ticksPerBar = segment.ticksPerBar;
+            } else {
+                meter.push_back(segment);
+            }
+            if(reader.tick == 0) {
+                numerator = num;
+                denominator = denom;
+            }
+        }
+    }
+}
+
+const SMFFile::MeterSegment &SMFFile::segmentAt(uint32_t tick)
+{
+    uint32_t i = meter.size() - 1;
+    while(i && meter[i].tick > tick) {
+        i--;
+    }
+    return meter[i];
+}
+
+/**
+ * Converts a file tick to a pattern tick counted from bar 1.
+ */
+uint32_t SMFFile::patternTick(uint32_t tick)
+{
+    const MeterSegment &segment = segmentAt(tick);
+    uint64_t elapsed = tick - segment.tick;
+    uint64_t bar = segment.bar - 1 + elapsed / segment.ticksPerBar;
+    uint64_t inBar = elapsed % segment.ticksPerBar;
+    uint64_t ret = bar * Pattern::TICKS_PER_BAR
+            + (inBar * Pattern::TICKS_PER_BAR + segment.ticksPerBar / 2) / segment.ticksPerBar;
+    return ret > UINT32_MAX ? UINT32_MAX : ret;
+}
+
+uint32_t SMFFile::patternDuration(uint32_t tick, uint32_t length)
+{
+    return patternTick(tick + length) - patternTick(tick);
+}
+
+/**
+ * Decodes the notes of one track into the pattern.
+ *
+ * Runs in the script thread.
+ */
+void SMFFile::decode(uint32_t track, Pattern &pattern)
+{
+    const TrackChunk &chunk = chunks[track];
+    // rough guess: a note on and a note off of three bytes plus delta each
+    pattern.reserve(pattern.size() + chunk.length / 8);
+    // start tick and velocity of sounding notes by channel and pitch
+    int64_t startTick[16][128];
+    uint8_t startVelocity[16][128];
+    for(int channel = 0; channel < 16; channel++) {
+        for(int pitch = 0; pitch < 128; pitch++) {
+            startTick[channel][pitch] = -1;
+        }
+    }
+    SMFTrackReader reader(chunk.data, chunk.length);
+    while(reader.next()) {
+        uint8_t type = reader.status & 0xf0;
+        uint8_t channel = reader.status & 0x0f;
+        if(type != Event::TYPE_NOTE_ON && type != Event::TYPE_NOTE_OFF) {
+            continue;
+        }
+        uint8_t pitch = reader.data1 & 0x7f;
+        int64_t &start = startTick[channel][pitch];
+        // retriggered notes end the sounding note
+        if(start >= 0) {
+            pattern.addNote(pitch, startVelocity[channel][pitch], patternTick(start),
+                            patternDuration(start, reader.tick - start));
+            start = -1;
+        }
+        if(type == Event::TYPE_NOTE_ON && reader.data2) {
+            start = reader.tick;
+            startVelocity[channel][pitch] = reader.data2 & 0x7f;
+        }
+    }
+    // notes still sounding end with the track
+    for(int channel = 0; channel < 16; channel++) {
+        for(int pitch = 0; pitch < 128; pitch++) {
+            int64_t start = startTick[channel][pitch];
+            if(start >= 0) {
+                pattern.addNote(pitch, startVelocity[channel][pitch], patternTick(start),
+                                patternDuration(start, reader.tick - start));
+            }
+        }
+    }
+}
+
+/**
+ * Reads one track (numbered from 1) of a MIDI file.
+ */
+Pattern *SMFReader::read(const char *file, int track)
+{
+    SMFFile smf(file);
+    if(track < 1 || (uint32_t)track > smf.trackCount()) {
+        throw std::logic_error("MIDI file has no track " + std::to_string(track));
+    }
+    std::unique_ptr<Pattern> pattern(new Pattern());
+    smf.decode(track - 1, *pattern);
+    return pattern.release();
+}
+
+/**
+ * Reads all tracks of a MIDI file into one pattern.
+ */
+Pattern *SMFReader::read(const char *file)
+{
+    SMFFile smf(file);
+    std::unique_ptr<Pattern> pattern(new Pattern());
+    for(uint32_t i = 0; i < smf.trackCount(); i++) {
+        smf.decode(i, *pattern);
+    }
+    return pattern.release();
+}
+
+/**
+ * Opens a MIDI file as a tune with one track per file track; the file stays
+ * mapped and each track is decoded when first asked for.
+ */
+Tune *SMFReader::readTune(const char *file)
+{
+    SMFFile *smf = new SMFFile(file);
+    Tune *tune = new Tune(smf->trackCount(), smf);
+    tune->setTitle(smf->getTitle().c_str());
+    tune->setTimeSignature(smf->getNumerator(), smf->getDenominator());
+    return tune;
+}
+
+}}
@@ -0,0 +1,92 @@
+/*
+ * This file is part of Bipscript.
+ *
+ * Bipscript is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Bipscript is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Bipscript.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef SMFREADER_H
+#define SMFREADER_H
+
+#include "miditune.h"
+
+#include <string>
+#include <vector>
+
+namespace bipscript {
+namespace midi {
+
+/**
+ * A standard MIDI file mapped into memory.
+ *
+ * Opening the file only indexes the track chunks and reads the time
+ * signatures of the first track; note data is decoded straight into pattern
+ * storage one track at a time when the track is asked for.
+ */
+class SMFFile : public TrackSource
+{
+    struct TrackChunk {
+        const uint8_t *data;
+        uint32_t length;
+    };
+    struct MeterSegment {
+        uint32_t tick;
+        uint32_t bar;
+        uint32_t ticksPerBar;
+    };
+    std::string name;
+    uint8_t *map;
+    size_t mapLength;
+    uint16_t format;
+    uint16_t division;
+    std::vector<TrackChunk> chunks;
+    std::vector<MeterSegment> meter;
+    std::string title;
+    uint8_t numerator;
+    uint8_t denominator;
+    void indexChunks();
+    void readMeter();
+    const MeterSegment &segmentAt(uint32_t tick);
+    uint32_t patternTick(uint32_t tick);
+    uint32_t patternDuration(uint32_t tick, uint32_t length);
+public:
+    SMFFile(const char *filename);
+    ~SMFFile();
+    uint32_t trackCount() {
+        return chunks.size();
+    }
+    uint16_t getFormat() {
+        return format;
+    }
+    const std::string &getTitle() {
+        return title;
+    }
+    uint8_t getNumerator() {
+        return numerator;
+    }
+    uint8_t getDenominator() {
+        return denominator;
+    }
+    void decode(uint32_t track, Pattern &pattern);
+};
+
+class SMFReader
+{
+public:
+    Pattern *read(const char *file, int track);
+    Pattern *read(const char *file);
+    Tune *readTune(const char *file);
+};
+
+}}
+
+#endif // SMFREADER_H
@@ -0,0 +1,265 @@
+/*
+ * This file is part of Bipscript.
+ *
+ * Bipscript is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Bipscript is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Bipscript.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "smfwriter.h"
+#include "audioengine.h"
+#include "tempomap.h"
+
+#include <cmath>
+#include <fstream>
+#include <iostream>
+
+namespace bipscript {
+namespace midi {
+
+static void *run_smf_writer(void *arg)
+{
+    ((SMFWriter*)arg)->run();
+    return 0;
+}
+
+SMFWriter::SMFWriter(const char *filename)
+    : filename(filename), midiInput(0), wasRolling(false), lastBpm(0),
+      lastNumerator(0), lastDenominator(0), meterBar(1), meterQuarter(0), stopping(false), lastTick(0)
+{
+    recordBuffer = jack_ringbuffer_create(sizeof(Record) * 8192);
+    jack_ringbuffer_mlock(recordBuffer);
+    sem_init(&semaphore, 0, 0);
+    if(pthread_create(&thread, NULL, run_smf_writer, this)) {
+        jack_ringbuffer_free(recordBuffer);
+        throw std::runtime_error("could not create MIDI file writer thread");
+    }
+}
+
+/**
+ * Runs in the script thread after the writer has left the process thread.
+ */
+SMFWriter::~SMFWriter()
+{
+    stopping.store(true);
+    sem_post(&semaphore);
+    pthread_join(thread, NULL);
+    drain();
+    writeFile();
+    sem_destroy(&semaphore);
+    jack_ringbuffer_free(recordBuffer);
+}
+
+void SMFWriter::connectMidi(Source &source)
+{
+    if(source.getMidiOutputCount() == 0) {
+        throw std::logic_error("cannot connect: the source has no MIDI outputs");
+    }
+    midiInput.store(source.getMidiConnection(0));
+}
+
+/**
+ * Runs in the process thread. No allocations.
+ */
+void SMFWriter::push(Record &record)
+{
+    if(jack_ringbuffer_write_space(recordBuffer) >= sizeof(Record)) {
+        jack_ringbuffer_write(recordBuffer, (const char*)&record, sizeof(Record));
+    }
+}
+
+/**
+ * Quarter notes from the start of bar 1 to the transport position. Without a
+ * tempo map the bars before a meter change keep the meter they were played
+ * in; bars never played are taken to be in the current meter.
+ *
+ * Runs in the process thread. No allocations.
+ */
+double SMFWriter::quarterOf(jack_position_t &pos)
+{
+    const transport::TempoMap *map = AudioEngine::instance().getTempoMap();
+    if(map) {
+        return map->quarterOf(pos);
+    }
+    if(!lastNumerator || pos.bar < meterBar) {
+        meterBar = 1;
+        meterQuarter = 0;
+    } else if(pos.beats_per_bar != lastNumerator || pos.beat_type != lastDenominator) {
+        meterQuarter += (pos.bar - meterBar) * lastNumerator * 4.0 / lastDenominator;
+        meterBar = pos.bar;
+    }
+    double beats = (pos.bar - meterBar) * pos.beats_per_bar + pos.beat - 1
+            + pos.tick / pos.ticks_per_beat;
+    return meterQuarter + beats * 4.0 / pos.beat_type;
+}
+
+/**
+ * Runs in the process thread. No allocations.
+ */
+void SMFWriter::doProcess(bool rolling, jack_position_t &pos, jack_nframes_t nframes, jack_nframes_t time)
+{
+    MidiConnection *connection = midiInput.load();
+    if(connection) {
+        connection->getSource()->process(rolling, pos, nframes, time);
+    }
+    Record record;
+    if(wasRolling && !rolling) {
+        record.kind = RECORD_FLUSH;
+        push(record);
+        sem_post(&semaphore);
+    }
+    wasRolling = rolling;
+    if(!rolling || !connection || !(pos.valid & JackPositionBBT)) {
+        return;
+    }
+    // quarter notes from the start of bar 1
+    double periodQuarters = quarterOf(pos);
+    double quartersPerFrame = pos.beats_per_minute * 4 / (60.0 * pos.frame_rate * pos.beat_type);
+    if(pos.beats_per_minute != lastBpm || pos.beats_per_bar != lastNumerator
+            || pos.beat_type != lastDenominator) {
+        record.kind = RECORD_METER;
+        record.tick = periodQuarters * DIVISION + 0.5;
+        record.bpm = lastBpm = pos.beats_per_minute;
+        record.numerator = lastNumerator = pos.beats_per_bar;
+        record.denominator = lastDenominator = pos.beat_type;
+        push(record);
+    }
+    uint32_t count = connection->getEventCount();
+    for(uint32_t i = 0; i < count; i++) {
+        const ConnectionEvent &evt = connection->getEvent(i);
+        if(evt.data[0] >= 0xf0) {
+            continue; // system messages are not recorded
+        }
+        double quarters = periodQuarters + evt.frame * quartersPerFrame;
+        record.kind = RECORD_EVENT;
+        record.tick = quarters * DIVISION + 0.5;
+        record.data[0] = evt.data[0];
+        record.data[1] = evt.getDatabyte1();
+        record.data[2] = evt.getDatabyte2();
+        push(record);
+    }
+    if(count) {
+        sem_post(&semaphore);
+    }
+}
+
+/**
+ * Writer thread: encodes records as they arrive.
+ */
+void SMFWriter::run()
+{
+    while(true) {
+        sem_wait(&semaphore);
+        if(stopping.load()) {
+            break;
+        }
+        drain();
+    }
+}
+
+void SMFWriter::drain()
+{
+    Record record;
+    while(jack_ringbuffer_read_space(recordBuffer) >= sizeof(Record)) {
+        jack_ringbuffer_read(recordBuffer, (char*)&record, sizeof(Record));
+        if(record.kind == RECORD_FLUSH) {
+            writeFile();
+        } else {
+            encode(record);
+        }
+    }
+}
+
+static void appendVariable(std::vector<uint8_t> &out, uint32_t value)
+{
+    uint8_t bytes[5];
+    int count = 0;
+    do {
+        bytes[count++] = value & 0x7f;
+        value >>= 7;
+    } while(value);
+    while(count > 1) {
+        out.push_back(bytes[--count] | 0x80);
+    }
+    out.push_back(bytes[0]);
+}
+
+/**
+ * Appends a record to the track; events recorded after a relocation to an
+ * earlier position are written at the current end of the track.
+ */
+void SMFWriter::encode(Record &record)
+{
+    uint32_t tick = record.tick > lastTick ? record.tick : lastTick;
+    appendVariable(track, tick - lastTick);
+    lastTick = tick;
+    if(record.kind == RECORD_METER) {
+        // tempo in microseconds per quarter note
+        uint32_t tempo = 60000000.0 * record.denominator / (4 * record.bpm);
+        const uint8_t tempoEvent[] = { 0xff, 0x51, 0x03,
+                    (uint8_t)(tempo >> 16), (uint8_t)(tempo >> 8), (uint8_t)tempo };
+        track.insert(track.end(), tempoEvent, tempoEvent + sizeof(tempoEvent));
+        appendVariable(track, 0);
+        const uint8_t meterEvent[] = { 0xff, 0x58, 0x04, (uint8_t)record.numerator,
+                    (uint8_t)std::log2(record.denominator), 24, 8 };
+        track.insert(track.end(), meterEvent, meterEvent + sizeof(meterEvent));
+        return;
+    }
+    track.push_back(record.data[0]);
+    uint8_t type = record.data[0] & 0xf0;
+    track.push_back(record.data[1]);
+    if(type != 0xc0 && type != 0xd0) {
+        track.push_back(record.data[2]);
+    }
+}
+
+static void writeBig(std::ofstream &out, uint32_t value, int bytes)
+{
+    for(int i = bytes - 1; i >= 0; i--) {
+        out.put((char)(value >> (i * 8)));
+    }
+}
+
+/**
+ * Rewrites the file with all events recorded so far.
+ */
+void SMFWriter::writeFile()
+{
+    std::ofstream out(filename, std::ios::binary | std::ios::trunc);
+    if(!out) {
+        std::cerr << "warning: could not write MIDI file " << filename << std::endl;
+        return;
+    }
+    const uint8_t endOfTrack[] = { 0x00, 0xff, 0x2f, 0x00 };
+    out.write("MThd", 4);
+    writeBig(out, 6, 4);
+    writeBig(out, 0, 2); // format
+    writeBig(out, 1, 2); // tracks
+    writeBig(out, DIVISION, 2);
+    out.write("MTrk", 4);
+    writeBig(out, track.size() + sizeof(endOfTrack), 4);
+    out.write((const char*)track.data(), track.size());
+    out.write((const char*)endOfTrack, sizeof(endOfTrack));
+}
+
+SMFWriter *SMFWriterCache::getSMFWriter(const char *filename)
+{
+    int key = std::hash<std::string>()(filename);
+    SMFWriter *writer = findObject(key);
+    if(!writer) {
+        writer = new SMFWriter(filename);
+        registerObject(key, writer);
+    }
+    return writer;
+}
+
+}}
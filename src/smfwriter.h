@@ -0,0 +1,99 @@
+/*
+ * This file is part of Bipscript.
+ *
+ * Bipscript is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Bipscript is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Bipscript.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef SMFWRITER_H
+#define SMFWRITER_H
+
+#include "midiconnection.h"
+#include "objectcache.h"
+
+#include <jack/ringbuffer.h>
+#include <pthread.h>
+#include <semaphore.h>
+
+#include <atomic>
+#include <string>
+#include <vector>
+
+namespace bipscript {
+namespace midi {
+
+/**
+ * Records the events of a MIDI source to a type 0 standard MIDI file.
+ *
+ * The process thread only copies events into a ring buffer; encoding and
+ * file output happen in a writer thread. The file is rewritten with
+ * everything recorded so far each time the transport stops and when the
+ * writer is removed.
+ */
+class SMFWriter : public Processor
+{
+    static const uint16_t DIVISION = 960;
+    static const uint8_t RECORD_EVENT = 0;
+    static const uint8_t RECORD_METER = 1;
+    static const uint8_t RECORD_FLUSH = 2;
+    struct Record {
+        uint8_t kind;
+        uint8_t data[3];
+        uint32_t tick;
+        float bpm;
+        float numerator;
+        float denominator;
+    };
+    std::string filename;
+    std::atomic<MidiConnection*> midiInput;
+    // process thread
+    jack_ringbuffer_t *recordBuffer;
+    bool wasRolling;
+    float lastBpm;
+    float lastNumerator;
+    float lastDenominator;
+    int32_t meterBar; // bar the current meter was first seen in
+    double meterQuarter; // quarter notes from the start to meterBar
+    double quarterOf(jack_position_t &pos);
+    void push(Record &record);
+    // writer thread
+    pthread_t thread;
+    sem_t semaphore;
+    std::atomic<bool> stopping;
+    std::vector<uint8_t> track;
+    uint32_t lastTick;
+    void drain();
+    void encode(Record &record);
+    void writeFile();
+public:
+    SMFWriter(const char *filename);
+    ~SMFWriter();
+    void connectMidi(Source &source);
+    void run();
+    // Processor interface
+    void doProcess(bool rolling, jack_position_t &pos, jack_nframes_t nframes, jack_nframes_t time);
+    void reposition() {}
+};
+
+class SMFWriterCache : public ProcessorCache<SMFWriter>
+{
+public:
+    static SMFWriterCache &instance() {
+        static SMFWriterCache instance;
+        return instance;
+    }
+    SMFWriter *getSMFWriter(const char *filename);
+};
+
+}}
+
+#endif // SMFWRITER_H
@@ -0,0 +1,387 @@
+/*
+ * This file is part of Bipscript.
+ *
+ * Bipscript is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Bipscript is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Bipscript.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "tempomap.h"
+
+#include <algorithm>
+
+namespace bipscript {
+namespace transport {
+
+static bool beatBefore(double beat, const TempoSegment &segment)
+{
+    return beat < segment.beat;
+}
+
+static bool tickBefore(int64_t tick, const TempoSegment &segment)
+{
+    return tick < segment.tick;
+}
+
+static bool frameBefore(int64_t frame, const TempoSegment &segment)
+{
+    return frame < segment.frame;
+}
+
+static bool quarterBefore(double quarter, const TempoSegment &segment)
+{
+    return quarter < segment.quarter;
+}
+
+static bool barBefore(uint32_t bar, const TempoSegment &segment)
+{
+    return bar < segment.bar;
+}
+
+TempoMap::TempoMap(double bpm, float beatsPerBar, float beatUnit)
+    : frameRate(0), ticksPerBeat(0)
+{
+    TempoSegment first = {0, 0, bpm, 0, 1, 0, beatsPerBar, beatUnit, true, 0, 0, 0, 0};
+    segments.push_back(first);
+}
+
+/**
+ * Change the tempo at the given fraction of a bar, ramping to it from the
+ * previous tempo change if requested. Changes must be added in order.
+ *
+ * Runs in the script thread.
+ */
+void TempoMap::addTempo(uint32_t bar, double fraction, double bpm, bool ramp)
+{
+    TempoSegment next = segments.back();
+    next.barBeat += ((double)bar - next.bar) * next.beatsPerBar;
+    next.bar = bar;
+    double beat = next.barBeat + fraction * next.beatsPerBar;
+    if(ramp) {
+        // the ramp runs from the last tempo change, across any meter changes
+        size_t start = segments.size() - 1;
+        while(!segments[start].tempoChange) {
+            start--;
+        }
+        TempoSegment &from = segments[start];
+        if(beat > from.beat) {
+            double slope = (bpm - from.bpm) / (beat - from.beat);
+            for(size_t i = start; i < segments.size(); i++) {
+                TempoSegment &segment = segments[i];
+                segment.slope = slope;
+                if(i > start) {
+                    TempoSegment &previous = segments[i - 1];
+                    segment.bpm = from.bpm + slope * (segment.beat - from.beat);
+                    segment.seconds = previous.seconds + previous.secondsFor(segment.beat - previous.beat);
+                }
+            }
+        }
+    }
+    TempoSegment &last = segments.back();
+    if(beat == last.beat) {
+        last.bpm = bpm;
+        last.slope = 0;
+        last.tempoChange = true;
+        return;
+    }
+    next.seconds = last.seconds + last.secondsFor(beat - last.beat);
+    next.beat = beat;
+    next.bpm = bpm;
+    next.slope = 0;
+    next.tempoChange = true;
+    segments.push_back(next);
+}
+
+/**
+ * Change the meter at the start of the given bar, a tempo ramp in progress
+ * carries on through it. Changes must be added in order.
+ *
+ * Runs in the script thread.
+ */
+void TempoMap::addMeter(uint32_t bar, float beatsPerBar, float beatUnit)
+{
+    TempoSegment &last = segments.back();
+    TempoSegment next = last;
+    next.barBeat += ((double)bar - last.bar) * last.beatsPerBar;
+    next.bar = bar;
+    next.beatsPerBar = beatsPerBar;
+    next.beatUnit = beatUnit;
+    if(next.barBeat == last.beat) {
+        last = next;
+        return;
+    }
+    next.beat = next.barBeat;
+    next.seconds = last.seconds + last.secondsFor(next.beat - last.beat);
+    next.bpm = last.tempoAt(next.beat - last.beat);
+    next.tempoChange = false;
+    segments.push_back(next);
+}
+
+/**
+ * Work out where each segment starts in frames and ticks once all changes
+ * are added, by following the map from the start exactly as the transport
+ * will while rolling.
+ *
+ * Runs in the script thread.
+ */
+void TempoMap::prepare(jack_nframes_t frameRate, double ticksPerBeat)
+{
+    this->frameRate = frameRate;
+    this->ticksPerBeat = ticksPerBeat;
+    for(TempoSegment &segment : segments) {
+        segment.tick = std::llround(segment.beat * ticksPerBeat);
+        segment.tickRate = segment.slope ? 0 : tickRateFor(segment.bpm);
+    }
+    for(size_t i = 1; i < segments.size(); i++) {
+        const TempoSegment &previous = segments[i - 1];
+        segments[i].quarter = previous.quarter + (segments[i].beat - previous.beat) * 4 / previous.beatUnit;
+        TempoAnchor anchor = anchorAt(i - 1, previous.frame, previous.tick);
+        segments[i].frame = frameAt(anchor, segments[i].tick);
+    }
+}
+
+size_t TempoMap::indexAtBeat(double beat) const
+{
+    auto it = std::upper_bound(segments.begin() + 1, segments.end(), beat, beatBefore);
+    return it - segments.begin() - 1;
+}
+
+size_t TempoMap::indexAtTick(int64_t tick) const
+{
+    auto it = std::upper_bound(segments.begin() + 1, segments.end(), tick, tickBefore);
+    return it - segments.begin() - 1;
+}
+
+const TempoSegment &TempoMap::segmentAtBar(uint32_t bar) const
+{
+    return *(std::upper_bound(segments.begin() + 1, segments.end(), bar, barBefore) - 1);
+}
+
+/**
+ * Absolute beat of a bar position.
+ */
+double TempoMap::beatOf(const Position &position) const
+{
+    const TempoSegment &segment = segmentAtBar(position.getBar());
+    double bars = (double)position.getBar() - segment.bar
+            + (double)position.getPosition() / position.getDivision();
+    return segment.barBeat + bars * segment.beatsPerBar;
+}
+
+/**
+ * Time of the given absolute beat, before the start the first tempo holds.
+ */
+double TempoMap::secondsAt(double beat) const
+{
+    if(beat < 0) {
+        return beat * 60 / segments[0].bpm;
+    }
+    const TempoSegment &segment = segmentAtBeat(beat);
+    return segment.seconds + segment.secondsFor(beat - segment.beat);
+}
+
+/**
+ * The frame the transport reaches the given number of quarter notes from
+ * the start at when following the map, as counted by a song position pointer.
+ *
+ * Runs in the process thread. No allocations.
+ */
+int64_t TempoMap::frameOfQuarter(double quarters) const
+{
+    size_t index = std::upper_bound(segments.begin() + 1, segments.end(), quarters, quarterBefore)
+            - segments.begin() - 1;
+    const TempoSegment &segment = segments[index];
+    double beat = segment.beat + (quarters - segment.quarter) * segment.beatUnit / 4;
+    TempoAnchor anchor = anchorAt(index, segment.frame, segment.tick);
+    return frameAt(anchor, std::llround(beat * ticksPerBeat));
+}
+
+/**
+ * Quarter notes from the start to the given transport position, counted
+ * across every meter change before it.
+ *
+ * Runs in the process thread. No allocations.
+ */
+double TempoMap::quarterOf(const jack_position_t &pos) const
+{
+    const TempoSegment &bar = segmentAtBar(pos.bar);
+    double beat = bar.barBeat + ((double)pos.bar - bar.bar) * bar.beatsPerBar
+            + pos.beat - 1 + pos.tick / pos.ticks_per_beat;
+    const TempoSegment &segment = segmentAtBeat(beat);
+    return segment.quarter + (beat - segment.beat) * 4 / segment.beatUnit;
+}
+
+TempoAnchor TempoMap::anchorAt(size_t index, int64_t frame, int64_t tick) const
+{
+    const TempoSegment &segment = segments[index];
+    double beats = tick / ticksPerBeat - segment.beat;
+    TempoAnchor anchor = {index, frame, tick, 0, segment.tickRate, segment.bpm};
+    if(segment.slope) {
+        anchor.seconds = segment.secondsFor(beats);
+        anchor.bpm = segment.tempoAt(beats);
+    }
+    return anchor;
+}
+
+/**
+ * The first frame from the anchor on that is at or past the given tick.
+ */
+int64_t TempoMap::frameAt(const TempoAnchor &anchor, int64_t tick) const
+{
+    if(tick <= anchor.tick) {
+        return anchor.frame;
+    }
+    if(anchor.tickRate) {
+        unsigned __int128 scaled = (unsigned __int128)(tick - anchor.tick) << 32;
+        return anchor.frame + (int64_t)((scaled + anchor.tickRate - 1) / anchor.tickRate);
+    }
+    const TempoSegment &segment = segments[anchor.index];
+    double seconds = segment.secondsFor(tick / ticksPerBeat - segment.beat) - anchor.seconds;
+    int64_t frame = anchor.frame + (int64_t)std::ceil(seconds * frameRate);
+    while(ticksAt(anchor, frame) < tick) {
+        frame++;
+    }
+    return frame;
+}
+
+/**
+ * The segment start at or before the given frame when following the map
+ * from the start, O(log segments).
+ *
+ * Runs in the process thread. No allocations.
+ */
+TempoAnchor TempoMap::anchorAtFrame(int64_t frame) const
+{
+    size_t index = std::upper_bound(segments.begin() + 1, segments.end(), frame, frameBefore)
+            - segments.begin() - 1;
+    const TempoSegment &segment = segments[index];
+    return anchorAt(index, segment.frame, segment.tick);
+}
+
+/**
+ * Move the anchor to the given frame and tick, on a constant tempo segment
+ * the given tempo applies from there; ramps always follow the map.
+ *
+ * Runs in the process thread. No allocations.
+ */
+TempoAnchor TempoMap::reanchor(const TempoAnchor &anchor, int64_t frame, int64_t tick, double bpm) const
+{
+    size_t index = anchor.index;
+    while(index + 1 < segments.size() && segments[index + 1].tick <= tick) {
+        index++;
+    }
+    TempoAnchor moved = anchorAt(index, frame, tick);
+    if(!segments[index].slope) {
+        moved.bpm = bpm;
+        moved.tickRate = tickRateFor(bpm);
+    }
+    return moved;
+}
+
+/**
+ * Cross into any later segments the given frame has reached, each one is
+ * anchored at its start tick on the first frame that reaches it. Returns
+ * true if the segment changed.
+ *
+ * Runs in the process thread. No allocations.
+ */
+bool TempoMap::follow(TempoAnchor &anchor, int64_t frame) const
+{
+    bool crossed = false;
+    while(anchor.index + 1 < segments.size()) {
+        int64_t tick = segments[anchor.index + 1].tick;
+        if(ticksAt(anchor, frame) < tick) {
+            break;
+        }
+        anchor = anchorAt(anchor.index + 1, frameAt(anchor, tick), tick);
+        crossed = true;
+    }
+    return crossed;
+}
+
+/**
+ * Absolute tick at the given frame: fixed point on a constant tempo, from
+ * the ramp curve otherwise, never accumulated.
+ *
+ * Runs in the process thread. No allocations.
+ */
+int64_t TempoMap::ticksAt(const TempoAnchor &anchor, int64_t frame) const
+{
+    if(anchor.tickRate) {
+        __int128 scaled = (__int128)(frame - anchor.frame) * anchor.tickRate;
+        return anchor.tick + (int64_t)(scaled >> 32);
+    }
+    const TempoSegment &segment = segments[anchor.index];
+    double seconds = anchor.seconds + (double)(frame - anchor.frame) / frameRate;
+    return std::llround((segment.beat + segment.beatsFor(seconds)) * ticksPerBeat);
+}
+
+/**
+ * Runs in the process thread. No allocations.
+ */
+double TempoMap::tempoAt(const TempoAnchor &anchor, int64_t tick) const
+{
+    const TempoSegment &segment = segments[anchor.index];
+    if(!segment.slope) {
+        return anchor.bpm;
+    }
+    return segment.tempoAt(tick / ticksPerBeat - segment.beat);
+}
+
+/**
+ * Fill in the bar, beat and tick of the given absolute tick.
+ *
+ * Runs in the process thread. No allocations.
+ */
+void TempoMap::locate(int64_t tick, jack_position_t &pos) const
+{
+    const TempoSegment &segment = segments[indexAtTick(tick)];
+    int64_t ticksPerBeat = std::llround(this->ticksPerBeat);
+    int64_t ticksPerBar = std::llround(segment.beatsPerBar * this->ticksPerBeat);
+    int64_t barTick = std::llround(segment.barBeat * this->ticksPerBeat);
+    int64_t bars = (tick - barTick) / ticksPerBar;
+    int64_t inBar = tick - barTick - bars * ticksPerBar;
+    pos.bar = segment.bar + bars;
+    pos.beat = inBar / ticksPerBeat + 1;
+    pos.tick = inBar % ticksPerBeat;
+    pos.bar_start_tick = barTick + bars * ticksPerBar;
+    pos.beats_per_bar = segment.beatsPerBar;
+    pos.beat_type = segment.beatUnit;
+}
+
+/**
+ * Frames from the given transport position to the given bar position. The
+ * constant tempo segment the transport is in runs at the reported tempo,
+ * which may have been changed live, the rest of the song follows the map.
+ *
+ * Runs in the process thread. No allocations.
+ */
+long TempoMap::frameOffset(const Position &position, jack_position_t &pos) const
+{
+    const TempoSegment &bar = segmentAtBar(pos.bar);
+    double current = bar.barBeat + ((double)pos.bar - bar.bar) * bar.beatsPerBar
+            + pos.beat - 1 + pos.tick / pos.ticks_per_beat;
+    double target = beatOf(position);
+    size_t index = indexAtBeat(current);
+    const TempoSegment &segment = segments[index];
+    // the part of the way within the current segment
+    double edge = std::min(std::max(target, segment.beat), endBeat(index));
+    double seconds = segment.slope
+            ? secondsAt(edge) - secondsAt(current)
+            : (edge - current) * 60 / pos.beats_per_minute;
+    if(edge != target) {
+        seconds += secondsAt(target) - secondsAt(edge);
+    }
+    return std::lround(seconds * pos.frame_rate);
+}
+
+}}
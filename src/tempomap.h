@@ -0,0 +1,138 @@
+/*
+ * This file is part of Bipscript.
+ *
+ * Bipscript is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Bipscript is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Bipscript.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef TEMPOMAP_H
+#define TEMPOMAP_H
+
+#include "listable.h"
+#include "position.h"
+
+#include <jack/types.h>
+#include <cmath>
+#include <vector>
+
+namespace bipscript {
+namespace transport {
+
+/**
+ * A stretch of the song with one meter and either a constant tempo or a
+ * linear tempo ramp, in beats.
+ */
+struct TempoSegment
+{
+    double beat;        // absolute beat the segment starts on
+    double seconds;     // time the segment starts at
+    double bpm;         // tempo at the start of the segment
+    double slope;       // tempo change per beat, zero for a constant tempo
+    uint32_t bar;       // bar the segment starts in
+    double barBeat;     // absolute beat that bar starts on
+    float beatsPerBar;
+    float beatUnit;
+    bool tempoChange;   // false when only the meter changes here
+    int64_t frame;      // first frame of the segment
+    int64_t tick;       // absolute tick the segment starts on
+    uint64_t tickRate;  // ticks per frame as 32.32 fixed point, zero for a ramp
+    double quarter;     // quarter notes from the start to the segment
+    double tempoAt(double beats) const {
+        return bpm + slope * beats;
+    }
+    /**
+     * Seconds from the start of the segment to the given beats into it.
+     */
+    double secondsFor(double beats) const {
+        if(!slope) {
+            return beats * 60 / bpm;
+        }
+        return 60 / slope * std::log1p(slope * beats / bpm);
+    }
+    /**
+     * Beats from the start of the segment to the given seconds into it.
+     */
+    double beatsFor(double seconds) const {
+        if(!slope) {
+            return seconds * bpm / 60;
+        }
+        return bpm * std::expm1(slope * seconds / 60) / slope;
+    }
+};
+
+/**
+ * Where the transport is within a segment. Ticks are derived from the frame
+ * relative to the anchor every period rather than accumulated, so the same
+ * frame always gives the same tick whatever the period size.
+ */
+struct TempoAnchor
+{
+    size_t index;       // segment the anchor is in
+    int64_t frame;
+    int64_t tick;
+    double seconds;     // time into the segment at the anchor, for ramps
+    uint64_t tickRate;  // ticks per frame as 32.32 fixed point, zero on a ramp
+    double bpm;
+};
+
+/**
+ * The tempo and meter changes of a song as a sorted array of segments, each
+ * with its start time, so any beat or frame can be found with a binary
+ * search.
+ *
+ * Built in the script thread and read-only once handed to the process
+ * thread.
+ */
+class TempoMap : public Listable
+{
+    std::vector<TempoSegment> segments;
+    jack_nframes_t frameRate;
+    double ticksPerBeat;
+    size_t indexAtBeat(double beat) const;
+    size_t indexAtTick(int64_t tick) const;
+    const TempoSegment &segmentAtBeat(double beat) const {
+        return segments[indexAtBeat(beat)];
+    }
+    const TempoSegment &segmentAtBar(uint32_t bar) const;
+    double endBeat(size_t index) const {
+        return index + 1 < segments.size() ? segments[index + 1].beat : INFINITY;
+    }
+    uint64_t tickRateFor(double bpm) const {
+        return std::llround(std::ldexp(ticksPerBeat * bpm / 60 / frameRate, 32));
+    }
+    TempoAnchor anchorAt(size_t index, int64_t frame, int64_t tick) const;
+    int64_t frameAt(const TempoAnchor &anchor, int64_t tick) const;
+public:
+    TempoMap(double bpm, float beatsPerBar, float beatUnit);
+    void addTempo(uint32_t bar, double fraction, double bpm, bool ramp);
+    void addMeter(uint32_t bar, float beatsPerBar, float beatUnit);
+    void prepare(jack_nframes_t frameRate, double ticksPerBeat);
+    double beatOf(const Position &position) const;
+    double secondsAt(double beat) const;
+    int64_t frameOfQuarter(double quarters) const;
+    double quarterOf(const jack_position_t &pos) const;
+    // transport position
+    TempoAnchor anchorAtFrame(int64_t frame) const;
+    TempoAnchor anchorAtTick(int64_t tick, int64_t frame) const {
+        return anchorAt(indexAtTick(tick), frame, tick);
+    }
+    TempoAnchor reanchor(const TempoAnchor &anchor, int64_t frame, int64_t tick, double bpm) const;
+    bool follow(TempoAnchor &anchor, int64_t frame) const;
+    int64_t ticksAt(const TempoAnchor &anchor, int64_t frame) const;
+    double tempoAt(const TempoAnchor &anchor, int64_t tick) const;
+    void locate(int64_t tick, jack_position_t &pos) const;
+    long frameOffset(const Position &position, jack_position_t &pos) const;
+};
+
+}}
+
+#endif // TEMPOMAP_H
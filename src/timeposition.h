@@ -19,6 +19,8 @@
 
 #include "position.h"
 
+#include <cmath>
+
 namespace bipscript {
 namespace transport {
 
@@ -36,18 +38,42 @@ public:
             setDivision(pos.ticks_per_beat * pos.beats_per_bar);
         }
     }
-    TimePosition(jack_position_t &pos, long frameOffset) :
-        time(pos.usecs) {
-        if(pos.valid) {
-            setBar(pos.bar);
-            // TODO: include frameOffset
-            setPosition(pos.tick + (pos.ticks_per_beat * (pos.beat - 1)));
-            setDivision(pos.ticks_per_beat * pos.beats_per_bar);
-        }
-    }
+    TimePosition(jack_position_t &pos, long frameOffset);
     jack_time_t getTime() { return time; }
 };
 
+/**
+ * Position of the given frame offset from the start of the period, which
+ * can be negative for frames in earlier periods.
+ *
+ * The offset is folded into the bar and tick at the current tempo, rounded
+ * to the nearest tick; the time is exact to the frame.
+ *
+ * Runs in the process thread. No allocations.
+ */
+inline TimePosition::TimePosition(jack_position_t &pos, long frameOffset) :
+    time(pos.usecs)
+{
+    if(pos.frame_rate) {
+        time += (int64_t)frameOffset * 1000000 / (int64_t)pos.frame_rate;
+    }
+    if(pos.valid) {
+        long ticksPerBar = std::lround(pos.ticks_per_beat * pos.beats_per_bar);
+        double offsetTicks = frameOffset * pos.ticks_per_beat * pos.beats_per_minute / (pos.frame_rate * 60.0);
+        long tick = pos.tick + std::lround(pos.ticks_per_beat * (pos.beat - 1) + offsetTicks);
+        // carry into the bar
+        long bar = pos.bar + (tick >= 0 ? tick / ticksPerBar : -((ticksPerBar - 1 - tick) / ticksPerBar));
+        tick -= (bar - pos.bar) * ticksPerBar;
+        if(bar < 1) {
+            bar = 1;
+            tick = 0;
+        }
+        setBar(bar);
+        setPosition(tick);
+        setDivision(ticksPerBar);
+    }
+}
+
 }}
 
 #endif // TIMEPOSITION_H
@@ -17,72 +17,210 @@
 
 #include "transportmaster.h"
 #include "audioengine.h"
+#include "objectcollector.h"
 
+#include <algorithm>
 #include <cmath>
+#include <stdexcept>
 
 namespace bipscript {
 namespace transport {
 
+static bool changeBefore(const TempoChange &one, const TempoChange &other)
+{
+    const Position &first = one.position;
+    const Position &second = other.position;
+    if(first.getBar() != second.getBar()) {
+        return first.getBar() < second.getBar();
+    }
+    uint64_t left = (uint64_t)first.getPosition() * second.getDivision();
+    uint64_t right = (uint64_t)second.getPosition() * first.getDivision();
+    if(left != right) {
+        return left < right;
+    }
+    // meter first so a tempo change in the same bar uses the new meter
+    return one.beatsPerBar && !other.beatsPerBar;
+}
+
+Master::Master(double bpm, float beatsPerBar, float beatUnit) :
+    initialBpm(bpm), initialBeatsPerBar(beatsPerBar), initialBeatUnit(beatUnit),
+    pendingMap(0), map(new TempoMap(bpm, beatsPerBar, beatUnit)),
+    ticksPerBeat(1920.0), bpm(bpm), doForceBeat(false)
+{
+    map->prepare(AudioEngine::instance().getSampleRate(), ticksPerBeat);
+    anchor = map->anchorAtFrame(0);
+    AudioEngine::instance().setTempoMap(map);
+}
+
 Master::~Master()
 {
     AudioEngine::instance().releaseTransportMaster();
+    delete pendingMap.load();
+    // events in the current cycle may still be reading the map
+    AudioEngine::instance().retire(map);
+}
+
+/**
+ * Rebuild the tempo map and hand it to the process thread, replacing any
+ * map it has not picked up yet.
+ *
+ * Runs in the script thread.
+ */
+void Master::publish()
+{
+    std::stable_sort(changes.begin(), changes.end(), changeBefore);
+    TempoMap *fresh = new TempoMap(initialBpm, initialBeatsPerBar, initialBeatUnit);
+    for(const TempoChange &change : changes) {
+        const Position &position = change.position;
+        if(change.beatsPerBar) {
+            fresh->addMeter(position.getBar(), change.beatsPerBar, change.beatUnit);
+        } else {
+            double fraction = (double)position.getPosition() / position.getDivision();
+            fresh->addTempo(position.getBar(), fraction, change.bpm, change.ramp);
+        }
+    }
+    fresh->prepare(AudioEngine::instance().getSampleRate(), ticksPerBeat);
+    delete pendingMap.exchange(fresh);
+}
+
+void Master::schedule(const TempoChange &change)
+{
+    changes.push_back(change);
+    publish();
+}
+
+/**
+ * Clear scheduled changes and start again from the given tempo and meter.
+ *
+ * Runs in the script thread.
+ */
+void Master::reset(double bpm, float beatsPerBar, float beatUnit)
+{
+    initialBpm = bpm;
+    initialBeatsPerBar = beatsPerBar;
+    initialBeatUnit = beatUnit;
+    changes.clear();
+    publish();
+}
+
+/**
+ * Runs in the script thread.
+ */
+void Master::setInitialBpm(double bpm)
+{
+    initialBpm = bpm;
+    publish();
+}
+
+/**
+ * Change to the given tempo at the given position.
+ *
+ * Runs in the script thread.
+ */
+void Master::scheduleBpm(double bpm, uint32_t bar, uint32_t position, uint32_t division)
+{
+    if(bpm <= 0) {
+        throw std::logic_error("bpm must be greater than zero");
+    }
+    schedule({Position(bar, position, division), bpm, false, 0, 0});
+}
+
+/**
+ * Ramp linearly from the previous tempo change to reach the given tempo at
+ * the given position.
+ *
+ * Runs in the script thread.
+ */
+void Master::scheduleRamp(double bpm, uint32_t bar, uint32_t position, uint32_t division)
+{
+    if(bpm <= 0) {
+        throw std::logic_error("bpm must be greater than zero");
+    }
+    schedule({Position(bar, position, division), bpm, true, 0, 0});
+}
+
+/**
+ * Change the meter at the start of the given bar.
+ *
+ * Runs in the script thread.
+ */
+void Master::scheduleTimeSignature(uint32_t numerator, uint32_t denominator, uint32_t bar)
+{
+    if(!numerator || !denominator) {
+        throw std::logic_error("time signature cannot have a zero numerator or denominator");
+    }
+    schedule({Position(bar, 0, 1), 0, false, (float)numerator, (float)denominator});
+}
+
+/**
+ * Change the meter from the current bar on.
+ *
+ * Runs in the script thread.
+ */
+void Master::setTimeSignature(uint32_t numerator, uint32_t denominator)
+{
+    jack_position_t pos;
+    AudioEngine::instance().getPosition(pos);
+    bool located = (pos.valid & JackPositionBBT) && pos.bar > 0;
+    scheduleTimeSignature(numerator, denominator, located ? pos.bar : 1);
 }
 
+/**
+ * Change the tempo live and skip to the next beat if already past the
+ * middle of the current one.
+ *
+ * Runs in the process thread.
+ */
 void Master::forceBeat(double bpm)
 {
     this->bpm = bpm;
     doForceBeat = true;
 }
 
+/**
+ * Jack timebase callback.
+ *
+ * Runs in the process thread. No allocations.
+ */
 void Master::setTime(jack_transport_state_t state, jack_nframes_t nframes, jack_position_t *pos, int new_pos)
 {
+    int64_t frame = pos->frame;
 
-    pos->valid = JackPositionBBT;
-    pos->beats_per_bar = beatsPerBar;
-    pos->beat_type = beatUnit;
-    pos->ticks_per_beat = ticksPerBeat;
-    pos->beats_per_minute = bpm;
+    // pick up a new tempo map, staying on the current tick
+    TempoMap *fresh = pendingMap.exchange(0);
+    if(fresh) {
+        int64_t tick = map->ticksAt(anchor, frame);
+        ObjectCollector::scriptCollector().recycle(map);
+        map = fresh;
+        AudioEngine::instance().setTempoMap(map);
+        anchor = map->anchorAtTick(tick, frame);
+        bpm = anchor.bpm;
+    }
 
     if (new_pos) {
-        // TODO: loop over tempo changes up to this point
-        long tick = ticksPerBeat * bpm * pos->frame / ((double) pos->frame_rate * 60.0);
-        long beat = tick / ticksPerBeat;
-
-        pos->bar = beat / beatsPerBar;
-        pos->beat = beat - (pos->bar * beatsPerBar) + 1;
-        pos->tick = tick - (beat * ticksPerBeat);
-        pos->bar_start_tick = pos->bar * beatsPerBar * ticksPerBeat;
-
-        pos->bar++; // bar is 1-based
-        lastTick = pos->tick;
-    } else {
-
-        lastTick += ticksPerBeat * bpm * nframes / ((double) pos->frame_rate * 60);
-        pos->tick = std::lround(lastTick);
-
-        while (pos->tick >= ticksPerBeat) {
-            pos->tick -= ticksPerBeat;
-            lastTick -= ticksPerBeat;
-            if (++pos->beat > beatsPerBar) {
-                pos->beat = 1;
-                pos->bar++;
-                pos->bar_start_tick += (beatsPerBar * ticksPerBeat);
-            }
-        }
+        anchor = map->anchorAtFrame(frame);
+        bpm = anchor.bpm;
+    } else if(map->follow(anchor, frame)) {
+        // scheduled changes override live tempo changes
+        bpm = anchor.bpm;
     }
 
-    if(doForceBeat) {
-        if(pos->tick > ticksPerBeat / 2) {
-            // skip to next beat
-            if (++pos->beat > beatsPerBar) {
-                pos->beat = 1;
-                pos->bar++;
-                pos->bar_start_tick += (beatsPerBar * ticksPerBeat);
-            }
-            lastTick = pos->tick = 0;
-        }
-        doForceBeat = false;
+    int64_t tick = map->ticksAt(anchor, frame);
+    int64_t ticks = ticksPerBeat;
+    if(doForceBeat && tick % ticks > ticks / 2) {
+        // skip to next beat
+        tick += ticks - tick % ticks;
+        anchor = map->reanchor(anchor, frame, tick, bpm);
+    } else if(bpm != anchor.bpm) {
+        anchor = map->reanchor(anchor, frame, tick, bpm);
     }
+    doForceBeat = false;
+    bpm = anchor.bpm;
+
+    pos->valid = JackPositionBBT;
+    pos->ticks_per_beat = ticksPerBeat;
+    pos->beats_per_minute = map->tempoAt(anchor, tick);
+    map->locate(tick, *pos);
 }
 
 /**
@@ -91,8 +229,10 @@ void Master::setTime(jack_transport_state_t state, jack_nframes_t nframes, jack_
 Master *MasterCache::getTransportMaster(float bpm, float beatsPerBar, float beatUnit)
 {
     Master *cached = cachedMaster.load();
-    if(cached) {
-        cached->setBpm(bpm);
+    if(cached && !active) {
+        cached->reset(bpm, beatsPerBar, beatUnit);
+    } else if(cached) {
+        cached->setInitialBpm(bpm);
     } else {
         cached = AudioEngine::instance().getTransportMaster(bpm, beatsPerBar, beatUnit);
         cachedMaster.store(cached);
@@ -19,38 +19,67 @@
 
 #include "jack/types.h"
 #include "objectcache.h"
+#include "tempomap.h"
 #include "timesignature.h"
 #include <atomic>
+#include <vector>
 
 namespace bipscript {
 namespace transport {
 
-class Master
+/**
+ * A tempo or meter change scheduled by the script.
+ */
+struct TempoChange
 {
-    double lastTick;
-    float beatsPerBar;
+    Position position;
+    double bpm;         // zero for a meter change
+    bool ramp;
+    float beatsPerBar;  // zero for a tempo change
     float beatUnit;
+};
+
+/**
+ * Jack timebase master: turns the transport frame into bar, beat and tick.
+ *
+ * The script schedules tempo and meter changes into a tempo map which is
+ * rebuilt and handed to the process thread on every change; live tempo
+ * changes from beat trackers apply until the next scheduled change.
+ */
+class Master
+{
+    // script thread
+    double initialBpm;
+    float initialBeatsPerBar;
+    float initialBeatUnit;
+    std::vector<TempoChange> changes;
+    std::atomic<TempoMap *> pendingMap; // script thread -> process thread
+    void publish();
+    void schedule(const TempoChange &change);
+    // process thread
+    TempoMap *map;
+    TempoAnchor anchor;
     double ticksPerBeat;
     double bpm;
     bool doForceBeat;
 public:
-    Master(double bpm, float beatsPerBar, float beatUnit) :
-        beatsPerBar(beatsPerBar), beatUnit(beatUnit),
-        ticksPerBeat(1920.0), bpm(bpm), doForceBeat(false) {}
+    Master(double bpm, float beatsPerBar, float beatUnit);
     ~Master();
-    // void scheduleBpm(bpm, bar, position, division)
+    // script thread
+    void reset(double bpm, float beatsPerBar, float beatUnit);
+    void setInitialBpm(double bpm);
+    void scheduleBpm(double bpm, uint32_t bar, uint32_t position, uint32_t division);
+    void scheduleRamp(double bpm, uint32_t bar, uint32_t position, uint32_t division);
+    void scheduleTimeSignature(uint32_t numerator, uint32_t denominator, uint32_t bar);
+    void setTimeSignature(uint32_t numerator, uint32_t denominator);
+    void setTimeSignature(TimeSignature &timeSignature) {
+        setTimeSignature(timeSignature.getNumerator(), timeSignature.getDenominator());
+    }
+    // process thread
     void setBpm(double bpm) {
         this->bpm = bpm;
     }
     void forceBeat(double bpm);
-    void setTimeSignature(uint32_t numerator, uint32_t denominator) {
-        this->beatsPerBar = numerator;
-        this->beatUnit = denominator;
-    }
-    void setTimeSignature(TimeSignature &timeSignature) {
-        this->beatsPerBar = timeSignature.getNumerator();
-        this->beatUnit = timeSignature.getDenominator();
-    }
     void setTime(jack_transport_state_t state, jack_nframes_t nframes, jack_position_t *pos, int new_pos);
 };
 